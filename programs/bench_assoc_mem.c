@@ -0,0 +1,476 @@
+/*
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Reports the heap memory used per association. A number of client
+ * sockets connect via AF_CONN to a single listening endpoint, both sides
+ * requesting the maximum number of streams like WebRTC data channels do.
+ * The heap usage is sampled after the associations are established and
+ * again after a message was sent on a few of the streams of each
+ * association, and reported per association (each connection accounts for
+ * two associations, one on each end). For comparison, the memory accounted
+ * by the stack itself is shown for one association of each end and for
+ * each allocation class. With -i the idle associations are compacted
+ * after the given quiet time and the heap usage is sampled once more.
+ */
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <unistd.h>
+#else
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include <usrsctp.h>
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+typedef HANDLE thread_t;
+#define mutex_init(m) InitializeCriticalSection(m)
+#define mutex_lock(m) EnterCriticalSection(m)
+#define mutex_unlock(m) LeaveCriticalSection(m)
+#define cond_init(c) InitializeConditionVariable(c)
+#define cond_wait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define cond_signal(c) WakeConditionVariable(c)
+#define sleep(s) Sleep((s) * 1000)
+#else
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+typedef pthread_t thread_t;
+#define mutex_init(m) pthread_mutex_init(m, NULL)
+#define mutex_lock(m) pthread_mutex_lock(m)
+#define mutex_unlock(m) pthread_mutex_unlock(m)
+#define cond_init(c) pthread_cond_init(c, NULL)
+#define cond_wait(c, m) pthread_cond_wait(c, m)
+#define cond_signal(c) pthread_cond_signal(c)
+#endif
+
+#define SERVER_PORT 5001
+#define MAX_STREAMS 65535
+
+char Usage[] =
+"Usage: bench_assoc_mem [options]\n"
+"Options:\n"
+"        -n             number of associations (default 100)\n"
+"        -s             number of streams negotiated (default 65535)\n"
+"        -u             number of streams used per association (default 4)\n"
+"        -i             quiet time in ms before idle associations are compacted (default 0, off)\n"
+;
+
+struct packet {
+	struct packet *next;
+	void *addr;
+	size_t length;
+	char data[];
+};
+
+/*
+ * The two ends of the in-memory link. A packet sent to one of them is
+ * received on the other one.
+ */
+static int link_client, link_server;
+
+static struct packet *queue_head, *queue_tail;
+static mutex_t queue_mutex;
+static cond_t queue_cond;
+static volatile int stop;
+
+#ifdef _WIN32
+static DWORD WINAPI
+#else
+static void *
+#endif
+handle_packets(void *arg)
+{
+	struct packet *packet;
+
+	for (;;) {
+		mutex_lock(&queue_mutex);
+		while ((queue_head == NULL) && !stop) {
+			cond_wait(&queue_cond, &queue_mutex);
+		}
+		packet = queue_head;
+		if (packet != NULL) {
+			queue_head = packet->next;
+			if (queue_head == NULL) {
+				queue_tail = NULL;
+			}
+		}
+		mutex_unlock(&queue_mutex);
+		if (packet == NULL) {
+			break;
+		}
+		usrsctp_conninput(packet->addr, packet->data, packet->length, 0);
+		free(packet);
+	}
+#ifdef _WIN32
+	return (0);
+#else
+	return (NULL);
+#endif
+}
+
+static int
+conn_output(void *addr, void *buf, size_t length, uint8_t tos, uint8_t set_df)
+{
+	struct packet *packet;
+
+	packet = malloc(sizeof(struct packet) + length);
+	if (packet == NULL) {
+		return (ENOMEM);
+	}
+	packet->next = NULL;
+	packet->addr = (addr == &link_client) ? (void *)&link_server : (void *)&link_client;
+	packet->length = length;
+	memcpy(packet->data, buf, length);
+	mutex_lock(&queue_mutex);
+	if (queue_tail == NULL) {
+		queue_head = packet;
+	} else {
+		queue_tail->next = packet;
+	}
+	queue_tail = packet;
+	cond_signal(&queue_cond);
+	mutex_unlock(&queue_mutex);
+	return (0);
+}
+
+/*
+ * Returns the number of bytes currently allocated from the heap, or 0 if
+ * this is not known on the platform.
+ */
+static size_t
+heap_in_use(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 mi;
+
+	mi = mallinfo2();
+	/* Large allocations are served by mmap() and not part of the arena. */
+	return (mi.uordblks + mi.hblkhd);
+#else
+	return (0);
+#endif
+}
+
+static int
+set_streams(struct socket *sock, uint16_t streams)
+{
+	struct sctp_initmsg initmsg;
+
+	memset(&initmsg, 0, sizeof(struct sctp_initmsg));
+	initmsg.sinit_num_ostreams = streams;
+	initmsg.sinit_max_instreams = streams;
+	return (usrsctp_setsockopt(sock, IPPROTO_SCTP, SCTP_INITMSG, &initmsg, (socklen_t)sizeof(struct sctp_initmsg)));
+}
+
+static void
+print_assoc_mem_stats(const char *what, struct socket *sock, sctp_assoc_t id)
+{
+	struct sctp_assoc_mem_stats sams;
+	socklen_t len;
+
+	memset(&sams, 0, sizeof(struct sctp_assoc_mem_stats));
+	sams.sams_assoc_id = id;
+	len = (socklen_t)sizeof(struct sctp_assoc_mem_stats);
+	if (usrsctp_getsockopt(sock, IPPROTO_SCTP, SCTP_GET_ASSOC_MEM_STATS, &sams, &len) < 0) {
+		perror("usrsctp_getsockopt SCTP_GET_ASSOC_MEM_STATS");
+		return;
+	}
+	printf("%s: %u association(s), %llu bytes: control %llu, streams %llu, mapping %llu, queues %llu, mbufs %llu\n",
+	       what, sams.sams_assocs,
+	       (unsigned long long)sams.sams_total,
+	       (unsigned long long)sams.sams_control,
+	       (unsigned long long)sams.sams_streams,
+	       (unsigned long long)sams.sams_mapping,
+	       (unsigned long long)sams.sams_queues,
+	       (unsigned long long)sams.sams_mbufs);
+}
+
+static void
+print_mem_stats(void)
+{
+	struct sctp_mem_stats stats[SCTP_MEM_STATS_MAX];
+	int i, n;
+
+	n = usrsctp_get_mem_stats(stats, SCTP_MEM_STATS_MAX);
+	for (i = 0; i < n; i++) {
+		printf("  %-20s %12llu bytes in %8llu objects, %10llu allocations, %llu failed\n",
+		       stats[i].sms_name,
+		       (unsigned long long)stats[i].sms_in_use,
+		       (unsigned long long)stats[i].sms_objects,
+		       (unsigned long long)stats[i].sms_allocs,
+		       (unsigned long long)stats[i].sms_failures);
+	}
+}
+
+static void
+report(const char *what, size_t before, size_t after, int associations)
+{
+	if ((before == 0) || (after < before)) {
+		printf("%-28s heap statistics not available\n", what);
+		return;
+	}
+	printf("%-28s %10lu bytes total, %8lu bytes per association\n", what,
+	       (unsigned long)(after - before),
+	       (unsigned long)((after - before) / (size_t)associations));
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct socket *server;
+	struct socket **clients;
+	struct sockaddr_conn sconn;
+	struct sctp_sndinfo sndinfo;
+	struct linger linger;
+	thread_t tid;
+	socklen_t infolen;
+	unsigned int infotype;
+	char buffer[1024];
+	struct sctpstat stat;
+	size_t base, established, used, compacted;
+	ssize_t n;
+	int i, c, s, number_of_associations, number_of_streams, used_streams, idle_time, flags;
+#ifdef _WIN32
+	WSADATA wsaData;
+#endif
+
+	number_of_associations = 100;
+	number_of_streams = MAX_STREAMS;
+	used_streams = 4;
+	idle_time = 0;
+	for (i = 1; i < argc; i++) {
+		if ((argv[i][0] != '-') || (argv[i][1] == '\0') || (argv[i][2] != '\0')) {
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+		if ((argv[i][1] != 'h') && (i + 1 == argc)) {
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+		switch (argv[i][1]) {
+		case 'n':
+			number_of_associations = atoi(argv[++i]);
+			break;
+		case 's':
+			number_of_streams = atoi(argv[++i]);
+			break;
+		case 'u':
+			used_streams = atoi(argv[++i]);
+			break;
+		case 'i':
+			idle_time = atoi(argv[++i]);
+			break;
+		default:
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if ((number_of_associations < 1) ||
+	    (number_of_streams < 1) || (number_of_streams > MAX_STREAMS) ||
+	    (used_streams < 0) || (used_streams > number_of_streams) ||
+	    (idle_time < 0)) {
+		printf("%s", Usage);
+		exit(EXIT_FAILURE);
+	}
+	clients = calloc((size_t)number_of_associations, sizeof(struct socket *));
+	if (clients == NULL) {
+		perror("calloc");
+		exit(EXIT_FAILURE);
+	}
+#ifdef _WIN32
+	if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0) {
+		printf("WSAStartup failed\n");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	mutex_init(&queue_mutex);
+	cond_init(&queue_cond);
+	usrsctp_init(0, conn_output, NULL);
+	usrsctp_sysctl_set_sctp_idle_compact_time((uint32_t)idle_time);
+#ifdef _WIN32
+	tid = CreateThread(NULL, 0, &handle_packets, NULL, 0, NULL);
+#else
+	if (pthread_create(&tid, NULL, &handle_packets, NULL)) {
+		perror("pthread_create");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	usrsctp_register_address((void *)&link_client);
+	usrsctp_register_address((void *)&link_server);
+
+	if ((server = usrsctp_socket(AF_CONN, SOCK_SEQPACKET, IPPROTO_SCTP, NULL, NULL, 0, NULL)) == NULL) {
+		perror("usrsctp_socket");
+		exit(EXIT_FAILURE);
+	}
+	if (set_streams(server, (uint16_t)number_of_streams) < 0) {
+		perror("usrsctp_setsockopt SCTP_INITMSG");
+		exit(EXIT_FAILURE);
+	}
+	memset(&sconn, 0, sizeof(struct sockaddr_conn));
+	sconn.sconn_family = AF_CONN;
+#ifdef HAVE_SCONN_LEN
+	sconn.sconn_len = sizeof(struct sockaddr_conn);
+#endif
+	sconn.sconn_port = htons(SERVER_PORT);
+	sconn.sconn_addr = &link_server;
+	if (usrsctp_bind(server, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_bind");
+		exit(EXIT_FAILURE);
+	}
+	if (usrsctp_listen(server, 1) < 0) {
+		perror("usrsctp_listen");
+		exit(EXIT_FAILURE);
+	}
+
+	linger.l_onoff = 1;
+	linger.l_linger = 0;
+	base = heap_in_use();
+	for (c = 0; c < number_of_associations; c++) {
+		if ((clients[c] = usrsctp_socket(AF_CONN, SOCK_STREAM, IPPROTO_SCTP, NULL, NULL, 0, NULL)) == NULL) {
+			perror("usrsctp_socket");
+			exit(EXIT_FAILURE);
+		}
+		if (set_streams(clients[c], (uint16_t)number_of_streams) < 0) {
+			perror("usrsctp_setsockopt SCTP_INITMSG");
+			exit(EXIT_FAILURE);
+		}
+		/* Abort the association when closing the socket. */
+		usrsctp_setsockopt(clients[c], SOL_SOCKET, SO_LINGER, &linger, (socklen_t)sizeof(struct linger));
+		sconn.sconn_port = htons(0);
+		sconn.sconn_addr = &link_client;
+		if (usrsctp_bind(clients[c], (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+			perror("usrsctp_bind");
+			exit(EXIT_FAILURE);
+		}
+		sconn.sconn_port = htons(SERVER_PORT);
+		if (usrsctp_connect(clients[c], (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+			perror("usrsctp_connect");
+			exit(EXIT_FAILURE);
+		}
+	}
+	established = heap_in_use();
+
+	/* Send one message on each of the used streams, spread over the range. */
+	memset(buffer, 'A', sizeof(buffer));
+	memset(&sndinfo, 0, sizeof(struct sctp_sndinfo));
+	for (c = 0; c < number_of_associations; c++) {
+		for (s = 0; s < used_streams; s++) {
+			sndinfo.snd_sid = (uint16_t)(((long)s * number_of_streams) / used_streams);
+			if (usrsctp_sendv(clients[c], buffer, sizeof(buffer), NULL, 0,
+			                  &sndinfo, (socklen_t)sizeof(struct sctp_sndinfo),
+			                  SCTP_SENDV_SNDINFO, 0) < 0) {
+				perror("usrsctp_sendv");
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+	/* Wait until all messages have been delivered to the server. */
+	for (i = 0; i < number_of_associations * used_streams; i++) {
+		infolen = 0;
+		infotype = 0;
+		flags = 0;
+		n = usrsctp_recvv(server, buffer, sizeof(buffer), NULL, NULL, NULL, &infolen, &infotype, &flags);
+		if (n < 0) {
+			perror("usrsctp_recvv");
+			exit(EXIT_FAILURE);
+		}
+		if ((flags & MSG_EOR) == 0) {
+			i--;
+		}
+	}
+	used = heap_in_use();
+
+	printf("%d associations, %d streams negotiated, %d streams used\n",
+	       number_of_associations, number_of_streams, used_streams);
+	report("established:", base, established, 2 * number_of_associations);
+	report("after sending:", base, used, 2 * number_of_associations);
+	print_assoc_mem_stats("client", clients[0], 0);
+	print_assoc_mem_stats("server", server, SCTP_ALL_ASSOC);
+	printf("Memory accounted by the stack:\n");
+	print_mem_stats();
+
+	if (idle_time > 0) {
+		/* A pass runs every idle_time ms, so two of them are enough. */
+		sleep((unsigned int)(2 * idle_time / 1000 + 1));
+		compacted = heap_in_use();
+		usrsctp_get_stat(&stat);
+		printf("%u associations compacted\n", stat.sctps_idle_compactions);
+		report("after compaction:", base, compacted, 2 * number_of_associations);
+		print_assoc_mem_stats("client", clients[0], 0);
+		print_assoc_mem_stats("server", server, SCTP_ALL_ASSOC);
+		printf("Memory accounted by the stack:\n");
+		print_mem_stats();
+	}
+
+	for (c = 0; c < number_of_associations; c++) {
+		usrsctp_close(clients[c]);
+	}
+	free(clients);
+	usrsctp_close(server);
+	mutex_lock(&queue_mutex);
+	stop = 1;
+	cond_signal(&queue_cond);
+	mutex_unlock(&queue_mutex);
+#ifdef _WIN32
+	WaitForSingleObject(tid, INFINITE);
+#else
+	pthread_join(tid, NULL);
+#endif
+	usrsctp_deregister_address((void *)&link_client);
+	usrsctp_deregister_address((void *)&link_server);
+	while (usrsctp_finish() != 0) {
+#ifdef _WIN32
+		Sleep(1000);
+#else
+		sleep(1);
+#endif
+	}
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,597 @@
+/*
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Compares the goodput of congestion control modules over an emulated
+ * path. A single association is set up via AF_CONN through an in-memory
+ * link. In the direction of the data the link has a bottleneck with the
+ * given rate and a drop tail buffer, drops packets at random with the
+ * given probability and delays them by the given one-way delay. In the
+ * reverse direction packets are only delayed. The client sends as fast
+ * as it can for the given time, the goodput is derived from the number
+ * of bytes delivered to the server.
+ */
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <unistd.h>
+#else
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+#include <usrsctp.h>
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION mutex_t;
+typedef HANDLE thread_t;
+#define mutex_init(m) InitializeCriticalSection(m)
+#define mutex_lock(m) EnterCriticalSection(m)
+#define mutex_unlock(m) LeaveCriticalSection(m)
+#define sleep_us(us) Sleep(((us) + 999) / 1000)
+#else
+typedef pthread_mutex_t mutex_t;
+typedef pthread_t thread_t;
+#define mutex_init(m) pthread_mutex_init(m, NULL)
+#define mutex_lock(m) pthread_mutex_lock(m)
+#define mutex_unlock(m) pthread_mutex_unlock(m)
+#define sleep_us(us) usleep(us)
+#endif
+
+#define SERVER_PORT 5001
+#define MAX_MESSAGE_SIZE 65536
+#define BUFFER_SIZE (32 * 1024 * 1024)
+#define MAX_CHUNKS_ON_QUEUE 65536
+
+char Usage[] =
+"Usage: bench_cc [options] [loss in percent ...]\n"
+"Options:\n"
+"        -r             bottleneck rate in Mbit/s (default 50)\n"
+"        -d             one-way delay in ms (default 20)\n"
+"        -q             bottleneck buffer in KB (default one BDP)\n"
+"        -m             message size (default 8192)\n"
+"        -t             duration of each run in seconds (default 10)\n"
+"        -T             write a cwnd, retransmission and timer trace to the file\n"
+"        -l             also report the given percentile of the RTT and of the\n"
+"                       send to ack latency of the messages, e.g. 99\n"
+;
+
+static const double default_loss[] = { 0.0, 0.1, 1.0, 2.0 };
+
+static const struct {
+	uint32_t id;
+	const char *name;
+} modules[] = {
+	{ SCTP_CC_RFC2581, "RFC2581" },
+	{ SCTP_CC_BBR, "BBR" },
+	{ SCTP_CC_CUBIC, "CUBIC" },
+};
+
+struct packet {
+	struct packet *next;
+	void *addr;
+	double due;
+	size_t length;
+	char data[];
+};
+
+struct direction {
+	struct packet *head, *tail;
+	double busy_until;
+};
+
+/*
+ * The two ends of the in-memory link. A packet sent to one of them is
+ * received on the other one.
+ */
+static int link_client, link_server;
+
+static struct direction forward, reverse;
+static mutex_t link_mutex;
+static double link_rate, link_delay, link_loss;
+static size_t link_buffer;
+static unsigned long lost, overflowed;
+static volatile int stop;
+static uint64_t received;
+static mutex_t received_mutex;
+static FILE *trace_file;
+static double percentile;
+static struct sctp_assoc_perf_stats perf_stats;
+static struct sctp_trace_event trace_events[1024];
+
+static double
+now(void)
+{
+#ifdef _WIN32
+	return ((double)GetTickCount64() / 1000.0);
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return ((double)tv.tv_sec + (double)tv.tv_usec / 1000000.0);
+#endif
+}
+
+static void
+link_flush(struct direction *dir)
+{
+	struct packet *packet;
+
+	while ((packet = dir->head) != NULL) {
+		dir->head = packet->next;
+		free(packet);
+	}
+	dir->tail = NULL;
+	dir->busy_until = 0.0;
+}
+
+static void
+trace_drain(void)
+{
+	int n;
+
+	while ((n = usrsctp_trace_read(trace_events, (int)(sizeof(trace_events) / sizeof(trace_events[0])))) > 0) {
+		fwrite(trace_events, sizeof(struct sctp_trace_event), (size_t)n, trace_file);
+	}
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+#else
+static void *
+#endif
+handle_packets(void *arg)
+{
+	struct direction *dir;
+	struct packet *packet;
+
+	for (;;) {
+		mutex_lock(&link_mutex);
+		if (stop) {
+			mutex_unlock(&link_mutex);
+			break;
+		}
+		/* Deliver the packet which is due first. */
+		if ((forward.head != NULL) &&
+		    ((reverse.head == NULL) || (forward.head->due <= reverse.head->due))) {
+			dir = &forward;
+		} else {
+			dir = &reverse;
+		}
+		packet = NULL;
+		if ((dir->head != NULL) && (dir->head->due <= now())) {
+			packet = dir->head;
+			dir->head = packet->next;
+			if (dir->head == NULL) {
+				dir->tail = NULL;
+			}
+		}
+		mutex_unlock(&link_mutex);
+		if (trace_file != NULL) {
+			trace_drain();
+		}
+		if (packet != NULL) {
+			usrsctp_conninput(packet->addr, packet->data, packet->length, 0);
+			free(packet);
+		} else {
+			sleep_us(100);
+		}
+	}
+#ifdef _WIN32
+	return (0);
+#else
+	return (NULL);
+#endif
+}
+
+static int
+conn_output(void *addr, void *buf, size_t length, uint8_t tos, uint8_t set_df)
+{
+	struct direction *dir;
+	struct packet *packet;
+	double t, start;
+
+	packet = malloc(sizeof(struct packet) + length);
+	if (packet == NULL) {
+		return (ENOMEM);
+	}
+	packet->next = NULL;
+	packet->addr = (addr == &link_client) ? (void *)&link_server : (void *)&link_client;
+	packet->length = length;
+	memcpy(packet->data, buf, length);
+	mutex_lock(&link_mutex);
+	t = now();
+	if (addr == &link_client) {
+		dir = &forward;
+		if ((double)rand() / RAND_MAX < link_loss) {
+			lost++;
+			mutex_unlock(&link_mutex);
+			free(packet);
+			return (0);
+		}
+		start = (dir->busy_until > t) ? dir->busy_until : t;
+		if ((start - t) * link_rate > (double)link_buffer) {
+			overflowed++;
+			mutex_unlock(&link_mutex);
+			free(packet);
+			return (0);
+		}
+		dir->busy_until = start + (double)length / link_rate;
+		packet->due = dir->busy_until + link_delay;
+	} else {
+		dir = &reverse;
+		packet->due = t + link_delay;
+	}
+	if (dir->tail == NULL) {
+		dir->head = packet;
+	} else {
+		dir->tail->next = packet;
+	}
+	dir->tail = packet;
+	mutex_unlock(&link_mutex);
+	return (0);
+}
+
+static int
+receive_cb(struct socket *sock, union sctp_sockstore addr, void *data,
+           size_t datalen, struct sctp_rcvinfo rcv, int flags, void *ulp_info)
+{
+	if (data != NULL) {
+		mutex_lock(&received_mutex);
+		received += datalen;
+		mutex_unlock(&received_mutex);
+		free(data);
+	}
+	return (1);
+}
+
+/*
+ * Returns the lower bound of the bucket holding the given percentile,
+ * in milliseconds.
+ */
+static double
+hist_percentile(const struct sctp_perf_histogram *hist, double p)
+{
+	uint64_t target, sum;
+	int i;
+
+	if (hist->sph_count == 0) {
+		return (0.0);
+	}
+	target = (uint64_t)(p / 100.0 * (double)hist->sph_count);
+	if (target == 0) {
+		target = 1;
+	}
+	sum = 0;
+	for (i = 0; i < SCTP_PERF_HIST_BUCKETS; i++) {
+		sum += hist->sph_buckets[i];
+		if (sum >= target) {
+			break;
+		}
+	}
+	if (i == SCTP_PERF_HIST_BUCKETS) {
+		i--;
+	}
+	return ((double)SCTP_PERF_HIST_BUCKET_LOW(i) / 1000.0);
+}
+
+/*
+ * Returns the goodput in Mbit/s or a negative value on failure.
+ */
+static double
+run(uint32_t module, double loss, size_t message_size, int duration)
+{
+	struct socket *sock;
+	struct sockaddr_conn sconn;
+	struct linger linger;
+	struct sctp_assoc_value av;
+	struct sctp_sndinfo sndinfo;
+	char *buffer;
+	uint64_t bytes;
+	double start, elapsed;
+	socklen_t optlen;
+	int sndbuf;
+
+	mutex_lock(&link_mutex);
+	link_loss = loss / 100.0;
+	lost = 0;
+	overflowed = 0;
+	srand(1);
+	mutex_unlock(&link_mutex);
+	if ((buffer = malloc(message_size)) == NULL) {
+		perror("malloc");
+		return (-1.0);
+	}
+	memset(buffer, 'A', message_size);
+	if ((sock = usrsctp_socket(AF_CONN, SOCK_STREAM, IPPROTO_SCTP, NULL, NULL, 0, NULL)) == NULL) {
+		perror("usrsctp_socket");
+		free(buffer);
+		return (-1.0);
+	}
+	memset(&sconn, 0, sizeof(struct sockaddr_conn));
+	sconn.sconn_family = AF_CONN;
+#ifdef HAVE_SCONN_LEN
+	sconn.sconn_len = sizeof(struct sockaddr_conn);
+#endif
+	sconn.sconn_port = htons(0);
+	sconn.sconn_addr = &link_client;
+	if (usrsctp_bind(sock, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_bind");
+		usrsctp_close(sock);
+		free(buffer);
+		return (-1.0);
+	}
+	linger.l_onoff = 1;
+	linger.l_linger = 0;
+	usrsctp_setsockopt(sock, SOL_SOCKET, SO_LINGER, &linger, (socklen_t)sizeof(struct linger));
+	sndbuf = BUFFER_SIZE;
+	if (usrsctp_setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, (socklen_t)sizeof(int)) < 0) {
+		perror("setsockopt SO_SNDBUF");
+	}
+	av.assoc_id = SCTP_FUTURE_ASSOC;
+	av.assoc_value = module;
+	if (usrsctp_setsockopt(sock, IPPROTO_SCTP, SCTP_PLUGGABLE_CC, &av, (socklen_t)sizeof(struct sctp_assoc_value)) < 0) {
+		perror("setsockopt SCTP_PLUGGABLE_CC");
+		usrsctp_close(sock);
+		free(buffer);
+		return (-1.0);
+	}
+	sconn.sconn_port = htons(SERVER_PORT);
+	if (usrsctp_connect(sock, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_connect");
+		usrsctp_close(sock);
+		free(buffer);
+		return (-1.0);
+	}
+	memset(&sndinfo, 0, sizeof(struct sctp_sndinfo));
+	mutex_lock(&received_mutex);
+	received = 0;
+	mutex_unlock(&received_mutex);
+	start = now();
+	do {
+		if (usrsctp_sendv(sock, buffer, message_size, NULL, 0,
+		                  &sndinfo, (socklen_t)sizeof(struct sctp_sndinfo),
+		                  SCTP_SENDV_SNDINFO, 0) < 0) {
+			perror("usrsctp_sendv");
+			break;
+		}
+		elapsed = now() - start;
+	} while (elapsed < duration);
+	mutex_lock(&received_mutex);
+	bytes = received;
+	mutex_unlock(&received_mutex);
+	elapsed = now() - start;
+	memset(&perf_stats, 0, sizeof(struct sctp_assoc_perf_stats));
+	optlen = (socklen_t)sizeof(struct sctp_assoc_perf_stats);
+	if (usrsctp_getsockopt(sock, IPPROTO_SCTP, SCTP_GET_ASSOC_PERF_STATS, &perf_stats, &optlen) < 0) {
+		perror("getsockopt SCTP_GET_ASSOC_PERF_STATS");
+	}
+	usrsctp_close(sock);
+	free(buffer);
+	/* Let the ABORT reach the peer and forget about the rest. */
+	sleep_us((unsigned int)(3 * link_delay * 1000000.0));
+	mutex_lock(&link_mutex);
+	link_flush(&forward);
+	link_flush(&reverse);
+	mutex_unlock(&link_mutex);
+	return ((double)bytes * 8.0 / elapsed / 1000000.0);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct socket *server;
+	struct sockaddr_conn sconn;
+	thread_t tid;
+	double rate, delay, loss, goodput;
+	size_t message_size, buffer_kb, m, nmodules;
+	int i, j, duration, rcvbuf, nloss;
+#ifdef _WIN32
+	WSADATA wsaData;
+#endif
+
+	rate = 50.0;
+	delay = 20.0;
+	buffer_kb = 0;
+	message_size = 8192;
+	duration = 10;
+	for (i = 1; i < argc; i++) {
+		if (argv[i][0] != '-') {
+			break;
+		}
+		if ((argv[i][1] == '\0') || (argv[i][2] != '\0') || (i + 1 == argc)) {
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+		switch (argv[i][1]) {
+		case 'r':
+			rate = atof(argv[++i]);
+			break;
+		case 'd':
+			delay = atof(argv[++i]);
+			break;
+		case 'q':
+			buffer_kb = (size_t)atoi(argv[++i]);
+			break;
+		case 'm':
+			message_size = (size_t)atoi(argv[++i]);
+			break;
+		case 't':
+			duration = atoi(argv[++i]);
+			break;
+		case 'l':
+			percentile = atof(argv[++i]);
+			break;
+		case 'T':
+			if ((trace_file = fopen(argv[++i], "wb")) == NULL) {
+				perror(argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		default:
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if ((rate <= 0.0) || (delay < 0.0) || (message_size < 1) ||
+	    (message_size > MAX_MESSAGE_SIZE) || (duration < 1) ||
+	    (percentile < 0.0) || (percentile > 100.0)) {
+		printf("%s", Usage);
+		exit(EXIT_FAILURE);
+	}
+	link_rate = rate * 1000000.0 / 8.0;
+	link_delay = delay / 1000.0;
+	if (buffer_kb == 0) {
+		link_buffer = (size_t)(link_rate * 2.0 * link_delay);
+	} else {
+		link_buffer = buffer_kb * 1024;
+	}
+#ifdef _WIN32
+	if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0) {
+		printf("WSAStartup failed\n");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	mutex_init(&link_mutex);
+	mutex_init(&received_mutex);
+	usrsctp_init(0, conn_output, NULL);
+	/* Don't let the number of queued chunks limit the cwnd. */
+	usrsctp_sysctl_set_sctp_max_chunks_on_queue(MAX_CHUNKS_ON_QUEUE);
+	if (trace_file != NULL) {
+		usrsctp_sysctl_set_sctp_logging_level(SCTP_CWND_LOGGING_ENABLE |
+		                                      SCTP_RTX_LOGGING_ENABLE |
+		                                      SCTP_TIMER_LOGGING_ENABLE);
+	}
+	if (percentile > 0.0) {
+		usrsctp_sysctl_set_sctp_perf_stats_enable(1);
+	}
+#ifdef _WIN32
+	tid = CreateThread(NULL, 0, &handle_packets, NULL, 0, NULL);
+#else
+	if (pthread_create(&tid, NULL, &handle_packets, NULL)) {
+		perror("pthread_create");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	usrsctp_register_address((void *)&link_client);
+	usrsctp_register_address((void *)&link_server);
+
+	if ((server = usrsctp_socket(AF_CONN, SOCK_SEQPACKET, IPPROTO_SCTP, receive_cb, NULL, 0, NULL)) == NULL) {
+		perror("usrsctp_socket");
+		exit(EXIT_FAILURE);
+	}
+	rcvbuf = BUFFER_SIZE;
+	if (usrsctp_setsockopt(server, SOL_SOCKET, SO_RCVBUF, &rcvbuf, (socklen_t)sizeof(int)) < 0) {
+		perror("setsockopt SO_RCVBUF");
+	}
+	memset(&sconn, 0, sizeof(struct sockaddr_conn));
+	sconn.sconn_family = AF_CONN;
+#ifdef HAVE_SCONN_LEN
+	sconn.sconn_len = sizeof(struct sockaddr_conn);
+#endif
+	sconn.sconn_port = htons(SERVER_PORT);
+	sconn.sconn_addr = &link_server;
+	if (usrsctp_bind(server, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_bind");
+		exit(EXIT_FAILURE);
+	}
+	if (usrsctp_listen(server, 1) < 0) {
+		perror("usrsctp_listen");
+		exit(EXIT_FAILURE);
+	}
+
+	printf("bottleneck %.1f Mbit/s, one-way delay %.1f ms, buffer %u KB, %u byte messages\n",
+	       rate, delay, (unsigned int)(link_buffer / 1024), (unsigned int)message_size);
+	nloss = (i < argc) ? argc - i : (int)(sizeof(default_loss) / sizeof(default_loss[0]));
+	nmodules = sizeof(modules) / sizeof(modules[0]);
+	for (j = 0; j < nloss; j++) {
+		loss = (i < argc) ? atof(argv[i + j]) : default_loss[j];
+		printf("loss %5.2f%%:", loss);
+		for (m = 0; m < nmodules; m++) {
+			goodput = run(modules[m].id, loss, message_size, duration);
+			printf(" %s %7.2f Mbit/s (%lu lost, %lu overflowed",
+			       modules[m].name, goodput, lost, overflowed);
+			if (percentile > 0.0) {
+				printf(", p%g rtt %.1f ms, send to ack %.1f ms",
+				       percentile,
+				       hist_percentile(&perf_stats.sps_rtt, percentile),
+				       hist_percentile(&perf_stats.sps_send_to_ack, percentile));
+			}
+			printf(")%s", (m + 1 < nmodules) ? "," : "\n");
+			fflush(stdout);
+		}
+	}
+
+	usrsctp_close(server);
+	mutex_lock(&link_mutex);
+	stop = 1;
+	mutex_unlock(&link_mutex);
+#ifdef _WIN32
+	WaitForSingleObject(tid, INFINITE);
+#else
+	pthread_join(tid, NULL);
+#endif
+	mutex_lock(&link_mutex);
+	link_flush(&forward);
+	link_flush(&reverse);
+	mutex_unlock(&link_mutex);
+	usrsctp_deregister_address((void *)&link_client);
+	usrsctp_deregister_address((void *)&link_server);
+	for (;;) {
+		if (trace_file != NULL) {
+			trace_drain();
+		}
+		if (usrsctp_finish() == 0) {
+			break;
+		}
+#ifdef _WIN32
+		Sleep(1000);
+#else
+		sleep(1);
+#endif
+	}
+	if (trace_file != NULL) {
+		fclose(trace_file);
+	}
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Measures the number of association setups per second a single listening
+ * endpoint can handle. Client threads repeatedly create a socket, connect
+ * to the server, and abort the association. All packets are exchanged via
+ * AF_CONN through an in-memory queue, so the numbers reflect the stack and
+ * not the network.
+ */
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <unistd.h>
+#else
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+#include <usrsctp.h>
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+typedef HANDLE thread_t;
+#define mutex_init(m) InitializeCriticalSection(m)
+#define mutex_lock(m) EnterCriticalSection(m)
+#define mutex_unlock(m) LeaveCriticalSection(m)
+#define cond_init(c) InitializeConditionVariable(c)
+#define cond_wait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define cond_signal(c) WakeConditionVariable(c)
+#define sleep(s) Sleep((s) * 1000)
+#else
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+typedef pthread_t thread_t;
+#define mutex_init(m) pthread_mutex_init(m, NULL)
+#define mutex_lock(m) pthread_mutex_lock(m)
+#define mutex_unlock(m) pthread_mutex_unlock(m)
+#define cond_init(c) pthread_cond_init(c, NULL)
+#define cond_wait(c, m) pthread_cond_wait(c, m)
+#define cond_signal(c) pthread_cond_signal(c)
+#endif
+
+#define SERVER_PORT 5001
+#define MAX_CLIENTS 64
+
+char Usage[] =
+"Usage: bench_handshake [options]\n"
+"Options:\n"
+"        -c             number of client threads (default 1)\n"
+"        -t             duration of the test in seconds (default 5)\n"
+"        -w             vtag time wait in seconds (default stack default)\n"
+;
+
+struct packet {
+	struct packet *next;
+	void *addr;
+	size_t length;
+	char data[];
+};
+
+/*
+ * The two ends of the in-memory link. A packet sent to one of them is
+ * received on the other one.
+ */
+static int link_client, link_server;
+
+static struct packet *queue_head, *queue_tail;
+static mutex_t queue_mutex;
+static cond_t queue_cond;
+static volatile int done, stop;
+
+struct client {
+	thread_t tid;
+	unsigned long handshakes;
+	unsigned long failures;
+};
+
+static struct client clients[MAX_CLIENTS];
+
+#ifdef _WIN32
+static DWORD WINAPI
+#else
+static void *
+#endif
+handle_packets(void *arg)
+{
+	struct packet *packet;
+
+	for (;;) {
+		mutex_lock(&queue_mutex);
+		while ((queue_head == NULL) && !stop) {
+			cond_wait(&queue_cond, &queue_mutex);
+		}
+		packet = queue_head;
+		if (packet != NULL) {
+			queue_head = packet->next;
+			if (queue_head == NULL) {
+				queue_tail = NULL;
+			}
+		}
+		mutex_unlock(&queue_mutex);
+		if (packet == NULL) {
+			break;
+		}
+		usrsctp_conninput(packet->addr, packet->data, packet->length, 0);
+		free(packet);
+	}
+#ifdef _WIN32
+	return (0);
+#else
+	return (NULL);
+#endif
+}
+
+static int
+conn_output(void *addr, void *buf, size_t length, uint8_t tos, uint8_t set_df)
+{
+	struct packet *packet;
+
+	packet = malloc(sizeof(struct packet) + length);
+	if (packet == NULL) {
+		return (ENOMEM);
+	}
+	packet->next = NULL;
+	packet->addr = (addr == &link_client) ? (void *)&link_server : (void *)&link_client;
+	packet->length = length;
+	memcpy(packet->data, buf, length);
+	mutex_lock(&queue_mutex);
+	if (queue_tail == NULL) {
+		queue_head = packet;
+	} else {
+		queue_tail->next = packet;
+	}
+	queue_tail = packet;
+	cond_signal(&queue_cond);
+	mutex_unlock(&queue_mutex);
+	return (0);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+#else
+static void *
+#endif
+run_client(void *arg)
+{
+	struct client *client;
+	struct socket *sock;
+	struct sockaddr_conn sconn;
+	struct linger linger;
+
+	client = (struct client *)arg;
+	linger.l_onoff = 1;
+	linger.l_linger = 0;
+	while (!done) {
+		if ((sock = usrsctp_socket(AF_CONN, SOCK_STREAM, IPPROTO_SCTP, NULL, NULL, 0, NULL)) == NULL) {
+			client->failures++;
+			continue;
+		}
+		memset(&sconn, 0, sizeof(struct sockaddr_conn));
+		sconn.sconn_family = AF_CONN;
+#ifdef HAVE_SCONN_LEN
+		sconn.sconn_len = sizeof(struct sockaddr_conn);
+#endif
+		sconn.sconn_port = htons(0);
+		sconn.sconn_addr = &link_client;
+		if (usrsctp_bind(sock, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+			client->failures++;
+			usrsctp_close(sock);
+			continue;
+		}
+		/* Abort the association when closing the socket. */
+		usrsctp_setsockopt(sock, SOL_SOCKET, SO_LINGER, &linger, (socklen_t)sizeof(struct linger));
+		sconn.sconn_port = htons(SERVER_PORT);
+		if (usrsctp_connect(sock, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+			client->failures++;
+		} else {
+			client->handshakes++;
+		}
+		usrsctp_close(sock);
+	}
+#ifdef _WIN32
+	return (0);
+#else
+	return (NULL);
+#endif
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct socket *server;
+	struct sockaddr_conn sconn;
+	thread_t tid;
+	unsigned long handshakes, failures;
+	int i, c, number_of_clients, duration, time_wait;
+#ifdef _WIN32
+	WSADATA wsaData;
+#endif
+
+	number_of_clients = 1;
+	duration = 5;
+	time_wait = -1;
+	for (i = 1; i < argc; i++) {
+		if ((argv[i][0] != '-') || (argv[i][1] == '\0') || (argv[i][2] != '\0')) {
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+		if ((argv[i][1] != 'h') && (i + 1 == argc)) {
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+		switch (argv[i][1]) {
+		case 'c':
+			number_of_clients = atoi(argv[++i]);
+			break;
+		case 't':
+			duration = atoi(argv[++i]);
+			break;
+		case 'w':
+			time_wait = atoi(argv[++i]);
+			break;
+		default:
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if ((number_of_clients < 1) || (number_of_clients > MAX_CLIENTS) || (duration < 1)) {
+		printf("%s", Usage);
+		exit(EXIT_FAILURE);
+	}
+#ifdef _WIN32
+	if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0) {
+		printf("WSAStartup failed\n");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	mutex_init(&queue_mutex);
+	cond_init(&queue_cond);
+	usrsctp_init(0, conn_output, NULL);
+	if (time_wait >= 0) {
+		usrsctp_sysctl_set_sctp_vtag_time_wait((uint32_t)time_wait);
+	}
+#ifdef _WIN32
+	tid = CreateThread(NULL, 0, &handle_packets, NULL, 0, NULL);
+#else
+	if (pthread_create(&tid, NULL, &handle_packets, NULL)) {
+		perror("pthread_create");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	usrsctp_register_address((void *)&link_client);
+	usrsctp_register_address((void *)&link_server);
+
+	if ((server = usrsctp_socket(AF_CONN, SOCK_SEQPACKET, IPPROTO_SCTP, NULL, NULL, 0, NULL)) == NULL) {
+		perror("usrsctp_socket");
+		exit(EXIT_FAILURE);
+	}
+	memset(&sconn, 0, sizeof(struct sockaddr_conn));
+	sconn.sconn_family = AF_CONN;
+#ifdef HAVE_SCONN_LEN
+	sconn.sconn_len = sizeof(struct sockaddr_conn);
+#endif
+	sconn.sconn_port = htons(SERVER_PORT);
+	sconn.sconn_addr = &link_server;
+	if (usrsctp_bind(server, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_bind");
+		exit(EXIT_FAILURE);
+	}
+	if (usrsctp_listen(server, 1) < 0) {
+		perror("usrsctp_listen");
+		exit(EXIT_FAILURE);
+	}
+
+	for (c = 0; c < number_of_clients; c++) {
+#ifdef _WIN32
+		clients[c].tid = CreateThread(NULL, 0, &run_client, &clients[c], 0, NULL);
+#else
+		if (pthread_create(&clients[c].tid, NULL, &run_client, &clients[c])) {
+			perror("pthread_create");
+			exit(EXIT_FAILURE);
+		}
+#endif
+	}
+	sleep(duration);
+	done = 1;
+	for (c = 0; c < number_of_clients; c++) {
+#ifdef _WIN32
+		WaitForSingleObject(clients[c].tid, INFINITE);
+#else
+		pthread_join(clients[c].tid, NULL);
+#endif
+	}
+	handshakes = 0;
+	failures = 0;
+	for (c = 0; c < number_of_clients; c++) {
+		handshakes += clients[c].handshakes;
+		failures += clients[c].failures;
+	}
+	printf("%d client(s), %d s: %lu handshakes (%.0f/s), %lu failures\n",
+	       number_of_clients, duration, handshakes,
+	       (double)handshakes / duration, failures);
+
+	usrsctp_close(server);
+	mutex_lock(&queue_mutex);
+	stop = 1;
+	cond_signal(&queue_cond);
+	mutex_unlock(&queue_mutex);
+#ifdef _WIN32
+	WaitForSingleObject(tid, INFINITE);
+#else
+	pthread_join(tid, NULL);
+#endif
+	usrsctp_deregister_address((void *)&link_client);
+	usrsctp_deregister_address((void *)&link_server);
+	while (usrsctp_finish() != 0) {
+#ifdef _WIN32
+		Sleep(1000);
+#else
+		sleep(1);
+#endif
+	}
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Micro benchmark for the HMAC code used by SCTP-AUTH and for signing
+ * state cookies. It checks the implementation against the test vectors
+ * of RFC 2202 (HMAC-SHA1) and RFC 4231 (HMAC-SHA256) and compares the
+ * throughput of computing the HMAC from the key on every call with the
+ * throughput when using the precomputed inner and outer state cached
+ * with the key.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+/*
+ * These are not part of the usrsctp API, but are exported by the library.
+ */
+extern void *sctp_set_key(uint8_t *, uint32_t);
+extern void sctp_free_key(void *);
+extern uint32_t sctp_hmac(uint16_t, uint8_t *, uint32_t, uint8_t *, uint32_t, uint8_t *);
+extern uint32_t sctp_compute_hmac(uint16_t, void *, uint8_t *, uint32_t, uint8_t *);
+
+#define HMAC_SHA1   0x0001
+#define HMAC_SHA256 0x0003
+
+#define MAX_DIGEST_LEN 32
+#define DEFAULT_ITERATIONS 200000
+
+struct test_vector {
+	uint16_t algo;
+	const char *key;
+	uint32_t keylen;
+	const char *data;
+	uint32_t datalen;
+	const char *digest;
+};
+
+static const struct test_vector test_vectors[] = {
+	/* RFC 2202, test cases 1, 2 and 6 */
+	{ HMAC_SHA1,
+	  "\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b", 20,
+	  "Hi There", 8,
+	  "b617318655057264e28bc0b6fb378c8ef146be00" },
+	{ HMAC_SHA1,
+	  "Jefe", 4,
+	  "what do ya want for nothing?", 28,
+	  "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79" },
+	{ HMAC_SHA1,
+	  NULL, 80,
+	  "Test Using Larger Than Block-Size Key - Hash Key First", 54,
+	  "aa4ae5e15272d00e95705637ce8a3b55ed402112" },
+	/* RFC 4231, test cases 1, 2 and 6 */
+	{ HMAC_SHA256,
+	  "\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b\x0b", 20,
+	  "Hi There", 8,
+	  "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7" },
+	{ HMAC_SHA256,
+	  "Jefe", 4,
+	  "what do ya want for nothing?", 28,
+	  "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" },
+	{ HMAC_SHA256,
+	  NULL, 131,
+	  "Test Using Larger Than Block-Size Key - Hash Key First", 54,
+	  "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54" },
+};
+
+static const uint32_t sizes[] = { 64, 256, 1024, 1452 };
+
+static double
+now(void)
+{
+#ifdef _WIN32
+	return ((double)GetTickCount64() / 1000.0);
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return ((double)tv.tv_sec + (double)tv.tv_usec / 1000000.0);
+#endif
+}
+
+static const char *
+algo_name(uint16_t algo)
+{
+	switch (algo) {
+	case HMAC_SHA1:
+		return ("HMAC-SHA1");
+	case HMAC_SHA256:
+		return ("HMAC-SHA256");
+	default:
+		return ("unknown");
+	}
+}
+
+static void
+to_hex(const uint8_t *digest, uint32_t len, char *hex)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+	}
+}
+
+/*
+ * Returns 1 on success, 0 if the algorithm is not supported and -1
+ * if a digest did not match.
+ */
+static int
+check_vectors(uint16_t algo)
+{
+	uint8_t key[131], digest[MAX_DIGEST_LEN];
+	char hex[2 * MAX_DIGEST_LEN + 1];
+	void *cached_key;
+	const struct test_vector *tv;
+	uint32_t len;
+	size_t i;
+
+	for (i = 0; i < sizeof(test_vectors) / sizeof(test_vectors[0]); i++) {
+		tv = &test_vectors[i];
+		if (tv->algo != algo) {
+			continue;
+		}
+		if (tv->key == NULL) {
+			memset(key, 0xaa, tv->keylen);
+		} else {
+			memcpy(key, tv->key, tv->keylen);
+		}
+		len = sctp_hmac(algo, key, tv->keylen, (uint8_t *)tv->data, tv->datalen, digest);
+		if (len == 0) {
+			return (0);
+		}
+		to_hex(digest, len, hex);
+		if (strcmp(hex, tv->digest) != 0) {
+			printf("%s: test vector %u failed (uncached): %s\n", algo_name(algo), (unsigned int)i, hex);
+			return (-1);
+		}
+		/* Run the cached path twice, the first call sets up the state. */
+		cached_key = sctp_set_key(key, tv->keylen);
+		sctp_compute_hmac(algo, cached_key, (uint8_t *)tv->data, tv->datalen, digest);
+		memset(digest, 0, sizeof(digest));
+		len = sctp_compute_hmac(algo, cached_key, (uint8_t *)tv->data, tv->datalen, digest);
+		sctp_free_key(cached_key);
+		to_hex(digest, len, hex);
+		if (strcmp(hex, tv->digest) != 0) {
+			printf("%s: test vector %u failed (cached): %s\n", algo_name(algo), (unsigned int)i, hex);
+			return (-1);
+		}
+	}
+	return (1);
+}
+
+static void
+run_benchmark(uint16_t algo, unsigned long iterations)
+{
+	uint8_t key[32], digest[MAX_DIGEST_LEN];
+	uint8_t *data;
+	void *cached_key;
+	double start, uncached, cached;
+	unsigned long i;
+	size_t s;
+
+	memset(key, 0x5a, sizeof(key));
+	data = malloc(sizes[sizeof(sizes) / sizeof(sizes[0]) - 1]);
+	if (data == NULL) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	memset(data, 0xa5, sizes[sizeof(sizes) / sizeof(sizes[0]) - 1]);
+	cached_key = sctp_set_key(key, sizeof(key));
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		start = now();
+		for (i = 0; i < iterations; i++) {
+			sctp_hmac(algo, key, sizeof(key), data, sizes[s], digest);
+		}
+		uncached = now() - start;
+		start = now();
+		for (i = 0; i < iterations; i++) {
+			sctp_compute_hmac(algo, cached_key, data, sizes[s], digest);
+		}
+		cached = now() - start;
+		printf("%-12s %5u bytes: uncached %10.0f ops/s, cached %10.0f ops/s, speedup %.2f\n",
+		       algo_name(algo), sizes[s],
+		       uncached > 0.0 ? iterations / uncached : 0.0,
+		       cached > 0.0 ? iterations / cached : 0.0,
+		       cached > 0.0 ? uncached / cached : 0.0);
+	}
+	sctp_free_key(cached_key);
+	free(data);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const uint16_t algos[] = { HMAC_SHA1, HMAC_SHA256 };
+	unsigned long iterations;
+	size_t i;
+	int result;
+
+	if (argc > 1) {
+		iterations = strtoul(argv[1], NULL, 10);
+	} else {
+		iterations = DEFAULT_ITERATIONS;
+	}
+	for (i = 0; i < sizeof(algos) / sizeof(algos[0]); i++) {
+		result = check_vectors(algos[i]);
+		if (result < 0) {
+			return (EXIT_FAILURE);
+		}
+		if (result == 0) {
+			printf("%s: not supported by this build\n", algo_name(algos[i]));
+			continue;
+		}
+		printf("%s: test vectors passed\n", algo_name(algos[i]));
+		run_benchmark(algos[i], iterations);
+	}
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Bulk transfer over an emulated path. A single association between two
+ * AF_CONN endpoints carries the given number of bytes through a pair of
+ * netem links, one per direction, which add delay, jitter, loss,
+ * reordering and a rate limit with a finite queue. The stack runs on a
+ * virtual clock and everything, including the timers, runs in the main
+ * thread: whenever nothing can be sent, the clock jumps to the next packet
+ * arrival or timer, whichever is first. A run therefore takes as long as
+ * the computation needs, not as long as the emulated transfer, and is
+ * repeatable for a given seed.
+ *
+ * Reports the goodput, the link statistics, the retransmissions and the
+ * ratio between the virtual and the wall clock time.
+ */
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#else
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+#include <usrsctp.h>
+#include "netem.h"
+
+#define SERVER_PORT 5001
+
+/*
+ * Each side of the association uses its endpoint as its AF_CONN address:
+ * packets passed to conn_output() for an endpoint leave on its link and are
+ * handed to usrsctp_conninput() with the peer endpoint as address.
+ */
+struct endpoint {
+	struct netem_link *out;
+	struct endpoint *peer;
+};
+
+static struct endpoint endpoints[2];
+static uint64_t bytes_received;
+
+static const char *Usage =
+	"Usage: bench_netem [options]\n"
+	"Options:\n"
+	"        -d delay        one way delay in ms (default 50)\n"
+	"        -j jitter       delay jitter in ms (default 0)\n"
+	"        -l loss         random loss in percent (default 0)\n"
+	"        -b percent      probability of starting a loss burst in percent (default 0)\n"
+	"        -B packets      mean length of a loss burst (default 3)\n"
+	"        -r reorder      reordering in percent (default 0)\n"
+	"        -R rate         link rate in kbit/s, 0 for unlimited (default 10000)\n"
+	"        -q bytes        queue limit in bytes, 0 for unlimited (default 64000)\n"
+	"        -n bytes        number of bytes to transfer (default 10000000)\n"
+	"        -s size         message size (default 1200)\n"
+	"        -S seed         seed of the link emulation (default 1)\n"
+	"        -t seconds      limit of the virtual time (default 600)\n";
+
+static double
+wall_clock(void)
+{
+#ifdef _WIN32
+	return ((double)GetTickCount64() / 1000.0);
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return ((double)tv.tv_sec + (double)tv.tv_usec / 1000000.0);
+#endif
+}
+
+static int
+conn_output(void *addr, void *buf, size_t length, uint8_t tos, uint8_t set_df)
+{
+	struct endpoint *ep;
+
+	ep = (struct endpoint *)addr;
+	/* A loss is not an error for the stack. */
+	netem_send(ep->out, usrsctp_get_clock(), buf, length);
+	return (0);
+}
+
+static void
+deliver(void *arg, const void *buf, size_t len)
+{
+	usrsctp_conninput(arg, buf, len, 0);
+}
+
+static int
+receive_cb(struct socket *sock, union sctp_sockstore addr, void *data,
+           size_t datalen, struct sctp_rcvinfo rcv, int flags, void *ulp_info)
+{
+	if (data != NULL) {
+		if ((flags & MSG_NOTIFICATION) == 0) {
+			bytes_received += datalen;
+		}
+		free(data);
+	}
+	return (1);
+}
+
+/*
+ * Lets the virtual time pass until the next event, but not beyond limit.
+ * Returns 0 if the limit was reached.
+ */
+static int
+step(uint64_t limit)
+{
+	uint64_t now, next, due;
+	int i;
+
+	now = usrsctp_get_clock();
+	next = usrsctp_next_timer();
+	for (i = 0; i < 2; i++) {
+		due = netem_next_due(endpoints[i].out);
+		if (due < next) {
+			next = due;
+		}
+	}
+	if (next > limit) {
+		usrsctp_advance_clock(limit - now);
+		return (0);
+	}
+	if (next > now) {
+		usrsctp_advance_clock(next - now);
+	} else {
+		usrsctp_advance_clock(0);
+	}
+	now = usrsctp_get_clock();
+	for (i = 0; i < 2; i++) {
+		netem_deliver(endpoints[i].out, now);
+	}
+	return (1);
+}
+
+static int
+is_established(struct socket *sock)
+{
+	struct sctp_status status;
+	socklen_t len;
+
+	len = (socklen_t)sizeof(struct sctp_status);
+	memset(&status, 0, sizeof(struct sctp_status));
+	if (usrsctp_getsockopt(sock, IPPROTO_SCTP, SCTP_STATUS, &status, &len) < 0) {
+		return (0);
+	}
+	return (status.sstat_state == SCTP_ESTABLISHED);
+}
+
+static struct socket *
+create_socket(struct endpoint *ep, uint16_t port)
+{
+	struct socket *sock;
+	struct sockaddr_conn sconn;
+	struct sctp_paddrparams paddrparams;
+	const int on = 1;
+
+	if ((sock = usrsctp_socket(AF_CONN, SOCK_STREAM, IPPROTO_SCTP, receive_cb, NULL, 0, NULL)) == NULL) {
+		perror("usrsctp_socket");
+		exit(EXIT_FAILURE);
+	}
+	if (usrsctp_setsockopt(sock, IPPROTO_SCTP, SCTP_NODELAY, &on, (socklen_t)sizeof(int)) < 0) {
+		perror("usrsctp_setsockopt SCTP_NODELAY");
+		exit(EXIT_FAILURE);
+	}
+	/*
+	 * The heartbeat interval is randomized by the stack, which does not use
+	 * the seed of the links. Disable them to keep runs repeatable.
+	 */
+	memset(&paddrparams, 0, sizeof(struct sctp_paddrparams));
+	paddrparams.spp_flags = SPP_HB_DISABLE;
+	if (usrsctp_setsockopt(sock, IPPROTO_SCTP, SCTP_PEER_ADDR_PARAMS, &paddrparams, (socklen_t)sizeof(struct sctp_paddrparams)) < 0) {
+		perror("usrsctp_setsockopt SCTP_PEER_ADDR_PARAMS");
+		exit(EXIT_FAILURE);
+	}
+	if (usrsctp_set_non_blocking(sock, 1) < 0) {
+		perror("usrsctp_set_non_blocking");
+		exit(EXIT_FAILURE);
+	}
+	memset(&sconn, 0, sizeof(struct sockaddr_conn));
+	sconn.sconn_family = AF_CONN;
+#ifdef HAVE_SCONN_LEN
+	sconn.sconn_len = sizeof(struct sockaddr_conn);
+#endif
+	sconn.sconn_port = htons(port);
+	sconn.sconn_addr = ep;
+	if (usrsctp_bind(sock, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_bind");
+		exit(EXIT_FAILURE);
+	}
+	return (sock);
+}
+
+static void
+print_link(const char *name, struct netem_link *link)
+{
+	struct netem_stats stats;
+
+	netem_get_stats(link, &stats);
+	printf("%s: %llu packets sent, %llu delivered, %llu lost, %llu lost in bursts, %llu dropped by the queue, %llu reordered\n",
+	       name,
+	       (unsigned long long)stats.packets_in,
+	       (unsigned long long)stats.packets_out,
+	       (unsigned long long)stats.lost_random,
+	       (unsigned long long)stats.lost_burst,
+	       (unsigned long long)stats.dropped_queue,
+	       (unsigned long long)stats.reordered);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct netem_params params;
+	struct sctpstat stat;
+	struct sctp_sndinfo sndinfo;
+	struct sockaddr_conn sconn;
+	struct socket *listener, *client, *server;
+	struct linger linger;
+	uint64_t bytes, bytes_sent, seed, start, limit, elapsed;
+	double wall_start, wall;
+	char *buffer;
+	size_t size;
+	ssize_t n;
+	int i;
+#ifdef _WIN32
+	WSADATA wsaData;
+#endif
+
+	memset(&params, 0, sizeof(struct netem_params));
+	params.delay = 50000;
+	params.burst_length = 3.0;
+	params.rate = 10000000 / 8;
+	params.queue_limit = 64000;
+	bytes = 10000000;
+	size = 1200;
+	seed = 1;
+	limit = 600;
+	for (i = 1; i < argc; i++) {
+		if ((argv[i][0] != '-') || (argv[i][1] == '\0') || (argv[i][2] != '\0') || (i + 1 == argc)) {
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+		switch (argv[i][1]) {
+		case 'd':
+			params.delay = (uint64_t)(atof(argv[++i]) * 1000.0);
+			break;
+		case 'j':
+			params.jitter = (uint64_t)(atof(argv[++i]) * 1000.0);
+			break;
+		case 'l':
+			params.loss = atof(argv[++i]) / 100.0;
+			break;
+		case 'b':
+			params.burst_enter = atof(argv[++i]) / 100.0;
+			break;
+		case 'B':
+			params.burst_length = atof(argv[++i]);
+			break;
+		case 'r':
+			params.reorder = atof(argv[++i]) / 100.0;
+			break;
+		case 'R':
+			params.rate = strtoull(argv[++i], NULL, 10) * 1000 / 8;
+			break;
+		case 'q':
+			params.queue_limit = (size_t)strtoul(argv[++i], NULL, 10);
+			break;
+		case 'n':
+			bytes = strtoull(argv[++i], NULL, 10);
+			break;
+		case 's':
+			size = (size_t)strtoul(argv[++i], NULL, 10);
+			break;
+		case 'S':
+			seed = strtoull(argv[++i], NULL, 10);
+			break;
+		case 't':
+			limit = strtoull(argv[++i], NULL, 10);
+			break;
+		default:
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if ((size == 0) || (bytes == 0) || (limit == 0)) {
+		printf("%s", Usage);
+		exit(EXIT_FAILURE);
+	}
+	if ((buffer = malloc(size)) == NULL) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	memset(buffer, 'A', size);
+#ifdef _WIN32
+	if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0) {
+		printf("WSAStartup failed\n");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	for (i = 0; i < 2; i++) {
+		endpoints[i].peer = &endpoints[1 - i];
+	}
+	for (i = 0; i < 2; i++) {
+		endpoints[i].out = netem_link_create(&params, seed + (uint64_t)i, deliver, endpoints[i].peer);
+		if (endpoints[i].out == NULL) {
+			perror("netem_link_create");
+			exit(EXIT_FAILURE);
+		}
+	}
+	usrsctp_init_virtual_clock(0, conn_output, NULL);
+	usrsctp_sysctl_set_sctp_ecn_enable(0);
+	usrsctp_register_address(&endpoints[0]);
+	usrsctp_register_address(&endpoints[1]);
+
+	listener = create_socket(&endpoints[1], SERVER_PORT);
+	if (usrsctp_listen(listener, 1) < 0) {
+		perror("usrsctp_listen");
+		exit(EXIT_FAILURE);
+	}
+	client = create_socket(&endpoints[0], 0);
+	memset(&sconn, 0, sizeof(struct sockaddr_conn));
+	sconn.sconn_family = AF_CONN;
+#ifdef HAVE_SCONN_LEN
+	sconn.sconn_len = sizeof(struct sockaddr_conn);
+#endif
+	sconn.sconn_port = htons(SERVER_PORT);
+	sconn.sconn_addr = &endpoints[0];
+	if ((usrsctp_connect(client, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) &&
+	    (errno != EINPROGRESS)) {
+		perror("usrsctp_connect");
+		exit(EXIT_FAILURE);
+	}
+
+	wall_start = wall_clock();
+	start = usrsctp_get_clock();
+	limit = start + limit * 1000000;
+	server = NULL;
+	bytes_sent = 0;
+	memset(&sndinfo, 0, sizeof(struct sctp_sndinfo));
+	sndinfo.snd_flags = SCTP_EOR;
+	while (bytes_received < bytes) {
+		if (server == NULL) {
+			server = usrsctp_accept(listener, NULL, NULL);
+		}
+		while ((bytes_sent < bytes) && is_established(client)) {
+			n = usrsctp_sendv(client, buffer, size, NULL, 0,
+			                  &sndinfo, (socklen_t)sizeof(struct sctp_sndinfo), SCTP_SENDV_SNDINFO, 0);
+			if (n < 0) {
+				if (errno != EWOULDBLOCK) {
+					perror("usrsctp_sendv");
+					exit(EXIT_FAILURE);
+				}
+				break;
+			}
+			bytes_sent += (uint64_t)n;
+		}
+		if (!step(limit)) {
+			printf("Virtual time limit reached.\n");
+			break;
+		}
+	}
+	elapsed = usrsctp_get_clock() - start;
+	wall = wall_clock() - wall_start;
+
+	memset(&stat, 0, sizeof(struct sctpstat));
+	usrsctp_get_stat(&stat);
+	printf("Transferred %llu bytes in %.3f s of virtual time, goodput %.3f Mbit/s\n",
+	       (unsigned long long)bytes_received, (double)elapsed / 1000000.0,
+	       elapsed > 0 ? (double)bytes_received * 8.0 / (double)elapsed : 0.0);
+	print_link("forward", endpoints[0].out);
+	print_link("reverse", endpoints[1].out);
+	printf("Retransmitted %u DATA chunks, %u by fast retransmit, %u T3 timeouts\n",
+	       stat.sctps_sendretransdata, stat.sctps_sendfastretrans, stat.sctps_timodata);
+	printf("Wall clock %.3f s, %.1f times faster than real time\n",
+	       wall, wall > 0.0 ? (double)elapsed / 1000000.0 / wall : 0.0);
+
+	/* Abort, there is nothing left to say. */
+	linger.l_onoff = 1;
+	linger.l_linger = 0;
+	usrsctp_setsockopt(client, SOL_SOCKET, SO_LINGER, &linger, (socklen_t)sizeof(struct linger));
+	usrsctp_close(client);
+	if (server != NULL) {
+		usrsctp_close(server);
+	}
+	usrsctp_close(listener);
+	usrsctp_deregister_address(&endpoints[0]);
+	usrsctp_deregister_address(&endpoints[1]);
+	/* Without a timer thread the clock must run for the sockets to go away. */
+	while (usrsctp_finish() != 0) {
+		step(UINT64_MAX);
+	}
+	for (i = 0; i < 2; i++) {
+		netem_link_destroy(endpoints[i].out);
+	}
+	free(buffer);
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,483 @@
+/*
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Measures the rate of scheduling decisions of a stream scheduler as a
+ * function of the number of outgoing streams. A single association is
+ * set up via AF_CONN through an in-memory queue, the priorities (or
+ * weights) of the streams are set to one of a number of levels and
+ * small messages are sent on all streams in turn, so that each message
+ * results in one DATA chunk and therefore in one scheduling decision.
+ * To make sure that all streams have data queued, the delivery of
+ * packets is paused while the send buffer is filled and resumed
+ * afterwards until the peer has received all messages. The rate includes
+ * adding the streams to the scheduler when filling the send buffer and
+ * selecting them when draining it.
+ */
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <unistd.h>
+#else
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+#include <usrsctp.h>
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+typedef HANDLE thread_t;
+#define mutex_init(m) InitializeCriticalSection(m)
+#define mutex_lock(m) EnterCriticalSection(m)
+#define mutex_unlock(m) LeaveCriticalSection(m)
+#define cond_init(c) InitializeConditionVariable(c)
+#define cond_wait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define cond_signal(c) WakeConditionVariable(c)
+#else
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+typedef pthread_t thread_t;
+#define mutex_init(m) pthread_mutex_init(m, NULL)
+#define mutex_lock(m) pthread_mutex_lock(m)
+#define mutex_unlock(m) pthread_mutex_unlock(m)
+#define cond_init(c) pthread_cond_init(c, NULL)
+#define cond_wait(c, m) pthread_cond_wait(c, m)
+#define cond_signal(c) pthread_cond_signal(c)
+#endif
+
+#define SERVER_PORT 5001
+#define MAX_MESSAGE_SIZE 1024
+#define SEND_BUFFER_SIZE (16 * 1024 * 1024)
+
+char Usage[] =
+"Usage: bench_scheduler [options] [number of streams ...]\n"
+"Options:\n"
+"        -s             stream scheduler (default 3, SCTP_SS_PRIORITY)\n"
+"        -l             number of priority levels or weights (default 4)\n"
+"        -m             message size (default 64)\n"
+"        -t             duration of each run in seconds (default 2)\n"
+;
+
+static const int default_streams[] = { 1, 16, 256, 1024, 4096, 16384, 65535 };
+
+struct packet {
+	struct packet *next;
+	void *addr;
+	size_t length;
+	char data[];
+};
+
+/*
+ * The two ends of the in-memory link. A packet sent to one of them is
+ * received on the other one.
+ */
+static int link_client, link_server;
+
+static struct packet *queue_head, *queue_tail;
+static mutex_t queue_mutex;
+static cond_t queue_cond;
+static volatile int stop, paused;
+static unsigned long received, expected;
+static mutex_t received_mutex;
+static cond_t received_cond;
+
+static double
+now(void)
+{
+#ifdef _WIN32
+	return ((double)GetTickCount64() / 1000.0);
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return ((double)tv.tv_sec + (double)tv.tv_usec / 1000000.0);
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+#else
+static void *
+#endif
+handle_packets(void *arg)
+{
+	struct packet *packet;
+
+	for (;;) {
+		mutex_lock(&queue_mutex);
+		while (((queue_head == NULL) || paused) && !stop) {
+			cond_wait(&queue_cond, &queue_mutex);
+		}
+		packet = queue_head;
+		if (packet != NULL) {
+			queue_head = packet->next;
+			if (queue_head == NULL) {
+				queue_tail = NULL;
+			}
+		}
+		mutex_unlock(&queue_mutex);
+		if (packet == NULL) {
+			break;
+		}
+		usrsctp_conninput(packet->addr, packet->data, packet->length, 0);
+		free(packet);
+	}
+#ifdef _WIN32
+	return (0);
+#else
+	return (NULL);
+#endif
+}
+
+static int
+conn_output(void *addr, void *buf, size_t length, uint8_t tos, uint8_t set_df)
+{
+	struct packet *packet;
+
+	packet = malloc(sizeof(struct packet) + length);
+	if (packet == NULL) {
+		return (ENOMEM);
+	}
+	packet->next = NULL;
+	packet->addr = (addr == &link_client) ? (void *)&link_server : (void *)&link_client;
+	packet->length = length;
+	memcpy(packet->data, buf, length);
+	mutex_lock(&queue_mutex);
+	if (queue_tail == NULL) {
+		queue_head = packet;
+	} else {
+		queue_tail->next = packet;
+	}
+	queue_tail = packet;
+	cond_signal(&queue_cond);
+	mutex_unlock(&queue_mutex);
+	return (0);
+}
+
+static int
+receive_cb(struct socket *sock, union sctp_sockstore addr, void *data,
+           size_t datalen, struct sctp_rcvinfo rcv, int flags, void *ulp_info)
+{
+	if (data != NULL) {
+		mutex_lock(&received_mutex);
+		if (++received == expected) {
+			cond_signal(&received_cond);
+		}
+		mutex_unlock(&received_mutex);
+		free(data);
+	}
+	return (1);
+}
+
+/*
+ * Returns the number of messages per second or a negative value on
+ * failure.
+ */
+static double
+run(int streams, int scheduler, int levels, size_t message_size, int duration)
+{
+	struct socket *sock;
+	struct sockaddr_conn sconn;
+	struct linger linger;
+	struct sctp_initmsg initmsg;
+	struct sctp_assoc_value av;
+	struct sctp_stream_value sv;
+	struct sctp_status status;
+	struct sctp_sndinfo sndinfo;
+	char buffer[MAX_MESSAGE_SIZE];
+	socklen_t len;
+	unsigned long messages;
+	double start, elapsed;
+	int i, sid, sndbuf;
+
+	sndbuf = SEND_BUFFER_SIZE;
+	if ((sock = usrsctp_socket(AF_CONN, SOCK_STREAM, IPPROTO_SCTP, NULL, NULL, 0, NULL)) == NULL) {
+		perror("usrsctp_socket");
+		return (-1.0);
+	}
+	memset(&sconn, 0, sizeof(struct sockaddr_conn));
+	sconn.sconn_family = AF_CONN;
+#ifdef HAVE_SCONN_LEN
+	sconn.sconn_len = sizeof(struct sockaddr_conn);
+#endif
+	sconn.sconn_port = htons(0);
+	sconn.sconn_addr = &link_client;
+	if (usrsctp_bind(sock, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_bind");
+		usrsctp_close(sock);
+		return (-1.0);
+	}
+	linger.l_onoff = 1;
+	linger.l_linger = 0;
+	usrsctp_setsockopt(sock, SOL_SOCKET, SO_LINGER, &linger, (socklen_t)sizeof(struct linger));
+	/* Allow enough messages to be queued to keep all streams busy. */
+	if (usrsctp_setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, (socklen_t)sizeof(int)) < 0) {
+		perror("setsockopt SO_SNDBUF");
+	}
+	memset(&initmsg, 0, sizeof(struct sctp_initmsg));
+	initmsg.sinit_num_ostreams = (uint16_t)streams;
+	if (usrsctp_setsockopt(sock, IPPROTO_SCTP, SCTP_INITMSG, &initmsg, (socklen_t)sizeof(struct sctp_initmsg)) < 0) {
+		perror("setsockopt SCTP_INITMSG");
+	}
+	av.assoc_id = SCTP_FUTURE_ASSOC;
+	av.assoc_value = (uint32_t)scheduler;
+	if (usrsctp_setsockopt(sock, IPPROTO_SCTP, SCTP_PLUGGABLE_SS, &av, (socklen_t)sizeof(struct sctp_assoc_value)) < 0) {
+		perror("setsockopt SCTP_PLUGGABLE_SS");
+		usrsctp_close(sock);
+		return (-1.0);
+	}
+	sconn.sconn_port = htons(SERVER_PORT);
+	if (usrsctp_connect(sock, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_connect");
+		usrsctp_close(sock);
+		return (-1.0);
+	}
+	len = (socklen_t)sizeof(struct sctp_status);
+	memset(&status, 0, sizeof(struct sctp_status));
+	if (usrsctp_getsockopt(sock, IPPROTO_SCTP, SCTP_STATUS, &status, &len) < 0) {
+		perror("getsockopt SCTP_STATUS");
+		usrsctp_close(sock);
+		return (-1.0);
+	}
+	if (status.sstat_outstrms < streams) {
+		streams = status.sstat_outstrms;
+	}
+	for (i = 0; i < streams; i++) {
+		sv.assoc_id = SCTP_CURRENT_ASSOC;
+		sv.stream_id = (uint16_t)i;
+		if (scheduler == SCTP_SS_WFQ) {
+			/* Weights must be positive. */
+			sv.stream_value = (uint16_t)(i % levels + 1);
+		} else {
+			sv.stream_value = (uint16_t)(i % levels);
+		}
+		usrsctp_setsockopt(sock, IPPROTO_SCTP, SCTP_SS_VALUE, &sv, (socklen_t)sizeof(struct sctp_stream_value));
+	}
+	usrsctp_set_non_blocking(sock, 1);
+	memset(buffer, 'A', sizeof(buffer));
+	memset(&sndinfo, 0, sizeof(struct sctp_sndinfo));
+	sid = 0;
+	mutex_lock(&received_mutex);
+	received = 0;
+	expected = 0;
+	mutex_unlock(&received_mutex);
+	messages = 0;
+	start = now();
+	do {
+		/* Fill the send buffer while no packets are delivered. */
+		mutex_lock(&queue_mutex);
+		paused = 1;
+		mutex_unlock(&queue_mutex);
+		for (;;) {
+			sndinfo.snd_sid = (uint16_t)sid;
+			if (usrsctp_sendv(sock, buffer, message_size, NULL, 0,
+			                  &sndinfo, (socklen_t)sizeof(struct sctp_sndinfo),
+			                  SCTP_SENDV_SNDINFO, 0) < 0) {
+				if ((errno == EWOULDBLOCK) || (errno == EAGAIN)) {
+					break;
+				}
+				perror("usrsctp_sendv");
+				usrsctp_close(sock);
+				return (-1.0);
+			}
+			messages++;
+			if (++sid == streams) {
+				sid = 0;
+			}
+		}
+		/* Drain it. */
+		mutex_lock(&received_mutex);
+		expected = messages;
+		mutex_unlock(&received_mutex);
+		mutex_lock(&queue_mutex);
+		paused = 0;
+		cond_signal(&queue_cond);
+		mutex_unlock(&queue_mutex);
+		mutex_lock(&received_mutex);
+		while (received < expected) {
+			cond_wait(&received_cond, &received_mutex);
+		}
+		mutex_unlock(&received_mutex);
+		elapsed = now() - start;
+	} while (elapsed < duration);
+	usrsctp_close(sock);
+	printf("%6d streams: %10lu messages in %.2f s, %10.0f decisions/s\n",
+	       streams, messages, elapsed, messages / elapsed);
+	return (messages / elapsed);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct socket *server;
+	struct sockaddr_conn sconn;
+	struct sctp_initmsg initmsg;
+	thread_t tid;
+	int i, scheduler, levels, duration, streams, nstreams;
+	size_t message_size;
+#ifdef _WIN32
+	WSADATA wsaData;
+#endif
+
+	scheduler = SCTP_SS_PRIORITY;
+	levels = 4;
+	message_size = 64;
+	duration = 2;
+	for (i = 1; i < argc; i++) {
+		if (argv[i][0] != '-') {
+			break;
+		}
+		if ((argv[i][1] == '\0') || (argv[i][2] != '\0') || (i + 1 == argc)) {
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+		switch (argv[i][1]) {
+		case 's':
+			scheduler = atoi(argv[++i]);
+			break;
+		case 'l':
+			levels = atoi(argv[++i]);
+			break;
+		case 'm':
+			message_size = (size_t)atoi(argv[++i]);
+			break;
+		case 't':
+			duration = atoi(argv[++i]);
+			break;
+		default:
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if ((levels < 1) || (message_size < 1) || (message_size > MAX_MESSAGE_SIZE) || (duration < 1)) {
+		printf("%s", Usage);
+		exit(EXIT_FAILURE);
+	}
+#ifdef _WIN32
+	if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0) {
+		printf("WSAStartup failed\n");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	mutex_init(&queue_mutex);
+	cond_init(&queue_cond);
+	mutex_init(&received_mutex);
+	cond_init(&received_cond);
+	usrsctp_init(0, conn_output, NULL);
+#ifdef _WIN32
+	tid = CreateThread(NULL, 0, &handle_packets, NULL, 0, NULL);
+#else
+	if (pthread_create(&tid, NULL, &handle_packets, NULL)) {
+		perror("pthread_create");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	usrsctp_register_address((void *)&link_client);
+	usrsctp_register_address((void *)&link_server);
+
+	if ((server = usrsctp_socket(AF_CONN, SOCK_SEQPACKET, IPPROTO_SCTP, receive_cb, NULL, 0, NULL)) == NULL) {
+		perror("usrsctp_socket");
+		exit(EXIT_FAILURE);
+	}
+	memset(&initmsg, 0, sizeof(struct sctp_initmsg));
+	initmsg.sinit_max_instreams = 65535;
+	if (usrsctp_setsockopt(server, IPPROTO_SCTP, SCTP_INITMSG, &initmsg, (socklen_t)sizeof(struct sctp_initmsg)) < 0) {
+		perror("setsockopt SCTP_INITMSG");
+	}
+	memset(&sconn, 0, sizeof(struct sockaddr_conn));
+	sconn.sconn_family = AF_CONN;
+#ifdef HAVE_SCONN_LEN
+	sconn.sconn_len = sizeof(struct sockaddr_conn);
+#endif
+	sconn.sconn_port = htons(SERVER_PORT);
+	sconn.sconn_addr = &link_server;
+	if (usrsctp_bind(server, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_bind");
+		exit(EXIT_FAILURE);
+	}
+	if (usrsctp_listen(server, 1) < 0) {
+		perror("usrsctp_listen");
+		exit(EXIT_FAILURE);
+	}
+
+	printf("scheduler %d, %d level(s), %u byte messages\n",
+	       scheduler, levels, (unsigned int)message_size);
+	if (i < argc) {
+		for (; i < argc; i++) {
+			streams = atoi(argv[i]);
+			if ((streams < 1) || (streams > 65535)) {
+				printf("%s", Usage);
+				exit(EXIT_FAILURE);
+			}
+			run(streams, scheduler, levels, message_size, duration);
+		}
+	} else {
+		nstreams = (int)(sizeof(default_streams) / sizeof(default_streams[0]));
+		for (i = 0; i < nstreams; i++) {
+			run(default_streams[i], scheduler, levels, message_size, duration);
+		}
+	}
+
+	usrsctp_close(server);
+	mutex_lock(&queue_mutex);
+	stop = 1;
+	cond_signal(&queue_cond);
+	mutex_unlock(&queue_mutex);
+#ifdef _WIN32
+	WaitForSingleObject(tid, INFINITE);
+#else
+	pthread_join(tid, NULL);
+#endif
+	usrsctp_deregister_address((void *)&link_client);
+	usrsctp_deregister_address((void *)&link_server);
+	while (usrsctp_finish() != 0) {
+#ifdef _WIN32
+		Sleep(1000);
+#else
+		sleep(1);
+#endif
+	}
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,880 @@
+/*
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Throughput benchmark for many associations driven by many threads.
+ * Every association runs between a one-to-one client socket and one of
+ * the one-to-many server sockets, all packets are exchanged via AF_CONN
+ * through in-memory queues, so the kernel is not involved and the
+ * numbers reflect the stack only. Associations are partitioned into
+ * groups, one per thread: each group has its own sender thread, its own
+ * server socket, its own packet thread and, when not using the receive
+ * callback, its own receiver thread calling usrsctp_recvv().
+ *
+ * For each message size the test runs for the given time and reports
+ * the messages and bits per second delivered, the CPU time used by the
+ * process per byte and percentiles of the latency from the call to
+ * usrsctp_sendv() until the message is delivered.
+ */
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+#include <usrsctp.h>
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+typedef HANDLE thread_t;
+#define mutex_init(m) InitializeCriticalSection(m)
+#define mutex_lock(m) EnterCriticalSection(m)
+#define mutex_unlock(m) LeaveCriticalSection(m)
+#define cond_init(c) InitializeConditionVariable(c)
+#define cond_wait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+#define cond_signal(c) WakeConditionVariable(c)
+#define sleep(s) Sleep((s) * 1000)
+#else
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+typedef pthread_t thread_t;
+#define mutex_init(m) pthread_mutex_init(m, NULL)
+#define mutex_lock(m) pthread_mutex_lock(m)
+#define mutex_unlock(m) pthread_mutex_unlock(m)
+#define cond_init(c) pthread_cond_init(c, NULL)
+#define cond_wait(c, m) pthread_cond_wait(c, m)
+#define cond_signal(c) pthread_cond_signal(c)
+#endif
+
+#define SERVER_PORT 5001
+#define MAX_THREADS 64
+#define MAX_ASSOCS 4096
+#define MAX_SIZES 32
+#define MIN_MESSAGE_SIZE 16
+#define MAX_MESSAGE_SIZE 65536
+#define RECV_BUFFER_SIZE 65536
+
+/* Latency histogram with 8 buckets per power of two, in nanoseconds. */
+#define HIST_SUB_BITS 3
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) << HIST_SUB_BITS)
+
+enum output_format {
+	OUTPUT_TEXT,
+	OUTPUT_CSV,
+	OUTPUT_JSON
+};
+
+char Usage[] =
+"Usage: bench_throughput [options]\n"
+"Options:\n"
+"        -a             number of associations (default 1)\n"
+"        -m             number of threads (default 1)\n"
+"        -s             comma separated list of message sizes (default 1024)\n"
+"        -t             duration of the test per message size in seconds (default 5)\n"
+"        -u             send unordered messages\n"
+"        -C             use the receive callback instead of usrsctp_recvv()\n"
+"        -o             output format: text, csv or json (default text)\n"
+;
+
+/* Put at the beginning of every message. */
+struct message_header {
+	uint64_t sent;
+	uint32_t phase;
+	uint32_t pad;
+};
+
+struct packet {
+	struct packet *next;
+	size_t length;
+	char data[];
+};
+
+/* Reassembly state of a message delivered in pieces. */
+struct partial {
+	uint64_t sent;
+	uint32_t phase;
+	int in_message;
+};
+
+struct group {
+	/* Used as the AF_CONN address of all sockets in the group. */
+	int index;
+	struct socket *server;
+	struct socket *clients[MAX_ASSOCS];
+	int number_of_clients;
+	thread_t sender_tid, receiver_tid, packet_tid;
+	/* The packet queue. */
+	mutex_t queue_mutex;
+	cond_t queue_cond;
+	struct packet *queue_head, *queue_tail;
+	/* Only used by the thread receiving for the group. */
+	struct partial *partials;
+	int number_of_partials;
+	char *recv_buffer;
+	/* Protected by mutex. */
+	mutex_t mutex;
+	cond_t cond;
+	int remaining;
+	uint64_t messages;
+	uint64_t bytes;
+	uint64_t histogram[HIST_BUCKETS];
+};
+
+static struct group groups[MAX_THREADS];
+static int number_of_groups;
+static volatile int done, stop;
+static volatile uint32_t phase;
+static volatile uint32_t message_size;
+static int unordered;
+
+static uint64_t
+now_ns(void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+
+	if (freq.QuadPart == 0) {
+		QueryPerformanceFrequency(&freq);
+	}
+	QueryPerformanceCounter(&now);
+	return ((uint64_t)(now.QuadPart / freq.QuadPart) * 1000000000 +
+	        (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart);
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+/* Returns the user and system CPU time used by the process in nanoseconds. */
+static uint64_t
+cpu_ns(void)
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	ULARGE_INTEGER k, u;
+
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+		return (0);
+	}
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	return ((k.QuadPart + u.QuadPart) * 100);
+#else
+	struct rusage ru;
+
+	if (getrusage(RUSAGE_SELF, &ru) < 0) {
+		return (0);
+	}
+	return ((uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000 +
+	        (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000);
+#endif
+}
+
+static int
+hist_bucket(uint64_t value)
+{
+	int msb;
+
+	if (value < (1 << HIST_SUB_BITS)) {
+		return ((int)value);
+	}
+	msb = 63;
+	while ((value & ((uint64_t)1 << msb)) == 0) {
+		msb--;
+	}
+	return (((msb - HIST_SUB_BITS + 1) << HIST_SUB_BITS) +
+	        (int)((value >> (msb - HIST_SUB_BITS)) & ((1 << HIST_SUB_BITS) - 1)));
+}
+
+static uint64_t
+hist_bucket_low(int bucket)
+{
+	int shift;
+
+	if (bucket < (1 << HIST_SUB_BITS)) {
+		return ((uint64_t)bucket);
+	}
+	shift = (bucket >> HIST_SUB_BITS) - 1;
+	return ((uint64_t)((1 << HIST_SUB_BITS) + (bucket & ((1 << HIST_SUB_BITS) - 1))) << shift);
+}
+
+/* Returns the lower bound of the bucket containing the p-th percentile. */
+static uint64_t
+hist_percentile(const uint64_t *histogram, uint64_t count, double p)
+{
+	uint64_t rank, sum;
+	int i;
+
+	if (count == 0) {
+		return (0);
+	}
+	rank = (uint64_t)((double)count * p / 100.0);
+	if (rank >= count) {
+		rank = count - 1;
+	}
+	sum = 0;
+	for (i = 0; i < HIST_BUCKETS; i++) {
+		sum += histogram[i];
+		if (sum > rank) {
+			return (hist_bucket_low(i));
+		}
+	}
+	return (hist_bucket_low(HIST_BUCKETS - 1));
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+#else
+static void *
+#endif
+handle_packets(void *arg)
+{
+	struct group *group;
+	struct packet *packet;
+
+	group = (struct group *)arg;
+	for (;;) {
+		mutex_lock(&group->queue_mutex);
+		while ((group->queue_head == NULL) && !stop) {
+			cond_wait(&group->queue_cond, &group->queue_mutex);
+		}
+		packet = group->queue_head;
+		if (packet != NULL) {
+			group->queue_head = packet->next;
+			if (group->queue_head == NULL) {
+				group->queue_tail = NULL;
+			}
+		}
+		mutex_unlock(&group->queue_mutex);
+		if (packet == NULL) {
+			break;
+		}
+		usrsctp_conninput(&group->index, packet->data, packet->length, 0);
+		free(packet);
+	}
+#ifdef _WIN32
+	return (0);
+#else
+	return (NULL);
+#endif
+}
+
+/*
+ * All sockets of a group use the same address, so the packets of an
+ * association always go through the same queue and stay in order.
+ */
+static int
+conn_output(void *addr, void *buf, size_t length, uint8_t tos, uint8_t set_df)
+{
+	struct group *group;
+	struct packet *packet;
+
+	group = &groups[*(int *)addr];
+	packet = malloc(sizeof(struct packet) + length);
+	if (packet == NULL) {
+		return (ENOMEM);
+	}
+	packet->next = NULL;
+	packet->length = length;
+	memcpy(packet->data, buf, length);
+	mutex_lock(&group->queue_mutex);
+	if (group->queue_tail == NULL) {
+		group->queue_head = packet;
+	} else {
+		group->queue_tail->next = packet;
+	}
+	group->queue_tail = packet;
+	cond_signal(&group->queue_cond);
+	mutex_unlock(&group->queue_mutex);
+	return (0);
+}
+
+static void
+handle_notification(struct group *group, union sctp_notification *notif, size_t n)
+{
+	if ((n < sizeof(struct sctp_assoc_change)) ||
+	    (notif->sn_header.sn_type != SCTP_ASSOC_CHANGE)) {
+		return;
+	}
+	switch (notif->sn_assoc_change.sac_state) {
+	case SCTP_COMM_LOST:
+	case SCTP_SHUTDOWN_COMP:
+		mutex_lock(&group->mutex);
+		group->remaining--;
+		cond_signal(&group->cond);
+		mutex_unlock(&group->mutex);
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+handle_data(struct group *group, sctp_assoc_t assoc_id, const char *data, size_t n, int eor)
+{
+	struct partial *partial;
+	struct message_header header;
+	uint64_t latency;
+
+	partial = &group->partials[(uint32_t)assoc_id % (uint32_t)group->number_of_partials];
+	if (!partial->in_message) {
+		if (n < sizeof(struct message_header)) {
+			return;
+		}
+		memcpy(&header, data, sizeof(struct message_header));
+		partial->sent = header.sent;
+		partial->phase = header.phase;
+		partial->in_message = 1;
+	}
+	if (!eor) {
+		return;
+	}
+	partial->in_message = 0;
+	latency = now_ns() - partial->sent;
+	mutex_lock(&group->mutex);
+	/* Messages of an earlier message size are not accounted. */
+	if (partial->phase == phase) {
+		group->messages++;
+		group->bytes += message_size;
+		group->histogram[hist_bucket(latency)]++;
+	}
+	mutex_unlock(&group->mutex);
+}
+
+static int
+receive_cb(struct socket *sock, union sctp_sockstore addr, void *data,
+           size_t datalen, struct sctp_rcvinfo rcv, int flags, void *ulp_info)
+{
+	struct group *group;
+
+	group = (struct group *)ulp_info;
+	if (data != NULL) {
+		if (flags & MSG_NOTIFICATION) {
+			handle_notification(group, (union sctp_notification *)data, datalen);
+		} else {
+			handle_data(group, rcv.rcv_assoc_id, (char *)data, datalen, flags & MSG_EOR);
+		}
+		free(data);
+	}
+	return (1);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+#else
+static void *
+#endif
+run_receiver(void *arg)
+{
+	struct group *group;
+	struct sctp_rcvinfo rcv;
+	struct sockaddr_conn from;
+	socklen_t fromlen, infolen;
+	unsigned int infotype;
+	ssize_t n;
+	int flags, remaining;
+
+	group = (struct group *)arg;
+	do {
+		fromlen = (socklen_t)sizeof(struct sockaddr_conn);
+		infolen = (socklen_t)sizeof(struct sctp_rcvinfo);
+		infotype = 0;
+		flags = 0;
+		n = usrsctp_recvv(group->server, group->recv_buffer, RECV_BUFFER_SIZE,
+		                  (struct sockaddr *)&from, &fromlen, &rcv, &infolen, &infotype, &flags);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("usrsctp_recvv");
+			break;
+		}
+		if (flags & MSG_NOTIFICATION) {
+			handle_notification(group, (union sctp_notification *)group->recv_buffer, (size_t)n);
+		} else if (infotype == SCTP_RECVV_RCVINFO) {
+			handle_data(group, rcv.rcv_assoc_id, group->recv_buffer, (size_t)n, flags & MSG_EOR);
+		}
+		mutex_lock(&group->mutex);
+		remaining = group->remaining;
+		mutex_unlock(&group->mutex);
+	} while (remaining > 0);
+#ifdef _WIN32
+	return (0);
+#else
+	return (NULL);
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+#else
+static void *
+#endif
+run_sender(void *arg)
+{
+	struct group *group;
+	struct sctp_sndinfo sndinfo;
+	struct message_header header;
+	char *buffer;
+	int c;
+
+	group = (struct group *)arg;
+	buffer = malloc(MAX_MESSAGE_SIZE);
+	if (buffer == NULL) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	memset(buffer, 'A', MAX_MESSAGE_SIZE);
+	memset(&sndinfo, 0, sizeof(struct sctp_sndinfo));
+	if (unordered) {
+		sndinfo.snd_flags = SCTP_UNORDERED;
+	}
+	memset(&header, 0, sizeof(struct message_header));
+	while (!done) {
+		for (c = 0; (c < group->number_of_clients) && !done; c++) {
+			header.phase = phase;
+			header.sent = now_ns();
+			memcpy(buffer, &header, sizeof(struct message_header));
+			if (usrsctp_sendv(group->clients[c], buffer, message_size, NULL, 0,
+			                  &sndinfo, (socklen_t)sizeof(struct sctp_sndinfo),
+			                  SCTP_SENDV_SNDINFO, 0) < 0) {
+				perror("usrsctp_sendv");
+				done = 1;
+			}
+		}
+	}
+	free(buffer);
+#ifdef _WIN32
+	return (0);
+#else
+	return (NULL);
+#endif
+}
+
+static int
+create_thread(thread_t *tid,
+#ifdef _WIN32
+              LPTHREAD_START_ROUTINE start,
+#else
+              void *(*start)(void *),
+#endif
+              void *arg)
+{
+#ifdef _WIN32
+	*tid = CreateThread(NULL, 0, start, arg, 0, NULL);
+	return ((*tid == NULL) ? -1 : 0);
+#else
+	return (pthread_create(tid, NULL, start, arg));
+#endif
+}
+
+static void
+join_thread(thread_t tid)
+{
+#ifdef _WIN32
+	WaitForSingleObject(tid, INFINITE);
+	CloseHandle(tid);
+#else
+	pthread_join(tid, NULL);
+#endif
+}
+
+static void
+setup_group(struct group *group, int use_callback)
+{
+	struct sockaddr_conn sconn;
+	struct sctp_event event;
+	const int on = 1;
+
+	mutex_init(&group->queue_mutex);
+	cond_init(&group->queue_cond);
+	mutex_init(&group->mutex);
+	cond_init(&group->cond);
+	/* Association identifiers are assigned consecutively per endpoint. */
+	group->number_of_partials = group->number_of_clients + 1;
+	group->partials = calloc((size_t)group->number_of_partials, sizeof(struct partial));
+	group->recv_buffer = malloc(RECV_BUFFER_SIZE);
+	if ((group->partials == NULL) || (group->recv_buffer == NULL)) {
+		perror("malloc");
+		exit(EXIT_FAILURE);
+	}
+	if (create_thread(&group->packet_tid, &handle_packets, group) != 0) {
+		perror("create_thread");
+		exit(EXIT_FAILURE);
+	}
+	usrsctp_register_address((void *)&group->index);
+	if ((group->server = usrsctp_socket(AF_CONN, SOCK_SEQPACKET, IPPROTO_SCTP,
+	                                    use_callback ? receive_cb : NULL,
+	                                    NULL, 0, use_callback ? group : NULL)) == NULL) {
+		perror("usrsctp_socket");
+		exit(EXIT_FAILURE);
+	}
+	memset(&event, 0, sizeof(struct sctp_event));
+	event.se_assoc_id = SCTP_FUTURE_ASSOC;
+	event.se_on = 1;
+	event.se_type = SCTP_ASSOC_CHANGE;
+	if (usrsctp_setsockopt(group->server, IPPROTO_SCTP, SCTP_EVENT, &event, (socklen_t)sizeof(struct sctp_event)) < 0) {
+		perror("usrsctp_setsockopt SCTP_EVENT");
+		exit(EXIT_FAILURE);
+	}
+	if (usrsctp_setsockopt(group->server, IPPROTO_SCTP, SCTP_RECVRCVINFO, &on, (socklen_t)sizeof(int)) < 0) {
+		perror("usrsctp_setsockopt SCTP_RECVRCVINFO");
+		exit(EXIT_FAILURE);
+	}
+	memset(&sconn, 0, sizeof(struct sockaddr_conn));
+	sconn.sconn_family = AF_CONN;
+#ifdef HAVE_SCONN_LEN
+	sconn.sconn_len = sizeof(struct sockaddr_conn);
+#endif
+	sconn.sconn_port = htons(SERVER_PORT);
+	sconn.sconn_addr = &group->index;
+	if (usrsctp_bind(group->server, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_bind");
+		exit(EXIT_FAILURE);
+	}
+	if (usrsctp_listen(group->server, 1) < 0) {
+		perror("usrsctp_listen");
+		exit(EXIT_FAILURE);
+	}
+}
+
+static struct socket *
+connect_client(struct group *group)
+{
+	struct socket *sock;
+	struct sockaddr_conn sconn;
+
+	if ((sock = usrsctp_socket(AF_CONN, SOCK_STREAM, IPPROTO_SCTP, NULL, NULL, 0, NULL)) == NULL) {
+		perror("usrsctp_socket");
+		exit(EXIT_FAILURE);
+	}
+	memset(&sconn, 0, sizeof(struct sockaddr_conn));
+	sconn.sconn_family = AF_CONN;
+#ifdef HAVE_SCONN_LEN
+	sconn.sconn_len = sizeof(struct sockaddr_conn);
+#endif
+	sconn.sconn_port = htons(0);
+	sconn.sconn_addr = &group->index;
+	if (usrsctp_bind(sock, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_bind");
+		exit(EXIT_FAILURE);
+	}
+	sconn.sconn_port = htons(SERVER_PORT);
+	if (usrsctp_connect(sock, (struct sockaddr *)&sconn, sizeof(struct sockaddr_conn)) < 0) {
+		perror("usrsctp_connect");
+		exit(EXIT_FAILURE);
+	}
+	return (sock);
+}
+
+static int
+parse_sizes(char *list, uint32_t *sizes)
+{
+	char *p, *end;
+	unsigned long size;
+	int n;
+
+	n = 0;
+	p = list;
+	while (*p != '\0') {
+		size = strtoul(p, &end, 10);
+		if ((end == p) || (size < MIN_MESSAGE_SIZE) || (size > MAX_MESSAGE_SIZE) || (n == MAX_SIZES)) {
+			return (-1);
+		}
+		sizes[n++] = (uint32_t)size;
+		if (*end == ',') {
+			end++;
+		} else if (*end != '\0') {
+			return (-1);
+		}
+		p = end;
+	}
+	return (n);
+}
+
+int
+main(int argc, char *argv[])
+{
+	enum output_format format;
+	uint32_t sizes[MAX_SIZES];
+	uint64_t histogram[HIST_BUCKETS];
+	uint64_t messages, bytes, start, elapsed, cpu_start, cpu_used;
+	double seconds, gbps, cpu_per_byte;
+	const char *api;
+	int i, j, s, g, number_of_sizes, number_of_assocs, duration, use_callback;
+#ifdef _WIN32
+	WSADATA wsaData;
+#endif
+
+	number_of_assocs = 1;
+	number_of_groups = 1;
+	number_of_sizes = 1;
+	sizes[0] = 1024;
+	duration = 5;
+	use_callback = 0;
+	format = OUTPUT_TEXT;
+	for (i = 1; i < argc; i++) {
+		if ((argv[i][0] != '-') || (argv[i][1] == '\0') || (argv[i][2] != '\0')) {
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+		if ((argv[i][1] != 'u') && (argv[i][1] != 'C') && (i + 1 == argc)) {
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+		switch (argv[i][1]) {
+		case 'a':
+			number_of_assocs = atoi(argv[++i]);
+			break;
+		case 'm':
+			number_of_groups = atoi(argv[++i]);
+			break;
+		case 's':
+			number_of_sizes = parse_sizes(argv[++i], sizes);
+			break;
+		case 't':
+			duration = atoi(argv[++i]);
+			break;
+		case 'u':
+			unordered = 1;
+			break;
+		case 'C':
+			use_callback = 1;
+			break;
+		case 'o':
+			i++;
+			if (strcmp(argv[i], "text") == 0) {
+				format = OUTPUT_TEXT;
+			} else if (strcmp(argv[i], "csv") == 0) {
+				format = OUTPUT_CSV;
+			} else if (strcmp(argv[i], "json") == 0) {
+				format = OUTPUT_JSON;
+			} else {
+				printf("%s", Usage);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		default:
+			printf("%s", Usage);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if ((number_of_groups < 1) || (number_of_groups > MAX_THREADS) ||
+	    (number_of_assocs < number_of_groups) || (number_of_assocs > MAX_ASSOCS) ||
+	    (number_of_sizes < 1) || (duration < 1)) {
+		printf("%s", Usage);
+		exit(EXIT_FAILURE);
+	}
+#ifdef _WIN32
+	if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0) {
+		printf("WSAStartup failed\n");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	usrsctp_init(0, conn_output, NULL);
+	usrsctp_sysctl_set_sctp_ecn_enable(0);
+
+	for (i = 0; i < number_of_assocs; i++) {
+		groups[i % number_of_groups].number_of_clients++;
+	}
+	for (g = 0; g < number_of_groups; g++) {
+		groups[g].index = g;
+		groups[g].remaining = groups[g].number_of_clients;
+		setup_group(&groups[g], use_callback);
+	}
+	for (g = 0; g < number_of_groups; g++) {
+		for (j = 0; j < groups[g].number_of_clients; j++) {
+			groups[g].clients[j] = connect_client(&groups[g]);
+		}
+	}
+	message_size = sizes[0];
+	for (g = 0; g < number_of_groups; g++) {
+		if (!use_callback) {
+			if (create_thread(&groups[g].receiver_tid, &run_receiver, &groups[g]) != 0) {
+				perror("create_thread");
+				exit(EXIT_FAILURE);
+			}
+		}
+		if (create_thread(&groups[g].sender_tid, &run_sender, &groups[g]) != 0) {
+			perror("create_thread");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	api = use_callback ? "callback" : "recvv";
+	if (format == OUTPUT_CSV) {
+		printf("size,associations,threads,ordered,api,msgs_per_s,gbit_per_s,cpu_ns_per_byte,"
+		       "latency_p50_us,latency_p90_us,latency_p99_us,latency_p999_us\n");
+	} else if (format == OUTPUT_JSON) {
+		printf("[\n");
+	}
+	for (s = 0; (s < number_of_sizes) && !done; s++) {
+		for (g = 0; g < number_of_groups; g++) {
+			mutex_lock(&groups[g].mutex);
+			groups[g].messages = 0;
+			groups[g].bytes = 0;
+			memset(groups[g].histogram, 0, sizeof(groups[g].histogram));
+			mutex_unlock(&groups[g].mutex);
+		}
+		message_size = sizes[s];
+		phase = (uint32_t)s + 1;
+		start = now_ns();
+		cpu_start = cpu_ns();
+		sleep(duration);
+		messages = 0;
+		bytes = 0;
+		memset(histogram, 0, sizeof(histogram));
+		/* Stop accounting for this message size. */
+		phase = 0;
+		for (g = 0; g < number_of_groups; g++) {
+			mutex_lock(&groups[g].mutex);
+			messages += groups[g].messages;
+			bytes += groups[g].bytes;
+			for (i = 0; i < HIST_BUCKETS; i++) {
+				histogram[i] += groups[g].histogram[i];
+			}
+			mutex_unlock(&groups[g].mutex);
+		}
+		elapsed = now_ns() - start;
+		cpu_used = cpu_ns() - cpu_start;
+		seconds = (double)elapsed / 1e9;
+		gbps = (double)bytes * 8.0 / seconds / 1e9;
+		cpu_per_byte = (bytes > 0) ? (double)cpu_used / (double)bytes : 0.0;
+		switch (format) {
+		case OUTPUT_TEXT:
+			printf("%5u bytes, %d association(s), %d thread(s), %s, %s: "
+			       "%.0f msgs/s, %.3f Gbit/s, %.2f CPU ns/byte, "
+			       "latency p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us\n",
+			       sizes[s], number_of_assocs, number_of_groups,
+			       unordered ? "unordered" : "ordered", api,
+			       (double)messages / seconds, gbps, cpu_per_byte,
+			       hist_percentile(histogram, messages, 50.0) / 1e3,
+			       hist_percentile(histogram, messages, 90.0) / 1e3,
+			       hist_percentile(histogram, messages, 99.0) / 1e3,
+			       hist_percentile(histogram, messages, 99.9) / 1e3);
+			break;
+		case OUTPUT_CSV:
+			printf("%u,%d,%d,%d,%s,%.0f,%.3f,%.2f,%.1f,%.1f,%.1f,%.1f\n",
+			       sizes[s], number_of_assocs, number_of_groups, !unordered, api,
+			       (double)messages / seconds, gbps, cpu_per_byte,
+			       hist_percentile(histogram, messages, 50.0) / 1e3,
+			       hist_percentile(histogram, messages, 90.0) / 1e3,
+			       hist_percentile(histogram, messages, 99.0) / 1e3,
+			       hist_percentile(histogram, messages, 99.9) / 1e3);
+			break;
+		case OUTPUT_JSON:
+			printf("  {\"size\": %u, \"associations\": %d, \"threads\": %d, \"ordered\": %s, \"api\": \"%s\", "
+			       "\"msgs_per_s\": %.0f, \"gbit_per_s\": %.3f, \"cpu_ns_per_byte\": %.2f, "
+			       "\"latency_us\": {\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"p999\": %.1f}}%s\n",
+			       sizes[s], number_of_assocs, number_of_groups, unordered ? "false" : "true", api,
+			       (double)messages / seconds, gbps, cpu_per_byte,
+			       hist_percentile(histogram, messages, 50.0) / 1e3,
+			       hist_percentile(histogram, messages, 90.0) / 1e3,
+			       hist_percentile(histogram, messages, 99.0) / 1e3,
+			       hist_percentile(histogram, messages, 99.9) / 1e3,
+			       (s + 1 < number_of_sizes) ? "," : "");
+			break;
+		}
+		fflush(stdout);
+	}
+	if (format == OUTPUT_JSON) {
+		printf("]\n");
+	}
+
+	done = 1;
+	for (g = 0; g < number_of_groups; g++) {
+		join_thread(groups[g].sender_tid);
+	}
+	/* Shut the associations down gracefully and wait until the servers saw it. */
+	for (g = 0; g < number_of_groups; g++) {
+		for (j = 0; j < groups[g].number_of_clients; j++) {
+			usrsctp_close(groups[g].clients[j]);
+		}
+	}
+	for (g = 0; g < number_of_groups; g++) {
+		if (use_callback) {
+			mutex_lock(&groups[g].mutex);
+			while (groups[g].remaining > 0) {
+				cond_wait(&groups[g].cond, &groups[g].mutex);
+			}
+			mutex_unlock(&groups[g].mutex);
+		} else {
+			join_thread(groups[g].receiver_tid);
+		}
+	}
+	/*
+	 * The receive callback runs on the packet threads, stop them before
+	 * closing the servers.
+	 */
+	stop = 1;
+	for (g = 0; g < number_of_groups; g++) {
+		mutex_lock(&groups[g].queue_mutex);
+		cond_signal(&groups[g].queue_cond);
+		mutex_unlock(&groups[g].queue_mutex);
+		join_thread(groups[g].packet_tid);
+		usrsctp_close(groups[g].server);
+		usrsctp_deregister_address((void *)&groups[g].index);
+		free(groups[g].partials);
+		free(groups[g].recv_buffer);
+	}
+	while (usrsctp_finish() != 0) {
+#ifdef _WIN32
+		Sleep(1000);
+#else
+		sleep(1);
+#endif
+	}
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return (EXIT_SUCCESS);
+}
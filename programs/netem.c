@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netem.h"
+
+struct netem_packet {
+	struct netem_packet *next;
+	uint64_t due;
+	size_t len;
+	uint8_t data[];
+};
+
+struct netem_link {
+	struct netem_params params;
+	uint64_t rng;
+	int in_burst;
+	uint64_t busy_until;
+	/* Sorted by due, packets with the same due time in FIFO order. */
+	struct netem_packet *head;
+	struct netem_packet *tail;
+	void (*deliver)(void *, const void *, size_t);
+	void *arg;
+	struct netem_stats stats;
+};
+
+/* xorshift64*, seeded with splitmix64 to avoid a zero state. */
+static uint64_t
+netem_random(struct netem_link *link)
+{
+	uint64_t x;
+
+	x = link->rng;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	link->rng = x;
+	return (x * UINT64_C(2685821657736338717));
+}
+
+static double
+netem_uniform(struct netem_link *link)
+{
+	return ((double)(netem_random(link) >> 11) * (1.0 / 9007199254740992.0));
+}
+
+struct netem_link *
+netem_link_create(const struct netem_params *params, uint64_t seed,
+                  void (*deliver)(void *, const void *, size_t), void *arg)
+{
+	struct netem_link *link;
+	uint64_t z;
+
+	link = calloc(1, sizeof(struct netem_link));
+	if (link == NULL) {
+		return (NULL);
+	}
+	link->params = *params;
+	z = seed + UINT64_C(0x9e3779b97f4a7c15);
+	z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+	z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+	z ^= z >> 31;
+	link->rng = (z != 0) ? z : 1;
+	link->deliver = deliver;
+	link->arg = arg;
+	return (link);
+}
+
+void
+netem_link_destroy(struct netem_link *link)
+{
+	struct netem_packet *p;
+
+	while ((p = link->head) != NULL) {
+		link->head = p->next;
+		free(p);
+	}
+	free(link);
+}
+
+static void
+netem_enqueue(struct netem_link *link, struct netem_packet *p)
+{
+	struct netem_packet **pp;
+
+	p->next = NULL;
+	if (link->head == NULL) {
+		link->head = p;
+		link->tail = p;
+		return;
+	}
+	if (link->tail->due <= p->due) {
+		link->tail->next = p;
+		link->tail = p;
+		return;
+	}
+	for (pp = &link->head; *pp != NULL; pp = &(*pp)->next) {
+		if ((*pp)->due > p->due) {
+			break;
+		}
+	}
+	p->next = *pp;
+	*pp = p;
+}
+
+int
+netem_send(struct netem_link *link, uint64_t now, const void *buf, size_t len)
+{
+	struct netem_params *params;
+	struct netem_packet *p;
+	uint64_t departure, backlog, jitter;
+
+	params = &link->params;
+	link->stats.packets_in++;
+	/* Gilbert-Elliott: a good and a bad state, all packets are lost in the bad one. */
+	if (params->burst_enter > 0.0) {
+		if (link->in_burst) {
+			if (params->burst_length <= 1.0 ||
+			    netem_uniform(link) < 1.0 / params->burst_length) {
+				link->in_burst = 0;
+			}
+		} else if (netem_uniform(link) < params->burst_enter) {
+			link->in_burst = 1;
+		}
+		if (link->in_burst) {
+			link->stats.lost_burst++;
+			return (-1);
+		}
+	}
+	if (params->loss > 0.0 && netem_uniform(link) < params->loss) {
+		link->stats.lost_random++;
+		return (-1);
+	}
+	if (params->rate > 0) {
+		if (link->busy_until > now) {
+			backlog = (link->busy_until - now) * params->rate / 1000000;
+		} else {
+			link->busy_until = now;
+			backlog = 0;
+		}
+		if (params->queue_limit > 0 && backlog + len > params->queue_limit) {
+			link->stats.dropped_queue++;
+			return (-1);
+		}
+		link->busy_until += ((uint64_t)len * 1000000 + params->rate - 1) / params->rate;
+		departure = link->busy_until;
+	} else {
+		departure = now;
+	}
+	p = malloc(sizeof(struct netem_packet) + len);
+	if (p == NULL) {
+		link->stats.dropped_queue++;
+		return (-1);
+	}
+	memcpy(p->data, buf, len);
+	p->len = len;
+	if (params->reorder > 0.0 && netem_uniform(link) < params->reorder) {
+		link->stats.reordered++;
+		p->due = departure;
+	} else {
+		p->due = departure + params->delay;
+		if (params->jitter > 0) {
+			jitter = netem_random(link) % (2 * params->jitter + 1);
+			if (p->due + jitter < departure + params->jitter) {
+				p->due = departure;
+			} else {
+				p->due = p->due + jitter - params->jitter;
+			}
+		}
+	}
+	netem_enqueue(link, p);
+	return (0);
+}
+
+uint64_t
+netem_next_due(const struct netem_link *link)
+{
+	if (link->head == NULL) {
+		return (UINT64_MAX);
+	}
+	return (link->head->due);
+}
+
+unsigned int
+netem_deliver(struct netem_link *link, uint64_t now)
+{
+	struct netem_packet *p;
+	unsigned int n;
+
+	n = 0;
+	while ((p = link->head) != NULL && p->due <= now) {
+		/* Unlink first, the callback might send on this link. */
+		link->head = p->next;
+		if (link->head == NULL) {
+			link->tail = NULL;
+		}
+		link->stats.packets_out++;
+		link->stats.bytes_out += p->len;
+		link->deliver(link->arg, p->data, p->len);
+		free(p);
+		n++;
+	}
+	return (n);
+}
+
+void
+netem_get_stats(const struct netem_link *link, struct netem_stats *stats)
+{
+	*stats = link->stats;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * A simple in-process link emulator in the spirit of Linux netem, used
+ * together with usrsctp_init_virtual_clock() to run AF_CONN associations
+ * over emulated paths. A link carries packets in one direction. Packets
+ * are subject to random and bursty (Gilbert-Elliott) loss, a rate limit
+ * with a finite queue, a fixed delay with uniform jitter and reordering.
+ * All randomness is drawn from a seeded generator, so a run is repeatable.
+ *
+ * A link is not thread safe, it is meant to be driven from a single thread
+ * together with the virtual clock.
+ */
+
+#ifndef NETEM_H
+#define NETEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct netem_params {
+	uint64_t delay;        /* one way delay in microseconds */
+	uint64_t jitter;       /* the delay varies by up to +/- jitter microseconds */
+	double loss;           /* probability of losing a packet */
+	double burst_enter;    /* probability of entering a loss burst */
+	double burst_length;   /* mean number of packets lost in a burst */
+	double reorder;        /* probability of sending a packet without delay */
+	uint64_t rate;         /* bytes per second, 0 means unlimited */
+	size_t queue_limit;    /* bytes queued before tail drop, 0 means unlimited */
+};
+
+struct netem_stats {
+	uint64_t packets_in;
+	uint64_t packets_out;
+	uint64_t bytes_out;
+	uint64_t lost_random;
+	uint64_t lost_burst;
+	uint64_t dropped_queue;
+	uint64_t reordered;
+};
+
+struct netem_link;
+
+/*
+ * deliver is called from netem_deliver() for every packet leaving the link,
+ * typically it calls usrsctp_conninput(). It may send on any link, including
+ * the one delivering.
+ */
+struct netem_link *netem_link_create(const struct netem_params *, uint64_t seed,
+                                     void (*deliver)(void *arg, const void *buf, size_t len),
+                                     void *arg);
+void netem_link_destroy(struct netem_link *);
+
+/* Queues a copy of the packet at time now. Returns 0, or -1 if it was dropped. */
+int netem_send(struct netem_link *, uint64_t now, const void *buf, size_t len);
+
+/* Returns the time the next packet leaves the link or UINT64_MAX if it is empty. */
+uint64_t netem_next_due(const struct netem_link *);
+
+/* Delivers all packets due at or before now. Returns the number delivered. */
+unsigned int netem_deliver(struct netem_link *, uint64_t now);
+
+void netem_get_stats(const struct netem_link *, struct netem_stats *);
+
+#endif
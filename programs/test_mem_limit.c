@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Sends UDP encapsulated packets to the stack while the hard memory limit
+ * leaves no room for the receive buffers. The receive thread has to drop
+ * those packets and keep running. Once the limit is lifted, packets have
+ * to be processed again. Packets of up to 65000 bytes are used, so chains
+ * of several buffers are needed.
+ */
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#else
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+#include <usrsctp.h>
+
+#define UDP_ENCAPS_PORT 9899
+#define PACKETS 200
+
+#ifdef _WIN32
+#define msleep(ms) Sleep(ms)
+typedef SOCKET test_socket_t;
+#else
+#define msleep(ms) usleep((ms) * 1000)
+typedef int test_socket_t;
+#endif
+
+static char buffer[65000];
+
+/* Returns the number of packets the stack processed meanwhile. */
+static uint32_t
+send_packets(test_socket_t fd, struct sockaddr_in *sin)
+{
+	static const int sizes[] = { 100, 1400, 3000, 9000, 30000, 65000 };
+	struct sctpstat stat;
+	uint32_t before;
+	int i;
+
+	usrsctp_get_stat(&stat);
+	before = stat.sctps_recvpackets;
+	for (i = 0; i < PACKETS; i++) {
+		if (sendto(fd, buffer, sizes[i % (sizeof(sizes) / sizeof(sizes[0]))], 0,
+		           (struct sockaddr *)sin, (socklen_t)sizeof(struct sockaddr_in)) < 0) {
+			perror("sendto");
+		}
+		msleep(1);
+	}
+	msleep(500);
+	usrsctp_get_stat(&stat);
+	return (stat.sctps_recvpackets - before);
+}
+
+int
+main(void)
+{
+	struct sockaddr_in sin;
+	test_socket_t fd;
+	uint32_t limited, unlimited;
+#ifdef _WIN32
+	WSADATA wsaData;
+
+	if (WSAStartup(MAKEWORD(2,2), &wsaData) != 0) {
+		printf("WSAStartup failed\n");
+		exit(EXIT_FAILURE);
+	}
+#endif
+	usrsctp_init(UDP_ENCAPS_PORT, NULL, NULL);
+	if ((fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
+		perror("socket");
+		exit(EXIT_FAILURE);
+	}
+	memset(&sin, 0, sizeof(struct sockaddr_in));
+	sin.sin_family = AF_INET;
+	sin.sin_port = htons(UDP_ENCAPS_PORT);
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	usrsctp_set_mem_limits(0, 1);
+	limited = send_packets(fd, &sin);
+	usrsctp_set_mem_limits(0, 0);
+	unlimited = send_packets(fd, &sin);
+	printf("%u of %d packets processed at the hard limit, %u without a limit\n",
+	       limited, PACKETS, unlimited);
+
+#ifdef _WIN32
+	closesocket(fd);
+#else
+	close(fd);
+#endif
+	while (usrsctp_finish() != 0) {
+		msleep(1000);
+	}
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	if ((limited >= PACKETS) || (unlimited == 0)) {
+		printf("FAILED\n");
+		return (EXIT_FAILURE);
+	}
+	return (EXIT_SUCCESS);
+}
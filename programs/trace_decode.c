@@ -0,0 +1,350 @@
+/*
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Prints the events collected with usrsctp_trace_read(). The input files
+ * contain struct sctp_trace_event records as returned by the library,
+ * written by a program running on a host with the same byte order. The
+ * events of all files are merged, sorted by time and printed one per
+ * line, with the time relative to the first event. Events dropped because
+ * a trace buffer was full are reported per thread.
+ */
+
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <usrsctp.h>
+
+/* Places the events are logged from, see sctp_constants.h. */
+#define SCTP_INCREASE_PEER_RWND     36
+#define SCTP_DECREASE_PEER_RWND     37
+#define SCTP_SET_PEER_RWND_VIA_SACK 38
+#define SCTP_LOG_NEW_SACK           42
+#define SCTP_LOG_TSN_ACKED          43
+#define SCTP_LOG_TSN_REVOKED        44
+#define SCTP_LOG_FREE_SENT          71
+#define SCTP_LOG_INITIAL_RTT        51
+#define SCTP_LOG_RTTVAR             52
+#define SCTP_CWND_INITIALIZATION    62
+#define SCTP_CWND_LOG_FROM_T3       63
+#define SCTP_RTX_LOG_T3            124
+#define SCTP_RTX_LOG_FR            125
+#define SCTP_PACKET_LOG_IN         126
+#define SCTP_PACKET_LOG_OUT        127
+
+struct name {
+	unsigned int value;
+	const char *name;
+};
+
+static const struct name event_names[] = {
+	{ SCTP_LOG_EVENT_CWND, "cwnd" },
+	{ SCTP_LOG_EVENT_FR, "fr" },
+	{ SCTP_LOG_EVENT_MAP, "map" },
+	{ SCTP_LOG_EVENT_MAXBURST, "maxburst" },
+	{ SCTP_LOG_EVENT_RWND, "rwnd" },
+	{ SCTP_LOG_EVENT_SACK, "sack" },
+	{ SCTP_LOG_EVENT_RTT, "rtt" },
+	{ SCTP_LOG_MISC_EVENT, "misc" },
+	{ SCTP_LOG_EVENT_TIMER, "timer" },
+	{ SCTP_LOG_EVENT_RTX, "rtx" },
+	{ SCTP_LOG_EVENT_PACKET, "packet" },
+};
+
+static const struct name cwnd_names[] = {
+	{ 1, "fast-retransmit" },
+	{ 2, "retransmission" },
+	{ 3, "burst" },
+	{ 4, "slow-start" },
+	{ 5, "congestion-avoidance" },
+	{ 6, "saturated" },
+	{ 31, "no-advance-ss" },
+	{ 32, "no-advance-ca" },
+	{ 61, "send" },
+	{ SCTP_CWND_INITIALIZATION, "init" },
+	{ SCTP_CWND_LOG_FROM_T3, "t3" },
+	{ 64, "sack" },
+	{ 65, "no-cumack" },
+	{ 66, "resend" },
+	{ 68, "send-now-completes" },
+	{ 69, "fill-outq-called" },
+	{ 70, "fill-outq-fills" },
+	{ 77, "presend" },
+	{ 78, "endsend" },
+};
+
+static const struct name timer_names[] = {
+	{ 1, "t3-rtx" },
+	{ 2, "init" },
+	{ 3, "delayed-sack" },
+	{ 4, "shutdown" },
+	{ 5, "heartbeat" },
+	{ 6, "cookie" },
+	{ 7, "new-cookie" },
+	{ 8, "pmtu-raise" },
+	{ 9, "shutdown-ack" },
+	{ 10, "asconf" },
+	{ 11, "shutdown-guard" },
+	{ 12, "autoclose" },
+	{ 13, "event-wake" },
+	{ 14, "stream-reset" },
+	{ 15, "inp-kill" },
+	{ 16, "asoc-kill" },
+	{ 17, "addr-wq" },
+	{ 18, "prim-deleted" },
+	{ 19, "pacing" },
+};
+
+static const struct name chunk_names[] = {
+	{ 0, "DATA" },
+	{ 1, "INIT" },
+	{ 2, "INIT-ACK" },
+	{ 3, "SACK" },
+	{ 4, "HEARTBEAT" },
+	{ 5, "HEARTBEAT-ACK" },
+	{ 6, "ABORT" },
+	{ 7, "SHUTDOWN" },
+	{ 8, "SHUTDOWN-ACK" },
+	{ 9, "ERROR" },
+	{ 10, "COOKIE-ECHO" },
+	{ 11, "COOKIE-ACK" },
+	{ 12, "ECNE" },
+	{ 13, "CWR" },
+	{ 14, "SHUTDOWN-COMPLETE" },
+	{ 15, "AUTH" },
+	{ 16, "NR-SACK" },
+	{ 64, "I-DATA" },
+	{ 128, "ASCONF-ACK" },
+	{ 130, "RE-CONFIG" },
+	{ 192, "FORWARD-TSN" },
+	{ 193, "ASCONF" },
+	{ 194, "I-FORWARD-TSN" },
+};
+
+#define NAME(table, value) lookup((table), sizeof(table) / sizeof((table)[0]), (value))
+
+static const char *
+lookup(const struct name *table, size_t n, unsigned int value)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		if (table[i].value == value) {
+			return (table[i].name);
+		}
+	}
+	return (NULL);
+}
+
+static void
+print_from(const char *name, unsigned int from)
+{
+	char buf[8];
+
+	if (name == NULL) {
+		snprintf(buf, sizeof(buf), "[%u]", from);
+		name = buf;
+	}
+	printf("%-20s ", name);
+}
+
+static int
+compare_events(const void *a, const void *b)
+{
+	const struct sctp_trace_event *x, *y;
+
+	x = (const struct sctp_trace_event *)a;
+	y = (const struct sctp_trace_event *)b;
+	if (x->time != y->time) {
+		return ((x->time < y->time) ? -1 : 1);
+	}
+	if (x->thread != y->thread) {
+		return ((x->thread < y->thread) ? -1 : 1);
+	}
+	if (x->seq != y->seq) {
+		return ((x->seq < y->seq) ? -1 : 1);
+	}
+	return (0);
+}
+
+static void
+print_event(const struct sctp_trace_event *ev)
+{
+	const uint32_t *p;
+	const char *name;
+	struct {
+		uint32_t cumack;
+		uint32_t oldcumack;
+		uint32_t tsn;
+		uint16_t gaps;
+		uint16_t dups;
+	} sack;
+
+	p = ev->params;
+	name = NAME(event_names, ev->event);
+	if (name != NULL) {
+		printf("%-8s ", name);
+	} else {
+		printf("event%-3u ", ev->event);
+	}
+	switch (ev->event) {
+	case SCTP_LOG_EVENT_CWND:
+		print_from(NAME(cwnd_names, ev->from), ev->from);
+		printf("cwnd %u flight %u incr %d peer-rwnd %u\n",
+		       p[0], p[1], (int32_t)p[2], p[3]);
+		return;
+	case SCTP_LOG_EVENT_RTT:
+		print_from(ev->from == SCTP_LOG_INITIAL_RTT ? "initial" :
+		           ev->from == SCTP_LOG_RTTVAR ? "update" : NULL, ev->from);
+		printf("rtt %u us rto %u ms lastsa %d lastsv %d\n",
+		       p[0], p[1], (int32_t)p[2], (int32_t)p[3]);
+		return;
+	case SCTP_LOG_EVENT_MAXBURST:
+		print_from(NULL, ev->from);
+		printf("error %d burst %d cwnd %u flight %u\n",
+		       (int32_t)p[0], (int32_t)p[1], p[2], p[3]);
+		return;
+	case SCTP_LOG_EVENT_SACK:
+		memcpy(&sack, p, sizeof(sack));
+		print_from(ev->from == SCTP_LOG_NEW_SACK ? "new" :
+		           ev->from == SCTP_LOG_TSN_ACKED ? "tsn-acked" :
+		           ev->from == SCTP_LOG_TSN_REVOKED ? "tsn-revoked" :
+		           ev->from == SCTP_LOG_FREE_SENT ? "free-sent" : NULL, ev->from);
+		printf("cumack %u old-cumack %u tsn %u gaps %u dups %u\n",
+		       sack.cumack, sack.oldcumack, sack.tsn, sack.gaps, sack.dups);
+		return;
+	case SCTP_LOG_EVENT_RWND:
+		print_from(ev->from == SCTP_INCREASE_PEER_RWND ? "increase" :
+		           ev->from == SCTP_DECREASE_PEER_RWND ? "decrease" :
+		           ev->from == SCTP_SET_PEER_RWND_VIA_SACK ? "set-via-sack" : NULL, ev->from);
+		printf("rwnd %u size %u overhead %u new %u\n",
+		       p[0], p[1], p[2], p[3]);
+		return;
+	case SCTP_LOG_EVENT_FR:
+		print_from(NULL, ev->from);
+		printf("%u %u %u\n", p[0], p[1], p[2]);
+		return;
+	case SCTP_LOG_EVENT_MAP:
+		print_from(NULL, ev->from);
+		printf("base %u cum %u high %u\n", p[0], p[1], p[2]);
+		return;
+	case SCTP_LOG_EVENT_TIMER:
+		print_from(NAME(timer_names, ev->from), ev->from);
+		printf("assoc %u flight %u rto %u errors %u\n",
+		       p[0], p[1], p[2], p[3]);
+		return;
+	case SCTP_LOG_EVENT_RTX:
+		print_from(ev->from == SCTP_RTX_LOG_FR ? "fast-retransmit" : "t3", ev->from);
+		printf("assoc %u tsn %u size %u sent %u times\n",
+		       p[0], p[1], p[2], p[3]);
+		return;
+	case SCTP_LOG_EVENT_PACKET:
+		name = NAME(chunk_names, p[3]);
+		print_from(ev->from == SCTP_PACKET_LOG_IN ? "in" : "out", ev->from);
+		printf("assoc %u vtag %08x length %u first %s\n",
+		       p[0], p[1], p[2], name != NULL ? name : "unknown");
+		return;
+	default:
+		print_from(NULL, ev->from);
+		printf("%08x %08x %08x %08x\n", p[0], p[1], p[2], p[3]);
+		return;
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct sctp_trace_event *events, *ev;
+	uint32_t *next_seq;
+	unsigned long lost;
+	size_t n, size, r;
+	FILE *f;
+	int i;
+
+	if (argc < 2) {
+		printf("Usage: trace_decode file ...\n");
+		return (EXIT_FAILURE);
+	}
+	n = 0;
+	size = 4096;
+	if ((events = malloc(size * sizeof(struct sctp_trace_event))) == NULL) {
+		perror("malloc");
+		return (EXIT_FAILURE);
+	}
+	for (i = 1; i < argc; i++) {
+		if ((f = fopen(argv[i], "rb")) == NULL) {
+			perror(argv[i]);
+			return (EXIT_FAILURE);
+		}
+		for (;;) {
+			if (n == size) {
+				size *= 2;
+				if ((events = realloc(events, size * sizeof(struct sctp_trace_event))) == NULL) {
+					perror("realloc");
+					return (EXIT_FAILURE);
+				}
+			}
+			r = fread(events + n, sizeof(struct sctp_trace_event), size - n, f);
+			if (r == 0) {
+				break;
+			}
+			n += r;
+		}
+		fclose(f);
+	}
+	if (n == 0) {
+		return (EXIT_SUCCESS);
+	}
+	qsort(events, n, sizeof(struct sctp_trace_event), compare_events);
+	if ((next_seq = calloc(65536, sizeof(uint32_t))) == NULL) {
+		perror("calloc");
+		return (EXIT_FAILURE);
+	}
+	lost = 0;
+	for (ev = events; ev < events + n; ev++) {
+		/* next_seq holds the expected sequence number plus one. */
+		if ((next_seq[ev->thread] != 0) && (ev->seq != next_seq[ev->thread] - 1)) {
+			printf("              thread %u: %u events lost\n",
+			       ev->thread, ev->seq - (next_seq[ev->thread] - 1));
+			lost += ev->seq - (next_seq[ev->thread] - 1);
+		}
+		next_seq[ev->thread] = ev->seq + 2;
+		printf("%13.6f %3u ", (double)(ev->time - events[0].time) / 1e9, ev->thread);
+		print_event(ev);
+	}
+	printf("%lu events, %lu lost\n", (unsigned long)n, lost);
+	free(next_seq);
+	free(events);
+	return (EXIT_SUCCESS);
+}
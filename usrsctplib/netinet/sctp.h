@@ -210,6 +210,8 @@ struct sctp_paramhdr {
 #define SCTP_GET_STAT_LOG		0x00001103
 #define SCTP_PCB_STATUS			0x00001104
 #define SCTP_GET_NONCE_VALUES           0x00001105
+#define SCTP_GET_ASSOC_PERF_STATS	0x00001106
+#define SCTP_GET_ASSOC_MEM_STATS	0x00001107
 
 
 /* Special hook for dynamically setting primary for all assoc's,
@@ -306,6 +308,10 @@ struct sctp_paramhdr {
 #define SCTP_CC_HTCP		0x00000002
 /* RTCC Congestion Control - RFC2581 plus */
 #define SCTP_CC_RTCC            0x00000003
+/* BBR like Congestion Control - model based, paced */
+#define SCTP_CC_BBR		0x00000004
+/* CUBIC Congestion Control with HyStart */
+#define SCTP_CC_CUBIC		0x00000005
 
 #define SCTP_CC_OPT_RTCC_SETMODE	0x00002000
 #define SCTP_CC_OPT_USE_DCCC_ECN	0x00002001
@@ -333,6 +339,8 @@ struct sctp_paramhdr {
 #define SCTP_SS_FAIR_BANDWITH		0x00000004
 /* First-come, first-serve */
 #define SCTP_SS_FIRST_COME		0x00000005
+/* Weighted fair queueing */
+#define SCTP_SS_WFQ		0x00000006
 
 
 /* fragment interleave constants
@@ -662,5 +670,8 @@ struct sctp_error_auth_invalid_hmac {
 #define SCTP_LOG_AT_SEND_2_SCTP				0x04000000
 #define SCTP_LOG_AT_SEND_2_OUTQ				0x08000000
 #define SCTP_LOG_TRY_ADVANCE				0x10000000
+#define SCTP_TIMER_LOGGING_ENABLE			0x20000000
+#define SCTP_RTX_LOGGING_ENABLE				0x40000000
+#define SCTP_PACKET_LOGGING_ENABLE			0x80000000
 
 #endif				/* !_NETINET_SCTP_H_ */
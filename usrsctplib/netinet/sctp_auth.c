@@ -254,6 +254,7 @@ sctp_alloc_key(uint32_t keylen)
 		/* out of memory */
 		return (NULL);
 	}
+	new_key->hmac_state = NULL;
 	new_key->keylen = keylen;
 	return (new_key);
 }
@@ -261,8 +262,11 @@ sctp_alloc_key(uint32_t keylen)
 void
 sctp_free_key(sctp_key_t *key)
 {
-	if (key != NULL)
+	if (key != NULL) {
+		if (key->hmac_state != NULL)
+			SCTP_FREE(key->hmac_state, SCTP_M_AUTH_KY);
 		SCTP_FREE(key,SCTP_M_AUTH_KY);
+	}
 }
 
 void
@@ -937,28 +941,28 @@ sctp_hmac_final(uint16_t hmac_algo, sctp_hash_context_t *ctx,
 /*-
  * Keyed-Hashing for Message Authentication: FIPS 198 (RFC 2104)
  *
- * Compute the HMAC digest using the desired hash key, text, and HMAC
- * algorithm.  Resulting digest is placed in 'digest' and digest length
- * is returned, if the HMAC was performed.
- *
- * WARNING: it is up to the caller to supply sufficient space to hold the
- * resultant digest.
+ * Precompute the keyed hash state for the key and HMAC algorithm: the
+ * inner and outer hash contexts after hashing the key XORed with the
+ * ipad and opad values.  These only depend on the key, so they can be
+ * reused for every HMAC computed with it.  Returns the digest length,
+ * or 0 if the key or algorithm are invalid.
  */
 uint32_t
-sctp_hmac(uint16_t hmac_algo, uint8_t *key, uint32_t keylen,
-    uint8_t *text, uint32_t textlen, uint8_t *digest)
+sctp_hmac_state_init(sctp_hmac_state_t *state, uint16_t hmac_algo,
+    uint8_t *key, uint32_t keylen)
 {
 	uint32_t digestlen;
 	uint32_t blocklen;
 	sctp_hash_context_t ctx;
-	uint8_t ipad[128], opad[128];	/* keyed hash inner/outer pads */
-	uint8_t temp[SCTP_AUTH_DIGEST_LEN_MAX];
+#if !defined(SCTP_USE_NSS_SHA1)
+	uint8_t pad[SCTP_AUTH_BLOCK_LEN_MAX];	/* keyed hash inner/outer pad */
 	uint32_t i;
+#endif
+	uint8_t temp[SCTP_AUTH_DIGEST_LEN_MAX];
 
 	/* sanity check the material and length */
-	if ((key == NULL) || (keylen == 0) || (text == NULL) ||
-	    (textlen == 0) || (digest == NULL)) {
-		/* can't do HMAC with empty key or text or digest store */
+	if ((state == NULL) || (key == NULL) || (keylen == 0)) {
+		/* can't do HMAC with empty key */
 		return (0);
 	}
 	/* validate the hmac algo and get the digest length */
@@ -976,81 +980,114 @@ sctp_hmac(uint16_t hmac_algo, uint8_t *key, uint32_t keylen,
 		keylen = digestlen;
 		key = temp;
 	}
-	/* initialize the inner/outer pads with the key and "append" zeroes */
-	memset(ipad, 0, blocklen);
-	memset(opad, 0, blocklen);
-	memcpy(ipad, key, keylen);
-	memcpy(opad, key, keylen);
-
-	/* XOR the key with ipad and opad values */
+	state->hmac_algo = hmac_algo;
+#if defined(SCTP_USE_NSS_SHA1)
+	memcpy(state->key, key, keylen);
+	state->keylen = keylen;
+#else
+	/* initialize the inner pad with the key and "append" zeroes */
+	memset(pad, 0, blocklen);
+	memcpy(pad, key, keylen);
+	for (i = 0; i < blocklen; i++) {
+		pad[i] ^= 0x36;
+	}
+	sctp_hmac_init(hmac_algo, &state->inner);
+	sctp_hmac_update(hmac_algo, &state->inner, pad, blocklen);
+	/* turn it into the outer pad */
 	for (i = 0; i < blocklen; i++) {
-		ipad[i] ^= 0x36;
-		opad[i] ^= 0x5c;
+		pad[i] ^= 0x36 ^ 0x5c;
 	}
+	sctp_hmac_init(hmac_algo, &state->outer);
+	sctp_hmac_update(hmac_algo, &state->outer, pad, blocklen);
+#endif
+	return (digestlen);
+}
 
-	/* perform inner hash */
-	sctp_hmac_init(hmac_algo, &ctx);
-	sctp_hmac_update(hmac_algo, &ctx, ipad, blocklen);
-	sctp_hmac_update(hmac_algo, &ctx, text, textlen);
-	sctp_hmac_final(hmac_algo, &ctx, temp);
+/* start the inner or outer hash from the precomputed state */
+static void
+sctp_hmac_state_start(sctp_hmac_state_t *state, sctp_hash_context_t *ctx,
+    int outer)
+{
+#if defined(SCTP_USE_NSS_SHA1)
+	uint8_t pad[SCTP_AUTH_BLOCK_LEN_MAX];
+	uint32_t blocklen;
+	uint32_t i;
 
-	/* perform outer hash */
-	sctp_hmac_init(hmac_algo, &ctx);
-	sctp_hmac_update(hmac_algo, &ctx, opad, blocklen);
-	sctp_hmac_update(hmac_algo, &ctx, temp, digestlen);
-	sctp_hmac_final(hmac_algo, &ctx, digest);
+	blocklen = sctp_get_hmac_block_len(state->hmac_algo);
+	memset(pad, 0, blocklen);
+	memcpy(pad, state->key, state->keylen);
+	for (i = 0; i < blocklen; i++) {
+		pad[i] ^= outer ? 0x5c : 0x36;
+	}
+	sctp_hmac_init(state->hmac_algo, ctx);
+	sctp_hmac_update(state->hmac_algo, ctx, pad, blocklen);
+#else
+	if (outer) {
+		*ctx = state->outer;
+	} else {
+		*ctx = state->inner;
+	}
+#endif
+}
 
+/* finish the inner hash in ctx and perform the outer hash */
+static uint32_t
+sctp_hmac_state_finish(sctp_hmac_state_t *state, sctp_hash_context_t *ctx,
+    uint8_t *digest)
+{
+	uint32_t digestlen;
+	uint8_t temp[SCTP_AUTH_DIGEST_LEN_MAX];
+
+	digestlen = sctp_get_hmac_digest_len(state->hmac_algo);
+	sctp_hmac_final(state->hmac_algo, ctx, temp);
+	sctp_hmac_state_start(state, ctx, 1);
+	sctp_hmac_update(state->hmac_algo, ctx, temp, digestlen);
+	sctp_hmac_final(state->hmac_algo, ctx, digest);
 	return (digestlen);
 }
 
-/* mbuf version */
+/*-
+ * Compute the HMAC digest of 'text' using a precomputed keyed hash state.
+ * Resulting digest is placed in 'digest' and digest length is returned,
+ * if the HMAC was performed.
+ *
+ * WARNING: it is up to the caller to supply sufficient space to hold the
+ * resultant digest.
+ */
 uint32_t
-sctp_hmac_m(uint16_t hmac_algo, uint8_t *key, uint32_t keylen,
-    struct mbuf *m, uint32_t m_offset, uint8_t *digest, uint32_t trailer)
+sctp_hmac_state_compute(sctp_hmac_state_t *state, uint8_t *text,
+    uint32_t textlen, uint8_t *digest)
 {
-	uint32_t digestlen;
-	uint32_t blocklen;
 	sctp_hash_context_t ctx;
-	uint8_t ipad[128], opad[128];	/* keyed hash inner/outer pads */
-	uint8_t temp[SCTP_AUTH_DIGEST_LEN_MAX];
-	uint32_t i;
-	struct mbuf *m_tmp;
 
 	/* sanity check the material and length */
-	if ((key == NULL) || (keylen == 0) || (m == NULL) || (digest == NULL)) {
-		/* can't do HMAC with empty key or text or digest store */
+	if ((state == NULL) || (text == NULL) || (textlen == 0) ||
+	    (digest == NULL)) {
+		/* can't do HMAC with empty text or digest store */
 		return (0);
 	}
-	/* validate the hmac algo and get the digest length */
-	digestlen = sctp_get_hmac_digest_len(hmac_algo);
-	if (digestlen == 0)
-		return (0);
+	/* perform inner hash */
+	sctp_hmac_state_start(state, &ctx, 0);
+	sctp_hmac_update(state->hmac_algo, &ctx, text, textlen);
+	/* perform outer hash */
+	return (sctp_hmac_state_finish(state, &ctx, digest));
+}
 
-	/* hash the key if it is longer than the hash block size */
-	blocklen = sctp_get_hmac_block_len(hmac_algo);
-	if (keylen > blocklen) {
-		sctp_hmac_init(hmac_algo, &ctx);
-		sctp_hmac_update(hmac_algo, &ctx, key, keylen);
-		sctp_hmac_final(hmac_algo, &ctx, temp);
-		/* set the hashed key as the key */
-		keylen = digestlen;
-		key = temp;
-	}
-	/* initialize the inner/outer pads with the key and "append" zeroes */
-	memset(ipad, 0, blocklen);
-	memset(opad, 0, blocklen);
-	memcpy(ipad, key, keylen);
-	memcpy(opad, key, keylen);
+/* mbuf version */
+uint32_t
+sctp_hmac_state_compute_m(sctp_hmac_state_t *state, struct mbuf *m,
+    uint32_t m_offset, uint8_t *digest, uint32_t trailer)
+{
+	sctp_hash_context_t ctx;
+	struct mbuf *m_tmp;
 
-	/* XOR the key with ipad and opad values */
-	for (i = 0; i < blocklen; i++) {
-		ipad[i] ^= 0x36;
-		opad[i] ^= 0x5c;
+	/* sanity check the material and length */
+	if ((state == NULL) || (m == NULL) || (digest == NULL)) {
+		/* can't do HMAC with empty text or digest store */
+		return (0);
 	}
-
 	/* perform inner hash */
-	sctp_hmac_init(hmac_algo, &ctx);
-	sctp_hmac_update(hmac_algo, &ctx, ipad, blocklen);
+	sctp_hmac_state_start(state, &ctx, 0);
 	/* find the correct starting mbuf and offset (get start of text) */
 	m_tmp = m;
 	while ((m_tmp != NULL) && (m_offset >= (uint32_t) SCTP_BUF_LEN(m_tmp))) {
@@ -1060,10 +1097,10 @@ sctp_hmac_m(uint16_t hmac_algo, uint8_t *key, uint32_t keylen,
 	/* now use the rest of the mbuf chain for the text */
 	while (m_tmp != NULL) {
 		if ((SCTP_BUF_NEXT(m_tmp) == NULL) && trailer) {
-			sctp_hmac_update(hmac_algo, &ctx, mtod(m_tmp, uint8_t *) + m_offset,
+			sctp_hmac_update(state->hmac_algo, &ctx, mtod(m_tmp, uint8_t *) + m_offset,
 					 SCTP_BUF_LEN(m_tmp) - (trailer+m_offset));
 		} else {
-			sctp_hmac_update(hmac_algo, &ctx, mtod(m_tmp, uint8_t *) + m_offset,
+			sctp_hmac_update(state->hmac_algo, &ctx, mtod(m_tmp, uint8_t *) + m_offset,
 					 SCTP_BUF_LEN(m_tmp) - m_offset);
 		}
 
@@ -1071,15 +1108,41 @@ sctp_hmac_m(uint16_t hmac_algo, uint8_t *key, uint32_t keylen,
 		m_offset = 0;
 		m_tmp = SCTP_BUF_NEXT(m_tmp);
 	}
-	sctp_hmac_final(hmac_algo, &ctx, temp);
-
 	/* perform outer hash */
-	sctp_hmac_init(hmac_algo, &ctx);
-	sctp_hmac_update(hmac_algo, &ctx, opad, blocklen);
-	sctp_hmac_update(hmac_algo, &ctx, temp, digestlen);
-	sctp_hmac_final(hmac_algo, &ctx, digest);
+	return (sctp_hmac_state_finish(state, &ctx, digest));
+}
 
-	return (digestlen);
+/*-
+ * Compute the HMAC digest using the desired hash key, text, and HMAC
+ * algorithm.  Resulting digest is placed in 'digest' and digest length
+ * is returned, if the HMAC was performed.
+ *
+ * WARNING: it is up to the caller to supply sufficient space to hold the
+ * resultant digest.
+ */
+uint32_t
+sctp_hmac(uint16_t hmac_algo, uint8_t *key, uint32_t keylen,
+    uint8_t *text, uint32_t textlen, uint8_t *digest)
+{
+	sctp_hmac_state_t state;
+
+	if (sctp_hmac_state_init(&state, hmac_algo, key, keylen) == 0) {
+		return (0);
+	}
+	return (sctp_hmac_state_compute(&state, text, textlen, digest));
+}
+
+/* mbuf version */
+uint32_t
+sctp_hmac_m(uint16_t hmac_algo, uint8_t *key, uint32_t keylen,
+    struct mbuf *m, uint32_t m_offset, uint8_t *digest, uint32_t trailer)
+{
+	sctp_hmac_state_t state;
+
+	if (sctp_hmac_state_init(&state, hmac_algo, key, keylen) == 0) {
+		return (0);
+	}
+	return (sctp_hmac_state_compute_m(&state, m, m_offset, digest, trailer));
 }
 
 /*-
@@ -1117,17 +1180,41 @@ sctp_verify_hmac(uint16_t hmac_algo, uint8_t *key, uint32_t keylen,
 
 
 /*
- * computes the requested HMAC using a key struct (which may be modified if
- * the keylen exceeds the HMAC block len).
+ * get the keyed hash state cached with the key, computing it if needed.
+ */
+static sctp_hmac_state_t *
+sctp_get_hmac_state(uint16_t hmac_algo, sctp_key_t *key)
+{
+	if (key->hmac_state != NULL) {
+		if (key->hmac_state->hmac_algo == hmac_algo) {
+			return (key->hmac_state);
+		}
+	} else {
+		SCTP_MALLOC(key->hmac_state, sctp_hmac_state_t *,
+		            sizeof(sctp_hmac_state_t), SCTP_M_AUTH_KY);
+		if (key->hmac_state == NULL) {
+			/* out of memory */
+			return (NULL);
+		}
+	}
+	if (sctp_hmac_state_init(key->hmac_state, hmac_algo, key->key,
+	    key->keylen) == 0) {
+		SCTP_FREE(key->hmac_state, SCTP_M_AUTH_KY);
+		key->hmac_state = NULL;
+		return (NULL);
+	}
+	return (key->hmac_state);
+}
+
+/*
+ * computes the requested HMAC using a key struct.  The keyed hash state
+ * is cached with the key, so it is only computed once per key.
  */
 uint32_t
 sctp_compute_hmac(uint16_t hmac_algo, sctp_key_t *key, uint8_t *text,
     uint32_t textlen, uint8_t *digest)
 {
-	uint32_t digestlen;
-	uint32_t blocklen;
-	sctp_hash_context_t ctx;
-	uint8_t temp[SCTP_AUTH_DIGEST_LEN_MAX];
+	sctp_hmac_state_t *state;
 
 	/* sanity check */
 	if ((key == NULL) || (text == NULL) || (textlen == 0) ||
@@ -1135,23 +1222,12 @@ sctp_compute_hmac(uint16_t hmac_algo, sctp_key_t *key, uint8_t *text,
 		/* can't do HMAC with empty key or text or digest store */
 		return (0);
 	}
-	/* validate the hmac algo and get the digest length */
-	digestlen = sctp_get_hmac_digest_len(hmac_algo);
-	if (digestlen == 0)
-		return (0);
-
-	/* hash the key if it is longer than the hash block size */
-	blocklen = sctp_get_hmac_block_len(hmac_algo);
-	if (key->keylen > blocklen) {
-		sctp_hmac_init(hmac_algo, &ctx);
-		sctp_hmac_update(hmac_algo, &ctx, key->key, key->keylen);
-		sctp_hmac_final(hmac_algo, &ctx, temp);
-		/* save the hashed key as the new key */
-		key->keylen = digestlen;
-		memcpy(key->key, temp, key->keylen);
+	state = sctp_get_hmac_state(hmac_algo, key);
+	if (state == NULL) {
+		return (sctp_hmac(hmac_algo, key->key, key->keylen, text,
+		    textlen, digest));
 	}
-	return (sctp_hmac(hmac_algo, key->key, key->keylen, text, textlen,
-	    digest));
+	return (sctp_hmac_state_compute(state, text, textlen, digest));
 }
 
 /* mbuf version */
@@ -1159,32 +1235,19 @@ uint32_t
 sctp_compute_hmac_m(uint16_t hmac_algo, sctp_key_t *key, struct mbuf *m,
     uint32_t m_offset, uint8_t *digest)
 {
-	uint32_t digestlen;
-	uint32_t blocklen;
-	sctp_hash_context_t ctx;
-	uint8_t temp[SCTP_AUTH_DIGEST_LEN_MAX];
+	sctp_hmac_state_t *state;
 
 	/* sanity check */
 	if ((key == NULL) || (m == NULL) || (digest == NULL)) {
 		/* can't do HMAC with empty key or text or digest store */
 		return (0);
 	}
-	/* validate the hmac algo and get the digest length */
-	digestlen = sctp_get_hmac_digest_len(hmac_algo);
-	if (digestlen == 0)
-		return (0);
-
-	/* hash the key if it is longer than the hash block size */
-	blocklen = sctp_get_hmac_block_len(hmac_algo);
-	if (key->keylen > blocklen) {
-		sctp_hmac_init(hmac_algo, &ctx);
-		sctp_hmac_update(hmac_algo, &ctx, key->key, key->keylen);
-		sctp_hmac_final(hmac_algo, &ctx, temp);
-		/* save the hashed key as the new key */
-		key->keylen = digestlen;
-		memcpy(key->key, temp, key->keylen);
+	state = sctp_get_hmac_state(hmac_algo, key);
+	if (state == NULL) {
+		return (sctp_hmac_m(hmac_algo, key->key, key->keylen, m,
+		    m_offset, digest, 0));
 	}
-	return (sctp_hmac_m(hmac_algo, key->key, key->keylen, m, m_offset, digest, 0));
+	return (sctp_hmac_state_compute_m(state, m, m_offset, digest, 0));
 }
 
 int
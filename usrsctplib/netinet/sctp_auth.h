@@ -45,6 +45,9 @@ __FBSDID("$FreeBSD: head/sys/netinet/sctp_auth.h 310590 2016-12-26 11:06:41Z tue
 #define SCTP_AUTH_DIGEST_LEN_SHA256	32
 #define SCTP_AUTH_DIGEST_LEN_MAX	SCTP_AUTH_DIGEST_LEN_SHA256
 
+/* hash block sizes */
+#define SCTP_AUTH_BLOCK_LEN_MAX		64
+
 /* random sizes */
 #define SCTP_AUTH_RANDOM_SIZE_DEFAULT	32
 #define SCTP_AUTH_RANDOM_SIZE_REQUIRED	32
@@ -57,7 +60,21 @@ typedef union sctp_hash_context {
 #endif
 } sctp_hash_context_t;
 
+/* keyed hash state of a HMAC key, with the key pads already hashed */
+typedef struct sctp_hmac_state {
+	uint16_t hmac_algo;
+#if defined(SCTP_USE_NSS_SHA1)
+	/* NSS contexts can't be copied, so keep the (hashed) key instead */
+	uint32_t keylen;
+	uint8_t key[SCTP_AUTH_BLOCK_LEN_MAX];
+#else
+	sctp_hash_context_t inner;	/* context after hashing key ^ ipad */
+	sctp_hash_context_t outer;	/* context after hashing key ^ opad */
+#endif
+} sctp_hmac_state_t;
+
 typedef struct sctp_key {
+	sctp_hmac_state_t *hmac_state;	/* cached HMAC state, if computed */
 	uint32_t keylen;
 	uint8_t key[];
 } sctp_key_t;
@@ -180,6 +197,14 @@ extern uint32_t sctp_hmac_m(uint16_t hmac_algo, uint8_t *key, uint32_t keylen,
 extern uint32_t sctp_compute_hmac_m(uint16_t hmac_algo, sctp_key_t *key,
     struct mbuf *m, uint32_t m_offset, uint8_t *digest);
 
+/* precomputed key versions */
+extern uint32_t sctp_hmac_state_init(sctp_hmac_state_t *state,
+    uint16_t hmac_algo, uint8_t *key, uint32_t keylen);
+extern uint32_t sctp_hmac_state_compute(sctp_hmac_state_t *state,
+    uint8_t *text, uint32_t textlen, uint8_t *digest);
+extern uint32_t sctp_hmac_state_compute_m(sctp_hmac_state_t *state,
+    struct mbuf *m, uint32_t m_offset, uint8_t *digest, uint32_t trailer);
+
 /*
  * authentication routines
  */
@@ -74,6 +74,7 @@ MALLOC_DEFINE(SCTP_M_MVRF, "sctp_mvrf", "sctp mvrf pcb list");
 MALLOC_DEFINE(SCTP_M_ITER, "sctp_iter", "sctp iterator control");
 MALLOC_DEFINE(SCTP_M_SOCKOPT, "sctp_socko", "sctp socket option");
 MALLOC_DEFINE(SCTP_M_MCORE, "sctp_mcore", "sctp mcore queue");
+MALLOC_DEFINE(SCTP_M_PERF, "sctp_perf", "sctp assoc perf stats");
 #endif
 
 /* Global NON-VNET structure that controls the iterator */
@@ -143,11 +144,13 @@ sctp_iterator_thread(void *v SCTP_UNUSED)
 #endif
 		       0, "waiting_for_work", 0);
 #else
+		SCTP_MTX_SLEEP(&sctp_it_ctl.ipi_iterator_wq_mtx);
 #if defined(__Userspace_os_Windows)
 		SleepConditionVariableCS(&sctp_it_ctl.iterator_wakeup, &sctp_it_ctl.ipi_iterator_wq_mtx, INFINITE);
 #else
 		pthread_cond_wait(&sctp_it_ctl.iterator_wakeup, &sctp_it_ctl.ipi_iterator_wq_mtx);
 #endif
+		SCTP_MTX_WAKEUP(&sctp_it_ctl.ipi_iterator_wq_mtx);
 #endif
 #if !defined(__FreeBSD__)
 		if (sctp_it_ctl.iterator_flags & SCTP_ITERATOR_MUST_EXIT) {
@@ -801,13 +804,14 @@ sctp_get_mbuf_for_msg(unsigned int space_needed, int want_header,
 
   /*
    * __Userspace__
-   * Using m_clget, which creates and mbuf and a cluster and
-   * hooks those together.
-   * TODO: This does not yet have functionality for jumbo packets.
-   *
+   * Using m_cljget, which hooks a cluster of the smallest size
+   * holding space_needed to the mbuf. If no jumbo cluster is
+   * available, fall back to a regular one unless all of the
+   * space must be in one buffer.
    */
 
 	int mbuf_threshold;
+	int aloc_size;
 	if (want_header) {
 		MGETHDR(m, how, type);
 	} else {
@@ -823,7 +827,20 @@ sctp_get_mbuf_for_msg(unsigned int space_needed, int want_header,
 
 
 	if ((int)space_needed > (((mbuf_threshold - 1) * MLEN) + MHLEN)) {
-		MCLGET(m, how);
+		if (space_needed <= MCLBYTES) {
+			aloc_size = MCLBYTES;
+		} else if (space_needed <= MJUMPAGESIZE) {
+			aloc_size = MJUMPAGESIZE;
+		} else if (space_needed <= MJUM9BYTES) {
+			aloc_size = MJUM9BYTES;
+		} else {
+			aloc_size = MJUM16BYTES;
+		}
+		m_cljget(m, how, aloc_size);
+		if ((SCTP_BUF_IS_EXTENDED(m) == 0) &&
+		    (aloc_size != MCLBYTES) && (allonebuf == 0)) {
+			MCLGET(m, how);
+		}
 		if (SCTP_BUF_IS_EXTENDED(m) == 0) {
 			sctp_m_freem(m);
 			return (NULL);
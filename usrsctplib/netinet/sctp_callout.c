@@ -34,6 +34,7 @@
 #include <sys/types.h>
 #if !defined (__Userspace_os_Windows)
 #include <sys/wait.h>
+#include <sys/time.h>
 #include <unistd.h>
 #include <pthread.h>
 #endif
@@ -46,6 +47,7 @@
 #include <errno.h>
 #include <netinet/sctp_sysctl.h>
 #include <netinet/sctp_pcb.h>
+#include <netinet/sctp_var.h>
 #else
 #include <netinet/sctp_os.h>
 #include <netinet/sctp_callout.h>
@@ -57,6 +59,10 @@
  */
 #if defined(__APPLE__) || defined(__Userspace__)
 static int ticks = 0;
+#if defined(__Userspace__)
+static int sctp_mem_drain_ticks = 0;
+static int sctp_idle_compact_ticks = 0;
+#endif
 #else
 extern int ticks;
 #endif
@@ -77,6 +83,101 @@ int sctp_get_tick_count(void) {
  */
 static sctp_os_timer_t *sctp_os_timer_next = NULL;
 
+#if defined(__Userspace__)
+/*
+ * Callouts started with sctp_os_timer_start_us() are kept on a separate
+ * queue, sorted by their deadline in microseconds. The timer thread sleeps
+ * until the earlier of the next tick and the first deadline on this queue.
+ * SCTP_TIMERQ_LOCK protects it as well.
+ */
+static struct calloutlist sctp_os_hr_callqueue = TAILQ_HEAD_INITIALIZER(sctp_os_hr_callqueue);
+#if !defined(__Userspace_os_Windows)
+static pthread_cond_t sctp_os_hr_cond = PTHREAD_COND_INITIALIZER;
+#endif
+
+/*
+ * With a virtual clock there is no timer thread and time only advances
+ * when sctp_os_virtual_clock_advance() is called. The clock is written
+ * with SCTP_TIMERQ_LOCK held, but read without it.
+ */
+static volatile uint64_t sctp_os_virtual_now;
+static uint64_t sctp_os_virtual_next_tick;
+
+static uint64_t
+sctp_os_virtual_clock_read(void)
+{
+#if defined(__Userspace_os_Windows)
+	return ((uint64_t)InterlockedCompareExchange64((volatile LONG64 *)&sctp_os_virtual_now, 0, 0));
+#else
+	return (__atomic_load_n(&sctp_os_virtual_now, __ATOMIC_ACQUIRE));
+#endif
+}
+
+static void
+sctp_os_virtual_clock_write(uint64_t now)
+{
+#if defined(__Userspace_os_Windows)
+	(void)InterlockedExchange64((volatile LONG64 *)&sctp_os_virtual_now, (LONG64)now);
+#else
+	__atomic_store_n(&sctp_os_virtual_now, now, __ATOMIC_RELEASE);
+#endif
+}
+
+uint64_t
+sctp_os_timer_now_us(void)
+{
+	if (SCTP_BASE_VAR(virtual_clock)) {
+		return (sctp_os_virtual_clock_read());
+	}
+#if defined(__Userspace_os_Windows)
+	return ((uint64_t)GetTickCount64() * 1000);
+#else
+	{
+		struct timeval now;
+
+		(void)gettimeofday(&now, NULL);
+		return ((uint64_t)1000000 * (uint64_t)now.tv_sec + (uint64_t)now.tv_usec);
+	}
+#endif
+}
+
+/* Used for SCTP_GETTIME_TIMEVAL(). */
+int
+sctp_os_gettimeofday(struct timeval *tv)
+{
+	uint64_t now;
+
+	if (SCTP_BASE_VAR(virtual_clock)) {
+		now = sctp_os_virtual_clock_read();
+		tv->tv_sec = (long)(now / 1000000);
+		tv->tv_usec = (long)(now % 1000000);
+		return (0);
+	}
+#if defined(__Userspace_os_Windows)
+	getwintimeofday(tv);
+	return (0);
+#else
+	return (gettimeofday(tv, NULL));
+#endif
+}
+#endif
+
+/* Must be called with SCTP_TIMERQ_LOCK held and c pending. */
+static void
+sctp_os_timer_dequeue(sctp_os_timer_t *c)
+{
+#if defined(__Userspace__)
+	if (c->c_flags & SCTP_CALLOUT_HIGHRES) {
+		TAILQ_REMOVE(&sctp_os_hr_callqueue, c, tqe);
+		return;
+	}
+#endif
+	if (c == sctp_os_timer_next) {
+		sctp_os_timer_next = TAILQ_NEXT(c, tqe);
+	}
+	TAILQ_REMOVE(&SCTP_BASE_INFO(callqueue), c, tqe);
+}
+
 void
 sctp_os_timer_init(sctp_os_timer_t *c)
 {
@@ -94,10 +195,7 @@ sctp_os_timer_start(sctp_os_timer_t *c, int to_ticks, void (*ftn) (void *),
 	SCTP_TIMERQ_LOCK();
 	/* check to see if we're rescheduling a timer */
 	if (c->c_flags & SCTP_CALLOUT_PENDING) {
-		if (c == sctp_os_timer_next) {
-			sctp_os_timer_next = TAILQ_NEXT(c, tqe);
-		}
-		TAILQ_REMOVE(&SCTP_BASE_INFO(callqueue), c, tqe);
+		sctp_os_timer_dequeue(c);
 		/*
 		 * part of the normal "stop a pending callout" process
 		 * is to clear the CALLOUT_ACTIVE and CALLOUT_PENDING
@@ -133,15 +231,77 @@ sctp_os_timer_stop(sctp_os_timer_t *c)
 		SCTP_TIMERQ_UNLOCK();
 		return (0);
 	}
-	c->c_flags &= ~(SCTP_CALLOUT_ACTIVE | SCTP_CALLOUT_PENDING);
-	if (c == sctp_os_timer_next) {
-		sctp_os_timer_next = TAILQ_NEXT(c, tqe);
-	}
-	TAILQ_REMOVE(&SCTP_BASE_INFO(callqueue), c, tqe);
+	sctp_os_timer_dequeue(c);
+	c->c_flags &= ~(SCTP_CALLOUT_ACTIVE | SCTP_CALLOUT_PENDING | SCTP_CALLOUT_HIGHRES);
 	SCTP_TIMERQ_UNLOCK();
 	return (1);
 }
 
+#if defined(__Userspace__)
+/*
+ * Like sctp_os_timer_start(), but the callout runs after usecs
+ * microseconds instead of a number of ticks.
+ */
+void
+sctp_os_timer_start_us(sctp_os_timer_t *c, uint32_t usecs, void (*ftn) (void *),
+                       void *arg)
+{
+	sctp_os_timer_t *prev;
+
+	if ((c == NULL) || (ftn == NULL))
+	    return;
+
+	if (usecs == 0)
+		usecs = 1;
+
+	SCTP_TIMERQ_LOCK();
+	if (c->c_flags & SCTP_CALLOUT_PENDING) {
+		sctp_os_timer_dequeue(c);
+	}
+	c->c_arg = arg;
+	c->c_flags = (SCTP_CALLOUT_ACTIVE | SCTP_CALLOUT_PENDING | SCTP_CALLOUT_HIGHRES);
+	c->c_func = ftn;
+	c->c_usec = sctp_os_timer_now_us() + usecs;
+	/* Deadlines are mostly increasing, so search from the tail. */
+	TAILQ_FOREACH_REVERSE(prev, &sctp_os_hr_callqueue, calloutlist, tqe) {
+		if (prev->c_usec <= c->c_usec) {
+			break;
+		}
+	}
+	if (prev == NULL) {
+		TAILQ_INSERT_HEAD(&sctp_os_hr_callqueue, c, tqe);
+#if !defined(__Userspace_os_Windows)
+		/* The timer thread might be sleeping past the new deadline. */
+		(void)pthread_cond_signal(&sctp_os_hr_cond);
+#endif
+	} else {
+		TAILQ_INSERT_AFTER(&sctp_os_hr_callqueue, prev, c, tqe);
+	}
+	SCTP_TIMERQ_UNLOCK();
+}
+
+static void
+sctp_handle_hr_timers(uint64_t now)
+{
+	sctp_os_timer_t *c;
+	void (*c_func)(void *);
+	void *c_arg;
+
+	SCTP_TIMERQ_LOCK();
+	while (((c = TAILQ_FIRST(&sctp_os_hr_callqueue)) != NULL) &&
+	       (c->c_usec <= now)) {
+		TAILQ_REMOVE(&sctp_os_hr_callqueue, c, tqe);
+		c_func = c->c_func;
+		c_arg = c->c_arg;
+		c->c_flags &= ~(SCTP_CALLOUT_PENDING | SCTP_CALLOUT_HIGHRES);
+		SCTP_TIMERQ_UNLOCK();
+		c_func(c_arg);
+		SCTP_TIMERQ_LOCK();
+	}
+	SCTP_TIMERQ_UNLOCK();
+}
+#endif
+
 static void
 sctp_handle_tick(int delta)
 {
@@ -170,6 +330,20 @@ sctp_handle_tick(int delta)
 	}
 	sctp_os_timer_next = NULL;
 	SCTP_TIMERQ_UNLOCK();
+#if defined(__Userspace__)
+	/* Drain all associations at most once per second under pressure. */
+	if ((sctp_mem_pressure_update() != SCTP_MEM_PRESSURE_NONE) &&
+	    (ticks - sctp_mem_drain_ticks >= hz)) {
+		sctp_mem_drain_ticks = ticks;
+		sctp_drain();
+	}
+	if ((SCTP_BASE_SYSCTL(sctp_idle_compact_time) != 0) &&
+	    (ticks - sctp_idle_compact_ticks >=
+	     (int)MSEC_TO_TICKS(SCTP_BASE_SYSCTL(sctp_idle_compact_time)))) {
+		sctp_idle_compact_ticks = ticks;
+		sctp_idle_compact();
+	}
+#endif
 }
 
 #if defined(__APPLE__)
@@ -184,28 +358,160 @@ sctp_timeout(void *arg SCTP_UNUSED)
 #if defined(__Userspace__)
 #define TIMEOUT_INTERVAL 10
 
-void *
-user_sctp_timer_iterate(void *arg)
+/*
+ * Sleep until the next tick is due or, if earlier, until the first high
+ * resolution callout expires. Starting a callout which expires before
+ * that wakes the thread up again, except on Windows, where the sleep is
+ * only shortened up front and has millisecond granularity.
+ */
+static void
+sctp_timer_sleep(uint64_t now, uint64_t next_tick)
 {
-	sctp_userspace_set_threadname("SCTP timer");
-	for (;;) {
+	sctp_os_timer_t *c;
+	uint64_t wakeup;
 #if defined (__Userspace_os_Windows)
-		Sleep(TIMEOUT_INTERVAL);
+	DWORD ms;
 #else
-		struct timeval timeout;
+	struct timeval tv;
+	struct timespec ts;
+	uint64_t abs_us;
+#endif
 
-		timeout.tv_sec  = 0;
-		timeout.tv_usec = 1000 * TIMEOUT_INTERVAL;
-		select(0, NULL, NULL, NULL, &timeout);
+	SCTP_TIMERQ_LOCK();
+	wakeup = next_tick;
+	c = TAILQ_FIRST(&sctp_os_hr_callqueue);
+	if ((c != NULL) && (c->c_usec < wakeup)) {
+		wakeup = c->c_usec;
+	}
+	if (wakeup <= now) {
+		SCTP_TIMERQ_UNLOCK();
+		return;
+	}
+#if defined (__Userspace_os_Windows)
+	SCTP_TIMERQ_UNLOCK();
+	ms = (DWORD)((wakeup - now + 999) / 1000);
+	Sleep(ms);
+#else
+	/* pthread_cond_timedwait() wants an absolute time of CLOCK_REALTIME. */
+	(void)gettimeofday(&tv, NULL);
+	abs_us = (uint64_t)1000000 * (uint64_t)tv.tv_sec + (uint64_t)tv.tv_usec + (wakeup - now);
+	ts.tv_sec = (time_t)(abs_us / 1000000);
+	ts.tv_nsec = (long)(abs_us % 1000000) * 1000;
+	SCTP_MTX_SLEEP(&SCTP_BASE_VAR(timer_mtx));
+	(void)pthread_cond_timedwait(&sctp_os_hr_cond, &SCTP_BASE_VAR(timer_mtx), &ts);
+	SCTP_MTX_WAKEUP(&SCTP_BASE_VAR(timer_mtx));
+	SCTP_TIMERQ_UNLOCK();
 #endif
+}
+
+void *
+user_sctp_timer_iterate(void *arg)
+{
+	uint64_t now, next_tick;
+
+	sctp_userspace_set_threadname("SCTP timer");
+	next_tick = sctp_os_timer_now_us() + 1000 * TIMEOUT_INTERVAL;
+	for (;;) {
+		now = sctp_os_timer_now_us();
+		if (next_tick > now + 1000 * TIMEOUT_INTERVAL) {
+			/* The clock went backwards. */
+			next_tick = now + 1000 * TIMEOUT_INTERVAL;
+		}
+		sctp_timer_sleep(now, next_tick);
 		if (SCTP_BASE_VAR(timer_thread_should_exit)) {
 			break;
 		}
-		sctp_handle_tick(MSEC_TO_TICKS(TIMEOUT_INTERVAL));
+		now = sctp_os_timer_now_us();
+		sctp_handle_hr_timers(now);
+		if (now >= next_tick) {
+			sctp_handle_tick(MSEC_TO_TICKS(TIMEOUT_INTERVAL));
+			next_tick += 1000 * TIMEOUT_INTERVAL;
+			if (next_tick <= now) {
+				/* Don't try to catch up after a stall. */
+				next_tick = now + 1000 * TIMEOUT_INTERVAL;
+			}
+		}
 	}
 	return (NULL);
 }
 
+/* Starts the virtual clock at the current time of day. */
+void
+sctp_os_virtual_clock_init(void)
+{
+	struct timeval now;
+	uint64_t now_us;
+
+#if defined(__Userspace_os_Windows)
+	getwintimeofday(&now);
+#else
+	(void)gettimeofday(&now, NULL);
+#endif
+	now_us = (uint64_t)1000000 * (uint64_t)now.tv_sec + (uint64_t)now.tv_usec;
+	sctp_os_virtual_clock_write(now_us);
+	sctp_os_virtual_next_tick = now_us + 1000 * TIMEOUT_INTERVAL;
+}
+
+/*
+ * Returns the time the next callout might be due: the next tick or, if
+ * earlier, the deadline of the first high resolution callout.
+ */
+uint64_t
+sctp_os_virtual_clock_next(void)
+{
+	sctp_os_timer_t *c;
+	uint64_t next;
+
+	SCTP_TIMERQ_LOCK();
+	next = sctp_os_virtual_next_tick;
+	c = TAILQ_FIRST(&sctp_os_hr_callqueue);
+	if ((c != NULL) && (c->c_usec < next)) {
+		next = c->c_usec;
+	}
+	SCTP_TIMERQ_UNLOCK();
+	return (next);
+}
+
+/*
+ * Advances the virtual clock by usecs microseconds. Callouts becoming due
+ * run in the calling thread, with the clock set to their deadline.
+ */
+void
+sctp_os_virtual_clock_advance(uint64_t usecs)
+{
+	sctp_os_timer_t *c;
+	uint64_t target, next;
+	int tick;
+
+	SCTP_TIMERQ_LOCK();
+	target = sctp_os_virtual_clock_read() + usecs;
+	for (;;) {
+		next = sctp_os_virtual_next_tick;
+		c = TAILQ_FIRST(&sctp_os_hr_callqueue);
+		if ((c != NULL) && (c->c_usec < next)) {
+			next = c->c_usec;
+		}
+		if (next > target) {
+			break;
+		}
+		if (next > sctp_os_virtual_clock_read()) {
+			sctp_os_virtual_clock_write(next);
+		}
+		tick = (next == sctp_os_virtual_next_tick);
+		if (tick) {
+			sctp_os_virtual_next_tick += 1000 * TIMEOUT_INTERVAL;
+		}
+		SCTP_TIMERQ_UNLOCK();
+		sctp_handle_hr_timers(next);
+		if (tick) {
+			sctp_handle_tick(MSEC_TO_TICKS(TIMEOUT_INTERVAL));
+		}
+		SCTP_TIMERQ_LOCK();
+	}
+	sctp_os_virtual_clock_write(target);
+	SCTP_TIMERQ_UNLOCK();
+}
+
 void
 sctp_start_timer(void)
 {
@@ -215,6 +521,10 @@ sctp_start_timer(void)
 	 */
 	int rc;
 
+	if (SCTP_BASE_VAR(virtual_clock)) {
+		/* Callouts are run by sctp_os_virtual_clock_advance(). */
+		return;
+	}
 	rc = sctp_userspace_thread_create(&SCTP_BASE_VAR(timer_thread), user_sctp_timer_iterate);
 	if (rc) {
 		SCTP_PRINTF("ERROR; return code from sctp_thread_create() is %d\n", rc);
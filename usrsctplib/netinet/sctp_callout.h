@@ -52,17 +52,17 @@ __FBSDID("$FreeBSD$");
 
 #if defined(__Userspace__)
 #if defined(__Userspace_os_Windows)
-#define SCTP_TIMERQ_LOCK()          EnterCriticalSection(&SCTP_BASE_VAR(timer_mtx))
-#define SCTP_TIMERQ_UNLOCK()        LeaveCriticalSection(&SCTP_BASE_VAR(timer_mtx))
+#define SCTP_TIMERQ_LOCK()          SCTP_MTX_LOCK(&SCTP_BASE_VAR(timer_mtx), SCTP_LOCK_CLASS_TIMERQ)
+#define SCTP_TIMERQ_UNLOCK()        SCTP_MTX_UNLOCK(&SCTP_BASE_VAR(timer_mtx), SCTP_LOCK_CLASS_TIMERQ)
 #define SCTP_TIMERQ_LOCK_INIT()     InitializeCriticalSection(&SCTP_BASE_VAR(timer_mtx))
 #define SCTP_TIMERQ_LOCK_DESTROY()  DeleteCriticalSection(&SCTP_BASE_VAR(timer_mtx))
 #else
 #ifdef INVARIANTS
-#define SCTP_TIMERQ_LOCK()          KASSERT(pthread_mutex_lock(&SCTP_BASE_VAR(timer_mtx)) == 0, ("%s: timer_mtx already locked", __func__))
-#define SCTP_TIMERQ_UNLOCK()        KASSERT(pthread_mutex_unlock(&SCTP_BASE_VAR(timer_mtx)) == 0, ("%s: timer_mtx not locked", __func__))
+#define SCTP_TIMERQ_LOCK()          KASSERT(SCTP_MTX_LOCK(&SCTP_BASE_VAR(timer_mtx), SCTP_LOCK_CLASS_TIMERQ) == 0, ("%s: timer_mtx already locked", __func__))
+#define SCTP_TIMERQ_UNLOCK()        KASSERT(SCTP_MTX_UNLOCK(&SCTP_BASE_VAR(timer_mtx), SCTP_LOCK_CLASS_TIMERQ) == 0, ("%s: timer_mtx not locked", __func__))
 #else
-#define SCTP_TIMERQ_LOCK()          (void)pthread_mutex_lock(&SCTP_BASE_VAR(timer_mtx))
-#define SCTP_TIMERQ_UNLOCK()        (void)pthread_mutex_unlock(&SCTP_BASE_VAR(timer_mtx))
+#define SCTP_TIMERQ_LOCK()          (void)SCTP_MTX_LOCK(&SCTP_BASE_VAR(timer_mtx), SCTP_LOCK_CLASS_TIMERQ)
+#define SCTP_TIMERQ_UNLOCK()        (void)SCTP_MTX_UNLOCK(&SCTP_BASE_VAR(timer_mtx), SCTP_LOCK_CLASS_TIMERQ)
 #endif
 #define SCTP_TIMERQ_LOCK_INIT()     (void)pthread_mutex_init(&SCTP_BASE_VAR(timer_mtx), &SCTP_BASE_VAR(mtx_attr))
 #define SCTP_TIMERQ_LOCK_DESTROY()  (void)pthread_mutex_destroy(&SCTP_BASE_VAR(timer_mtx))
@@ -79,19 +79,29 @@ struct sctp_callout {
 	void *c_arg;		/* function argument */
 	void (*c_func)(void *);	/* function to call */
 	int c_flags;		/* state of this entry */
+#if defined(__Userspace__)
+	uint64_t c_usec;	/* deadline of a high resolution callout */
+#endif
 };
 typedef struct sctp_callout sctp_os_timer_t;
 
 #define	SCTP_CALLOUT_ACTIVE	0x0002	/* callout is currently active */
 #define	SCTP_CALLOUT_PENDING	0x0004	/* callout is waiting for timeout */
+#define	SCTP_CALLOUT_HIGHRES	0x0008	/* callout is on the high resolution queue */
 
 void sctp_os_timer_init(sctp_os_timer_t *tmr);
 void sctp_os_timer_start(sctp_os_timer_t *, int, void (*)(void *), void *);
 int sctp_os_timer_stop(sctp_os_timer_t *);
+#if defined(__Userspace__)
+void sctp_os_timer_start_us(sctp_os_timer_t *, uint32_t, void (*)(void *), void *);
+#endif
 
 #define SCTP_OS_TIMER_INIT	sctp_os_timer_init
 #define SCTP_OS_TIMER_START	sctp_os_timer_start
 #define SCTP_OS_TIMER_STOP	sctp_os_timer_stop
+#if defined(__Userspace__)
+#define SCTP_OS_TIMER_START_US	sctp_os_timer_start_us
+#endif
 /* MT FIXME: Is the following correct? */
 #define SCTP_OS_TIMER_STOP_DRAIN SCTP_OS_TIMER_STOP
 #define	SCTP_OS_TIMER_PENDING(tmr) ((tmr)->c_flags & SCTP_CALLOUT_PENDING)
@@ -100,6 +110,11 @@ int sctp_os_timer_stop(sctp_os_timer_t *);
 
 #if defined(__Userspace__)
 void sctp_start_timer(void);
+uint64_t sctp_os_timer_now_us(void);
+int sctp_os_gettimeofday(struct timeval *);
+void sctp_os_virtual_clock_init(void);
+void sctp_os_virtual_clock_advance(uint64_t);
+uint64_t sctp_os_virtual_clock_next(void);
 #endif
 #if defined(__APPLE__)
 void sctp_timeout(void *);
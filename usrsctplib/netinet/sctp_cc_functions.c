@@ -2406,6 +2406,828 @@ sctp_htcp_cwnd_update_after_ecn_echo(struct sctp_tcb *stcb,
 	}
 }
 
+/*
+ * Helpers for the modules measuring time in us and working in rounds, a
+ * round ends when everything sent at its start has been cum-acked.
+ */
+static uint32_t
+sctp_cc_round_end_tsn(struct sctp_association *asoc)
+{
+	struct sctp_tmit_chunk *chk;
+
+	chk = TAILQ_LAST(&asoc->sent_queue, sctpchunk_listhead);
+	if (chk != NULL) {
+		return (chk->rec.data.tsn);
+	} else {
+		return (asoc->sending_seq - 1);
+	}
+}
+
+static int
+sctp_cc_round_done(struct sctp_association *asoc, uint32_t round_end_tsn)
+{
+	struct sctp_tmit_chunk *chk;
+
+	/*
+	 * Acked chunks have been removed from the sent queue already, but
+	 * last_acked_seq is not updated yet on the express path.
+	 */
+	chk = TAILQ_FIRST(&asoc->sent_queue);
+	return ((chk == NULL) || SCTP_TSN_GT(chk->rec.data.tsn, round_end_tsn));
+}
+
+/*
+ * Pacing rate for modules without a rate estimate: the cwnd spread over the
+ * smoothed RTT, with some headroom so that pacing does not limit the
+ * growth of the cwnd.
+ */
+static uint64_t
+sctp_cc_cwnd_pacing_rate(struct sctp_nets *net)
+{
+	uint64_t srtt, rate;
+
+	if (net->RTO_measured == 0) {
+		return (0);
+	}
+	srtt = (uint64_t)(net->lastsa >> SCTP_RTT_SHIFT) * 1000;
+	if (srtt == 0) {
+		srtt = net->rtt;
+	}
+	if (srtt == 0) {
+		srtt = 1;
+	}
+	rate = (uint64_t)net->cwnd * 1000000 / srtt;
+	if (net->cwnd < net->ssthresh) {
+		rate = (rate * SCTP_PACING_SS_GAIN) >> 8;
+	} else {
+		rate = (rate * SCTP_PACING_CA_GAIN) >> 8;
+	}
+	return (rate);
+}
+
+/*
+ * BBR like congestion control. Each destination keeps a windowed max of
+ * the delivery rate seen per round trip (the bottleneck bandwidth) and a
+ * windowed min of the RTT. The cwnd is derived from the product of both
+ * and a pacing rate from the bandwidth estimate. Loss does not change the
+ * model, it only limits how far the cwnd may exceed one BDP.
+ */
+
+static const uint16_t sctp_bbr_pacing_gain[SCTP_BBR_CYCLE_LEN] = {
+	320, 192, 256, 256, 256, 256, 256, 256
+};
+
+static void
+sctp_bbr_start_round(struct sctp_tcb *stcb, struct sctp_nets *net, uint64_t now)
+{
+	net->cc_mod.bbr.round_start = now;
+	net->cc_mod.bbr.round_end_tsn = sctp_cc_round_end_tsn(&stcb->asoc);
+	net->cc_mod.bbr.delivered = 0;
+	net->cc_mod.bbr.app_limited = 0;
+}
+
+/* Returns gain * BDP, or 0 if there is no estimate yet. */
+static uint32_t
+sctp_bbr_target_cwnd(struct sctp_nets *net, uint16_t gain)
+{
+	struct bbr *bbr;
+	uint64_t target;
+
+	bbr = &net->cc_mod.bbr;
+	if ((bbr->btl_bw == 0) || (bbr->min_rtt == 0)) {
+		return (0);
+	}
+	target = bbr->btl_bw * bbr->min_rtt / 1000000;
+	target = (target * gain) >> 8;
+	/* Leave room for delayed and stretched SACKs. */
+	target += 3 * net->mtu;
+	if (target < SCTP_BBR_MIN_CWND_MTU * net->mtu) {
+		target = SCTP_BBR_MIN_CWND_MTU * net->mtu;
+	}
+	if (target > 0x7fffffff) {
+		target = 0x7fffffff;
+	}
+	return ((uint32_t)target);
+}
+
+static void
+sctp_bbr_enter_probe_bw(struct sctp_nets *net)
+{
+	struct bbr *bbr;
+	uint32_t rnd;
+
+	bbr = &net->cc_mod.bbr;
+	bbr->state = SCTP_BBR_PROBE_BW;
+	bbr->cwnd_gain = SCTP_BBR_CWND_GAIN;
+	/* Start at a random phase, but never in the draining one. */
+	SCTP_READ_RANDOM(&rnd, sizeof(rnd));
+	bbr->cycle_idx = (uint8_t)(rnd % (SCTP_BBR_CYCLE_LEN - 1));
+	if (bbr->cycle_idx >= 1) {
+		bbr->cycle_idx++;
+	}
+	bbr->pacing_gain = sctp_bbr_pacing_gain[bbr->cycle_idx];
+}
+
+static void
+sctp_bbr_update_bw(struct sctp_nets *net, uint64_t now)
+{
+	struct bbr *bbr;
+	uint64_t bw, elapsed;
+	int i;
+
+	bbr = &net->cc_mod.bbr;
+	elapsed = now - bbr->round_start;
+	/*
+	 * A round can not be shorter than the RTT, shorter ones are the
+	 * result of compressed SACKs and would overestimate the rate.
+	 */
+	if (elapsed < bbr->min_rtt) {
+		elapsed = bbr->min_rtt;
+	}
+	if (elapsed == 0) {
+		elapsed = 1;
+	}
+	bw = bbr->delivered * 1000000 / elapsed;
+	if (bbr->app_limited && (bw < bbr->btl_bw)) {
+		/* Don't let an application limited round age out the estimate. */
+		bw = bbr->btl_bw;
+	}
+	bbr->round_count++;
+	bbr->bw_samples[bbr->round_count % SCTP_BBR_BW_WINDOW] = bw;
+	bbr->btl_bw = 0;
+	for (i = 0; i < SCTP_BBR_BW_WINDOW; i++) {
+		if (bbr->bw_samples[i] > bbr->btl_bw) {
+			bbr->btl_bw = bbr->bw_samples[i];
+		}
+	}
+}
+
+static void
+sctp_bbr_check_full_bw(struct bbr *bbr)
+{
+	if (bbr->full_bw_reached || bbr->app_limited) {
+		return;
+	}
+	if (bbr->btl_bw >= ((bbr->full_bw * SCTP_BBR_FULL_BW_THRESH) >> 8)) {
+		/* Still growing, the pipe is not full yet. */
+		bbr->full_bw = bbr->btl_bw;
+		bbr->full_bw_cnt = 0;
+		return;
+	}
+	if (++bbr->full_bw_cnt >= SCTP_BBR_FULL_BW_CNT) {
+		bbr->full_bw_reached = 1;
+	}
+}
+
+static void
+sctp_bbr_update_state(struct sctp_nets *net, int round_end, uint64_t now)
+{
+	struct bbr *bbr;
+
+	bbr = &net->cc_mod.bbr;
+	switch (bbr->state) {
+	case SCTP_BBR_STARTUP:
+		if (round_end) {
+			sctp_bbr_check_full_bw(bbr);
+		}
+		if (bbr->full_bw_reached) {
+			bbr->state = SCTP_BBR_DRAIN;
+			bbr->pacing_gain = SCTP_BBR_DRAIN_GAIN;
+			bbr->cwnd_gain = SCTP_BBR_HIGH_GAIN;
+		}
+		break;
+	case SCTP_BBR_DRAIN:
+		if (net->flight_size <= sctp_bbr_target_cwnd(net, SCTP_BBR_UNIT)) {
+			sctp_bbr_enter_probe_bw(net);
+		}
+		break;
+	case SCTP_BBR_PROBE_BW:
+		if (round_end) {
+			if ((bbr->cycle_idx == 0) && (bbr->inflight_hi > 0)) {
+				/* Probe slowly for more room than at the last loss. */
+				bbr->inflight_hi += max(bbr->inflight_hi >> 4, net->mtu);
+			}
+			bbr->cycle_idx = (bbr->cycle_idx + 1) % SCTP_BBR_CYCLE_LEN;
+			bbr->pacing_gain = sctp_bbr_pacing_gain[bbr->cycle_idx];
+		}
+		break;
+	default:
+		break;
+	}
+	if ((bbr->state != SCTP_BBR_PROBE_RTT) &&
+	    (bbr->min_rtt_stamp != 0) &&
+	    (now - bbr->min_rtt_stamp > SCTP_BBR_MIN_RTT_WIN)) {
+		/*
+		 * The min RTT has not been seen for a while, drain the queue
+		 * to measure it again. Samples taken now rebuild min_rtt.
+		 */
+		bbr->state = SCTP_BBR_PROBE_RTT;
+		bbr->pacing_gain = SCTP_BBR_UNIT;
+		bbr->cwnd_gain = SCTP_BBR_UNIT;
+		bbr->prior_cwnd = net->cwnd;
+		bbr->probe_rtt_done = 0;
+		bbr->min_rtt = 0;
+	}
+	if (bbr->state == SCTP_BBR_PROBE_RTT) {
+		if (bbr->probe_rtt_done == 0) {
+			if (net->flight_size <= SCTP_BBR_MIN_CWND_MTU * net->mtu) {
+				bbr->probe_rtt_done = now + SCTP_BBR_PROBE_RTT_TIME;
+			}
+		} else if (now >= bbr->probe_rtt_done) {
+			if (bbr->min_rtt == 0) {
+				bbr->min_rtt = (uint32_t)min(net->rtt, 0xffffffff);
+			}
+			bbr->min_rtt_stamp = now;
+			if (net->cwnd < bbr->prior_cwnd) {
+				net->cwnd = bbr->prior_cwnd;
+			}
+			if (bbr->full_bw_reached) {
+				sctp_bbr_enter_probe_bw(net);
+			} else {
+				bbr->state = SCTP_BBR_STARTUP;
+				bbr->pacing_gain = SCTP_BBR_HIGH_GAIN;
+				bbr->cwnd_gain = SCTP_BBR_HIGH_GAIN;
+			}
+		}
+	}
+	bbr->pacing_rate = (bbr->btl_bw * bbr->pacing_gain) >> 8;
+}
+
+/*
+ * A cwnd of two BDPs overflows a shallow buffer, paced or not. So after
+ * a loss the cwnd is bounded by a fraction of what was in flight, but not
+ * below one BDP, and the bound is raised again while probing for bandwidth.
+ */
+static void
+sctp_bbr_loss_detected(struct sctp_nets *net, uint32_t inflight)
+{
+	struct bbr *bbr;
+	uint32_t floor;
+
+	bbr = &net->cc_mod.bbr;
+	bbr->inflight_hi = (uint32_t)(((uint64_t)inflight * SCTP_BBR_LOSS_BETA) >> 8);
+	floor = sctp_bbr_target_cwnd(net, SCTP_BBR_UNIT);
+	if (bbr->inflight_hi < floor) {
+		bbr->inflight_hi = floor;
+	}
+	if (bbr->inflight_hi < SCTP_BBR_MIN_CWND_MTU * net->mtu) {
+		bbr->inflight_hi = SCTP_BBR_MIN_CWND_MTU * net->mtu;
+	}
+}
+
+static void
+sctp_bbr_set_initial_cc_param(struct sctp_tcb *stcb, struct sctp_nets *net)
+{
+	net->cwnd = min((net->mtu * 4), max((2 * net->mtu), SCTP_INITIAL_CWND));
+	net->ssthresh = stcb->asoc.peers_rwnd;
+	sctp_enforce_cwnd_limit(&stcb->asoc, net);
+	memset(&net->cc_mod.bbr, 0, sizeof(struct bbr));
+	net->cc_mod.bbr.state = SCTP_BBR_STARTUP;
+	net->cc_mod.bbr.pacing_gain = SCTP_BBR_HIGH_GAIN;
+	net->cc_mod.bbr.cwnd_gain = SCTP_BBR_HIGH_GAIN;
+	sctp_bbr_start_round(stcb, net, sctp_get_time_usec());
+	stcb->asoc.use_precise_time = 1;
+	if (SCTP_BASE_SYSCTL(sctp_logging_level) & (SCTP_CWND_MONITOR_ENABLE|SCTP_CWND_LOGGING_ENABLE)) {
+		sctp_log_cwnd(stcb, net, 0, SCTP_CWND_INITIALIZATION);
+	}
+}
+
+static void
+sctp_bbr_cwnd_update_after_sack(struct sctp_tcb *stcb,
+                                struct sctp_association *asoc,
+                                int accum_moved SCTP_UNUSED,
+                                int reneged_all SCTP_UNUSED,
+                                int will_exit)
+{
+	struct sctp_nets *net;
+	struct bbr *bbr;
+	uint64_t now;
+	uint32_t target, old_cwnd, min_cwnd;
+	int round_end;
+
+	now = sctp_get_time_usec();
+	TAILQ_FOREACH(net, &asoc->nets, sctp_next) {
+		if (net->net_ack == 0) {
+			if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_LOGGING_ENABLE) {
+				sctp_log_cwnd(stcb, net, 0, SCTP_CWND_LOG_FROM_SACK);
+			}
+			continue;
+		}
+		bbr = &net->cc_mod.bbr;
+		bbr->delivered += net->net_ack;
+		if ((net->flight_size + net->mtu < net->cwnd) &&
+		    TAILQ_EMPTY(&asoc->send_queue) &&
+		    (asoc->stream_queue_cnt == 0)) {
+			bbr->app_limited = 1;
+		}
+		round_end = sctp_cc_round_done(asoc, bbr->round_end_tsn);
+		if (round_end) {
+			sctp_bbr_update_bw(net, now);
+			sctp_bbr_start_round(stcb, net, now);
+		}
+		sctp_bbr_update_state(net, round_end, now);
+
+		old_cwnd = net->cwnd;
+		min_cwnd = SCTP_BBR_MIN_CWND_MTU * net->mtu;
+		if (bbr->in_recovery) {
+			if (round_end) {
+				bbr->packet_conservation = 0;
+			}
+			if ((net->fast_retran_loss_recovery == 0) ||
+			    (will_exit && (asoc->sctp_cmt_on_off == 0))) {
+				/* Recovery is over, go back to where we were. */
+				bbr->in_recovery = 0;
+				bbr->packet_conservation = 0;
+				if (net->cwnd < bbr->prior_cwnd) {
+					net->cwnd = bbr->prior_cwnd;
+				}
+			}
+		}
+		if (bbr->state == SCTP_BBR_PROBE_RTT) {
+			if (net->cwnd > min_cwnd) {
+				net->cwnd = min_cwnd;
+			}
+		} else if (bbr->packet_conservation) {
+			/* Send one packet for each one which left the network. */
+			if (net->cwnd < net->flight_size + net->net_ack) {
+				net->cwnd = net->flight_size + net->net_ack;
+			}
+		} else {
+			target = sctp_bbr_target_cwnd(net, bbr->cwnd_gain);
+			if ((bbr->inflight_hi > 0) && (target > bbr->inflight_hi)) {
+				target = bbr->inflight_hi;
+			}
+			if (bbr->full_bw_reached && (target > 0)) {
+				net->cwnd = min(net->cwnd + net->net_ack, target);
+			} else if ((target == 0) || (net->cwnd < target)) {
+				net->cwnd += net->net_ack;
+			}
+			if (net->cwnd < min_cwnd) {
+				net->cwnd = min_cwnd;
+			}
+		}
+		sctp_enforce_cwnd_limit(asoc, net);
+		if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_MONITOR_ENABLE) {
+			sctp_log_cwnd(stcb, net, net->cwnd - old_cwnd, SCTP_CWND_LOG_FROM_CA);
+		}
+	}
+}
+
+static void
+sctp_bbr_cwnd_update_after_fr(struct sctp_tcb *stcb,
+                              struct sctp_association *asoc)
+{
+	struct sctp_nets *net;
+	struct sctp_tmit_chunk *lchk;
+	uint32_t old_cwnd;
+
+	/*
+	 * Loss does not change the model. For the first round of recovery
+	 * only as much is sent as has left the network, afterwards the cwnd
+	 * grows as usual and it is restored when recovery is over.
+	 */
+	TAILQ_FOREACH(net, &asoc->nets, sctp_next) {
+		if ((asoc->fast_retran_loss_recovery == 0) ||
+		    (asoc->sctp_cmt_on_off > 0)) {
+			if (net->net_ack > 0) {
+				old_cwnd = net->cwnd;
+				if (net->cc_mod.bbr.in_recovery == 0) {
+					if ((net->cc_mod.bbr.state == SCTP_BBR_STARTUP) &&
+					    (net->cc_mod.bbr.btl_bw > 0)) {
+						/* The buffer overflowed, the pipe is full. */
+						net->cc_mod.bbr.full_bw_reached = 1;
+					}
+					sctp_bbr_loss_detected(net, net->cwnd);
+					net->cc_mod.bbr.prior_cwnd = min(net->cwnd, net->cc_mod.bbr.inflight_hi);
+					net->cc_mod.bbr.in_recovery = 1;
+				}
+				net->cc_mod.bbr.packet_conservation = 1;
+				net->cwnd = max(net->flight_size + net->net_ack,
+				                SCTP_BBR_MIN_CWND_MTU * net->mtu);
+				sctp_enforce_cwnd_limit(asoc, net);
+				if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_MONITOR_ENABLE) {
+					sctp_log_cwnd(stcb, net, (net->cwnd - old_cwnd),
+					              SCTP_CWND_LOG_FROM_FR);
+				}
+				sctp_bbr_start_round(stcb, net, sctp_get_time_usec());
+				lchk = TAILQ_FIRST(&asoc->send_queue);
+				net->partial_bytes_acked = 0;
+				asoc->fast_retran_loss_recovery = 1;
+				if (lchk == NULL) {
+					asoc->fast_recovery_tsn = asoc->sending_seq - 1;
+				} else {
+					asoc->fast_recovery_tsn = lchk->rec.data.tsn - 1;
+				}
+				net->fast_retran_loss_recovery = 1;
+				if (lchk == NULL) {
+					net->fast_recovery_tsn = asoc->sending_seq - 1;
+				} else {
+					net->fast_recovery_tsn = lchk->rec.data.tsn - 1;
+				}
+				sctp_timer_stop(SCTP_TIMER_TYPE_SEND,
+				                stcb->sctp_ep, stcb, net,
+				                SCTP_FROM_SCTP_CC_FUNCTIONS + SCTP_LOC_4);
+				sctp_timer_start(SCTP_TIMER_TYPE_SEND,
+				                 stcb->sctp_ep, stcb, net);
+			}
+		} else if (net->net_ack > 0) {
+			SCTP_STAT_INCR(sctps_fastretransinrtt);
+		}
+	}
+}
+
+static void
+sctp_bbr_cwnd_update_after_timeout(struct sctp_tcb *stcb,
+                                   struct sctp_nets *net)
+{
+	uint32_t old_cwnd;
+
+	old_cwnd = net->cwnd;
+	if (net->cc_mod.bbr.in_recovery == 0) {
+		sctp_bbr_loss_detected(net, net->cwnd);
+	}
+	net->ssthresh = max(net->cwnd / 2, SCTP_BBR_MIN_CWND_MTU * net->mtu);
+	net->cwnd = net->mtu;
+	net->partial_bytes_acked = 0;
+	net->cc_mod.bbr.in_recovery = 0;
+	net->cc_mod.bbr.packet_conservation = 0;
+	/* Restart the round, the bandwidth and RTT estimates are kept. */
+	sctp_bbr_start_round(stcb, net, sctp_get_time_usec());
+	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_MONITOR_ENABLE) {
+		sctp_log_cwnd(stcb, net, net->cwnd - old_cwnd, SCTP_CWND_LOG_FROM_RTX);
+	}
+}
+
+static void
+sctp_bbr_rtt_calculated(struct sctp_tcb *stcb SCTP_UNUSED,
+                        struct sctp_nets *net,
+                        struct timeval *now SCTP_UNUSED)
+{
+	struct bbr *bbr;
+	uint32_t rtt;
+
+	bbr = &net->cc_mod.bbr;
+	rtt = (uint32_t)min(net->rtt, 0xffffffff);
+	if (rtt == 0) {
+		rtt = 1;
+	}
+	if ((bbr->min_rtt == 0) || (rtt <= bbr->min_rtt)) {
+		bbr->min_rtt = rtt;
+		bbr->min_rtt_stamp = sctp_get_time_usec();
+	}
+}
+
+static uint64_t
+sctp_bbr_pacing_rate(struct sctp_tcb *stcb SCTP_UNUSED, struct sctp_nets *net)
+{
+	if (net->cc_mod.bbr.pacing_rate == 0) {
+		/* No bandwidth sample yet. */
+		return (sctp_cc_cwnd_pacing_rate(net));
+	}
+	return (net->cc_mod.bbr.pacing_rate);
+}
+
+/*
+ * CUBIC congestion control (RFC 8312). In congestion avoidance the cwnd
+ * follows a cubic function of the time since the last congestion event,
+ * which makes the growth independent of the RTT and quick on paths with
+ * a large BDP. Slow start is left early when the RTT starts to increase
+ * (HyStart). SCTP takes a single RTT measurement per round trip, so the
+ * delay increase is detected by comparing the samples of two rounds.
+ */
+
+/* Integer cube root. */
+static uint32_t
+sctp_cubic_cbrt(uint64_t a)
+{
+	uint64_t x, b;
+	int s;
+
+	x = 0;
+	for (s = 63; s >= 0; s -= 3) {
+		x <<= 1;
+		b = 3 * x * (x + 1) + 1;
+		if ((a >> s) >= b) {
+			a -= b << s;
+			x++;
+		}
+	}
+	return ((uint32_t)x);
+}
+
+static void
+sctp_cubic_congestion_event(struct sctp_nets *net)
+{
+	struct cubic *cubic;
+
+	cubic = &net->cc_mod.cubic;
+	cubic->epoch_start = 0;
+	if (net->cwnd < cubic->w_max) {
+		/* Fast convergence, leave room for new flows. */
+		cubic->w_max = (uint32_t)(((uint64_t)net->cwnd * SCTP_CUBIC_FAST_CONV) >> 10);
+	} else {
+		cubic->w_max = net->cwnd;
+	}
+	net->ssthresh = (uint32_t)(((uint64_t)net->cwnd * SCTP_CUBIC_BETA) >> 10);
+	if (net->ssthresh < 2 * net->mtu) {
+		net->ssthresh = 2 * net->mtu;
+	}
+}
+
+/* Returns the increase of the cwnd in congestion avoidance. */
+static uint32_t
+sctp_cubic_cong_avoid(struct sctp_nets *net)
+{
+	struct cubic *cubic;
+	uint64_t now, t, target, num;
+	int64_t offs, delta;
+	uint32_t incr;
+
+	cubic = &net->cc_mod.cubic;
+	now = sctp_get_time_usec();
+	if (cubic->epoch_start == 0) {
+		cubic->epoch_start = now;
+		cubic->cwnd_rem = 0;
+		cubic->w_est_rem = 0;
+		cubic->w_est = net->cwnd;
+		if (net->cwnd < cubic->w_max) {
+			/* K = cbrt((w_max - cwnd) / C) with C = 0.4 MTUs / s^3 */
+			cubic->k = sctp_cubic_cbrt((uint64_t)(cubic->w_max - net->cwnd) * 2500000000ULL / net->mtu);
+			cubic->origin = cubic->w_max;
+		} else {
+			cubic->k = 0;
+			cubic->origin = net->cwnd;
+		}
+	}
+	/* Aim at where the cubic function will be one RTT from now. */
+	t = (now - cubic->epoch_start + cubic->min_rtt) / 1000;
+	if (t > (1 << 20)) {
+		t = 1 << 20;
+	}
+	offs = (int64_t)t - (int64_t)cubic->k;
+	/* C * (t - K)^3 in MTUs is 4 * delta / 10000 with t and K in ms. */
+	delta = ((offs * offs) / 1000) * offs / 1000;
+	delta = 4 * delta * (int64_t)net->mtu / 10000;
+	if ((int64_t)cubic->origin + delta < 0) {
+		target = 0;
+	} else {
+		target = (uint64_t)((int64_t)cubic->origin + delta);
+	}
+	/* Don't be slower than Reno would be. */
+	num = (uint64_t)net->net_ack * net->mtu * SCTP_CUBIC_ALPHA + cubic->w_est_rem;
+	cubic->w_est += (uint32_t)(num / ((uint64_t)net->cwnd << 10));
+	cubic->w_est_rem = num % ((uint64_t)net->cwnd << 10);
+	if (target < cubic->w_est) {
+		target = cubic->w_est;
+	}
+	if (target > net->cwnd + net->cwnd / 2) {
+		target = net->cwnd + net->cwnd / 2;
+	}
+	if (target > net->cwnd) {
+		num = (target - net->cwnd) * net->net_ack + cubic->cwnd_rem;
+		incr = (uint32_t)(num / net->cwnd);
+		cubic->cwnd_rem = num % net->cwnd;
+	} else {
+		/* On the plateau, grow by one MTU per 100 cwnds acked. */
+		num = (uint64_t)net->mtu * net->net_ack + cubic->cwnd_rem;
+		incr = (uint32_t)(num / (100 * (uint64_t)net->cwnd));
+		cubic->cwnd_rem = num % (100 * (uint64_t)net->cwnd);
+	}
+	return (incr);
+}
+
+static void
+sctp_cubic_hystart_round(struct sctp_association *asoc, struct sctp_nets *net)
+{
+	struct cubic *cubic;
+	uint32_t eta;
+
+	cubic = &net->cc_mod.cubic;
+	if (!sctp_cc_round_done(asoc, cubic->round_end_tsn)) {
+		return;
+	}
+	if ((cubic->hystart_done == 0) &&
+	    (cubic->round_min_rtt > 0) &&
+	    (cubic->last_round_min_rtt > 0) &&
+	    (net->cwnd >= SCTP_CUBIC_HYSTART_LOW_WINDOW * net->mtu)) {
+		eta = cubic->last_round_min_rtt / 8;
+		if (eta < SCTP_CUBIC_HYSTART_MIN_ETA) {
+			eta = SCTP_CUBIC_HYSTART_MIN_ETA;
+		}
+		if (eta > SCTP_CUBIC_HYSTART_MAX_ETA) {
+			eta = SCTP_CUBIC_HYSTART_MAX_ETA;
+		}
+		if (cubic->round_min_rtt >= cubic->last_round_min_rtt + eta) {
+			/* The queue is building up, leave slow start. */
+			cubic->hystart_done = 1;
+			net->ssthresh = net->cwnd;
+		}
+	}
+	if (cubic->round_min_rtt > 0) {
+		cubic->last_round_min_rtt = cubic->round_min_rtt;
+	}
+	cubic->round_min_rtt = 0;
+	cubic->round_end_tsn = sctp_cc_round_end_tsn(asoc);
+}
+
+static void
+sctp_cubic_set_initial_cc_param(struct sctp_tcb *stcb, struct sctp_nets *net)
+{
+	net->cwnd = min((net->mtu * 4), max((2 * net->mtu), SCTP_INITIAL_CWND));
+	net->ssthresh = stcb->asoc.peers_rwnd;
+	sctp_enforce_cwnd_limit(&stcb->asoc, net);
+	memset(&net->cc_mod.cubic, 0, sizeof(struct cubic));
+	net->cc_mod.cubic.round_end_tsn = sctp_cc_round_end_tsn(&stcb->asoc);
+	stcb->asoc.use_precise_time = 1;
+	if (SCTP_BASE_SYSCTL(sctp_logging_level) & (SCTP_CWND_MONITOR_ENABLE|SCTP_CWND_LOGGING_ENABLE)) {
+		sctp_log_cwnd(stcb, net, 0, SCTP_CWND_INITIALIZATION);
+	}
+}
+
+static void
+sctp_cubic_cwnd_update_after_sack(struct sctp_tcb *stcb,
+                                  struct sctp_association *asoc,
+                                  int accum_moved,
+                                  int reneged_all SCTP_UNUSED,
+                                  int will_exit)
+{
+	struct sctp_nets *net;
+	uint32_t incr;
+
+	TAILQ_FOREACH(net, &asoc->nets, sctp_next) {
+		if (net->net_ack == 0) {
+			if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_LOGGING_ENABLE) {
+				sctp_log_cwnd(stcb, net, 0, SCTP_CWND_LOG_FROM_SACK);
+			}
+			continue;
+		}
+		if (asoc->fast_retran_loss_recovery &&
+		    will_exit == 0 &&
+		    (asoc->sctp_cmt_on_off == 0)) {
+			/* No cwnd update in loss recovery. */
+			continue;
+		}
+		if (!accum_moved &&
+		    ((asoc->sctp_cmt_on_off == 0) || !net->new_pseudo_cumack)) {
+			if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_LOGGING_ENABLE) {
+				sctp_log_cwnd(stcb, net, net->mtu, SCTP_CWND_LOG_NO_CUMACK);
+			}
+			continue;
+		}
+		if (net->cwnd < net->ssthresh) {
+			sctp_cubic_hystart_round(asoc, net);
+		}
+		if (net->flight_size + net->net_ack < net->cwnd) {
+			/* Not limited by the cwnd, don't grow it. */
+			if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_LOGGING_ENABLE) {
+				sctp_log_cwnd(stcb, net, net->net_ack, SCTP_CWND_LOG_NOADV_CA);
+			}
+			continue;
+		}
+		if (net->cwnd < net->ssthresh) {
+			incr = net->net_ack;
+			if (incr > net->mtu * SCTP_BASE_SYSCTL(sctp_L2_abc_variable)) {
+				incr = net->mtu * SCTP_BASE_SYSCTL(sctp_L2_abc_variable);
+			}
+			net->cwnd += incr;
+			sctp_enforce_cwnd_limit(asoc, net);
+			if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_MONITOR_ENABLE) {
+				sctp_log_cwnd(stcb, net, incr, SCTP_CWND_LOG_FROM_SS);
+			}
+		} else {
+			incr = sctp_cubic_cong_avoid(net);
+			net->cwnd += incr;
+			sctp_enforce_cwnd_limit(asoc, net);
+			if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_MONITOR_ENABLE) {
+				sctp_log_cwnd(stcb, net, incr, SCTP_CWND_LOG_FROM_CA);
+			}
+		}
+	}
+}
+
+static void
+sctp_cubic_cwnd_update_after_fr(struct sctp_tcb *stcb,
+                                struct sctp_association *asoc)
+{
+	struct sctp_nets *net;
+	struct sctp_tmit_chunk *lchk;
+	uint32_t old_cwnd;
+
+	TAILQ_FOREACH(net, &asoc->nets, sctp_next) {
+		if ((asoc->fast_retran_loss_recovery == 0) ||
+		    (asoc->sctp_cmt_on_off > 0)) {
+			/* out of a RFC2582 Fast recovery window? */
+			if (net->net_ack > 0) {
+				old_cwnd = net->cwnd;
+				sctp_cubic_congestion_event(net);
+				net->cwnd = net->ssthresh;
+				sctp_enforce_cwnd_limit(asoc, net);
+				if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_MONITOR_ENABLE) {
+					sctp_log_cwnd(stcb, net, (net->cwnd - old_cwnd),
+					              SCTP_CWND_LOG_FROM_FR);
+				}
+				lchk = TAILQ_FIRST(&asoc->send_queue);
+				net->partial_bytes_acked = 0;
+				/* Turn on fast recovery window */
+				asoc->fast_retran_loss_recovery = 1;
+				if (lchk == NULL) {
+					/* Mark end of the window */
+					asoc->fast_recovery_tsn = asoc->sending_seq - 1;
+				} else {
+					asoc->fast_recovery_tsn = lchk->rec.data.tsn - 1;
+				}
+				/*
+				 * CMT fast recovery -- per destination
+				 * recovery variable.
+				 */
+				net->fast_retran_loss_recovery = 1;
+				if (lchk == NULL) {
+					/* Mark end of the window */
+					net->fast_recovery_tsn = asoc->sending_seq - 1;
+				} else {
+					net->fast_recovery_tsn = lchk->rec.data.tsn - 1;
+				}
+				sctp_timer_stop(SCTP_TIMER_TYPE_SEND,
+				                stcb->sctp_ep, stcb, net,
+				                SCTP_FROM_SCTP_CC_FUNCTIONS + SCTP_LOC_5);
+				sctp_timer_start(SCTP_TIMER_TYPE_SEND,
+				                 stcb->sctp_ep, stcb, net);
+			}
+		} else if (net->net_ack > 0) {
+			/*
+			 * Mark a peg that we WOULD have done a cwnd
+			 * reduction but RFC2582 prevented this action.
+			 */
+			SCTP_STAT_INCR(sctps_fastretransinrtt);
+		}
+	}
+}
+
+static void
+sctp_cubic_cwnd_update_after_timeout(struct sctp_tcb *stcb,
+                                     struct sctp_nets *net)
+{
+	uint32_t old_cwnd;
+
+	old_cwnd = net->cwnd;
+	sctp_cubic_congestion_event(net);
+	net->cwnd = net->mtu;
+	net->partial_bytes_acked = 0;
+	/* Slow start again, with HyStart. */
+	net->cc_mod.cubic.hystart_done = 0;
+	net->cc_mod.cubic.round_min_rtt = 0;
+	net->cc_mod.cubic.last_round_min_rtt = 0;
+	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_MONITOR_ENABLE) {
+		sctp_log_cwnd(stcb, net, net->cwnd - old_cwnd, SCTP_CWND_LOG_FROM_RTX);
+	}
+}
+
+static void
+sctp_cubic_cwnd_update_after_ecn_echo(struct sctp_tcb *stcb,
+                                      struct sctp_nets *net,
+                                      int in_window,
+                                      int num_pkt_lost SCTP_UNUSED)
+{
+	uint32_t old_cwnd;
+
+	if (in_window == 0) {
+		old_cwnd = net->cwnd;
+		SCTP_STAT_INCR(sctps_ecnereducedcwnd);
+		sctp_cubic_congestion_event(net);
+		if (net->ssthresh < net->mtu) {
+			net->ssthresh = net->mtu;
+			/* here back off the timer as well, to slow us down */
+			net->RTO <<= 1;
+		}
+		net->cwnd = net->ssthresh;
+		sctp_enforce_cwnd_limit(&stcb->asoc, net);
+		if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_CWND_MONITOR_ENABLE) {
+			sctp_log_cwnd(stcb, net, (net->cwnd - old_cwnd), SCTP_CWND_LOG_FROM_SAT);
+		}
+	}
+}
+
+static void
+sctp_cubic_rtt_calculated(struct sctp_tcb *stcb SCTP_UNUSED,
+                          struct sctp_nets *net,
+                          struct timeval *now SCTP_UNUSED)
+{
+	struct cubic *cubic;
+	uint32_t rtt;
+
+	cubic = &net->cc_mod.cubic;
+	rtt = (uint32_t)min(net->rtt, 0xffffffff);
+	if (rtt == 0) {
+		rtt = 1;
+	}
+	if ((cubic->min_rtt == 0) || (rtt < cubic->min_rtt)) {
+		cubic->min_rtt = rtt;
+	}
+	if ((cubic->round_min_rtt == 0) || (rtt < cubic->round_min_rtt)) {
+		cubic->round_min_rtt = rtt;
+	}
+}
+
 const struct sctp_cc_functions sctp_cc_functions[] = {
 {
 #if defined(__Windows__) || defined(__Userspace_os_Windows)
@@ -2502,5 +3324,63 @@ const struct sctp_cc_functions sctp_cc_functions[] = {
 	.sctp_cwnd_socket_option = sctp_cwnd_rtcc_socket_option,
 	.sctp_rtt_calculated = sctp_rtt_rtcc_calculated
 #endif
+},
+{
+#if defined(__Windows__) || defined(__Userspace_os_Windows)
+	sctp_bbr_set_initial_cc_param,
+	sctp_bbr_cwnd_update_after_sack,
+	sctp_cwnd_update_exit_pf_common,
+	sctp_bbr_cwnd_update_after_fr,
+	sctp_bbr_cwnd_update_after_timeout,
+	sctp_cwnd_update_after_ecn_echo,
+	sctp_cwnd_update_after_packet_dropped,
+	sctp_cwnd_update_after_output,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	sctp_bbr_rtt_calculated,
+	sctp_bbr_pacing_rate
+#else
+	.sctp_set_initial_cc_param = sctp_bbr_set_initial_cc_param,
+	.sctp_cwnd_update_after_sack = sctp_bbr_cwnd_update_after_sack,
+	.sctp_cwnd_update_exit_pf = sctp_cwnd_update_exit_pf_common,
+	.sctp_cwnd_update_after_fr = sctp_bbr_cwnd_update_after_fr,
+	.sctp_cwnd_update_after_timeout = sctp_bbr_cwnd_update_after_timeout,
+	.sctp_cwnd_update_after_ecn_echo = sctp_cwnd_update_after_ecn_echo,
+	.sctp_cwnd_update_after_packet_dropped = sctp_cwnd_update_after_packet_dropped,
+	.sctp_cwnd_update_after_output = sctp_cwnd_update_after_output,
+	.sctp_rtt_calculated = sctp_bbr_rtt_calculated,
+	.sctp_pacing_rate = sctp_bbr_pacing_rate
+#endif
+},
+{
+#if defined(__Windows__) || defined(__Userspace_os_Windows)
+	sctp_cubic_set_initial_cc_param,
+	sctp_cubic_cwnd_update_after_sack,
+	sctp_cwnd_update_exit_pf_common,
+	sctp_cubic_cwnd_update_after_fr,
+	sctp_cubic_cwnd_update_after_timeout,
+	sctp_cubic_cwnd_update_after_ecn_echo,
+	sctp_cwnd_update_after_packet_dropped,
+	sctp_cwnd_update_after_output,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	sctp_cubic_rtt_calculated
+#else
+	.sctp_set_initial_cc_param = sctp_cubic_set_initial_cc_param,
+	.sctp_cwnd_update_after_sack = sctp_cubic_cwnd_update_after_sack,
+	.sctp_cwnd_update_exit_pf = sctp_cwnd_update_exit_pf_common,
+	.sctp_cwnd_update_after_fr = sctp_cubic_cwnd_update_after_fr,
+	.sctp_cwnd_update_after_timeout = sctp_cubic_cwnd_update_after_timeout,
+	.sctp_cwnd_update_after_ecn_echo = sctp_cubic_cwnd_update_after_ecn_echo,
+	.sctp_cwnd_update_after_packet_dropped = sctp_cwnd_update_after_packet_dropped,
+	.sctp_cwnd_update_after_output = sctp_cwnd_update_after_output,
+	.sctp_rtt_calculated = sctp_cubic_rtt_calculated
+#endif
 }
 };
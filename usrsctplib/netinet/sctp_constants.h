@@ -111,6 +111,37 @@ extern void getwintimeofday(struct timeval *tv);
 #define BETA_MIN	(1<<6)  /* 0.5 with shift << 7 */
 #define BETA_MAX	102	/* 0.8 with shift << 7 */
 
+/* Values defined for the BBR algorithm */
+#define SCTP_BBR_STARTUP	0
+#define SCTP_BBR_DRAIN		1
+#define SCTP_BBR_PROBE_BW	2
+#define SCTP_BBR_PROBE_RTT	3
+#define SCTP_BBR_UNIT		(1<<8)	/* 1.0 with shift << 8 */
+#define SCTP_BBR_HIGH_GAIN	739	/* 2.885 (2/ln 2) with shift << 8 */
+#define SCTP_BBR_DRAIN_GAIN	88	/* 1/2.885 with shift << 8 */
+#define SCTP_BBR_CWND_GAIN	512	/* 2.0 with shift << 8 */
+#define SCTP_BBR_CYCLE_LEN	8
+#define SCTP_BBR_FULL_BW_THRESH	320	/* 1.25 with shift << 8 */
+#define SCTP_BBR_FULL_BW_CNT	3
+#define SCTP_BBR_MIN_RTT_WIN	10000000 /* 10 seconds in us */
+#define SCTP_BBR_PROBE_RTT_TIME	200000	/* 200 ms in us */
+#define SCTP_BBR_MIN_CWND_MTU	4
+#define SCTP_BBR_LOSS_BETA	179	/* 0.7 with shift << 8 */
+
+/* Values defined for the CUBIC algorithm */
+#define SCTP_CUBIC_BETA		717	/* 0.7 with shift << 10 */
+#define SCTP_CUBIC_FAST_CONV	870	/* (1 + 0.7) / 2 with shift << 10 */
+#define SCTP_CUBIC_ALPHA	542	/* 3 * (1 - 0.7) / (1 + 0.7) with shift << 10 */
+#define SCTP_CUBIC_HYSTART_LOW_WINDOW	16	/* in MTUs */
+#define SCTP_CUBIC_HYSTART_MIN_ETA	4000	/* 4 ms in us */
+#define SCTP_CUBIC_HYSTART_MAX_ETA	16000	/* 16 ms in us */
+
+/* Values defined for packet pacing */
+#define SCTP_PACING_BURST_USEC	1000	/* send up to 1 ms worth of data at once */
+#define SCTP_PACING_MIN_BURST_MTU	2
+#define SCTP_PACING_SS_GAIN	512	/* 2.0 with shift << 8 */
+#define SCTP_PACING_CA_GAIN	307	/* 1.2 with shift << 8 */
+
 /* Places that CWND log can happen from */
 #define SCTP_CWND_LOG_FROM_FR	1
 #define SCTP_CWND_LOG_FROM_RTX	2
@@ -234,7 +265,17 @@ extern void getwintimeofday(struct timeval *tv);
 #define SCTP_THRESHOLD_INCR        121
 #define SCTP_FLIGHT_LOG_DWN_WP_FWD 122
 #define SCTP_FWD_TSN_CHECK         123
-#define SCTP_LOG_MAX_TYPES 124
+#define SCTP_RTX_LOG_T3            124
+#define SCTP_RTX_LOG_FR            125
+#define SCTP_PACKET_LOG_IN         126
+#define SCTP_PACKET_LOG_OUT        127
+#define SCTP_LOG_MAX_TYPES 128
+
+/* Per association histograms, see struct sctp_assoc_perf_stats. */
+#define SCTP_PERF_RTT              0
+#define SCTP_PERF_SEND_TO_ACK      1
+#define SCTP_PERF_RECV_DWELL       2
+#define SCTP_PERF_SACK_BYTES       3
 /*
  * To turn on various logging, you must first enable 'options KTR' and
  * you might want to bump the entires 'options KTR_ENTRIES=80000'.
@@ -265,8 +306,11 @@ extern void getwintimeofday(struct timeval *tv);
 #define SCTP_LOG_EVENT_MBUF 17
 #define SCTP_LOG_CHUNK_PROC 18
 #define SCTP_LOG_ERROR_RET  19
+#define SCTP_LOG_EVENT_TIMER 20
+#define SCTP_LOG_EVENT_RTX  21
+#define SCTP_LOG_EVENT_PACKET 22
 
-#define SCTP_LOG_MAX_EVENT 20
+#define SCTP_LOG_MAX_EVENT 23
 
 #define SCTP_LOCK_UNKNOWN 2
 
@@ -310,6 +354,14 @@ extern void getwintimeofday(struct timeval *tv);
 #define SCTP_SIGNATURE_SIZE	SCTP_AUTH_DIGEST_LEN_SHA1
 #define SCTP_SIGNATURE_ALOC_SIZE SCTP_SIGNATURE_SIZE
 
+/*
+ * Size of the per endpoint template for the parameters of an INIT-ACK sent
+ * without an association. Large enough for the fixed size parameters, a
+ * list of all chunk types and SCTP_INITACK_PARAMS_MAX_HMACS HMAC ids.
+ */
+#define SCTP_INITACK_PARAMS_SIZE 512
+#define SCTP_INITACK_PARAMS_MAX_HMACS 64
+
 /*
  * the SCTP protocol signature this includes the version number encoded in
  * the last 4 bits of the signature.
@@ -386,6 +438,7 @@ extern void getwintimeofday(struct timeval *tv);
 #define SCTP_OUTPUT_FROM_DRAIN          15
 #define SCTP_OUTPUT_FROM_CLOSING        16
 #define SCTP_OUTPUT_FROM_SOCKOPT        17
+#define SCTP_OUTPUT_FROM_PACING_TMR     18
 
 /* SCTP chunk types are moved sctp.h for application (NAT, FW) use */
 
@@ -564,8 +617,9 @@ extern void getwintimeofday(struct timeval *tv);
 #define SCTP_TIMER_TYPE_ASOCKILL        16
 #define SCTP_TIMER_TYPE_ADDR_WQ         17
 #define SCTP_TIMER_TYPE_PRIM_DELETED    18
+#define SCTP_TIMER_TYPE_PACING          19
 /* add new timers here - and increment LAST */
-#define SCTP_TIMER_TYPE_LAST            19
+#define SCTP_TIMER_TYPE_LAST            20
 
 #define SCTP_IS_TIMER_TYPE_VALID(t)	(((t) > SCTP_TIMER_TYPE_NONE) && \
 					 ((t) < SCTP_TIMER_TYPE_LAST))
@@ -957,6 +1011,15 @@ extern void getwintimeofday(struct timeval *tv);
  */
 #define SCTP_STACK_VTAG_HASH_SIZE   32
 
+/*
+ * Each vtag in time wait is also counted in one of these counters, so that
+ * a tag can be checked without taking the INP-INFO lock and walking the
+ * chain when the counter for it is zero.
+ */
+#define SCTP_VTAG_TIMEWAIT_FILTER_SIZE 1024
+#define SCTP_VTAG_TIMEWAIT_FILTER_INDEX(tag) \
+	(((tag) / SCTP_STACK_VTAG_HASH_SIZE) % SCTP_VTAG_TIMEWAIT_FILTER_SIZE)
+
 /*
  * Number of seconds of time wait for a vtag.
  */
@@ -1016,13 +1079,9 @@ extern void getwintimeofday(struct timeval *tv);
      (((uint8_t *)&(a)->s_addr)[1] == 254))
 
 #if defined(__Userspace__)
-#if defined(__Userspace_os_Windows)
-#define SCTP_GETTIME_TIMEVAL(x)	getwintimeofday(x)
-#define SCTP_GETPTIME_TIMEVAL(x) getwintimeofday(x) /* this doesn't seem to ever be used.. */
-#else
-#define SCTP_GETTIME_TIMEVAL(x)	gettimeofday(x, NULL)
-#define SCTP_GETPTIME_TIMEVAL(x) gettimeofday(x, NULL)
-#endif
+/* Follows the virtual clock, see usrsctp_init_virtual_clock(). */
+#define SCTP_GETTIME_TIMEVAL(x)	sctp_os_gettimeofday(x)
+#define SCTP_GETPTIME_TIMEVAL(x) sctp_os_gettimeofday(x)
 #endif
 
 #if defined(_KERNEL)
@@ -711,6 +711,61 @@ calculate_crc32c(uint32_t crc32c,
 		return (multitable_crc32c(crc32c, buffer, length));
 	}
 }
+
+#if defined(__Userspace__)
+/*
+ * Same as calculate_crc32c(), but the buffer is also copied to dst while
+ * it is being read, so each byte is only loaded once.
+ */
+static uint32_t
+calculate_crc32c_copy(uint32_t crc32c,
+                      unsigned char *dst,
+                      const unsigned char *src,
+                      unsigned int length)
+{
+#if BYTE_ORDER == LITTLE_ENDIAN
+	uint32_t term1, term2;
+	uint32_t word0, word1;
+#endif
+
+	while ((length > 0) && (((uintptr_t)src) & 0x3)) {
+		SCTP_CRC32C(crc32c, *src);
+		*dst++ = *src++;
+		length--;
+	}
+#if BYTE_ORDER == LITTLE_ENDIAN
+	while (length >= 8) {
+		word0 = *(const uint32_t *)src;
+		word1 = *(const uint32_t *)(src + 4);
+		memcpy(dst, &word0, sizeof(uint32_t));
+		memcpy(dst + 4, &word1, sizeof(uint32_t));
+		crc32c ^= word0;
+		term1 = sctp_crc_tableil8_o88[crc32c & 0x000000FF] ^
+		    sctp_crc_tableil8_o80[(crc32c >> 8) & 0x000000FF];
+		term2 = crc32c >> 16;
+		crc32c = term1 ^
+		    sctp_crc_tableil8_o72[term2 & 0x000000FF] ^
+		    sctp_crc_tableil8_o64[(term2 >> 8) & 0x000000FF];
+		term1 = sctp_crc_tableil8_o56[word1 & 0x000000FF] ^
+		    sctp_crc_tableil8_o48[(word1 >> 8) & 0x000000FF];
+		term2 = word1 >> 16;
+		crc32c = crc32c ^
+		    term1 ^
+		    sctp_crc_tableil8_o40[term2 & 0x000000FF] ^
+		    sctp_crc_tableil8_o32[(term2 >> 8) & 0x000000FF];
+		src += 8;
+		dst += 8;
+		length -= 8;
+	}
+#endif
+	while (length > 0) {
+		SCTP_CRC32C(crc32c, *src);
+		*dst++ = *src++;
+		length--;
+	}
+	return (crc32c);
+}
+#endif
 #endif /* FreeBSD < 80000 || other OS */
 
 #if defined(__Userspace__)
@@ -789,6 +844,37 @@ sctp_calculate_cksum(struct mbuf *m, uint32_t offset)
 	base = sctp_finalize_crc32c(base);
 	return (base);
 }
+
+#if defined(__Userspace__)
+uint32_t
+sctp_calculate_cksum_copy(struct mbuf *m, caddr_t buffer, uint32_t len)
+{
+	/*
+	 * Copy the first 'len' bytes of the mbuf chain 'm', which starts
+	 * with a sctphdr (with csum set to 0), to the contiguous 'buffer'
+	 * and compute the SCTP checksum in the same pass. The checksum is
+	 * returned, but not stored in 'buffer'.
+	 */
+	uint32_t base = 0xffffffff;
+	uint32_t count;
+	struct mbuf *at;
+
+	for (at = m; (at != NULL) && (len > 0); at = SCTP_BUF_NEXT(at)) {
+		if (SCTP_BUF_LEN(at) <= 0) {
+			continue;
+		}
+		count = min((uint32_t)SCTP_BUF_LEN(at), len);
+		base = calculate_crc32c_copy(base,
+		    (unsigned char *)buffer,
+		    mtod(at, unsigned char *),
+		    (unsigned int)count);
+		buffer += count;
+		len -= count;
+	}
+	base = sctp_finalize_crc32c(base);
+	return (base);
+}
+#endif
 #endif				/* !defined(SCTP_WITH_NO_CSUM) */
 
 
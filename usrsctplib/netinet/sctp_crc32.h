@@ -51,6 +51,7 @@ void sctp_delayed_cksum(struct mbuf *, uint32_t offset);
 uint32_t calculate_crc32c(uint32_t, const unsigned char *, unsigned int);
 uint32_t sctp_finalize_crc32c(uint32_t);
 uint32_t sctp_calculate_cksum(struct mbuf *, uint32_t);
+uint32_t sctp_calculate_cksum_copy(struct mbuf *, caddr_t, uint32_t);
 #endif
 #endif
 #endif				/* __crc32c_h__ */
@@ -102,6 +102,12 @@ sctp_calc_rwnd(struct sctp_tcb *stcb, struct sctp_association *asoc)
 		KASSERT(asoc->cnt_on_reasm_queue == 0, ("cnt_on_reasm_queue is %u", asoc->cnt_on_reasm_queue));
 		KASSERT(asoc->cnt_on_all_streams == 0, ("cnt_on_all_streams is %u", asoc->cnt_on_all_streams));
 		calc = max(SCTP_SB_LIMIT_RCV(stcb->sctp_socket), SCTP_MINIMAL_RWND);
+#if defined(__Userspace__)
+		/* Under memory pressure only grant the minimum. */
+		if (sctp_mem_pressure() != SCTP_MEM_PRESSURE_NONE) {
+			calc = SCTP_MINIMAL_RWND;
+		}
+#endif
 		return (calc);
 	}
 	/* get actual space */
@@ -127,6 +133,12 @@ sctp_calc_rwnd(struct sctp_tcb *stcb, struct sctp_association *asoc)
 	if (calc < stcb->asoc.my_rwnd_control_len) {
 		calc = 1;
 	}
+#if defined(__Userspace__)
+	if ((sctp_mem_pressure() != SCTP_MEM_PRESSURE_NONE) &&
+	    (calc > SCTP_MINIMAL_RWND)) {
+		calc = SCTP_MINIMAL_RWND;
+	}
+#endif
 	return (calc);
 }
 
@@ -522,7 +534,7 @@ sctp_queue_data_to_stream(struct sctp_tcb *stcb,
 	struct sctp_stream_in *strm;
 	char msg[SCTP_DIAG_INFO_LEN];
 
-	strm = &asoc->strmin[control->sinfo_stream];
+	strm = SCTP_STRMIN(asoc, control->sinfo_stream);
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_STR_LOGGING_ENABLE) {
 		sctp_log_strm_del(control, NULL, SCTP_STR_LOG_FROM_INTO_STRD);
 	}
@@ -1365,7 +1377,7 @@ sctp_queue_data_for_reasm(struct sctp_tcb *stcb, struct sctp_association *asoc,
 	int do_wakeup, unordered;
 	uint32_t lenadded;
 
-	strm = &asoc->strmin[control->sinfo_stream];
+	strm = SCTP_STRMIN(asoc, control->sinfo_stream);
 	/*
 	 * For old un-ordered data chunks.
 	 */
@@ -1818,6 +1830,11 @@ sctp_process_a_data_chunk(struct sctp_tcb *stcb, struct sctp_association *asoc,
 		}
 		return (0);
 	}
+	/* The stream is allocated when the first DATA chunk for it arrives. */
+	if (sctp_get_strmin(stcb, sid) == NULL) {
+		SCTP_STAT_INCR(sctps_nomem);
+		return (0);
+	}
 	/*
 	 * If its a fragmented message, lets see if we can
 	 * find the control on the reassembly queues.
@@ -1835,7 +1852,7 @@ sctp_process_a_data_chunk(struct sctp_tcb *stcb, struct sctp_association *asoc,
 		         mid, chk_flags);
 		goto err_out;
 	}
-	control = sctp_find_reasm_entry(&asoc->strmin[sid], mid, ordered, asoc->idata_supported);
+	control = sctp_find_reasm_entry(SCTP_STRMIN(asoc, sid), mid, ordered, asoc->idata_supported);
 	SCTPDBG(SCTP_DEBUG_XXX, "chunk_flags:0x%x look for control on queues %p\n",
 		chk_flags, control);
 	if ((chk_flags & SCTP_DATA_NOT_FRAG) != SCTP_DATA_NOT_FRAG) {
@@ -1970,20 +1987,20 @@ sctp_process_a_data_chunk(struct sctp_tcb *stcb, struct sctp_association *asoc,
 	if ((chk_flags & SCTP_DATA_FIRST_FRAG) &&
 	    (TAILQ_EMPTY(&asoc->resetHead)) &&
 	    (chk_flags & SCTP_DATA_UNORDERED) == 0 &&
-	    SCTP_MID_GE(asoc->idata_supported, asoc->strmin[sid].last_mid_delivered, mid)) {
+	    SCTP_MID_GE(asoc->idata_supported, SCTP_STRMIN(asoc, sid)->last_mid_delivered, mid)) {
 		/* The incoming sseq is behind where we last delivered? */
 		SCTPDBG(SCTP_DEBUG_INDATA1, "EVIL/Broken-Dup S-SEQ: %u delivered: %u from peer, Abort!\n",
-			mid, asoc->strmin[sid].last_mid_delivered);
+			mid, SCTP_STRMIN(asoc, sid)->last_mid_delivered);
 
 		if (asoc->idata_supported) {
 			snprintf(msg, sizeof(msg), "Delivered MID=%8.8x, got TSN=%8.8x, SID=%4.4x, MID=%8.8x",
-			         asoc->strmin[sid].last_mid_delivered,
+			         SCTP_STRMIN(asoc, sid)->last_mid_delivered,
 			         tsn,
 			         sid,
 			         mid);
 		} else {
 			snprintf(msg, sizeof(msg), "Delivered SSN=%4.4x, got TSN=%8.8x, SID=%4.4x, SSN=%4.4x",
-			         (uint16_t)asoc->strmin[sid].last_mid_delivered,
+			         (uint16_t)SCTP_STRMIN(asoc, sid)->last_mid_delivered,
 			         tsn,
 			         sid,
 			         (uint16_t)mid);
@@ -2083,8 +2100,8 @@ sctp_process_a_data_chunk(struct sctp_tcb *stcb, struct sctp_association *asoc,
 	if ((chk_flags & SCTP_DATA_NOT_FRAG) == SCTP_DATA_NOT_FRAG &&
 	    TAILQ_EMPTY(&asoc->resetHead) &&
 	    ((ordered == 0) ||
-	     (SCTP_MID_EQ(asoc->idata_supported, asoc->strmin[sid].last_mid_delivered + 1, mid) &&
-	      TAILQ_EMPTY(&asoc->strmin[sid].inqueue)))) {
+	     (SCTP_MID_EQ(asoc->idata_supported, SCTP_STRMIN(asoc, sid)->last_mid_delivered + 1, mid) &&
+	      TAILQ_EMPTY(&SCTP_STRMIN(asoc, sid)->inqueue)))) {
 		/* Candidate for express delivery */
 		/*
 		 * Its not fragmented, No PD-API is up, Nothing in the
@@ -2106,7 +2123,7 @@ sctp_process_a_data_chunk(struct sctp_tcb *stcb, struct sctp_association *asoc,
 
 		if ((chk_flags & SCTP_DATA_UNORDERED) == 0) {
 			/* for ordered, bump what we delivered */
-			asoc->strmin[sid].last_mid_delivered++;
+			SCTP_STRMIN(asoc, sid)->last_mid_delivered++;
 		}
 		SCTP_STAT_INCR(sctps_recvexpress);
 		if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_STR_LOGGING_ENABLE) {
@@ -2266,7 +2283,7 @@ finish_express_del:
 			     asoc->highest_tsn_inside_map, SCTP_MAP_PREPARE_SLIDE);
 	}
 	if (need_reasm_check) {
-		(void)sctp_deliver_reasm_check(stcb, asoc, &asoc->strmin[sid], SCTP_READ_LOCK_NOT_HELD);
+		(void)sctp_deliver_reasm_check(stcb, asoc, SCTP_STRMIN(asoc, sid), SCTP_READ_LOCK_NOT_HELD);
 		need_reasm_check = 0;
 	}
 	/* check the special flag for stream resets */
@@ -2293,7 +2310,7 @@ finish_express_del:
 					return (0);
 				}
 				if (need_reasm_check) {
-					(void)sctp_deliver_reasm_check(stcb, asoc, &asoc->strmin[control->sinfo_stream], SCTP_READ_LOCK_NOT_HELD);
+					(void)sctp_deliver_reasm_check(stcb, asoc, SCTP_STRMIN(asoc, control->sinfo_stream), SCTP_READ_LOCK_NOT_HELD);
 					need_reasm_check = 0;
 				}
 			}
@@ -2313,7 +2330,7 @@ finish_express_del:
 					return (0);
 				}
 				if (need_reasm_check) {
-					(void)sctp_deliver_reasm_check(stcb, asoc, &asoc->strmin[control->sinfo_stream], SCTP_READ_LOCK_NOT_HELD);
+					(void)sctp_deliver_reasm_check(stcb, asoc, SCTP_STRMIN(asoc, control->sinfo_stream), SCTP_READ_LOCK_NOT_HELD);
 					need_reasm_check = 0;
 				}
 			}
@@ -3087,16 +3104,16 @@ sctp_process_segment_range(struct sctp_tcb *stcb, struct sctp_tmit_chunk **p_tp1
 					/* NR Sack code here */
 					if (nr_sacking &&
 					    (tp1->sent != SCTP_DATAGRAM_NR_ACKED)) {
-						if (stcb->asoc.strmout[tp1->rec.data.sid].chunks_on_queues > 0) {
-							stcb->asoc.strmout[tp1->rec.data.sid].chunks_on_queues--;
+						if (SCTP_STRMOUT(&stcb->asoc, tp1->rec.data.sid)->chunks_on_queues > 0) {
+							SCTP_STRMOUT(&stcb->asoc, tp1->rec.data.sid)->chunks_on_queues--;
 #ifdef INVARIANTS
 						} else {
 							panic("No chunks on the queues for sid %u.", tp1->rec.data.sid);
 #endif
 						}
-						if ((stcb->asoc.strmout[tp1->rec.data.sid].chunks_on_queues == 0) &&
-						    (stcb->asoc.strmout[tp1->rec.data.sid].state == SCTP_STREAM_RESET_PENDING) &&
-						    TAILQ_EMPTY(&stcb->asoc.strmout[tp1->rec.data.sid].outqueue)) {
+						if ((SCTP_STRMOUT(&stcb->asoc, tp1->rec.data.sid)->chunks_on_queues == 0) &&
+						    (SCTP_STRMOUT(&stcb->asoc, tp1->rec.data.sid)->state == SCTP_STREAM_RESET_PENDING) &&
+						    TAILQ_EMPTY(&SCTP_STRMOUT(&stcb->asoc, tp1->rec.data.sid)->outqueue)) {
 							stcb->asoc.trigger_reset = 1;
 						}
 						tp1->sent = SCTP_DATAGRAM_NR_ACKED;
@@ -3861,6 +3878,25 @@ sctp_window_probe_recovery(struct sctp_tcb *stcb,
 	}
 }
 
+/* Records the number of bytes newly acked by this SACK, if any. */
+static void
+sctp_perf_sack_bytes(struct sctp_tcb *stcb)
+{
+	struct sctp_nets *net;
+	uint32_t bytes;
+
+	if (SCTP_BASE_SYSCTL(sctp_perf_stats_enable) == 0) {
+		return;
+	}
+	bytes = 0;
+	TAILQ_FOREACH(net, &stcb->asoc.nets, sctp_next) {
+		bytes += net->net_ack;
+	}
+	if (bytes > 0) {
+		sctp_perf_record(stcb, SCTP_PERF_SACK_BYTES, bytes);
+	}
+}
+
 void
 sctp_express_handle_sack(struct sctp_tcb *stcb, uint32_t cumack,
                          uint32_t rwnd, int *abort_now, int ecne_seen)
@@ -4044,20 +4080,24 @@ sctp_express_handle_sack(struct sctp_tcb *stcb, uint32_t cumack,
 					tp1->rec.data.chunk_was_revoked = 0;
 				}
 				if (tp1->sent != SCTP_DATAGRAM_NR_ACKED) {
-					if (asoc->strmout[tp1->rec.data.sid].chunks_on_queues > 0) {
-						asoc->strmout[tp1->rec.data.sid].chunks_on_queues--;
+					if (SCTP_STRMOUT(asoc, tp1->rec.data.sid)->chunks_on_queues > 0) {
+						SCTP_STRMOUT(asoc, tp1->rec.data.sid)->chunks_on_queues--;
 #ifdef INVARIANTS
 					} else {
 						panic("No chunks on the queues for sid %u.", tp1->rec.data.sid);
 #endif
 					}
 				}
-				if ((asoc->strmout[tp1->rec.data.sid].chunks_on_queues == 0) &&
-				    (asoc->strmout[tp1->rec.data.sid].state == SCTP_STREAM_RESET_PENDING) &&
-				    TAILQ_EMPTY(&asoc->strmout[tp1->rec.data.sid].outqueue)) {
+				if ((SCTP_STRMOUT(asoc, tp1->rec.data.sid)->chunks_on_queues == 0) &&
+				    (SCTP_STRMOUT(asoc, tp1->rec.data.sid)->state == SCTP_STREAM_RESET_PENDING) &&
+				    TAILQ_EMPTY(&SCTP_STRMOUT(asoc, tp1->rec.data.sid)->outqueue)) {
 					asoc->trigger_reset = 1;
 				}
 				TAILQ_REMOVE(&asoc->sent_queue, tp1, sctp_next);
+				if ((tp1->rec.data.rcv_flags & SCTP_DATA_LAST_FRAG) &&
+				    (tp1->sent != SCTP_FORWARD_TSN_SKIP)) {
+					sctp_perf_record_since(stcb, SCTP_PERF_SEND_TO_ACK, &tp1->rec.data.queued_time);
+				}
 				if (tp1->data) {
 					/* sa_ignore NO_NULL_CHK */
 					sctp_free_bufspace(stcb, asoc, tp1, 1);
@@ -4140,6 +4180,7 @@ sctp_express_handle_sack(struct sctp_tcb *stcb, uint32_t cumack,
 		}
 	}
 
+	sctp_perf_sack_bytes(stcb);
 	/* JRS - Use the congestion control given in the CC module */
 	if ((asoc->last_acked_seq != cumack) && (ecne_seen == 0)) {
 		TAILQ_FOREACH(net, &asoc->nets, sctp_next) {
@@ -4760,20 +4801,24 @@ sctp_handle_sack(struct mbuf *m, int offset_seg, int offset_dup,
 			break;
 		}
 		if (tp1->sent != SCTP_DATAGRAM_NR_ACKED) {
-			if (asoc->strmout[tp1->rec.data.sid].chunks_on_queues > 0) {
-				asoc->strmout[tp1->rec.data.sid].chunks_on_queues--;
+			if (SCTP_STRMOUT(asoc, tp1->rec.data.sid)->chunks_on_queues > 0) {
+				SCTP_STRMOUT(asoc, tp1->rec.data.sid)->chunks_on_queues--;
 #ifdef INVARIANTS
 			} else {
 				panic("No chunks on the queues for sid %u.", tp1->rec.data.sid);
 #endif
 			}
 		}
-		if ((asoc->strmout[tp1->rec.data.sid].chunks_on_queues == 0) &&
-		    (asoc->strmout[tp1->rec.data.sid].state == SCTP_STREAM_RESET_PENDING) &&
-		    TAILQ_EMPTY(&asoc->strmout[tp1->rec.data.sid].outqueue)) {
+		if ((SCTP_STRMOUT(asoc, tp1->rec.data.sid)->chunks_on_queues == 0) &&
+		    (SCTP_STRMOUT(asoc, tp1->rec.data.sid)->state == SCTP_STREAM_RESET_PENDING) &&
+		    TAILQ_EMPTY(&SCTP_STRMOUT(asoc, tp1->rec.data.sid)->outqueue)) {
 			asoc->trigger_reset = 1;
 		}
 		TAILQ_REMOVE(&asoc->sent_queue, tp1, sctp_next);
+		if ((tp1->rec.data.rcv_flags & SCTP_DATA_LAST_FRAG) &&
+		    (tp1->sent != SCTP_FORWARD_TSN_SKIP)) {
+			sctp_perf_record_since(stcb, SCTP_PERF_SEND_TO_ACK, &tp1->rec.data.queued_time);
+		}
 		if (PR_SCTP_ENABLED(tp1->flags)) {
 			if (asoc->pr_sctp_cnt != 0)
 				asoc->pr_sctp_cnt--;
@@ -4923,6 +4968,7 @@ sctp_handle_sack(struct mbuf *m, int offset_seg, int offset_dup,
 	else
 		asoc->saw_sack_with_nr_frags = 0;
 
+	sctp_perf_sack_bytes(stcb);
 	/* JRS - Use the congestion control given in the CC module */
 	if (ecne_seen == 0) {
 		TAILQ_FOREACH(net, &asoc->nets, sctp_next) {
@@ -5417,7 +5463,7 @@ sctp_flush_reassm_for_str_seq(struct sctp_tcb *stcb,
 	 * delivery function... to see if it can be delivered... But
 	 * for now we just dump everything on the queue.
 	 */
-	strm = &asoc->strmin[stream];
+	strm = SCTP_STRMIN(asoc, stream);
 	control = sctp_find_reasm_entry(strm, mid, ordered, asoc->idata_supported);
 	if (control == NULL) {
 		/* Not found */
@@ -5595,11 +5641,16 @@ sctp_handle_forward_tsn(struct sctp_tcb *stcb,
 
 	/* This is now done as part of clearing up the stream/seq */
 	if (asoc->idata_supported == 0) {
-		uint16_t sid;
+		uint32_t sid;
 		/* Flush all the un-ordered data based on cum-tsn */
 		SCTP_INP_READ_LOCK(stcb->sctp_ep);
 		for (sid = 0 ; sid < asoc->streamincnt; sid++) {
-			sctp_flush_reassm_for_str_seq(stcb, asoc, sid, 0, 0, new_cum_tsn);
+			if (SCTP_STRMIN_PAGE(asoc, sid) == NULL) {
+				/* Nothing was received on these streams. */
+				sid |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			sctp_flush_reassm_for_str_seq(stcb, asoc, (uint16_t)sid, 0, 0, new_cum_tsn);
 		}
 		SCTP_INP_READ_UNLOCK(stcb->sctp_ep);
 	}
@@ -5674,7 +5725,11 @@ sctp_handle_forward_tsn(struct sctp_tcb *stcb,
 				 */
 				asoc->fragmented_delivery_inprogress = 0;
 			}
-			strm = &asoc->strmin[sid];
+			strm = sctp_get_strmin(stcb, sid);
+			if (strm == NULL) {
+				SCTP_STAT_INCR(sctps_nomem);
+				break;
+			}
 			for (cur_mid = strm->last_mid_delivered; SCTP_MID_GE(asoc->idata_supported, mid, cur_mid); cur_mid++) {
 				sctp_flush_reassm_for_str_seq(stcb, asoc, sid, cur_mid, ordered, new_cum_tsn);
 			}
@@ -258,8 +258,13 @@ sctp_is_there_unsent_data(struct sctp_tcb *stcb, int so_locked
 	if (!stcb->asoc.ss_functions.sctp_ss_is_empty(stcb, asoc)) {
 		/* Check to see if some data queued */
 		for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
+			if (SCTP_STRMOUT_PAGE(asoc, i) == NULL) {
+				/* Skip the streams not allocated yet. */
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
 			/*sa_ignore FREED_MEMORY*/
-			sp = TAILQ_FIRST(&stcb->asoc.strmout[i].outqueue);
+			sp = TAILQ_FIRST(&SCTP_STRMOUT(&stcb->asoc, i)->outqueue);
 			if (sp == NULL) {
 				continue;
 			}
@@ -279,8 +284,8 @@ sctp_is_there_unsent_data(struct sctp_tcb *stcb, int so_locked
 					            sp->put_last_out);
 				}
 				atomic_subtract_int(&stcb->asoc.stream_queue_cnt, 1);
-				TAILQ_REMOVE(&stcb->asoc.strmout[i].outqueue, sp, next);
-				stcb->asoc.ss_functions.sctp_ss_remove_from_stream(stcb, asoc, &asoc->strmout[i], sp, 1);
+				TAILQ_REMOVE(&SCTP_STRMOUT(&stcb->asoc, i)->outqueue, sp, next);
+				stcb->asoc.ss_functions.sctp_ss_remove_from_stream(stcb, asoc, SCTP_STRMOUT(asoc, i), sp, 1);
 				if (sp->net) {
 					sctp_free_remote_addr(sp->net);
 					sp->net = NULL;
@@ -290,7 +295,7 @@ sctp_is_there_unsent_data(struct sctp_tcb *stcb, int so_locked
 					sp->data = NULL;
 				}
 				sctp_free_a_strmoq(stcb, sp, so_locked);
-				if (!TAILQ_EMPTY(&stcb->asoc.strmout[i].outqueue)) {
+				if (!TAILQ_EMPTY(&SCTP_STRMOUT(&stcb->asoc, i)->outqueue)) {
 					unsent_data++;
 				}
 			} else {
@@ -312,6 +317,7 @@ sctp_process_init(struct sctp_init_chunk *cp, struct sctp_tcb *stcb)
 	struct sctp_association *asoc;
 	struct sctp_nets *lnet;
 	unsigned int i;
+	uint16_t num_streams;
 
 	init = &cp->init;
 	asoc = &stcb->asoc;
@@ -344,8 +350,8 @@ sctp_process_init(struct sctp_init_chunk *cp, struct sctp_tcb *stcb)
 			if (chk->rec.data.sid >= newcnt) {
 				TAILQ_REMOVE(&asoc->send_queue, chk, sctp_next);
 				asoc->send_queue_cnt--;
-				if (asoc->strmout[chk->rec.data.sid].chunks_on_queues > 0) {
-					asoc->strmout[chk->rec.data.sid].chunks_on_queues--;
+				if (SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues > 0) {
+					SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues--;
 #ifdef INVARIANTS
 				} else {
 					panic("No chunks on the queues for sid %u.", chk->rec.data.sid);
@@ -366,7 +372,11 @@ sctp_process_init(struct sctp_init_chunk *cp, struct sctp_tcb *stcb)
 		}
 		if (asoc->strmout) {
 			for (i = newcnt; i < asoc->pre_open_streams; i++) {
-				outs = &asoc->strmout[i];
+				if (SCTP_STRMOUT_PAGE(asoc, i) == NULL) {
+					i |= SCTP_STREAM_PAGE_MASK;
+					continue;
+				}
+				outs = SCTP_STRMOUT(asoc, i);
 				TAILQ_FOREACH_SAFE(sp, &outs->outqueue, next, nsp) {
 					atomic_subtract_int(&stcb->asoc.stream_queue_cnt, 1);
 					TAILQ_REMOVE(&outs->outqueue, sp, next);
@@ -393,9 +403,14 @@ sctp_process_init(struct sctp_init_chunk *cp, struct sctp_tcb *stcb)
 	}
 	SCTP_TCB_SEND_UNLOCK(stcb);
 	asoc->streamoutcnt = asoc->pre_open_streams;
+	asoc->strmout_state = SCTP_STREAM_OPEN;
 	if (asoc->strmout) {
 		for (i = 0; i < asoc->streamoutcnt; i++) {
-			asoc->strmout[i].state = SCTP_STREAM_OPEN;
+			if (SCTP_STRMOUT_PAGE(asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			SCTP_STRMOUT(asoc, i)->state = SCTP_STREAM_OPEN;
 		}
 	}
 	/* EY - nr_sack: initialize highest tsn in nr_mapping_array */
@@ -415,31 +430,27 @@ sctp_process_init(struct sctp_init_chunk *cp, struct sctp_tcb *stcb)
 	if (asoc->strmin != NULL) {
 		/* Free the old ones */
 		for (i = 0; i < asoc->streamincnt; i++) {
-			sctp_clean_up_stream(stcb, &asoc->strmin[i].inqueue);
-			sctp_clean_up_stream(stcb, &asoc->strmin[i].uno_inqueue);
+			if (SCTP_STRMIN_PAGE(asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			sctp_clean_up_stream(stcb, &SCTP_STRMIN(asoc, i)->inqueue);
+			sctp_clean_up_stream(stcb, &SCTP_STRMIN(asoc, i)->uno_inqueue);
 		}
-		SCTP_FREE(asoc->strmin, SCTP_M_STRMI);
+		sctp_free_strmin(asoc);
 	}
 	if (asoc->max_inbound_streams > ntohs(init->num_outbound_streams)) {
-		asoc->streamincnt = ntohs(init->num_outbound_streams);
+		num_streams = ntohs(init->num_outbound_streams);
 	} else {
-		asoc->streamincnt = asoc->max_inbound_streams;
+		num_streams = asoc->max_inbound_streams;
 	}
-	SCTP_MALLOC(asoc->strmin, struct sctp_stream_in *, asoc->streamincnt *
-		    sizeof(struct sctp_stream_in), SCTP_M_STRMI);
-	if (asoc->strmin == NULL) {
+	/* The streams themselves are allocated when DATA arrives for them. */
+	if (sctp_grow_strmin(asoc, num_streams) != 0) {
 		/* we didn't get memory for the streams! */
 		SCTPDBG(SCTP_DEBUG_INPUT2, "process_init: couldn't get memory for the streams!\n");
+		asoc->streamincnt = 0;
 		return (-1);
 	}
-	for (i = 0; i < asoc->streamincnt; i++) {
-		asoc->strmin[i].sid = i;
-		asoc->strmin[i].last_mid_delivered = 0xffffffff;
-		TAILQ_INIT(&asoc->strmin[i].inqueue);
-		TAILQ_INIT(&asoc->strmin[i].uno_inqueue);
-		asoc->strmin[i].pd_api_started = 0;
-		asoc->strmin[i].delivery_started = 0;
-	}
 	/*
 	 * load_address_from_init will put the addresses into the
 	 * association when the COOKIE is processed or the INIT-ACK is
@@ -972,7 +983,7 @@ sctp_handle_shutdown(struct sctp_shutdown_chunk *cp,
 		if (asoc->control_pdapi->on_strm_q) {
 			struct sctp_stream_in *strm;
 
-			strm = &asoc->strmin[asoc->control_pdapi->sinfo_stream];
+			strm = SCTP_STRMIN(asoc, asoc->control_pdapi->sinfo_stream);
 			if (asoc->control_pdapi->on_strm_q == SCTP_ON_UNORDERED) {
 				/* Unordered */
 				TAILQ_REMOVE(&strm->uno_inqueue, asoc->control_pdapi, next_instrm);
@@ -2045,20 +2056,24 @@ sctp_process_cookie_existing(struct mbuf *m, int iphlen, int offset,
 
 		sctp_report_all_outbound(stcb, 0, 1, SCTP_SO_LOCKED);
 		for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-			stcb->asoc.strmout[i].chunks_on_queues = 0;
+			if (SCTP_STRMOUT_PAGE(asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			SCTP_STRMOUT(&stcb->asoc, i)->chunks_on_queues = 0;
 #if defined(SCTP_DETAILED_STR_STATS)
 			for (j = 0; j < SCTP_PR_SCTP_MAX + 1; j++) {
-				asoc->strmout[i].abandoned_sent[j] = 0;
-				asoc->strmout[i].abandoned_unsent[j] = 0;
+				SCTP_STRMOUT(asoc, i)->abandoned_sent[j] = 0;
+				SCTP_STRMOUT(asoc, i)->abandoned_unsent[j] = 0;
 			}
 #else
-			asoc->strmout[i].abandoned_sent[0] = 0;
-			asoc->strmout[i].abandoned_unsent[0] = 0;
+			SCTP_STRMOUT(asoc, i)->abandoned_sent[0] = 0;
+			SCTP_STRMOUT(asoc, i)->abandoned_unsent[0] = 0;
 #endif
-			stcb->asoc.strmout[i].sid = i;
-			stcb->asoc.strmout[i].next_mid_ordered = 0;
-			stcb->asoc.strmout[i].next_mid_unordered = 0;
-			stcb->asoc.strmout[i].last_msg_incomplete = 0;
+			SCTP_STRMOUT(&stcb->asoc, i)->sid = i;
+			SCTP_STRMOUT(&stcb->asoc, i)->next_mid_ordered = 0;
+			SCTP_STRMOUT(&stcb->asoc, i)->next_mid_unordered = 0;
+			SCTP_STRMOUT(&stcb->asoc, i)->last_msg_incomplete = 0;
 		}
 		/* process the INIT-ACK info (my info) */
 		asoc->my_vtag = ntohl(initack_cp->init.initiate_tag);
@@ -2627,14 +2642,14 @@ sctp_handle_cookie_echo(struct mbuf *m, int iphlen, int offset,
 	if ((cookie->time_entered.tv_sec < (long)ep->time_of_secret_change) &&
 	    (ep->current_secret_number != ep->last_secret_number)) {
 		/* it's the old cookie */
-		(void)sctp_hmac_m(SCTP_HMAC,
-		    (uint8_t *)ep->secret_key[(int)ep->last_secret_number],
-		    SCTP_SECRET_SIZE, m, cookie_offset, calc_sig, 0);
+		(void)sctp_hmac_state_compute_m(
+		    &ep->secret_hmac_state[(int)ep->last_secret_number],
+		    m, cookie_offset, calc_sig, 0);
 	} else {
 		/* it's the current cookie */
-		(void)sctp_hmac_m(SCTP_HMAC,
-		    (uint8_t *)ep->secret_key[(int)ep->current_secret_number],
-		    SCTP_SECRET_SIZE, m, cookie_offset, calc_sig, 0);
+		(void)sctp_hmac_state_compute_m(
+		    &ep->secret_hmac_state[(int)ep->current_secret_number],
+		    m, cookie_offset, calc_sig, 0);
 	}
 	/* get the signature */
 	SCTP_INP_RUNLOCK(l_inp);
@@ -2650,9 +2665,9 @@ sctp_handle_cookie_echo(struct mbuf *m, int iphlen, int offset,
 		if ((cookie->time_entered.tv_sec == (long)ep->time_of_secret_change) &&
 		    (ep->current_secret_number != ep->last_secret_number)) {
 			/* compute digest with old */
-			(void)sctp_hmac_m(SCTP_HMAC,
-			    (uint8_t *)ep->secret_key[(int)ep->last_secret_number],
-			    SCTP_SECRET_SIZE, m, cookie_offset, calc_sig, 0);
+			(void)sctp_hmac_state_compute_m(
+			    &ep->secret_hmac_state[(int)ep->last_secret_number],
+			    m, cookie_offset, calc_sig, 0);
 			/* compare */
 			if (memcmp(calc_sig, sig, SCTP_SIGNATURE_SIZE) == 0)
 				cookie_ok = 1;
@@ -3009,6 +3024,7 @@ sctp_handle_cookie_echo(struct mbuf *m, int iphlen, int offset,
 #if defined(__Userspace__)
 			inp->ulp_info = (*inp_p)->ulp_info;
 			inp->recv_callback = (*inp_p)->recv_callback;
+			inp->recv_batch_callback = (*inp_p)->recv_batch_callback;
 			inp->send_callback = (*inp_p)->send_callback;
 			inp->send_sb_threshold = (*inp_p)->send_sb_threshold;
 #endif
@@ -3679,12 +3695,20 @@ sctp_reset_in_stream(struct sctp_tcb *stcb, uint32_t number_entries, uint16_t *l
 			if (temp >= stcb->asoc.streamincnt) {
 				continue;
 			}
-			stcb->asoc.strmin[temp].last_mid_delivered = 0xffffffff;
+			if (SCTP_STRMIN_PAGE(&stcb->asoc, temp) == NULL) {
+				/* Streams not allocated yet are still in the initial state. */
+				continue;
+			}
+			SCTP_STRMIN(&stcb->asoc, temp)->last_mid_delivered = 0xffffffff;
 		}
 	} else {
 		list = NULL;
 		for (i = 0; i < stcb->asoc.streamincnt; i++) {
-			stcb->asoc.strmin[i].last_mid_delivered = 0xffffffff;
+			if (SCTP_STRMIN_PAGE(&stcb->asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			SCTP_STRMIN(&stcb->asoc, i)->last_mid_delivered = 0xffffffff;
 		}
 	}
 	sctp_ulp_notify(SCTP_NOTIFY_STR_RESET_RECV, stcb, number_entries, (void *)list, SCTP_SO_NOT_LOCKED);
@@ -3703,13 +3727,21 @@ sctp_reset_out_streams(struct sctp_tcb *stcb, uint32_t number_entries, uint16_t
 				/* no such stream */
 				continue;
 			}
-			stcb->asoc.strmout[temp].next_mid_ordered = 0;
-			stcb->asoc.strmout[temp].next_mid_unordered = 0;
+			if (SCTP_STRMOUT_PAGE(&stcb->asoc, temp) == NULL) {
+				/* Streams not allocated yet are still in the initial state. */
+				continue;
+			}
+			SCTP_STRMOUT(&stcb->asoc, temp)->next_mid_ordered = 0;
+			SCTP_STRMOUT(&stcb->asoc, temp)->next_mid_unordered = 0;
 		}
 	} else {
 		for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-			stcb->asoc.strmout[i].next_mid_ordered = 0;
-			stcb->asoc.strmout[i].next_mid_unordered = 0;
+			if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			SCTP_STRMOUT(&stcb->asoc, i)->next_mid_ordered = 0;
+			SCTP_STRMOUT(&stcb->asoc, i)->next_mid_unordered = 0;
 		}
 	}
 	sctp_ulp_notify(SCTP_NOTIFY_STR_RESET_SEND, stcb, number_entries, (void *)list, SCTP_SO_NOT_LOCKED);
@@ -3728,11 +3760,18 @@ sctp_reset_clear_pending(struct sctp_tcb *stcb, uint32_t number_entries, uint16_
 				/* no such stream */
 				continue;
 			}
-			stcb->asoc.strmout[temp].state = SCTP_STREAM_OPEN;
+			if (SCTP_STRMOUT_PAGE(&stcb->asoc, temp) == NULL) {
+				continue;
+			}
+			SCTP_STRMOUT(&stcb->asoc, temp)->state = SCTP_STREAM_OPEN;
 		}
 	} else {
 		for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-			stcb->asoc.strmout[i].state = SCTP_STREAM_OPEN;
+			if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			SCTP_STRMOUT(&stcb->asoc, i)->state = SCTP_STREAM_OPEN;
 		}
 	}
 }
@@ -3887,7 +3926,11 @@ sctp_handle_stream_reset_response(struct sctp_tcb *stcb,
 					/* Put the new streams into effect */
 					int i;
 					for ( i = asoc->streamoutcnt; i< (asoc->streamoutcnt + num_stream); i++) {
-						asoc->strmout[i].state = SCTP_STREAM_OPEN;
+						if (SCTP_STRMOUT_PAGE(asoc, i) == NULL) {
+							i |= SCTP_STREAM_PAGE_MASK;
+							continue;
+						}
+						SCTP_STRMOUT(asoc, i)->state = SCTP_STREAM_OPEN;
 					}
 					asoc->streamoutcnt += num_stream;
 					sctp_notify_stream_reset_add(stcb, stcb->asoc.streamincnt, stcb->asoc.streamoutcnt, 0);
@@ -4002,22 +4045,27 @@ sctp_handle_str_reset_request_in(struct sctp_tcb *stcb,
 			if (number_entries) {
 				for (i = 0; i < number_entries; i++) {
 					temp = ntohs(req->list_of_streams[i]);
-					if (temp >= stcb->asoc.streamoutcnt) {
+					if ((temp >= stcb->asoc.streamoutcnt) ||
+					    (sctp_get_strmout(stcb, temp) == NULL)) {
 						asoc->last_reset_action[0] = SCTP_STREAM_RESET_RESULT_DENIED;
 						goto bad_boy;
 					}
 					req->list_of_streams[i] = temp;
 				}
 				for (i = 0; i < number_entries; i++) {
-					if (stcb->asoc.strmout[req->list_of_streams[i]].state == SCTP_STREAM_OPEN) {
-						stcb->asoc.strmout[req->list_of_streams[i]].state = SCTP_STREAM_RESET_PENDING;
+					if (SCTP_STRMOUT(&stcb->asoc, req->list_of_streams[i])->state == SCTP_STREAM_OPEN) {
+						SCTP_STRMOUT(&stcb->asoc, req->list_of_streams[i])->state = SCTP_STREAM_RESET_PENDING;
 					}
 				}
 			} else {
 				/* Its all */
+				if (sctp_alloc_all_strmout(stcb) != 0) {
+					asoc->last_reset_action[0] = SCTP_STREAM_RESET_RESULT_DENIED;
+					goto bad_boy;
+				}
 				for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-					if (stcb->asoc.strmout[i].state == SCTP_STREAM_OPEN)
-						stcb->asoc.strmout[i].state = SCTP_STREAM_RESET_PENDING;
+					if (SCTP_STRMOUT(&stcb->asoc, i)->state == SCTP_STREAM_OPEN)
+						SCTP_STRMOUT(&stcb->asoc, i)->state = SCTP_STREAM_RESET_PENDING;
 				}
 			}
 			asoc->last_reset_action[0] = SCTP_STREAM_RESET_RESULT_PERFORMED;
@@ -4189,10 +4237,9 @@ sctp_handle_str_reset_add_strm(struct sctp_tcb *stcb, struct sctp_tmit_chunk *ch
 	 * If its within our max-streams we will
 	 * allow it.
 	 */
-	uint32_t num_stream, i;
+	uint32_t num_stream;
 	uint32_t seq;
 	struct sctp_association *asoc = &stcb->asoc;
-	struct sctp_queued_to_read *ctl, *nctl;
 
 	/* Get the number. */
 	seq = ntohl(str_add->request_seq);
@@ -4209,48 +4256,14 @@ sctp_handle_str_reset_add_strm(struct sctp_tcb *stcb, struct sctp_tmit_chunk *ch
   denied:
 			stcb->asoc.last_reset_action[0] = SCTP_STREAM_RESET_RESULT_DENIED;
 		} else {
-			/* Ok, we can do that :-) */
-			struct sctp_stream_in *oldstrm;
-
-			/* save off the old */
-			oldstrm = stcb->asoc.strmin;
-			SCTP_MALLOC(stcb->asoc.strmin, struct sctp_stream_in *,
-			            (num_stream * sizeof(struct sctp_stream_in)),
-			            SCTP_M_STRMI);
-			if (stcb->asoc.strmin == NULL) {
-				stcb->asoc.strmin = oldstrm;
+			/*
+			 * Ok, we can do that :-) Only the directory grows, the
+			 * streams already allocated stay where they are and the
+			 * new ones are allocated on first use.
+			 */
+			if (sctp_grow_strmin(asoc, (uint16_t)num_stream) != 0) {
 				goto denied;
 			}
-			/* copy off the old data */
-			for (i = 0; i < stcb->asoc.streamincnt; i++) {
-				TAILQ_INIT(&stcb->asoc.strmin[i].inqueue);
-				TAILQ_INIT(&stcb->asoc.strmin[i].uno_inqueue);
-				stcb->asoc.strmin[i].sid = i;
-				stcb->asoc.strmin[i].last_mid_delivered = oldstrm[i].last_mid_delivered;
-				stcb->asoc.strmin[i].delivery_started = oldstrm[i].delivery_started;
-				stcb->asoc.strmin[i].pd_api_started = oldstrm[i].pd_api_started;
-				/* now anything on those queues? */
-				TAILQ_FOREACH_SAFE(ctl, &oldstrm[i].inqueue, next_instrm, nctl) {
-					TAILQ_REMOVE(&oldstrm[i].inqueue, ctl, next_instrm);
-					TAILQ_INSERT_TAIL(&stcb->asoc.strmin[i].inqueue, ctl, next_instrm);
-				}
-				TAILQ_FOREACH_SAFE(ctl, &oldstrm[i].uno_inqueue, next_instrm, nctl) {
-					TAILQ_REMOVE(&oldstrm[i].uno_inqueue, ctl, next_instrm);
-					TAILQ_INSERT_TAIL(&stcb->asoc.strmin[i].uno_inqueue, ctl, next_instrm);
-				}
-			}
-			/* Init the new streams */
-			for (i = stcb->asoc.streamincnt; i < num_stream; i++) {
-				TAILQ_INIT(&stcb->asoc.strmin[i].inqueue);
-				TAILQ_INIT(&stcb->asoc.strmin[i].uno_inqueue);
-				stcb->asoc.strmin[i].sid = i;
-				stcb->asoc.strmin[i].last_mid_delivered = 0xffffffff;
-				stcb->asoc.strmin[i].pd_api_started = 0;
-				stcb->asoc.strmin[i].delivery_started = 0;
-			}
-			SCTP_FREE(oldstrm, SCTP_M_STRMI);
-			/* update the size */
-			stcb->asoc.streamincnt = num_stream;
 			stcb->asoc.last_reset_action[0] = SCTP_STREAM_RESET_RESULT_PERFORMED;
 			sctp_notify_stream_reset_add(stcb, stcb->asoc.streamincnt, stcb->asoc.streamoutcnt, 0);
 		}
@@ -5911,6 +5924,11 @@ sctp_common_input_processing(struct mbuf **mm, int iphlen, int offset, int lengt
 	struct sctp_nets *net = NULL;
 
 	SCTP_STAT_INCR(sctps_recvdatagrams);
+#if defined(__Userspace__)
+	sctp_recv_batch_begin();
+	SCTP_CAPTURE_PACKET(m, iphlen, length - iphlen, src, dst,
+	                    port, port ? htons(SCTP_BASE_SYSCTL(sctp_udp_tunneling_port)) : 0, 0);
+#endif
 #ifdef SCTP_AUDITING_ENABLED
 	sctp_audit_log(0xE0, 1);
 	sctp_auditing(0, inp, stcb, net);
@@ -5970,6 +5988,9 @@ sctp_common_input_processing(struct mbuf **mm, int iphlen, int offset, int lengt
 	}
 	stcb = sctp_findassociation_addr(m, offset, src, dst,
 	                                 sh, ch, &inp, &net, vrf_id);
+	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_PACKET_LOGGING_ENABLE) {
+		sctp_log_packet(stcb, sh->v_tag, (uint32_t)(length - iphlen), ch->chunk_type, SCTP_PACKET_LOG_IN);
+	}
 #if defined(INET) || defined(INET6)
 	if ((ch->chunk_type != SCTP_INITIATION) &&
 	    (net != NULL) && (net->port != port)) {
@@ -6291,6 +6312,10 @@ trigger_send:
 		SCTP_INP_DECR_REF(inp_decr);
 		SCTP_INP_WUNLOCK(inp_decr);
 	}
+#if defined(__Userspace__)
+	/* No locks are held, deliver the messages collected. */
+	sctp_recv_batch_end();
+#endif
 	return;
 }
 
@@ -550,6 +550,7 @@ struct sx {int dummy;};
 #endif
 
 #include "netinet/sctp_sha1.h"
+#include "netinet/sctp_sha256.h"
 
 #if __FreeBSD_version >= 700000
 #include <netinet/ip_options.h>
@@ -585,15 +586,25 @@ MALLOC_DECLARE(SCTP_M_TIMW);
 MALLOC_DECLARE(SCTP_M_MVRF);
 MALLOC_DECLARE(SCTP_M_ITER);
 MALLOC_DECLARE(SCTP_M_SOCKOPT);
+MALLOC_DECLARE(SCTP_M_PERF);
 
-#if defined(SCTP_LOCAL_TRACE_BUF)
+/*
+ * The sctp_log_* functions record into the per thread binary trace rings,
+ * which are read with usrsctp_trace_read(). Which events are recorded is
+ * controlled by sctp_logging_level.
+ */
+#include <user_trace.h>
+#define SCTP_CTR6(m, d, p1, p2, p3, p4, p5, p6) \
+	sctp_trace_record((uint8_t)(p1), (uint8_t)(p2), (uint32_t)(p3), (uint32_t)(p4), (uint32_t)(p5), (uint32_t)(p6))
 
-#define SCTP_GET_CYCLECOUNT get_cyclecount()
-#define SCTP_CTR6 sctp_log_trace
+/* Packets are passed to the pcapng capture, see usrsctp_capture_start(). */
+#include <user_capture.h>
 
-#else
-#define SCTP_CTR6 CTR6
-#endif
+/* Lock statistics, see usrsctp_get_lock_stats(). */
+#include <user_lock_stats.h>
+
+/* Memory accounting, see usrsctp_get_mem_stats(). */
+#include <user_mem_stats.h>
 
 /* Empty ktr statement for _Userspace__ (similar to what is done for mac) */
 #define	CTR6(m, d, p1, p2, p3, p4, p5, p6)
@@ -690,9 +701,14 @@ MALLOC_DECLARE(SCTP_M_SOCKOPT);
 #define SCTP_MALLOC(var, type, size, name)				\
 	do {								\
 		MALLOC(var, type, size, name, M_NOWAIT);		\
+		sctp_mem_malloced((void *)(var));			\
 	} while (0)
 
-#define SCTP_FREE(var, type)	FREE(var, type)
+#define SCTP_FREE(var, type)						\
+	do {								\
+		sctp_mem_freed((void *)(var));				\
+		FREE(var, type);					\
+	} while (0)
 
 #define SCTP_MALLOC_SONAME(var, type, size)				\
 	do {								\
@@ -709,19 +725,22 @@ MALLOC_DECLARE(SCTP_M_SOCKOPT);
 
 
 #if defined(SCTP_SIMPLE_ALLOCATOR)
-/*typedef size_t sctp_zone_t;*/
+/*
+ * A zone is a handle to its class in the memory accounting, which also
+ * records the element size, see user_mem_stats.c.
+ */
 #define SCTP_ZONE_INIT(zone, name, size, number) { \
-	zone = size; \
+	zone = sctp_mem_zone_init(name, size); \
 }
 
 /* __Userspace__ SCTP_ZONE_GET: allocate element from the zone */
 #define SCTP_ZONE_GET(zone, type)  \
-        (type *)malloc(zone);
+        (type *)sctp_mem_zone_alloc(zone);
 
 
 /* __Userspace__ SCTP_ZONE_FREE: free element from the zone */
 #define SCTP_ZONE_FREE(zone, element) { \
-	free(element);  \
+	sctp_mem_zone_free(zone, element);  \
 }
 
 #define SCTP_ZONE_DESTROY(zone)
@@ -996,6 +1015,11 @@ int sctp_userspace_get_mtu_from_ifn(uint32_t if_index, int af);
 #define SCTP_SHA1_UPDATE	sctp_sha1_update
 #define SCTP_SHA1_FINAL(x,y)	sctp_sha1_final((unsigned char *)x, y)
 
+#define SCTP_SHA256_CTX		struct sctp_sha256_context
+#define SCTP_SHA256_INIT	sctp_sha256_init
+#define SCTP_SHA256_UPDATE	sctp_sha256_update
+#define SCTP_SHA256_FINAL(x,y)	sctp_sha256_final((unsigned char *)x, y)
+
 /* start OOTB only stuff */
 /* TODO IFT_LOOP is in net/if_types.h on Linux */
 #define IFT_LOOP 0x18
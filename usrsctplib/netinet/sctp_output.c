@@ -3711,47 +3711,15 @@ sctp_process_cmsgs_for_init(struct sctp_tcb *stcb, struct mbuf *control, int *er
 				if (initmsg.sinit_max_init_timeo)
 					stcb->asoc.initial_init_rto_max = initmsg.sinit_max_init_timeo;
 				if (stcb->asoc.streamoutcnt < stcb->asoc.pre_open_streams) {
-					struct sctp_stream_out *tmp_str;
-					unsigned int i;
-#if defined(SCTP_DETAILED_STR_STATS)
-					int j;
-#endif
-
 					/* Default is NOT correct */
 					SCTPDBG(SCTP_DEBUG_OUTPUT1, "Ok, default:%d pre_open:%d\n",
 						stcb->asoc.streamoutcnt, stcb->asoc.pre_open_streams);
-					SCTP_TCB_UNLOCK(stcb);
-					SCTP_MALLOC(tmp_str,
-					            struct sctp_stream_out *,
-					            (stcb->asoc.pre_open_streams * sizeof(struct sctp_stream_out)),
-					            SCTP_M_STRMO);
-					SCTP_TCB_LOCK(stcb);
-					if (tmp_str != NULL) {
-						SCTP_FREE(stcb->asoc.strmout, SCTP_M_STRMO);
-						stcb->asoc.strmout = tmp_str;
-						stcb->asoc.strm_realoutsize = stcb->asoc.streamoutcnt = stcb->asoc.pre_open_streams;
+					/* The new streams are allocated on first use. */
+					if (sctp_grow_strmout(&stcb->asoc, stcb->asoc.pre_open_streams) == 0) {
+						stcb->asoc.streamoutcnt = stcb->asoc.pre_open_streams;
 					} else {
 						stcb->asoc.pre_open_streams = stcb->asoc.streamoutcnt;
 					}
-					for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-						TAILQ_INIT(&stcb->asoc.strmout[i].outqueue);
-						stcb->asoc.strmout[i].chunks_on_queues = 0;
-						stcb->asoc.strmout[i].next_mid_ordered = 0;
-						stcb->asoc.strmout[i].next_mid_unordered = 0;
-#if defined(SCTP_DETAILED_STR_STATS)
-						for (j = 0; j < SCTP_PR_SCTP_MAX + 1; j++) {
-							stcb->asoc.strmout[i].abandoned_sent[j] = 0;
-							stcb->asoc.strmout[i].abandoned_unsent[j] = 0;
-						}
-#else
-						stcb->asoc.strmout[i].abandoned_sent[0] = 0;
-						stcb->asoc.strmout[i].abandoned_unsent[0] = 0;
-#endif
-						stcb->asoc.strmout[i].sid = i;
-						stcb->asoc.strmout[i].last_msg_incomplete = 0;
-						stcb->asoc.strmout[i].state = SCTP_STREAM_OPENING;
-						stcb->asoc.ss_functions.sctp_ss_init_stream(stcb, &stcb->asoc.strmout[i], NULL);
-					}
 				}
 				break;
 #ifdef INET
@@ -4074,6 +4042,34 @@ sctp_handle_no_route(struct sctp_tcb *stcb,
 }
 #endif
 
+#if defined(__Userspace__)
+/*
+ * Linearize the AF_CONN packet 'm' into 'buffer' for handing it to the
+ * conn_output callback. If the checksum is not offloaded, it is computed
+ * while copying, so the packet is only walked once.
+ */
+static void
+sctp_conn_copy_packet(struct mbuf *m, caddr_t buffer, int len)
+{
+#if defined(SCTP_WITH_NO_CSUM)
+	SCTP_STAT_INCR(sctps_sendnocrc);
+	m_copydata(m, 0, len, buffer);
+#else
+	uint32_t checksum;
+
+	if (SCTP_BASE_VAR(crc32c_offloaded) == 0) {
+		checksum = sctp_calculate_cksum_copy(m, buffer, (uint32_t)len);
+		((struct sctphdr *)buffer)->checksum = checksum;
+		mtod(m, struct sctphdr *)->checksum = checksum;
+		SCTP_STAT_INCR(sctps_sendswcrc);
+	} else {
+		m_copydata(m, 0, len, buffer);
+		SCTP_STAT_INCR(sctps_sendhwcrc);
+	}
+#endif
+}
+#endif
+
 static int
 sctp_lowlevel_chunk_output(struct sctp_inpcb *inp,
     struct sctp_tcb *stcb,	/* may be NULL */
@@ -4133,6 +4129,7 @@ sctp_lowlevel_chunk_output(struct sctp_inpcb *inp,
 	struct udphdr *udp = NULL;
 #endif
 	uint8_t tos_value;
+	uint8_t chunk_type;
 #if defined(__APPLE__) || defined(SCTP_SO_LOCK_TESTING)
 	struct socket *so = NULL;
 #endif
@@ -4161,6 +4158,12 @@ sctp_lowlevel_chunk_output(struct sctp_inpcb *inp,
 	if ((auth != NULL) && (stcb != NULL)) {
 		sctp_fill_hmac_digest_m(m, auth_offset, auth, stcb, auth_keyid);
 	}
+	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_PACKET_LOGGING_ENABLE) {
+		/* The common header is prepended below. */
+		m_copydata(m, 0, 1, (caddr_t)&chunk_type);
+		sctp_log_packet(stcb, v_tag, (uint32_t)(sizeof(struct sctphdr) + sctp_calculate_len(m)),
+		                chunk_type, SCTP_PACKET_LOG_OUT);
+	}
 
 	if (net) {
 		tos_value = net->dscp;
@@ -5004,16 +5007,6 @@ sctp_lowlevel_chunk_output(struct sctp_inpcb *inp,
 		sctphdr->dest_port = dest_port;
 		sctphdr->v_tag = v_tag;
 		sctphdr->checksum = 0;
-#if defined(SCTP_WITH_NO_CSUM)
-		SCTP_STAT_INCR(sctps_sendnocrc);
-#else
-		if (SCTP_BASE_VAR(crc32c_offloaded) == 0) {
-			sctphdr->checksum = sctp_calculate_cksum(m, 0);
-			SCTP_STAT_INCR(sctps_sendswcrc);
-		} else {
-			SCTP_STAT_INCR(sctps_sendhwcrc);
-		}
-#endif
 		if (tos_value == 0) {
 			tos_value = inp->ip_inp.inp.inp_ip_tos;
 		}
@@ -5023,7 +5016,8 @@ sctp_lowlevel_chunk_output(struct sctp_inpcb *inp,
 		}
 		/* Don't alloc/free for each packet */
 		if ((buffer = malloc(packet_length)) != NULL) {
-			m_copydata(m, 0, packet_length, buffer);
+			sctp_conn_copy_packet(m, buffer, packet_length);
+			SCTP_CAPTURE_PACKET(m, 0, packet_length, NULL, to, 0, 0, 1);
 			ret = SCTP_BASE_VAR(conn_output)(sconn->sconn_addr, buffer, packet_length, tos_value, nofragment_flag);
 			free(buffer);
 		} else {
@@ -5894,6 +5888,194 @@ sctp_are_there_new_addresses(struct sctp_association *asoc,
 	return (0);
 }
 
+/*
+ * Add the parameters of an INIT-ACK following the fixed part of the chunk
+ * (everything except the addresses, the state cookie and error causes) to
+ * buf. Returns the number of bytes written; the padding required after the
+ * last parameter is not included but returned in *padding. If random_offset
+ * is not NULL, it is set to the offset of the random data of the RANDOM
+ * parameter or 0, if there is none.
+ */
+static uint16_t
+sctp_add_initack_params(struct sctp_inpcb *inp, struct sctp_association *asoc,
+                        int nat_friendly, caddr_t buf,
+                        uint16_t *padding, uint16_t *random_offset)
+{
+	struct sctp_adaptation_layer_indication *ali;
+	struct sctp_supported_chunk_types_param *pr_supported;
+	struct sctp_paramhdr *ph;
+	uint16_t num_ext, len, padding_len, parameter_len;
+
+	len = 0;
+	padding_len = 0;
+	if (random_offset != NULL) {
+		*random_offset = 0;
+	}
+	/* adaptation layer indication parameter */
+	if (inp->sctp_ep.adaptation_layer_indicator_provided) {
+		parameter_len = (uint16_t)sizeof(struct sctp_adaptation_layer_indication);
+		ali = (struct sctp_adaptation_layer_indication *)(buf + len);
+		ali->ph.param_type = htons(SCTP_ULP_ADAPTATION);
+		ali->ph.param_length = htons(parameter_len);
+		ali->indication = htonl(inp->sctp_ep.adaptation_layer_indicator);
+		len += parameter_len;
+	}
+
+	/* ECN parameter */
+	if (((asoc != NULL) && (asoc->ecn_supported == 1)) ||
+	    ((asoc == NULL) && (inp->ecn_supported == 1))) {
+		parameter_len = (uint16_t)sizeof(struct sctp_paramhdr);
+		ph = (struct sctp_paramhdr *)(buf + len);
+		ph->param_type = htons(SCTP_ECN_CAPABLE);
+		ph->param_length = htons(parameter_len);
+		len += parameter_len;
+	}
+
+	/* PR-SCTP supported parameter */
+	if (((asoc != NULL) && (asoc->prsctp_supported == 1)) ||
+	    ((asoc == NULL) && (inp->prsctp_supported == 1))) {
+		parameter_len = (uint16_t)sizeof(struct sctp_paramhdr);
+		ph = (struct sctp_paramhdr *)(buf + len);
+		ph->param_type = htons(SCTP_PRSCTP_SUPPORTED);
+		ph->param_length = htons(parameter_len);
+		len += parameter_len;
+	}
+
+	/* Add NAT friendly parameter */
+	if (nat_friendly) {
+		parameter_len = (uint16_t)sizeof(struct sctp_paramhdr);
+		ph = (struct sctp_paramhdr *)(buf + len);
+		ph->param_type = htons(SCTP_HAS_NAT_SUPPORT);
+		ph->param_length = htons(parameter_len);
+		len += parameter_len;
+	}
+
+	/* And now tell the peer which extensions we support */
+	num_ext = 0;
+	pr_supported = (struct sctp_supported_chunk_types_param *)(buf + len);
+	if (((asoc != NULL) && (asoc->prsctp_supported == 1)) ||
+	    ((asoc == NULL) && (inp->prsctp_supported == 1))) {
+		pr_supported->chunk_types[num_ext++] = SCTP_FORWARD_CUM_TSN;
+		if (((asoc != NULL) && (asoc->idata_supported == 1)) ||
+		    ((asoc == NULL) && (inp->idata_supported == 1))) {
+			pr_supported->chunk_types[num_ext++] = SCTP_IFORWARD_CUM_TSN;
+		}
+	}
+	if (((asoc != NULL) && (asoc->auth_supported == 1)) ||
+	    ((asoc == NULL) && (inp->auth_supported == 1))) {
+		pr_supported->chunk_types[num_ext++] = SCTP_AUTHENTICATION;
+	}
+	if (((asoc != NULL) && (asoc->asconf_supported == 1)) ||
+	    ((asoc == NULL) && (inp->asconf_supported == 1))) {
+		pr_supported->chunk_types[num_ext++] = SCTP_ASCONF;
+		pr_supported->chunk_types[num_ext++] = SCTP_ASCONF_ACK;
+	}
+	if (((asoc != NULL) && (asoc->reconfig_supported == 1)) ||
+	    ((asoc == NULL) && (inp->reconfig_supported == 1))) {
+		pr_supported->chunk_types[num_ext++] = SCTP_STREAM_RESET;
+	}
+	if (((asoc != NULL) && (asoc->idata_supported == 1)) ||
+	    ((asoc == NULL) && (inp->idata_supported == 1))) {
+		pr_supported->chunk_types[num_ext++] = SCTP_IDATA;
+	}
+	if (((asoc != NULL) && (asoc->nrsack_supported == 1)) ||
+	    ((asoc == NULL) && (inp->nrsack_supported == 1))) {
+		pr_supported->chunk_types[num_ext++] = SCTP_NR_SELECTIVE_ACK;
+	}
+	if (((asoc != NULL) && (asoc->pktdrop_supported == 1)) ||
+	    ((asoc == NULL) && (inp->pktdrop_supported == 1))) {
+		pr_supported->chunk_types[num_ext++] = SCTP_PACKET_DROPPED;
+	}
+	if (num_ext > 0) {
+		parameter_len = (uint16_t)sizeof(struct sctp_supported_chunk_types_param) + num_ext;
+		pr_supported->ph.param_type = htons(SCTP_SUPPORTED_CHUNK_EXT);
+		pr_supported->ph.param_length = htons(parameter_len);
+		padding_len = SCTP_SIZE32(parameter_len) - parameter_len;
+		len += parameter_len;
+	}
+
+	/* add authentication parameters */
+	if (((asoc != NULL) && (asoc->auth_supported == 1)) ||
+	    ((asoc == NULL) && (inp->auth_supported == 1))) {
+		struct sctp_auth_random *randp;
+		struct sctp_auth_hmac_algo *hmacs;
+		struct sctp_auth_chunk_list *chunks;
+
+		if (padding_len > 0) {
+			memset(buf + len, 0, padding_len);
+			len += padding_len;
+			padding_len = 0;
+		}
+		/* generate and add RANDOM parameter */
+		randp = (struct sctp_auth_random *)(buf + len);
+		parameter_len = (uint16_t)sizeof(struct sctp_auth_random) +
+		                SCTP_AUTH_RANDOM_SIZE_DEFAULT;
+		randp->ph.param_type = htons(SCTP_RANDOM);
+		randp->ph.param_length = htons(parameter_len);
+		SCTP_READ_RANDOM(randp->random_data, SCTP_AUTH_RANDOM_SIZE_DEFAULT);
+		if (random_offset != NULL) {
+			*random_offset = len + (uint16_t)sizeof(struct sctp_auth_random);
+		}
+		padding_len = SCTP_SIZE32(parameter_len) - parameter_len;
+		len += parameter_len;
+
+		if (padding_len > 0) {
+			memset(buf + len, 0, padding_len);
+			len += padding_len;
+			padding_len = 0;
+		}
+		/* add HMAC_ALGO parameter */
+		hmacs = (struct sctp_auth_hmac_algo *)(buf + len);
+		parameter_len = (uint16_t)sizeof(struct sctp_auth_hmac_algo) +
+		                sctp_serialize_hmaclist(inp->sctp_ep.local_hmacs,
+		                                        (uint8_t *)hmacs->hmac_ids);
+		hmacs->ph.param_type = htons(SCTP_HMAC_LIST);
+		hmacs->ph.param_length = htons(parameter_len);
+		padding_len = SCTP_SIZE32(parameter_len) - parameter_len;
+		len += parameter_len;
+
+		if (padding_len > 0) {
+			memset(buf + len, 0, padding_len);
+			len += padding_len;
+			padding_len = 0;
+		}
+		/* add CHUNKS parameter */
+		chunks = (struct sctp_auth_chunk_list *)(buf + len);
+		parameter_len = (uint16_t)sizeof(struct sctp_auth_chunk_list) +
+		                sctp_serialize_auth_chunks(inp->sctp_ep.local_auth_chunks,
+		                                           chunks->chunk_types);
+		chunks->ph.param_type = htons(SCTP_CHUNK_LIST);
+		chunks->ph.param_length = htons(parameter_len);
+		padding_len = SCTP_SIZE32(parameter_len) - parameter_len;
+		len += parameter_len;
+	}
+	*padding = padding_len;
+	return (len);
+}
+
+/*
+ * (Re)build the template used by sctp_send_initiate_ack() for INIT-ACKs
+ * sent without an association. Must be called with the INP write lock
+ * held whenever one of the endpoint settings it is built from changes.
+ * INIT processing only reads it, holding the INP read lock.
+ */
+void
+sctp_build_initack_params(struct sctp_inpcb *inp)
+{
+	inp->sctp_ep.initack_params_valid = 0;
+	if ((inp->sctp_ep.local_hmacs != NULL) &&
+	    (inp->sctp_ep.local_hmacs->num_algo > SCTP_INITACK_PARAMS_MAX_HMACS)) {
+		/* Doesn't fit, build the parameters each time. */
+		return;
+	}
+	inp->sctp_ep.initack_params_len =
+	    sctp_add_initack_params(inp, NULL, 0,
+	                            (caddr_t)inp->sctp_ep.initack_params,
+	                            &inp->sctp_ep.initack_params_padding,
+	                            &inp->sctp_ep.initack_params_random);
+	inp->sctp_ep.initack_params_valid = 1;
+}
+
 /*
  * Given a MBUF chain that was sent into us containing an INIT. Build a
  * INIT-ACK with COOKIE and send back. We assume that the in_initpkt has done
@@ -5914,9 +6096,6 @@ sctp_send_initiate_ack(struct sctp_inpcb *inp, struct sctp_tcb *stcb,
 	struct sctp_association *asoc;
 	struct mbuf *m, *m_tmp, *m_last, *m_cookie, *op_err;
 	struct sctp_init_ack_chunk *initack;
-	struct sctp_adaptation_layer_indication *ali;
-	struct sctp_supported_chunk_types_param *pr_supported;
-	struct sctp_paramhdr *ph;
 	union sctp_sockstore *over_addr;
 	struct sctp_scoping scp;
 #ifdef INET
@@ -5944,7 +6123,7 @@ sctp_send_initiate_ack(struct sctp_inpcb *inp, struct sctp_tcb *stcb,
 	int nat_friendly = 0;
 	int error;
 	struct socket *so;
-	uint16_t num_ext, chunk_len, padding_len, parameter_len;
+	uint16_t chunk_len, padding_len, parameter_len;
 
 	if (stcb) {
 		asoc = &stcb->asoc;
@@ -6386,140 +6565,21 @@ sctp_send_initiate_ack(struct sctp_inpcb *inp, struct sctp_tcb *stcb,
 	initack->init.num_inbound_streams =
 		htons(inp->sctp_ep.max_open_streams_intome);
 
-	/* adaptation layer indication parameter */
-	if (inp->sctp_ep.adaptation_layer_indicator_provided) {
-		parameter_len = (uint16_t)sizeof(struct sctp_adaptation_layer_indication);
-		ali = (struct sctp_adaptation_layer_indication *)(mtod(m, caddr_t) + chunk_len);
-		ali->ph.param_type = htons(SCTP_ULP_ADAPTATION);
-		ali->ph.param_length = htons(parameter_len);
-		ali->indication = htonl(inp->sctp_ep.adaptation_layer_indicator);
-		chunk_len += parameter_len;
-	}
-
-	/* ECN parameter */
-	if (((asoc != NULL) && (asoc->ecn_supported == 1)) ||
-	    ((asoc == NULL) && (inp->ecn_supported == 1))) {
-		parameter_len = (uint16_t)sizeof(struct sctp_paramhdr);
-		ph = (struct sctp_paramhdr *)(mtod(m, caddr_t) + chunk_len);
-		ph->param_type = htons(SCTP_ECN_CAPABLE);
-		ph->param_length = htons(parameter_len);
-		chunk_len += parameter_len;
-	}
-
-	/* PR-SCTP supported parameter */
-	if (((asoc != NULL) && (asoc->prsctp_supported == 1)) ||
-	    ((asoc == NULL) && (inp->prsctp_supported == 1))) {
-		parameter_len = (uint16_t)sizeof(struct sctp_paramhdr);
-		ph = (struct sctp_paramhdr *)(mtod(m, caddr_t) + chunk_len);
-		ph->param_type = htons(SCTP_PRSCTP_SUPPORTED);
-		ph->param_length = htons(parameter_len);
-		chunk_len += parameter_len;
-	}
-
-	/* Add NAT friendly parameter */
-	if (nat_friendly) {
-		parameter_len = (uint16_t)sizeof(struct sctp_paramhdr);
-		ph = (struct sctp_paramhdr *)(mtod(m, caddr_t) + chunk_len);
-		ph->param_type = htons(SCTP_HAS_NAT_SUPPORT);
-		ph->param_length = htons(parameter_len);
-		chunk_len += parameter_len;
-	}
-
-	/* And now tell the peer which extensions we support */
-	num_ext = 0;
-	pr_supported = (struct sctp_supported_chunk_types_param *)(mtod(m, caddr_t) + chunk_len);
-	if (((asoc != NULL) && (asoc->prsctp_supported == 1)) ||
-	    ((asoc == NULL) && (inp->prsctp_supported == 1))) {
-		pr_supported->chunk_types[num_ext++] = SCTP_FORWARD_CUM_TSN;
-		if (((asoc != NULL) && (asoc->idata_supported == 1)) ||
-		    ((asoc == NULL) && (inp->idata_supported == 1))) {
-			pr_supported->chunk_types[num_ext++] = SCTP_IFORWARD_CUM_TSN;
-		}
-	}
-	if (((asoc != NULL) && (asoc->auth_supported == 1)) ||
-	    ((asoc == NULL) && (inp->auth_supported == 1))) {
-		pr_supported->chunk_types[num_ext++] = SCTP_AUTHENTICATION;
-	}
-	if (((asoc != NULL) && (asoc->asconf_supported == 1)) ||
-	    ((asoc == NULL) && (inp->asconf_supported == 1))) {
-		pr_supported->chunk_types[num_ext++] = SCTP_ASCONF;
-		pr_supported->chunk_types[num_ext++] = SCTP_ASCONF_ACK;
-	}
-	if (((asoc != NULL) && (asoc->reconfig_supported == 1)) ||
-	    ((asoc == NULL) && (inp->reconfig_supported == 1))) {
-		pr_supported->chunk_types[num_ext++] = SCTP_STREAM_RESET;
-	}
-	if (((asoc != NULL) && (asoc->idata_supported == 1)) ||
-	    ((asoc == NULL) && (inp->idata_supported == 1))) {
-		pr_supported->chunk_types[num_ext++] = SCTP_IDATA;
-	}
-	if (((asoc != NULL) && (asoc->nrsack_supported == 1)) ||
-	    ((asoc == NULL) && (inp->nrsack_supported == 1))) {
-		pr_supported->chunk_types[num_ext++] = SCTP_NR_SELECTIVE_ACK;
-	}
-	if (((asoc != NULL) && (asoc->pktdrop_supported == 1)) ||
-	    ((asoc == NULL) && (inp->pktdrop_supported == 1))) {
-		pr_supported->chunk_types[num_ext++] = SCTP_PACKET_DROPPED;
-	}
-	if (num_ext > 0) {
-		parameter_len = (uint16_t)sizeof(struct sctp_supported_chunk_types_param) + num_ext;
-		pr_supported->ph.param_type = htons(SCTP_SUPPORTED_CHUNK_EXT);
-		pr_supported->ph.param_length = htons(parameter_len);
-		padding_len = SCTP_SIZE32(parameter_len) - parameter_len;
-		chunk_len += parameter_len;
-	}
-
-	/* add authentication parameters */
-	if (((asoc != NULL) && (asoc->auth_supported == 1)) ||
-	    ((asoc == NULL) && (inp->auth_supported == 1))) {
-		struct sctp_auth_random *randp;
-		struct sctp_auth_hmac_algo *hmacs;
-		struct sctp_auth_chunk_list *chunks;
-
-		if (padding_len > 0) {
-			memset(mtod(m, caddr_t) + chunk_len, 0, padding_len);
-			chunk_len += padding_len;
-			padding_len = 0;
-		}
-		/* generate and add RANDOM parameter */
-		randp = (struct sctp_auth_random *)(mtod(m, caddr_t) + chunk_len);
-		parameter_len = (uint16_t)sizeof(struct sctp_auth_random) +
-		                SCTP_AUTH_RANDOM_SIZE_DEFAULT;
-		randp->ph.param_type = htons(SCTP_RANDOM);
-		randp->ph.param_length = htons(parameter_len);
-		SCTP_READ_RANDOM(randp->random_data, SCTP_AUTH_RANDOM_SIZE_DEFAULT);
-		padding_len = SCTP_SIZE32(parameter_len) - parameter_len;
-		chunk_len += parameter_len;
-
-		if (padding_len > 0) {
-			memset(mtod(m, caddr_t) + chunk_len, 0, padding_len);
-			chunk_len += padding_len;
-			padding_len = 0;
-		}
-		/* add HMAC_ALGO parameter */
-		hmacs = (struct sctp_auth_hmac_algo *)(mtod(m, caddr_t) + chunk_len);
-		parameter_len = (uint16_t)sizeof(struct sctp_auth_hmac_algo) +
-		                sctp_serialize_hmaclist(inp->sctp_ep.local_hmacs,
-		                                        (uint8_t *)hmacs->hmac_ids);
-		hmacs->ph.param_type = htons(SCTP_HMAC_LIST);
-		hmacs->ph.param_length = htons(parameter_len);
-		padding_len = SCTP_SIZE32(parameter_len) - parameter_len;
-		chunk_len += parameter_len;
-
-		if (padding_len > 0) {
-			memset(mtod(m, caddr_t) + chunk_len, 0, padding_len);
-			chunk_len += padding_len;
-			padding_len = 0;
-		}
-		/* add CHUNKS parameter */
-		chunks = (struct sctp_auth_chunk_list *)(mtod(m, caddr_t) + chunk_len);
-		parameter_len = (uint16_t)sizeof(struct sctp_auth_chunk_list) +
-		                sctp_serialize_auth_chunks(inp->sctp_ep.local_auth_chunks,
-		                                           chunks->chunk_types);
-		chunks->ph.param_type = htons(SCTP_CHUNK_LIST);
-		chunks->ph.param_length = htons(parameter_len);
-		padding_len = SCTP_SIZE32(parameter_len) - parameter_len;
-		chunk_len += parameter_len;
+	if ((asoc == NULL) && (nat_friendly == 0) &&
+	    (inp->sctp_ep.initack_params_valid == 1)) {
+		/* Stateless response, use the endpoint template. */
+		memcpy(mtod(m, caddr_t) + chunk_len, inp->sctp_ep.initack_params,
+		       inp->sctp_ep.initack_params_len);
+		if (inp->sctp_ep.initack_params_random > 0) {
+			SCTP_READ_RANDOM(mtod(m, caddr_t) + chunk_len + inp->sctp_ep.initack_params_random,
+			                 SCTP_AUTH_RANDOM_SIZE_DEFAULT);
+		}
+		chunk_len += inp->sctp_ep.initack_params_len;
+		padding_len = inp->sctp_ep.initack_params_padding;
+	} else {
+		chunk_len += sctp_add_initack_params(inp, asoc, nat_friendly,
+		                                     mtod(m, caddr_t) + chunk_len,
+		                                     &padding_len, NULL);
 	}
 	SCTP_BUF_LEN(m) = chunk_len;
 	m_last = m;
@@ -6600,9 +6660,9 @@ sctp_send_initiate_ack(struct sctp_inpcb *inp, struct sctp_tcb *stcb,
 	/* Time to sign the cookie, we don't sign over the cookie
 	 * signature though thus we set trailer.
 	 */
-	(void)sctp_hmac_m(SCTP_HMAC,
-			  (uint8_t *)inp->sctp_ep.secret_key[(int)(inp->sctp_ep.current_secret_number)],
-			  SCTP_SECRET_SIZE, m_cookie, sizeof(struct sctp_paramhdr),
+	(void)sctp_hmac_state_compute_m(
+			  &inp->sctp_ep.secret_hmac_state[(int)(inp->sctp_ep.current_secret_number)],
+			  m_cookie, sizeof(struct sctp_paramhdr),
 			  (uint8_t *)signature, SCTP_SIGNATURE_SIZE);
 	/*
 	 * We sifa 0 here to NOT set IP_DF if its IPv4, we ignore the return
@@ -6848,7 +6908,12 @@ sctp_msg_append(struct sctp_tcb *stcb,
 		error = EINVAL;
 		goto out_now;
 	}
-	strm = &stcb->asoc.strmout[srcv->sinfo_stream];
+	strm = sctp_get_strmout(stcb, srcv->sinfo_stream);
+	if (strm == NULL) {
+		SCTP_LTRACE_ERR_RET(NULL, stcb, NULL, SCTP_FROM_SCTP_OUTPUT, ENOMEM);
+		error = ENOMEM;
+		goto out_now;
+	}
 	/* Now can we send this? */
 	if ((SCTP_GET_STATE(&stcb->asoc) == SCTP_STATE_SHUTDOWN_SENT) ||
 	    (SCTP_GET_STATE(&stcb->asoc) == SCTP_STATE_SHUTDOWN_ACK_SENT) ||
@@ -6876,7 +6941,8 @@ sctp_msg_append(struct sctp_tcb *stcb,
 	} else {
 		sp->net = NULL;
 	}
-	(void)SCTP_GETTIME_TIMEVAL(&sp->ts);
+	(void)SCTP_GETTIME_TIMEVAL(&sp->queued_time);
+	sp->ts = sp->queued_time;
 	sp->sid = srcv->sinfo_stream;
 	sp->msg_is_complete = 1;
 	sp->sender_all_done = 1;
@@ -8037,6 +8103,7 @@ re_look:
 	chk->rec.data.doing_fast_retransmit = 0;
 
 	chk->rec.data.timetodrop = sp->ts;
+	chk->rec.data.queued_time = sp->queued_time;
 	chk->flags = sp->act_flags;
 
 	if (sp->net) {
@@ -8275,7 +8342,11 @@ sctp_move_chunks_from_net(struct sctp_tcb *stcb, struct sctp_nets *net)
 	}
 	asoc = &stcb->asoc;
 	for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-		TAILQ_FOREACH(sp, &stcb->asoc.strmout[i].outqueue, next) {
+		if (SCTP_STRMOUT_PAGE(asoc, i) == NULL) {
+			i |= SCTP_STREAM_PAGE_MASK;
+			continue;
+		}
+		TAILQ_FOREACH(sp, &SCTP_STRMOUT(&stcb->asoc, i)->outqueue, next) {
 			if (sp->net == net) {
 				sctp_free_remote_addr(sp->net);
 				sp->net = NULL;
@@ -8290,6 +8361,63 @@ sctp_move_chunks_from_net(struct sctp_tcb *stcb, struct sctp_nets *net)
 	}
 }
 
+/*
+ * Packet pacing. If the CC module supplies a pacing rate for a destination,
+ * each packet sent to it moves net->pacing_next out by the time the packet
+ * takes at that rate. Up to SCTP_PACING_BURST_USEC worth of data (but at
+ * least SCTP_PACING_MIN_BURST_MTU packets) may still leave back to back,
+ * further data waits for the pacing timer.
+ */
+static uint64_t
+sctp_pacing_rate(struct sctp_tcb *stcb, struct sctp_nets *net)
+{
+	if (stcb->asoc.cc_functions.sctp_pacing_rate == NULL) {
+		return (0);
+	}
+	return ((*stcb->asoc.cc_functions.sctp_pacing_rate)(stcb, net));
+}
+
+static int
+sctp_pacing_blocked(struct sctp_tcb *stcb, struct sctp_nets *net)
+{
+	if (net->pacing_next == 0) {
+		return (0);
+	}
+	if (sctp_pacing_rate(stcb, net) == 0) {
+		net->pacing_next = 0;
+		return (0);
+	}
+	if (net->pacing_next <= sctp_get_time_usec()) {
+		return (0);
+	}
+	if (!SCTP_OS_TIMER_PENDING(&net->pacing_timer.timer)) {
+		sctp_timer_start(SCTP_TIMER_TYPE_PACING, stcb->sctp_ep, stcb, net);
+	}
+	return (1);
+}
+
+static void
+sctp_pacing_sent(struct sctp_tcb *stcb, struct sctp_nets *net, uint32_t len)
+{
+	uint64_t rate, now, burst;
+
+	rate = sctp_pacing_rate(stcb, net);
+	if (rate == 0) {
+		net->pacing_next = 0;
+		return;
+	}
+	now = sctp_get_time_usec();
+	burst = (uint64_t)SCTP_PACING_MIN_BURST_MTU * net->mtu * 1000000 / rate;
+	if (burst < SCTP_PACING_BURST_USEC) {
+		burst = SCTP_PACING_BURST_USEC;
+	}
+	if (net->pacing_next + burst < now) {
+		/* Idle for a while, don't let the credit grow beyond a burst. */
+		net->pacing_next = now - burst;
+	}
+	net->pacing_next += (uint64_t)len * 1000000 / rate;
+}
+
 int
 sctp_med_chunk_output(struct sctp_inpcb *inp,
 		      struct sctp_tcb *stcb,
@@ -9151,6 +9279,11 @@ again_one_more_time:
 						continue;
 					}
 				}
+				if ((bundle_at == 0) && sctp_pacing_blocked(stcb, net)) {
+					/* not yet, the pacing timer is running */
+					*reason_code = 10;
+					break;
+				}
 				if ((chk->send_size > omtu) && ((chk->flags & CHUNK_FLAGS_FRAGMENT_OK) == 0)) {
 					/*-
 					 * strange, we have a chunk that is
@@ -9377,6 +9510,7 @@ again_one_more_time:
 				}
 				SCTP_STAT_INCR_BY(sctps_senddata, bundle_at);
 				sctp_clean_up_datalist(stcb, asoc, data_list, bundle_at, net);
+				sctp_pacing_sent(stcb, net, to_out);
 			}
 			if (one_chunk) {
 				break;
@@ -10366,6 +10500,10 @@ sctp_chunk_retransmission(struct sctp_inpcb *inp,
 					data_list[i]->rec.data.chunk_was_revoked = 0;
 				}
 				data_list[i]->snd_count++;
+				if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_RTX_LOGGING_ENABLE) {
+					sctp_log_rtx(stcb, data_list[i],
+					             data_list[i]->rec.data.doing_fast_retransmit ? SCTP_RTX_LOG_FR : SCTP_RTX_LOG_T3);
+				}
 				sctp_ucount_decr(asoc->sent_queue_retran_cnt);
 				/* record the time */
 				data_list[i]->sent_rcv_time = asoc->time_last_sent;
@@ -11958,26 +12096,29 @@ sctp_send_resp_msg(struct sockaddr *src, struct sockaddr *dst,
 		struct sockaddr_conn *sconn;
 
 		sconn = (struct sockaddr_conn *)src;
-#if defined(SCTP_WITH_NO_CSUM)
-		SCTP_STAT_INCR(sctps_sendnocrc);
-#else
-		if (SCTP_BASE_VAR(crc32c_offloaded) == 0) {
-			shout->checksum = sctp_calculate_cksum(mout, 0);
-			SCTP_STAT_INCR(sctps_sendswcrc);
-		} else {
-			SCTP_STAT_INCR(sctps_sendhwcrc);
-		}
-#endif
-#ifdef SCTP_PACKET_LOGGING
-		if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LAST_PACKET_TRACING) {
-			sctp_packet_log(mout);
-		}
-#endif
 		/* Don't alloc/free for each packet */
 		if ((buffer = malloc(len)) != NULL) {
-			m_copydata(mout, 0, len, buffer);
+			sctp_conn_copy_packet(mout, buffer, len);
+			SCTP_CAPTURE_PACKET(mout, 0, len, dst, src, 0, 0, 1);
+#ifdef SCTP_PACKET_LOGGING
+			if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LAST_PACKET_TRACING) {
+				sctp_packet_log(mout);
+			}
+#endif
 			SCTP_BASE_VAR(conn_output)(sconn->sconn_addr, buffer, len, 0, 0);
 			free(buffer);
+		} else {
+#ifdef SCTP_PACKET_LOGGING
+			/* The packet is dropped, but still log it as sent. */
+			if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LAST_PACKET_TRACING) {
+#if !defined(SCTP_WITH_NO_CSUM)
+				if (SCTP_BASE_VAR(crc32c_offloaded) == 0) {
+					shout->checksum = sctp_calculate_cksum(mout, 0);
+				}
+#endif
+				sctp_packet_log(mout);
+			}
+#endif
 		}
 		sctp_m_freem(mout);
 		break;
@@ -12428,7 +12569,8 @@ static int
 sctp_add_stream_reset_out(struct sctp_tcb *stcb, struct sctp_tmit_chunk *chk,
                           uint32_t seq, uint32_t resp_seq, uint32_t last_sent)
 {
-	uint16_t len, old_len, i;
+	uint16_t len, old_len;
+	uint32_t i;
 	struct sctp_stream_reset_out_request *req_out;
 	struct sctp_chunkhdr *ch;
 	int at;
@@ -12440,9 +12582,14 @@ sctp_add_stream_reset_out(struct sctp_tcb *stcb, struct sctp_tmit_chunk *chk,
 	req_out = (struct sctp_stream_reset_out_request *)((caddr_t)ch + len);
 	/* now how long will this param be? */
 	for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-		if ((stcb->asoc.strmout[i].state == SCTP_STREAM_RESET_PENDING) &&
-		    (stcb->asoc.strmout[i].chunks_on_queues == 0) &&
-		    TAILQ_EMPTY(&stcb->asoc.strmout[i].outqueue)) {
+		if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+			/* Streams not allocated yet are not being reset. */
+			i |= SCTP_STREAM_PAGE_MASK;
+			continue;
+		}
+		if ((SCTP_STRMOUT(&stcb->asoc, i)->state == SCTP_STREAM_RESET_PENDING) &&
+		    (SCTP_STRMOUT(&stcb->asoc, i)->chunks_on_queues == 0) &&
+		    TAILQ_EMPTY(&SCTP_STRMOUT(&stcb->asoc, i)->outqueue)) {
 			number_entries++;
 		}
 	}
@@ -12464,12 +12611,16 @@ sctp_add_stream_reset_out(struct sctp_tcb *stcb, struct sctp_tmit_chunk *chk,
 	at = 0;
 	if (number_entries) {
 		for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-			if ((stcb->asoc.strmout[i].state == SCTP_STREAM_RESET_PENDING) &&
-			    (stcb->asoc.strmout[i].chunks_on_queues == 0) &&
-			    TAILQ_EMPTY(&stcb->asoc.strmout[i].outqueue)) {
-				req_out->list_of_streams[at] = htons(i);
+			if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			if ((SCTP_STRMOUT(&stcb->asoc, i)->state == SCTP_STREAM_RESET_PENDING) &&
+			    (SCTP_STRMOUT(&stcb->asoc, i)->chunks_on_queues == 0) &&
+			    TAILQ_EMPTY(&SCTP_STRMOUT(&stcb->asoc, i)->outqueue)) {
+				req_out->list_of_streams[at] = htons((uint16_t)i);
 				at++;
-				stcb->asoc.strmout[i].state = SCTP_STREAM_RESET_IN_FLIGHT;
+				SCTP_STRMOUT(&stcb->asoc, i)->state = SCTP_STREAM_RESET_IN_FLIGHT;
 				if (at >= number_entries) {
 					break;
 				}
@@ -12477,7 +12628,11 @@ sctp_add_stream_reset_out(struct sctp_tcb *stcb, struct sctp_tmit_chunk *chk,
 		}
 	} else {
 		for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-			stcb->asoc.strmout[i].state = SCTP_STREAM_RESET_IN_FLIGHT;
+			if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			SCTP_STRMOUT(&stcb->asoc, i)->state = SCTP_STREAM_RESET_IN_FLIGHT;
 		}
 	}
 	if (SCTP_SIZE32(len) > len) {
@@ -12918,73 +13073,28 @@ sctp_send_str_reset_req(struct sctp_tcb *stcb,
 	}
 	if ((add_stream & 1) &&
 	    ((stcb->asoc.strm_realoutsize - stcb->asoc.streamoutcnt) < adding_o)) {
-		/* Need to allocate more */
-		struct sctp_stream_out *oldstream;
-		struct sctp_stream_queue_pending *sp, *nsp;
-		int i;
-#if defined(SCTP_DETAILED_STR_STATS)
-		int j;
-#endif
-
-		oldstream = stcb->asoc.strmout;
-		/* get some more */
-		SCTP_MALLOC(stcb->asoc.strmout, struct sctp_stream_out *,
-			    (stcb->asoc.streamoutcnt + adding_o) * sizeof(struct sctp_stream_out),
-			    SCTP_M_STRMO);
-		if (stcb->asoc.strmout == NULL) {
+		/*
+		 * Need to allocate more. Only the directory grows, the
+		 * streams already allocated stay where they are.
+		 */
+		uint32_t i;
+
+		if (sctp_grow_strmout(&stcb->asoc, stcb->asoc.streamoutcnt + adding_o) != 0) {
 			uint8_t x;
-			stcb->asoc.strmout = oldstream;
 			/* Turn off the bit */
 			x = add_stream & 0xfe;
 			add_stream = x;
 			goto skip_stuff;
 		}
-		/* Ok now we proceed with copying the old out stuff and
-		 * initializing the new stuff.
-		 */
+		/* Reset the new streams which are already allocated. */
 		SCTP_TCB_SEND_LOCK(stcb);
-		stcb->asoc.ss_functions.sctp_ss_clear(stcb, &stcb->asoc, 0, 1);
-		for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-			TAILQ_INIT(&stcb->asoc.strmout[i].outqueue);
-			stcb->asoc.strmout[i].chunks_on_queues = oldstream[i].chunks_on_queues;
-			stcb->asoc.strmout[i].next_mid_ordered = oldstream[i].next_mid_ordered;
-			stcb->asoc.strmout[i].next_mid_unordered = oldstream[i].next_mid_unordered;
-			stcb->asoc.strmout[i].last_msg_incomplete = oldstream[i].last_msg_incomplete;
-			stcb->asoc.strmout[i].sid = i;
-			stcb->asoc.strmout[i].state = oldstream[i].state;
-			/* FIX ME FIX ME */
-			/* This should be a SS_COPY operation FIX ME STREAM SCHEDULER EXPERT */
-			stcb->asoc.ss_functions.sctp_ss_init_stream(stcb, &stcb->asoc.strmout[i], &oldstream[i]);
-			/* now anything on those queues? */
-			TAILQ_FOREACH_SAFE(sp, &oldstream[i].outqueue, next, nsp) {
-				TAILQ_REMOVE(&oldstream[i].outqueue, sp, next);
-				TAILQ_INSERT_TAIL(&stcb->asoc.strmout[i].outqueue, sp, next);
-			}
-
-		}
-		/* now the new streams */
-		stcb->asoc.ss_functions.sctp_ss_init(stcb, &stcb->asoc, 1);
-		for (i = stcb->asoc.streamoutcnt; i < (stcb->asoc.streamoutcnt + adding_o); i++) {
-			TAILQ_INIT(&stcb->asoc.strmout[i].outqueue);
-			stcb->asoc.strmout[i].chunks_on_queues = 0;
-#if defined(SCTP_DETAILED_STR_STATS)
-			for (j = 0; j < SCTP_PR_SCTP_MAX + 1; j++) {
-				stcb->asoc.strmout[i].abandoned_sent[j] = 0;
-				stcb->asoc.strmout[i].abandoned_unsent[j] = 0;
-			}
-#else
-			stcb->asoc.strmout[i].abandoned_sent[0] = 0;
-			stcb->asoc.strmout[i].abandoned_unsent[0] = 0;
-#endif
-			stcb->asoc.strmout[i].next_mid_ordered = 0;
-			stcb->asoc.strmout[i].next_mid_unordered = 0;
-			stcb->asoc.strmout[i].sid = i;
-			stcb->asoc.strmout[i].last_msg_incomplete = 0;
-			stcb->asoc.ss_functions.sctp_ss_init_stream(stcb, &stcb->asoc.strmout[i], NULL);
-			stcb->asoc.strmout[i].state = SCTP_STREAM_CLOSED;
-		}
-		stcb->asoc.strm_realoutsize = stcb->asoc.streamoutcnt + adding_o;
-		SCTP_FREE(oldstream, SCTP_M_STRMO);
+		for (i = stcb->asoc.streamoutcnt; i < (uint32_t)(stcb->asoc.streamoutcnt + adding_o); i++) {
+			if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			sctp_init_stream_out(stcb, SCTP_STRMOUT(&stcb->asoc, i), (uint16_t)i, SCTP_STREAM_CLOSED);
+		}
 		SCTP_TCB_SEND_UNLOCK(stcb);
 	}
 skip_stuff:
@@ -13288,7 +13398,8 @@ sctp_copy_it_in(struct sctp_tcb *stcb,
 	sp->ppid = srcv->sinfo_ppid;
 	sp->context = srcv->sinfo_context;
 	sp->fsn = 0;
-	(void)SCTP_GETTIME_TIMEVAL(&sp->ts);
+	(void)SCTP_GETTIME_TIMEVAL(&sp->queued_time);
+	sp->ts = sp->queued_time;
 
 	sp->sid = srcv->sinfo_stream;
 #if defined(__APPLE__)
@@ -13452,6 +13563,42 @@ sctp_sosend(struct socket *so,
 	return (error);
 }
 
+#if defined(__Userspace__)
+/*
+ * Start an output pass on the association data was queued on with
+ * SCTP_SEND_NO_OUTPUT. For one-to-one style sockets assoc_id is ignored.
+ */
+int
+sctp_output_flush(struct socket *so, sctp_assoc_t assoc_id)
+{
+	struct sctp_inpcb *inp;
+	struct sctp_tcb *stcb;
+
+	inp = (struct sctp_inpcb *)so->so_pcb;
+	if (inp == NULL) {
+		SCTP_LTRACE_ERR_RET(NULL, NULL, NULL, SCTP_FROM_SCTP_OUTPUT, EINVAL);
+		return (EINVAL);
+	}
+	if ((inp->sctp_flags & SCTP_PCB_FLAGS_TCPTYPE) ||
+	    (inp->sctp_flags & SCTP_PCB_FLAGS_IN_TCPPOOL)) {
+		SCTP_INP_RLOCK(inp);
+		stcb = LIST_FIRST(&inp->sctp_asoc_list);
+		if (stcb) {
+			SCTP_TCB_LOCK(stcb);
+		}
+		SCTP_INP_RUNLOCK(inp);
+	} else {
+		stcb = sctp_findassociation_ep_asocid(inp, assoc_id, 1);
+	}
+	if (stcb == NULL) {
+		SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_OUTPUT, ENOENT);
+		return (ENOENT);
+	}
+	sctp_chunk_output(inp, stcb, SCTP_OUTPUT_FROM_USR_SEND, SCTP_SO_LOCKED);
+	SCTP_TCB_UNLOCK(stcb);
+	return (0);
+}
+#endif
 
 int
 sctp_lower_sosend(struct socket *so,
@@ -13503,6 +13650,9 @@ sctp_lower_sosend(struct socket *so,
 	int got_all_of_the_send = 0;
 	int hold_tcblock = 0;
 	int non_blocking = 0;
+#if defined(__Userspace__)
+	int no_output;
+#endif
 	uint32_t local_add_more, local_soresv = 0;
 	uint16_t port;
 	uint16_t sinfo_flags;
@@ -13512,6 +13662,10 @@ sctp_lower_sosend(struct socket *so,
 	net = NULL;
 	stcb = NULL;
 	asoc = NULL;
+#if defined(__Userspace__)
+	no_output = (flags & SCTP_SEND_NO_OUTPUT) ? 1 : 0;
+	flags &= ~SCTP_SEND_NO_OUTPUT;
+#endif
 
 #if defined(__APPLE__)
 	sctp_lock_assert(so);
@@ -13870,6 +14024,21 @@ sctp_lower_sosend(struct socket *so,
 	    ) {
 		non_blocking = 1;
 	}
+#if defined(__Userspace__)
+	/*
+	 * Keep the memory left below the hard limit for the stack, so that
+	 * the data already queued can still be sent and acknowledged.
+	 */
+	if ((sndlen > 0) && (sctp_mem_accept_data() == 0)) {
+		if (non_blocking) {
+			error = EWOULDBLOCK;
+		} else {
+			error = ENOBUFS;
+		}
+		SCTP_LTRACE_ERR_RET(inp, stcb, net, SCTP_FROM_SCTP_OUTPUT, error);
+		goto out_unlocked;
+	}
+#endif
 	/* would we block? */
 	if (non_blocking) {
 		uint32_t amount;
@@ -13916,12 +14085,24 @@ sctp_lower_sosend(struct socket *so,
 		error = EINVAL;
 		goto out_unlocked;
 	}
-	if ((asoc->strmout[srcv->sinfo_stream].state != SCTP_STREAM_OPEN) &&
-	    (asoc->strmout[srcv->sinfo_stream].state != SCTP_STREAM_OPENING)) {
+	if (SCTP_STRMOUT_PAGE(asoc, srcv->sinfo_stream) == NULL) {
+		/* First message on a stream not allocated yet. */
+		if (hold_tcblock == 0) {
+			SCTP_TCB_LOCK(stcb);
+			hold_tcblock = 1;
+		}
+		if (sctp_get_strmout(stcb, srcv->sinfo_stream) == NULL) {
+			SCTP_LTRACE_ERR_RET(inp, stcb, net, SCTP_FROM_SCTP_OUTPUT, ENOMEM);
+			error = ENOMEM;
+			goto out_unlocked;
+		}
+	}
+	if ((SCTP_STRMOUT(asoc, srcv->sinfo_stream)->state != SCTP_STREAM_OPEN) &&
+	    (SCTP_STRMOUT(asoc, srcv->sinfo_stream)->state != SCTP_STREAM_OPENING)) {
 		/*
 		 * Can't queue any data while stream reset is underway.
 		 */
-		if (asoc->strmout[srcv->sinfo_stream].state > SCTP_STREAM_OPEN) {
+		if (SCTP_STRMOUT(asoc, srcv->sinfo_stream)->state > SCTP_STREAM_OPEN) {
 			error = EAGAIN;
 		} else {
 			error = EINVAL;
@@ -14122,6 +14303,18 @@ sctp_lower_sosend(struct socket *so,
 	    (max_len == 0) ||
 	    ((stcb->asoc.chunks_on_out_queue+stcb->asoc.stream_queue_cnt) >= SCTP_BASE_SYSCTL(sctp_max_chunks_on_queue))) {
 		/* No room right now ! */
+#if defined(__Userspace__)
+		if (no_output) {
+			/*
+			 * Data queued by earlier calls of a batch is still
+			 * waiting for sctp_output_flush(), push it out
+			 * before sleeping for space.
+			 */
+			SCTP_TCB_LOCK(stcb);
+			sctp_chunk_output(inp, stcb, SCTP_OUTPUT_FROM_USR_SEND, SCTP_SO_LOCKED);
+			SCTP_TCB_UNLOCK(stcb);
+		}
+#endif
 		SOCKBUF_LOCK(&so->so_snd);
 		inqueue_bytes = stcb->asoc.total_output_queue_size - (stcb->asoc.chunks_on_out_queue * SCTP_DATA_CHUNK_OVERHEAD(stcb));
 		while ((SCTP_SB_LIMIT_SND(so) < (inqueue_bytes + local_add_more)) ||
@@ -14207,7 +14400,7 @@ skip_preblock:
 		}
 		SCTP_TCB_SEND_UNLOCK(stcb);
 
-		strm = &stcb->asoc.strmout[srcv->sinfo_stream];
+		strm = SCTP_STRMOUT(&stcb->asoc, srcv->sinfo_stream);
 		if (strm->last_msg_incomplete == 0) {
 		do_a_copy_in:
 			sp = sctp_copy_it_in(stcb, asoc, srcv, uio, net, max_len, user_marks_eor, &error);
@@ -14712,6 +14905,12 @@ skip_out_eof:
 		}
 		asoc->ifp_had_enobuf = 0;
 	}
+#if defined(__Userspace__)
+	if (no_output) {
+		/* The caller sends the whole batch with sctp_output_flush(). */
+		queue_only = 1;
+	}
+#endif
 	un_sent = stcb->asoc.total_output_queue_size - stcb->asoc.total_flight;
 	if ((sctp_is_feature_off(inp, SCTP_PCB_FLAGS_NODELAY)) &&
 	    (stcb->asoc.total_flight > 0) &&
@@ -82,6 +82,8 @@ void sctp_send_initiate(struct sctp_inpcb *, struct sctp_tcb *, int
 #endif
     );
 
+void sctp_build_initack_params(struct sctp_inpcb *);
+
 void
 sctp_send_initiate_ack(struct sctp_inpcb *, struct sctp_tcb *,
                        struct sctp_nets *, struct mbuf *,
@@ -266,6 +268,16 @@ sctp_sosend(struct socket *so,
 #endif
 );
 
+#if defined(__Userspace__)
+/*
+ * sctp_lower_sosend() flag: only queue the user data, the caller pushes
+ * it out later with sctp_output_flush().
+ */
+#define SCTP_SEND_NO_OUTPUT 0x40000000
+
+int sctp_output_flush(struct socket *, sctp_assoc_t);
+#endif
+
 #endif
 #endif
 
@@ -2840,6 +2840,7 @@ sctp_inpcb_alloc(struct socket *so, uint32_t vrf_id)
 #if defined(__Userspace__)
 	inp->ulp_info = NULL;
 	inp->recv_callback = NULL;
+	inp->recv_batch_callback = NULL;
 	inp->send_callback = NULL;
 	inp->send_sb_threshold = 0;
 #endif
@@ -3035,8 +3036,11 @@ sctp_inpcb_alloc(struct socket *so, uint32_t vrf_id)
 	/* seed random number generator */
 	m->random_counter = 1;
 	m->store_at = SCTP_SIGNATURE_SIZE;
+#if !defined(__Userspace__)
+	/* Userspace uses read_random() directly, see sctp_select_initial_TSN() */
 	SCTP_READ_RANDOM(m->random_numbers, sizeof(m->random_numbers));
 	sctp_fill_random_store(m);
+#endif
 
 	/* Minimum cookie size */
 	m->size_of_a_cookie = (sizeof(struct sctp_init_msg) * 2) +
@@ -3050,6 +3054,8 @@ sctp_inpcb_alloc(struct socket *so, uint32_t vrf_id)
 	for (i = 0; i < SCTP_NUMBER_OF_SECRETS; i++) {
 		m->secret_key[0][i] = sctp_select_initial_TSN(m);
 	}
+	(void)sctp_hmac_state_init(&m->secret_hmac_state[0], SCTP_HMAC,
+	    (uint8_t *)m->secret_key[0], SCTP_SECRET_SIZE);
 	sctp_timer_start(SCTP_TIMER_TYPE_NEWCOOKIE, inp, NULL, NULL);
 
 	/* How long is a cookie good for ? */
@@ -3072,6 +3078,7 @@ sctp_inpcb_alloc(struct socket *so, uint32_t vrf_id)
 	/* add default NULL key as key id 0 */
 	null_key = sctp_alloc_sharedkey();
 	sctp_insert_sharedkey(&m->shared_keys, null_key);
+	sctp_build_initack_params(inp);
 	SCTP_INP_WUNLOCK(inp);
 #ifdef SCTP_LOG_CLOSING
 	sctp_log_closing(inp, NULL, 12);
@@ -3101,11 +3108,18 @@ sctp_move_pcb_and_assoc(struct sctp_inpcb *old_inp, struct sctp_inpcb *new_inp,
 	    old_inp->sctp_ep.time_of_secret_change;
 	memcpy(new_inp->sctp_ep.secret_key, old_inp->sctp_ep.secret_key,
 	    sizeof(old_inp->sctp_ep.secret_key));
+	memcpy(new_inp->sctp_ep.secret_hmac_state, old_inp->sctp_ep.secret_hmac_state,
+	    sizeof(old_inp->sctp_ep.secret_hmac_state));
 	new_inp->sctp_ep.current_secret_number =
 	    old_inp->sctp_ep.current_secret_number;
 	new_inp->sctp_ep.last_secret_number =
 	    old_inp->sctp_ep.last_secret_number;
 	new_inp->sctp_ep.size_of_a_cookie = old_inp->sctp_ep.size_of_a_cookie;
+	/*
+	 * The callers copied the endpoint settings after new_inp was
+	 * allocated, so its INIT-ACK template is stale.
+	 */
+	sctp_build_initack_params(new_inp);
 
 	/* make it so new data pours into the new socket */
 	stcb->sctp_socket = new_inp->sctp_socket;
@@ -3194,6 +3208,7 @@ sctp_move_pcb_and_assoc(struct sctp_inpcb *old_inp, struct sctp_inpcb *new_inp,
 	TAILQ_FOREACH(net, &stcb->asoc.nets, sctp_next) {
 		net->pmtu_timer.ep = (void *)new_inp;
 		net->hb_timer.ep = (void *)new_inp;
+		net->pacing_timer.ep = (void *)new_inp;
 		net->rxt_timer.ep = (void *)new_inp;
 	}
 	SCTP_INP_WUNLOCK(new_inp);
@@ -4602,6 +4617,7 @@ sctp_add_remote_addr(struct sctp_tcb *stcb, struct sockaddr *newaddr,
 	SCTP_OS_TIMER_INIT(&net->rxt_timer.timer);
 	SCTP_OS_TIMER_INIT(&net->pmtu_timer.timer);
 	SCTP_OS_TIMER_INIT(&net->hb_timer.timer);
+	SCTP_OS_TIMER_INIT(&net->pacing_timer.timer);
 
 	/* Now generate a route for this guy */
 #ifdef INET6
@@ -5093,10 +5109,7 @@ sctp_aloc_assoc(struct sctp_inpcb *inp, struct sockaddr *firstaddr,
 
 	if ((err = sctp_add_remote_addr(stcb, firstaddr, NULL, port, SCTP_DO_SETSCOPE, SCTP_ALLOC_ASOC))) {
 		/* failure.. memory error? */
-		if (asoc->strmout) {
-			SCTP_FREE(asoc->strmout, SCTP_M_STRMO);
-			asoc->strmout = NULL;
-		}
+		sctp_free_strmout(asoc);
 		if (asoc->mapping_array) {
 			SCTP_FREE(asoc->mapping_array, SCTP_M_MAP);
 			asoc->mapping_array = NULL;
@@ -5233,6 +5246,38 @@ sctp_del_remote_addr(struct sctp_tcb *stcb, struct sockaddr *remaddr)
 	return (-2);
 }
 
+static void
+sctp_timewait_set(struct sctp_timewait *twait, uint32_t tag, uint32_t expire,
+                  uint16_t lport, uint16_t rport)
+{
+	twait->tv_sec_at_expire = expire;
+	twait->v_tag = tag;
+	twait->lport = lport;
+	twait->rport = rport;
+	atomic_add_int(&SCTP_BASE_INFO(vtag_timewait_filter)[SCTP_VTAG_TIMEWAIT_FILTER_INDEX(tag)], 1);
+}
+
+/*
+ * Expired entries are also cleared by sctp_is_vtag_good() holding only the
+ * INP-INFO read lock, so two threads may clear the same entry. The entry is
+ * claimed by swapping its tag to 0 and only the winner updates the filter.
+ */
+static void
+sctp_timewait_clear(struct sctp_timewait *twait)
+{
+	uint32_t tag;
+
+	tag = twait->v_tag;
+	if ((tag == 0) ||
+	    (atomic_cmpset_int(&twait->v_tag, tag, 0) == 0)) {
+		return;
+	}
+	atomic_subtract_int(&SCTP_BASE_INFO(vtag_timewait_filter)[SCTP_VTAG_TIMEWAIT_FILTER_INDEX(tag)], 1);
+	twait->tv_sec_at_expire = 0;
+	twait->lport = 0;
+	twait->rport = 0;
+}
+
 void
 sctp_delete_from_timewait(uint32_t tag, uint16_t lport, uint16_t rport)
 {
@@ -5247,10 +5292,7 @@ sctp_delete_from_timewait(uint32_t tag, uint16_t lport, uint16_t rport)
 		  if ((twait_block->vtag_block[i].v_tag == tag) &&
 		      (twait_block->vtag_block[i].lport == lport) &&
 		      (twait_block->vtag_block[i].rport == rport)) {
-				twait_block->vtag_block[i].tv_sec_at_expire = 0;
-				twait_block->vtag_block[i].v_tag = 0;
-				twait_block->vtag_block[i].lport = 0;
-				twait_block->vtag_block[i].rport = 0;
+				sctp_timewait_clear(&twait_block->vtag_block[i]);
 				found = 1;
 				break;
 			}
@@ -5307,25 +5349,17 @@ sctp_add_vtag_to_timewait(uint32_t tag, uint32_t time, uint16_t lport, uint16_t
 		for (i = 0; i < SCTP_NUMBER_IN_VTAG_BLOCK; i++) {
 			if ((twait_block->vtag_block[i].v_tag == 0) &&
 			    !set) {
-				twait_block->vtag_block[i].tv_sec_at_expire =
-					now.tv_sec + time;
-				twait_block->vtag_block[i].v_tag = tag;
-				twait_block->vtag_block[i].lport = lport;
-				twait_block->vtag_block[i].rport = rport;
+				sctp_timewait_set(&twait_block->vtag_block[i], tag,
+				                  now.tv_sec + time, lport, rport);
 				set = 1;
 			} else if ((twait_block->vtag_block[i].v_tag) &&
 				    ((long)twait_block->vtag_block[i].tv_sec_at_expire < now.tv_sec)) {
 				/* Audit expires this guy */
-				twait_block->vtag_block[i].tv_sec_at_expire = 0;
-				twait_block->vtag_block[i].v_tag = 0;
-				twait_block->vtag_block[i].lport = 0;
-				twait_block->vtag_block[i].rport = 0;
+				sctp_timewait_clear(&twait_block->vtag_block[i]);
 				if (set == 0) {
 					/* Reuse it for my new tag */
-					twait_block->vtag_block[i].tv_sec_at_expire = now.tv_sec + time;
-					twait_block->vtag_block[i].v_tag = tag;
-					twait_block->vtag_block[i].lport = lport;
-					twait_block->vtag_block[i].rport = rport;
+					sctp_timewait_set(&twait_block->vtag_block[i], tag,
+					                  now.tv_sec + time, lport, rport);
 					set = 1;
 				}
 			}
@@ -5350,10 +5384,8 @@ sctp_add_vtag_to_timewait(uint32_t tag, uint32_t time, uint16_t lport, uint16_t
 		}
 		memset(twait_block, 0, sizeof(struct sctp_tagblock));
 		LIST_INSERT_HEAD(chain, twait_block, sctp_nxt_tagblock);
-		twait_block->vtag_block[0].tv_sec_at_expire = now.tv_sec + time;
-		twait_block->vtag_block[0].v_tag = tag;
-		twait_block->vtag_block[0].lport = lport;
-		twait_block->vtag_block[0].rport = rport;
+		sctp_timewait_set(&twait_block->vtag_block[0], tag,
+		                  now.tv_sec + time, lport, rport);
 	}
 }
 
@@ -5514,6 +5546,8 @@ sctp_free_assoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb, int from_inpcbfre
 		net->pmtu_timer.self = NULL;
 		(void)SCTP_OS_TIMER_STOP(&net->hb_timer.timer);
 		net->hb_timer.self = NULL;
+		(void)SCTP_OS_TIMER_STOP(&net->pacing_timer.timer);
+		net->pacing_timer.self = NULL;
 	}
 	/* Now the read queue needs to be cleaned up (only once) */
 	if ((stcb->asoc.state & SCTP_STATE_ABOUT_TO_BE_FREED) == 0) {
@@ -5695,6 +5729,7 @@ sctp_free_assoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb, int from_inpcbfre
 		(void)SCTP_OS_TIMER_STOP(&net->rxt_timer.timer);
 		(void)SCTP_OS_TIMER_STOP(&net->pmtu_timer.timer);
 		(void)SCTP_OS_TIMER_STOP(&net->hb_timer.timer);
+		(void)SCTP_OS_TIMER_STOP(&net->pacing_timer.timer);
 	}
 
 	asoc->strreset_timer.type = SCTP_TIMER_TYPE_NONE;
@@ -5706,7 +5741,11 @@ sctp_free_assoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb, int from_inpcbfre
 	for (i = 0; i < asoc->streamoutcnt; i++) {
 		struct sctp_stream_out *outs;
 
-		outs = &asoc->strmout[i];
+		if (SCTP_STRMOUT_PAGE(asoc, i) == NULL) {
+			i |= SCTP_STREAM_PAGE_MASK;
+			continue;
+		}
+		outs = SCTP_STRMOUT(asoc, i);
 		/* now clean up any chunks here */
 		TAILQ_FOREACH_SAFE(sp, &outs->outqueue, next, nsp) {
 			atomic_subtract_int(&asoc->stream_queue_cnt, 1);
@@ -5767,8 +5806,8 @@ sctp_free_assoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb, int from_inpcbfre
 	}
 	/* pending send queue SHOULD be empty */
 	TAILQ_FOREACH_SAFE(chk, &asoc->send_queue, sctp_next, nchk) {
-		if (asoc->strmout[chk->rec.data.sid].chunks_on_queues > 0) {
-			asoc->strmout[chk->rec.data.sid].chunks_on_queues--;
+		if (SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues > 0) {
+			SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues--;
 #ifdef INVARIANTS
 		} else {
 			panic("No chunks on the queues for sid %u.", chk->rec.data.sid);
@@ -5799,8 +5838,8 @@ sctp_free_assoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb, int from_inpcbfre
 	/* sent queue SHOULD be empty */
 	TAILQ_FOREACH_SAFE(chk, &asoc->sent_queue, sctp_next, nchk) {
 		if (chk->sent != SCTP_DATAGRAM_NR_ACKED) {
-			if (asoc->strmout[chk->rec.data.sid].chunks_on_queues > 0) {
-				asoc->strmout[chk->rec.data.sid].chunks_on_queues--;
+			if (SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues > 0) {
+				SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues--;
 #ifdef INVARIANTS
 			} else {
 				panic("No chunks on the queues for sid %u.", chk->rec.data.sid);
@@ -5828,8 +5867,12 @@ sctp_free_assoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb, int from_inpcbfre
 	}
 #ifdef INVARIANTS
 	for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-		if (stcb->asoc.strmout[i].chunks_on_queues > 0) {
-			panic("%u chunks left for stream %u.", stcb->asoc.strmout[i].chunks_on_queues, i);
+		if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+			i |= SCTP_STREAM_PAGE_MASK;
+			continue;
+		}
+		if (SCTP_STRMOUT(&stcb->asoc, i)->chunks_on_queues > 0) {
+			panic("%u chunks left for stream %u.", SCTP_STRMOUT(&stcb->asoc, i)->chunks_on_queues, i);
 		}
 	}
 #endif
@@ -5870,20 +5913,21 @@ sctp_free_assoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb, int from_inpcbfre
 		asoc->nr_mapping_array = NULL;
 	}
 	/* the stream outs */
-	if (asoc->strmout) {
-		SCTP_FREE(asoc->strmout, SCTP_M_STRMO);
-		asoc->strmout = NULL;
-	}
+	sctp_free_strmout(asoc);
 	asoc->strm_realoutsize = asoc->streamoutcnt = 0;
 	if (asoc->strmin) {
 		for (i = 0; i < asoc->streamincnt; i++) {
-			sctp_clean_up_stream(stcb, &asoc->strmin[i].inqueue);
-			sctp_clean_up_stream(stcb, &asoc->strmin[i].uno_inqueue);
+			if (SCTP_STRMIN_PAGE(asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			sctp_clean_up_stream(stcb, &SCTP_STRMIN(asoc, i)->inqueue);
+			sctp_clean_up_stream(stcb, &SCTP_STRMIN(asoc, i)->uno_inqueue);
 		}
-		SCTP_FREE(asoc->strmin, SCTP_M_STRMI);
-		asoc->strmin = NULL;
+		sctp_free_strmin(asoc);
 	}
 	asoc->streamincnt = 0;
+	sctp_perf_free(stcb);
 	TAILQ_FOREACH_SAFE(net, &asoc->nets, sctp_next, nnet) {
 #ifdef INVARIANTS
 		if (SCTP_BASE_INFO(ipi_count_raddr) == 0) {
@@ -6762,6 +6806,8 @@ sctp_pcb_init()
 	for (i = 0; i < SCTP_STACK_VTAG_HASH_SIZE; i++) {
 		LIST_INIT(&SCTP_BASE_INFO(vtag_timewait)[i]);
 	}
+	memset(SCTP_BASE_INFO(vtag_timewait_filter), 0,
+	       sizeof(SCTP_BASE_INFO(vtag_timewait_filter)));
 #if defined(SCTP_PROCESS_LEVEL_LOCKS)
 #if defined(__Userspace_os_Windows)
 	InitializeConditionVariable(&sctp_it_ctl.iterator_wakeup);
@@ -7013,6 +7059,9 @@ retry:
 	SCTP_TIMERQ_LOCK_DESTROY();
 	SCTP_ZONE_DESTROY(zone_mbuf);
 	SCTP_ZONE_DESTROY(zone_clust);
+	SCTP_ZONE_DESTROY(zone_jumbop);
+	SCTP_ZONE_DESTROY(zone_jumbo9);
+	SCTP_ZONE_DESTROY(zone_jumbo16);
 	SCTP_ZONE_DESTROY(zone_ext_refcnt);
 #endif
 	/* Get rid of other stuff too. */
@@ -7767,9 +7816,20 @@ sctp_is_vtag_good(uint32_t tag, uint16_t lport, uint16_t rport, struct timeval *
 	struct sctp_tcb *stcb;
 	int i;
 
-	SCTP_INP_INFO_RLOCK();
 	head = &SCTP_BASE_INFO(sctp_asochash)[SCTP_PCBHASH_ASOC(tag,
 								SCTP_BASE_INFO(hashasocmark))];
+	/*
+	 * Fast path without the INP-INFO lock: no association uses a tag
+	 * in this hash bucket and no tag with this filter index is in time
+	 * wait. Racing with an insertion is no different from the insertion
+	 * happening right after the check, which the locked check below
+	 * can't prevent either.
+	 */
+	if (LIST_EMPTY(head) &&
+	    (SCTP_BASE_INFO(vtag_timewait_filter)[SCTP_VTAG_TIMEWAIT_FILTER_INDEX(tag)] == 0)) {
+		return (1);
+	}
+	SCTP_INP_INFO_RLOCK();
 	LIST_FOREACH(stcb, head, sctp_asocs) {
 		/* We choose not to lock anything here. TCB's can't be
 		 * removed since we have the read lock, so they can't
@@ -7807,10 +7867,7 @@ sctp_is_vtag_good(uint32_t tag, uint16_t lport, uint16_t rport, struct timeval *
 			} else if ((long)twait_block->vtag_block[i].tv_sec_at_expire  <
 				   now->tv_sec) {
 				/* Audit expires this guy */
-				twait_block->vtag_block[i].tv_sec_at_expire = 0;
-				twait_block->vtag_block[i].v_tag = 0;
-				twait_block->vtag_block[i].lport = 0;
-				twait_block->vtag_block[i].rport = 0;
+				sctp_timewait_clear(&twait_block->vtag_block[i]);
 			} else if ((twait_block->vtag_block[i].v_tag == tag) &&
 				   (twait_block->vtag_block[i].lport == lport) &&
 				   (twait_block->vtag_block[i].rport == rport)) {
@@ -7851,7 +7908,11 @@ sctp_drain_mbufs(struct sctp_tcb *stcb)
 	cnt = 0;
 	/* Ok that was fun, now we will drain all the inbound streams? */
 	for (strmat = 0; strmat < asoc->streamincnt; strmat++) {
-		TAILQ_FOREACH_SAFE(control, &asoc->strmin[strmat].inqueue, next_instrm, ncontrol) {
+		if (SCTP_STRMIN_PAGE(asoc, strmat) == NULL) {
+			strmat |= SCTP_STREAM_PAGE_MASK;
+			continue;
+		}
+		TAILQ_FOREACH_SAFE(control, &SCTP_STRMIN(asoc, strmat)->inqueue, next_instrm, ncontrol) {
 #ifdef INVARIANTS
 			if (control->on_strm_q != SCTP_ON_ORDERED ) {
 				panic("Huh control: %p on_q: %d -- not ordered?",
@@ -7860,8 +7921,15 @@ sctp_drain_mbufs(struct sctp_tcb *stcb)
 #endif
 			if (SCTP_TSN_GT(control->sinfo_tsn, cumulative_tsn_p1)) {
 				/* Yep it is above cum-ack */
-				cnt++;
 				SCTP_CALC_TSN_TO_GAP(gap, control->sinfo_tsn, asoc->mapping_array_base_tsn);
+				if (SCTP_IS_TSN_PRESENT(asoc->nr_mapping_array, gap)) {
+					/*
+					 * The first fragment was marked non-revokable
+					 * when it was taken, so keep the message.
+					 */
+					continue;
+				}
+				cnt++;
 				KASSERT(control->length > 0, ("control has zero length"));
 				if (asoc->size_on_all_streams >= control->length) {
 					asoc->size_on_all_streams -= control->length;
@@ -7878,7 +7946,7 @@ sctp_drain_mbufs(struct sctp_tcb *stcb)
 					TAILQ_REMOVE(&stcb->sctp_ep->read_queue, control, next);
 					control->on_read_q = 0;
 				}
-				TAILQ_REMOVE(&asoc->strmin[strmat].inqueue, control, next_instrm);
+				TAILQ_REMOVE(&SCTP_STRMIN(asoc, strmat)->inqueue, control, next_instrm);
 				control->on_strm_q = 0;
 				if (control->data) {
 					sctp_m_freem(control->data);
@@ -7911,7 +7979,7 @@ sctp_drain_mbufs(struct sctp_tcb *stcb)
 				sctp_free_a_readq(stcb, control);
 			}
 		}
-		TAILQ_FOREACH_SAFE(control, &asoc->strmin[strmat].uno_inqueue, next_instrm, ncontrol) {
+		TAILQ_FOREACH_SAFE(control, &SCTP_STRMIN(asoc, strmat)->uno_inqueue, next_instrm, ncontrol) {
 #ifdef INVARIANTS
 			if (control->on_strm_q != SCTP_ON_UNORDERED ) {
 				panic("Huh control: %p on_q: %d -- not unordered?",
@@ -7920,8 +7988,15 @@ sctp_drain_mbufs(struct sctp_tcb *stcb)
 #endif
 			if (SCTP_TSN_GT(control->sinfo_tsn, cumulative_tsn_p1)) {
 				/* Yep it is above cum-ack */
-				cnt++;
 				SCTP_CALC_TSN_TO_GAP(gap, control->sinfo_tsn, asoc->mapping_array_base_tsn);
+				if (SCTP_IS_TSN_PRESENT(asoc->nr_mapping_array, gap)) {
+					/*
+					 * The first fragment was marked non-revokable
+					 * when it was taken, so keep the message.
+					 */
+					continue;
+				}
+				cnt++;
 				KASSERT(control->length > 0, ("control has zero length"));
 				if (asoc->size_on_all_streams >= control->length) {
 					asoc->size_on_all_streams -= control->length;
@@ -7938,7 +8013,7 @@ sctp_drain_mbufs(struct sctp_tcb *stcb)
 					TAILQ_REMOVE(&stcb->sctp_ep->read_queue, control, next);
 					control->on_read_q = 0;
 				}
-				TAILQ_REMOVE(&asoc->strmin[strmat].uno_inqueue, control, next_instrm);
+				TAILQ_REMOVE(&SCTP_STRMIN(asoc, strmat)->uno_inqueue, control, next_instrm);
 				control->on_strm_q = 0;
 				if (control->data) {
 					sctp_m_freem(control->data);
@@ -8024,6 +8099,30 @@ sctp_drain_mbufs(struct sctp_tcb *stcb)
 	 */
 }
 
+#if defined(__Userspace__)
+/* Return the chunks cached by the association to the zone. */
+static void
+sctp_drain_chunk_cache(struct sctp_tcb *stcb)
+{
+	struct sctp_tmit_chunk *chk, *nchk;
+
+	SCTP_TCB_LOCK_ASSERT(stcb);
+	TAILQ_FOREACH_SAFE(chk, &stcb->asoc.free_chunks, sctp_next, nchk) {
+		TAILQ_REMOVE(&stcb->asoc.free_chunks, chk, sctp_next);
+		if (chk->data) {
+			sctp_m_freem(chk->data);
+			chk->data = NULL;
+		}
+		if (chk->holds_key_ref)
+			sctp_auth_key_release(stcb, chk->auth_keyid, SCTP_SO_LOCKED);
+		SCTP_ZONE_FREE(SCTP_BASE_INFO(ipi_zone_chunk), chk);
+		SCTP_DECR_CHK_COUNT();
+		atomic_subtract_int(&SCTP_BASE_INFO(ipi_free_chunks), 1);
+	}
+	stcb->asoc.free_chunk_cnt = 0;
+}
+
+#endif
 void
 sctp_drain()
 {
@@ -8069,6 +8168,9 @@ sctp_drain()
 				/* For each association */
 				SCTP_TCB_LOCK(stcb);
 				sctp_drain_mbufs(stcb);
+#if defined(__Userspace__)
+				sctp_drain_chunk_cache(stcb);
+#endif
 				SCTP_TCB_UNLOCK(stcb);
 			}
 			SCTP_INP_RUNLOCK(inp);
@@ -8081,6 +8183,107 @@ sctp_drain()
 #endif
 }
 
+#if defined(__Userspace__)
+/*
+ * Set on the timer thread when a pass is started and cleared on the
+ * iterator thread when it is done, so it is only changed atomically.
+ */
+static volatile uint32_t sctp_idle_compact_running = 0;
+
+/*
+ * Release the memory an idle association does not need: the cached
+ * chunks and mapping arrays grown beyond their initial size. The arrays
+ * are expanded again by sctp_process_a_data_chunk() when DATA arrives.
+ * Stream state is kept, it holds the sequence numbers.
+ */
+static void
+sctp_idle_compact_assoc(struct sctp_inpcb *inp SCTP_UNUSED, struct sctp_tcb *stcb,
+                        void *ptr SCTP_UNUSED, uint32_t val)
+{
+	struct sctp_association *asoc;
+	struct timeval now, *last;
+	uint8_t *mapping_array, *nr_mapping_array;
+	int64_t idle;
+
+	SCTP_TCB_LOCK_ASSERT(stcb);
+	asoc = &stcb->asoc;
+	if (SCTP_GET_STATE(asoc) != SCTP_STATE_OPEN) {
+		return;
+	}
+	if (asoc->time_last_rcvd.tv_sec > asoc->time_last_sent.tv_sec) {
+		last = &asoc->time_last_rcvd;
+	} else {
+		last = &asoc->time_last_sent;
+	}
+	(void)SCTP_GETTIME_TIMEVAL(&now);
+	idle = (int64_t)(now.tv_sec - last->tv_sec) * 1000 +
+	       (now.tv_usec - last->tv_usec) / 1000;
+	if ((idle < (int64_t)val) ||
+	    !TAILQ_EMPTY(&asoc->send_queue) ||
+	    !TAILQ_EMPTY(&asoc->sent_queue) ||
+	    (asoc->stream_queue_cnt > 0) ||
+	    (asoc->cnt_on_reasm_queue > 0) ||
+	    (asoc->cnt_on_all_streams > 0)) {
+		return;
+	}
+	SCTP_STAT_INCR(sctps_idle_compactions);
+	sctp_drain_chunk_cache(stcb);
+	if ((asoc->mapping_array_size > SCTP_INITIAL_MAPPING_ARRAY) &&
+	    (asoc->highest_tsn_inside_map == asoc->cumulative_tsn) &&
+	    (asoc->highest_tsn_inside_nr_map == asoc->cumulative_tsn)) {
+		SCTP_MALLOC(mapping_array, uint8_t *, SCTP_INITIAL_MAPPING_ARRAY, SCTP_M_MAP);
+		SCTP_MALLOC(nr_mapping_array, uint8_t *, SCTP_INITIAL_MAPPING_ARRAY, SCTP_M_MAP);
+		if ((mapping_array == NULL) || (nr_mapping_array == NULL)) {
+			if (mapping_array != NULL) {
+				SCTP_FREE(mapping_array, SCTP_M_MAP);
+			}
+			if (nr_mapping_array != NULL) {
+				SCTP_FREE(nr_mapping_array, SCTP_M_MAP);
+			}
+			return;
+		}
+		/* Nothing is outstanding, so start over like sctp_slide_mapping_arrays(). */
+		memset(mapping_array, 0, SCTP_INITIAL_MAPPING_ARRAY);
+		memset(nr_mapping_array, 0, SCTP_INITIAL_MAPPING_ARRAY);
+		SCTP_FREE(asoc->mapping_array, SCTP_M_MAP);
+		SCTP_FREE(asoc->nr_mapping_array, SCTP_M_MAP);
+		asoc->mapping_array = mapping_array;
+		asoc->nr_mapping_array = nr_mapping_array;
+		asoc->mapping_array_size = SCTP_INITIAL_MAPPING_ARRAY;
+		asoc->mapping_array_base_tsn = asoc->cumulative_tsn + 1;
+	}
+}
+
+static void
+sctp_idle_compact_done(void *ptr SCTP_UNUSED, uint32_t val SCTP_UNUSED)
+{
+	(void)atomic_cmpset_int(&sctp_idle_compact_running, 1, 0);
+}
+
+/*
+ * Called from the timer every sctp_idle_compact_time ms. The work is
+ * done by the iterator thread, a new pass is only started when the
+ * previous one has completed.
+ */
+void
+sctp_idle_compact(void)
+{
+	uint32_t quiet_time;
+
+	quiet_time = SCTP_BASE_SYSCTL(sctp_idle_compact_time);
+	if ((quiet_time == 0) ||
+	    (atomic_cmpset_int(&sctp_idle_compact_running, 0, 1) == 0)) {
+		return;
+	}
+	if (sctp_initiate_iterator(NULL, sctp_idle_compact_assoc, NULL,
+	                           SCTP_PCB_ANY_FLAGS, SCTP_PCB_ANY_FEATURES,
+	                           SCTP_ASOC_ANY_STATE, NULL, quiet_time,
+	                           sctp_idle_compact_done, NULL, 1) != 0) {
+		(void)atomic_cmpset_int(&sctp_idle_compact_running, 1, 0);
+	}
+}
+
+#endif
 /*
  * start a new iterator
  * iterates through all endpoints and associations based on the pcb_state
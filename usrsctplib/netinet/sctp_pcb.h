@@ -275,6 +275,7 @@ struct sctp_epinfo {
 	uint32_t ipi_free_strmoq;
 
 	struct sctpvtaghead vtag_timewait[SCTP_STACK_VTAG_HASH_SIZE];
+	uint32_t vtag_timewait_filter[SCTP_VTAG_TIMEWAIT_FILTER_SIZE];
 
 	/* address work queue handling */
 	struct sctp_timer addr_wq_timer;
@@ -310,6 +311,7 @@ struct sctp_base_info {
 	userland_mutex_t timer_mtx;
 	userland_thread_t timer_thread;
 	uint8_t timer_thread_should_exit;
+	uint8_t virtual_clock;
 #if !defined(__Userspace_os_Windows)
 	pthread_mutexattr_t mtx_attr;
 #if defined(INET) || defined(INET6)
@@ -354,6 +356,8 @@ struct sctp_pcb {
 	unsigned int time_of_secret_change;	/* number of seconds from
 						 * timeval.tv_sec */
 	uint32_t secret_key[SCTP_HOW_MANY_SECRETS][SCTP_NUMBER_OF_SECRETS];
+	/* keyed hash states of the secrets, used for signing cookies */
+	sctp_hmac_state_t secret_hmac_state[SCTP_HOW_MANY_SECRETS];
 	unsigned int size_of_a_cookie;
 
 	unsigned int sctp_timeoutticks[SCTP_NUM_TMRS];
@@ -416,6 +420,18 @@ struct sctp_pcb {
 	char current_secret_number;
 	char last_secret_number;
 	uint16_t port; /* remote UDP encapsulation port */
+
+	/*
+	 * Parameters of an INIT-ACK sent without an association. The RANDOM
+	 * parameter is filled in when the template is copied. It is rebuilt
+	 * by sctp_build_initack_params() under the INP write lock whenever
+	 * one of the endpoint settings used for building it is changed.
+	 */
+	uint32_t initack_params[SCTP_INITACK_PARAMS_SIZE / sizeof(uint32_t)];
+	uint16_t initack_params_len;
+	uint16_t initack_params_random;	/* offset of the random data, 0 if none */
+	uint16_t initack_params_padding;
+	uint8_t initack_params_valid;
 };
 
 #ifndef SCTP_ALIGNMENT
@@ -595,6 +611,7 @@ struct sctp_inpcb {
 	void *ulp_info;
 	int (*recv_callback)(struct socket *, union sctp_sockstore, void *, size_t,
                              struct sctp_rcvinfo, int, void *);
+	int (*recv_batch_callback)(struct socket *, struct sctp_recvbatch_msg *, int, void *);
 	uint32_t send_sb_threshold;
 	int (*send_callback)(struct socket *, uint32_t);
 #endif
@@ -604,6 +621,8 @@ struct sctp_inpcb {
 int register_recv_cb (struct socket *,
                       int (*)(struct socket *, union sctp_sockstore, void *, size_t,
                               struct sctp_rcvinfo, int, void *));
+int register_recv_batch_cb (struct socket *,
+                            int (*)(struct socket *, struct sctp_recvbatch_msg *, int, void *));
 int register_send_cb (struct socket *, uint32_t, int (*)(struct socket *, uint32_t));
 int register_ulp_info (struct socket *, void *);
 
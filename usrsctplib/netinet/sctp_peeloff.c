@@ -151,6 +151,7 @@ sctp_do_peeloff(struct socket *head, struct socket *so, sctp_assoc_t assoc_id)
 #if defined(__Userspace__)
 	n_inp->ulp_info = inp->ulp_info;
 	n_inp->recv_callback = inp->recv_callback;
+	n_inp->recv_batch_callback = inp->recv_batch_callback;
 	n_inp->send_callback = inp->send_callback;
 	n_inp->send_sb_threshold = inp->send_sb_threshold;
 #endif
@@ -256,6 +257,7 @@ sctp_get_peeloff(struct socket *head, sctp_assoc_t assoc_id, int *error)
 #if defined(__Userspace__)
 	n_inp->ulp_info = inp->ulp_info;
 	n_inp->recv_callback = inp->recv_callback;
+	n_inp->recv_batch_callback = inp->recv_batch_callback;
 	n_inp->send_callback = inp->send_callback;
 	n_inp->send_sb_threshold = inp->send_sb_threshold;
 #endif
@@ -119,9 +119,9 @@
 #define SCTP_WQ_ADDR_DESTROY() \
 	DeleteCriticalSection(&SCTP_BASE_INFO(wq_addr_mtx))
 #define SCTP_WQ_ADDR_LOCK() \
-	EnterCriticalSection(&SCTP_BASE_INFO(wq_addr_mtx))
+	SCTP_MTX_LOCK(&SCTP_BASE_INFO(wq_addr_mtx), SCTP_LOCK_CLASS_WQ_ADDR)
 #define SCTP_WQ_ADDR_UNLOCK() \
-	LeaveCriticalSection(&SCTP_BASE_INFO(wq_addr_mtx))
+	SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(wq_addr_mtx), SCTP_LOCK_CLASS_WQ_ADDR)
 
 
 #define SCTP_INP_INFO_LOCK_INIT() \
@@ -129,24 +129,24 @@
 #define SCTP_INP_INFO_LOCK_DESTROY() \
 	DeleteCriticalSection(&SCTP_BASE_INFO(ipi_ep_mtx))
 #define SCTP_INP_INFO_RLOCK() \
-	EnterCriticalSection(&SCTP_BASE_INFO(ipi_ep_mtx))
+	SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO)
 #define SCTP_INP_INFO_TRYLOCK()	\
-	TryEnterCriticalSection(&SCTP_BASE_INFO(ipi_ep_mtx))
+	SCTP_MTX_TRYLOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO)
 #define SCTP_INP_INFO_WLOCK() \
-	EnterCriticalSection(&SCTP_BASE_INFO(ipi_ep_mtx))
+	SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO)
 #define SCTP_INP_INFO_RUNLOCK() \
-	LeaveCriticalSection(&SCTP_BASE_INFO(ipi_ep_mtx))
+	SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO)
 #define SCTP_INP_INFO_WUNLOCK()	\
-	LeaveCriticalSection(&SCTP_BASE_INFO(ipi_ep_mtx))
+	SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO)
 
 #define SCTP_IP_PKTLOG_INIT() \
 	InitializeCriticalSection(&SCTP_BASE_INFO(ipi_pktlog_mtx))
 #define SCTP_IP_PKTLOG_DESTROY () \
 	DeleteCriticalSection(&SCTP_BASE_INFO(ipi_pktlog_mtx))
 #define SCTP_IP_PKTLOG_LOCK() \
-	EnterCriticalSection(&SCTP_BASE_INFO(ipi_pktlog_mtx))
+	SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_pktlog_mtx), SCTP_LOCK_CLASS_IP_PKTLOG)
 #define SCTP_IP_PKTLOG_UNLOCK() \
-	LeaveCriticalSection(&SCTP_BASE_INFO(ipi_pktlog_mtx))
+	SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_pktlog_mtx), SCTP_LOCK_CLASS_IP_PKTLOG)
 
 /*
  * The INP locks we will use for locking an SCTP endpoint, so for example if
@@ -158,9 +158,9 @@
 #define SCTP_INP_READ_DESTROY(_inp) \
 	DeleteCriticalSection(&(_inp)->inp_rdata_mtx)
 #define SCTP_INP_READ_LOCK(_inp) \
-	EnterCriticalSection(&(_inp)->inp_rdata_mtx)
+	SCTP_MTX_LOCK(&(_inp)->inp_rdata_mtx, SCTP_LOCK_CLASS_INP_READ)
 #define SCTP_INP_READ_UNLOCK(_inp) \
-	LeaveCriticalSection(&(_inp)->inp_rdata_mtx)
+	SCTP_MTX_UNLOCK(&(_inp)->inp_rdata_mtx, SCTP_LOCK_CLASS_INP_READ)
 
 #define SCTP_INP_LOCK_INIT(_inp) \
 	InitializeCriticalSection(&(_inp)->inp_mtx)
@@ -170,18 +170,18 @@
 #define SCTP_INP_RLOCK(_inp) do { 						\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE)	\
 		sctp_log_lock(_inp, NULL, SCTP_LOG_LOCK_INP);			\
-		EnterCriticalSection(&(_inp)->inp_mtx);				\
+		SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP);				\
 } while (0)
 #define SCTP_INP_WLOCK(_inp) do { 						\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE)	\
 		sctp_log_lock(_inp, NULL, SCTP_LOG_LOCK_INP);			\
-	EnterCriticalSection(&(_inp)->inp_mtx);					\
+	SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP);					\
 } while (0)
 #else
 #define SCTP_INP_RLOCK(_inp) \
-	EnterCriticalSection(&(_inp)->inp_mtx)
+	SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP)
 #define SCTP_INP_WLOCK(_inp) \
-	EnterCriticalSection(&(_inp)->inp_mtx)
+	SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP)
 #endif
 
 #define SCTP_TCB_SEND_LOCK_INIT(_tcb) \
@@ -189,9 +189,9 @@
 #define SCTP_TCB_SEND_LOCK_DESTROY(_tcb) \
 	DeleteCriticalSection(&(_tcb)->tcb_send_mtx)
 #define SCTP_TCB_SEND_LOCK(_tcb) \
-	EnterCriticalSection(&(_tcb)->tcb_send_mtx)
+	SCTP_MTX_LOCK(&(_tcb)->tcb_send_mtx, SCTP_LOCK_CLASS_TCB_SEND)
 #define SCTP_TCB_SEND_UNLOCK(_tcb) \
-	LeaveCriticalSection(&(_tcb)->tcb_send_mtx)
+	SCTP_MTX_UNLOCK(&(_tcb)->tcb_send_mtx, SCTP_LOCK_CLASS_TCB_SEND)
 
 #define SCTP_INP_INCR_REF(_inp) atomic_add_int(&((_inp)->refcount), 1)
 #define SCTP_INP_DECR_REF(_inp) atomic_add_int(&((_inp)->refcount), -1)
@@ -204,19 +204,19 @@
 #define SCTP_ASOC_CREATE_LOCK(_inp) do {					\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE)	\
 		sctp_log_lock(_inp, NULL, SCTP_LOG_LOCK_CREATE);		\
-	EnterCriticalSection(&(_inp)->inp_create_mtx);				\
+	SCTP_MTX_LOCK(&(_inp)->inp_create_mtx, SCTP_LOCK_CLASS_ASOC_CREATE);				\
 } while (0)
 #else
 #define SCTP_ASOC_CREATE_LOCK(_inp) \
-	EnterCriticalSection(&(_inp)->inp_create_mtx)
+	SCTP_MTX_LOCK(&(_inp)->inp_create_mtx, SCTP_LOCK_CLASS_ASOC_CREATE)
 #endif
 
 #define SCTP_INP_RUNLOCK(_inp) \
-	LeaveCriticalSection(&(_inp)->inp_mtx)
+	SCTP_MTX_UNLOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP)
 #define SCTP_INP_WUNLOCK(_inp) \
-	LeaveCriticalSection(&(_inp)->inp_mtx)
+	SCTP_MTX_UNLOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP)
 #define SCTP_ASOC_CREATE_UNLOCK(_inp) \
-	LeaveCriticalSection(&(_inp)->inp_create_mtx)
+	SCTP_MTX_UNLOCK(&(_inp)->inp_create_mtx, SCTP_LOCK_CLASS_ASOC_CREATE)
 
 /*
  * For the majority of things (once we have found the association) we will
@@ -234,15 +234,15 @@
 #define SCTP_TCB_LOCK(_tcb) do {						\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE)	\
 		sctp_log_lock(_tcb->sctp_ep, _tcb, SCTP_LOG_LOCK_TCB);		\
-	EnterCriticalSection(&(_tcb)->tcb_mtx);					\
+	SCTP_MTX_LOCK(&(_tcb)->tcb_mtx, SCTP_LOCK_CLASS_TCB);					\
 } while (0)
 #else
 #define SCTP_TCB_LOCK(_tcb) \
-	EnterCriticalSection(&(_tcb)->tcb_mtx)
+	SCTP_MTX_LOCK(&(_tcb)->tcb_mtx, SCTP_LOCK_CLASS_TCB)
 #endif
-#define SCTP_TCB_TRYLOCK(_tcb) 	((TryEnterCriticalSection(&(_tcb)->tcb_mtx)))
+#define SCTP_TCB_TRYLOCK(_tcb) 	SCTP_MTX_TRYLOCK(&(_tcb)->tcb_mtx, SCTP_LOCK_CLASS_TCB)
 #define SCTP_TCB_UNLOCK(_tcb) \
-	LeaveCriticalSection(&(_tcb)->tcb_mtx)
+	SCTP_MTX_UNLOCK(&(_tcb)->tcb_mtx, SCTP_LOCK_CLASS_TCB)
 #define SCTP_TCB_LOCK_ASSERT(_tcb)
 
 #else /* all Userspaces except Windows */
@@ -252,14 +252,14 @@
 	(void)pthread_mutex_destroy(&SCTP_BASE_INFO(wq_addr_mtx))
 #ifdef INVARIANTS
 #define SCTP_WQ_ADDR_LOCK() \
-	KASSERT(pthread_mutex_lock(&SCTP_BASE_INFO(wq_addr_mtx)) == 0, ("%s: wq_addr_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&SCTP_BASE_INFO(wq_addr_mtx), SCTP_LOCK_CLASS_WQ_ADDR) == 0, ("%s: wq_addr_mtx already locked", __func__))
 #define SCTP_WQ_ADDR_UNLOCK() \
-	KASSERT(pthread_mutex_unlock(&SCTP_BASE_INFO(wq_addr_mtx)) == 0, ("%s: wq_addr_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(wq_addr_mtx), SCTP_LOCK_CLASS_WQ_ADDR) == 0, ("%s: wq_addr_mtx not locked", __func__))
 #else
 #define SCTP_WQ_ADDR_LOCK() \
-	(void)pthread_mutex_lock(&SCTP_BASE_INFO(wq_addr_mtx))
+	(void)SCTP_MTX_LOCK(&SCTP_BASE_INFO(wq_addr_mtx), SCTP_LOCK_CLASS_WQ_ADDR)
 #define SCTP_WQ_ADDR_UNLOCK() \
-	(void)pthread_mutex_unlock(&SCTP_BASE_INFO(wq_addr_mtx))
+	(void)SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(wq_addr_mtx), SCTP_LOCK_CLASS_WQ_ADDR)
 #endif
 
 #define SCTP_INP_INFO_LOCK_INIT() \
@@ -268,25 +268,25 @@
 	(void)pthread_mutex_destroy(&SCTP_BASE_INFO(ipi_ep_mtx))
 #ifdef INVARIANTS
 #define SCTP_INP_INFO_RLOCK() \
-	KASSERT(pthread_mutex_lock(&SCTP_BASE_INFO(ipi_ep_mtx)) == 0, ("%s: ipi_ep_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO) == 0, ("%s: ipi_ep_mtx already locked", __func__))
 #define SCTP_INP_INFO_WLOCK() \
-	KASSERT(pthread_mutex_lock(&SCTP_BASE_INFO(ipi_ep_mtx)) == 0, ("%s: ipi_ep_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO) == 0, ("%s: ipi_ep_mtx already locked", __func__))
 #define SCTP_INP_INFO_RUNLOCK() \
-	KASSERT(pthread_mutex_unlock(&SCTP_BASE_INFO(ipi_ep_mtx)) == 0, ("%s: ipi_ep_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO) == 0, ("%s: ipi_ep_mtx not locked", __func__))
 #define SCTP_INP_INFO_WUNLOCK() \
-	KASSERT(pthread_mutex_unlock(&SCTP_BASE_INFO(ipi_ep_mtx)) == 0, ("%s: ipi_ep_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO) == 0, ("%s: ipi_ep_mtx not locked", __func__))
 #else
 #define SCTP_INP_INFO_RLOCK() \
-	(void)pthread_mutex_lock(&SCTP_BASE_INFO(ipi_ep_mtx))
+	(void)SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO)
 #define SCTP_INP_INFO_WLOCK() \
-	(void)pthread_mutex_lock(&SCTP_BASE_INFO(ipi_ep_mtx))
+	(void)SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO)
 #define SCTP_INP_INFO_RUNLOCK() \
-	(void)pthread_mutex_unlock(&SCTP_BASE_INFO(ipi_ep_mtx))
+	(void)SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO)
 #define SCTP_INP_INFO_WUNLOCK() \
-	(void)pthread_mutex_unlock(&SCTP_BASE_INFO(ipi_ep_mtx))
+	(void)SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO)
 #endif
 #define SCTP_INP_INFO_TRYLOCK() \
-	(!(pthread_mutex_trylock(&SCTP_BASE_INFO(ipi_ep_mtx))))
+	SCTP_MTX_TRYLOCK(&SCTP_BASE_INFO(ipi_ep_mtx), SCTP_LOCK_CLASS_INP_INFO)
 
 #define SCTP_IP_PKTLOG_INIT() \
 	(void)pthread_mutex_init(&SCTP_BASE_INFO(ipi_pktlog_mtx), &SCTP_BASE_VAR(mtx_attr))
@@ -294,14 +294,14 @@
 	(void)pthread_mutex_destroy(&SCTP_BASE_INFO(ipi_pktlog_mtx))
 #ifdef INVARIANTS
 #define SCTP_IP_PKTLOG_LOCK() \
-	KASSERT(pthread_mutex_lock(&SCTP_BASE_INFO(ipi_pktlog_mtx)) == 0, ("%s: ipi_pktlog_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_pktlog_mtx), SCTP_LOCK_CLASS_IP_PKTLOG) == 0, ("%s: ipi_pktlog_mtx already locked", __func__))
 #define SCTP_IP_PKTLOG_UNLOCK() \
-	KASSERT(pthread_mutex_unlock(&SCTP_BASE_INFO(ipi_pktlog_mtx)) == 0, ("%s: ipi_pktlog_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_pktlog_mtx), SCTP_LOCK_CLASS_IP_PKTLOG) == 0, ("%s: ipi_pktlog_mtx not locked", __func__))
 #else
 #define SCTP_IP_PKTLOG_LOCK() \
-	(void)pthread_mutex_lock(&SCTP_BASE_INFO(ipi_pktlog_mtx))
+	(void)SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_pktlog_mtx), SCTP_LOCK_CLASS_IP_PKTLOG)
 #define SCTP_IP_PKTLOG_UNLOCK() \
-	(void)pthread_mutex_unlock(&SCTP_BASE_INFO(ipi_pktlog_mtx))
+	(void)SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_pktlog_mtx), SCTP_LOCK_CLASS_IP_PKTLOG)
 #endif
 
 
@@ -316,14 +316,14 @@
 	(void)pthread_mutex_destroy(&(_inp)->inp_rdata_mtx)
 #ifdef INVARIANTS
 #define SCTP_INP_READ_LOCK(_inp) \
-	KASSERT(pthread_mutex_lock(&(_inp)->inp_rdata_mtx) == 0, ("%s: inp_rdata_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&(_inp)->inp_rdata_mtx, SCTP_LOCK_CLASS_INP_READ) == 0, ("%s: inp_rdata_mtx already locked", __func__))
 #define SCTP_INP_READ_UNLOCK(_inp) \
-	KASSERT(pthread_mutex_unlock(&(_inp)->inp_rdata_mtx) == 0, ("%s: inp_rdata_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&(_inp)->inp_rdata_mtx, SCTP_LOCK_CLASS_INP_READ) == 0, ("%s: inp_rdata_mtx not locked", __func__))
 #else
 #define SCTP_INP_READ_LOCK(_inp) \
-	(void)pthread_mutex_lock(&(_inp)->inp_rdata_mtx)
+	(void)SCTP_MTX_LOCK(&(_inp)->inp_rdata_mtx, SCTP_LOCK_CLASS_INP_READ)
 #define SCTP_INP_READ_UNLOCK(_inp) \
-	(void)pthread_mutex_unlock(&(_inp)->inp_rdata_mtx)
+	(void)SCTP_MTX_UNLOCK(&(_inp)->inp_rdata_mtx, SCTP_LOCK_CLASS_INP_READ)
 #endif
 
 #define SCTP_INP_LOCK_INIT(_inp) \
@@ -335,45 +335,45 @@
 #define SCTP_INP_RLOCK(_inp) do {									\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE)				\
 		sctp_log_lock(_inp, NULL, SCTP_LOG_LOCK_INP);						\
-	KASSERT(pthread_mutex_lock(&(_inp)->inp_mtx) == 0, ("%s: inp_mtx already locked", __func__))	\
+	KASSERT(SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP) == 0, ("%s: inp_mtx already locked", __func__))	\
 } while (0)
 #define SCTP_INP_WLOCK(_inp) do {									\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE)				\
 		sctp_log_lock(_inp, NULL, SCTP_LOG_LOCK_INP);						\
-	KASSERT(pthread_mutex_lock(&(_inp)->inp_mtx) == 0, ("%s: inp_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP) == 0, ("%s: inp_mtx already locked", __func__))
 } while (0)
 #else
 #define SCTP_INP_RLOCK(_inp) \
-	KASSERT(pthread_mutex_lock(&(_inp)->inp_mtx) == 0, ("%s: inp_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP) == 0, ("%s: inp_mtx already locked", __func__))
 #define SCTP_INP_WLOCK(_inp) \
-	KASSERT(pthread_mutex_lock(&(_inp)->inp_mtx) == 0, ("%s: inp_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP) == 0, ("%s: inp_mtx already locked", __func__))
 #endif
 #define SCTP_INP_RUNLOCK(_inp) \
-	KASSERT(pthread_mutex_unlock(&(_inp)->inp_mtx) == 0, ("%s: inp_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP) == 0, ("%s: inp_mtx not locked", __func__))
 #define SCTP_INP_WUNLOCK(_inp) \
-	KASSERT(pthread_mutex_unlock(&(_inp)->inp_mtx) == 0, ("%s: inp_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP) == 0, ("%s: inp_mtx not locked", __func__))
 #else
 #ifdef SCTP_LOCK_LOGGING
 #define SCTP_INP_RLOCK(_inp) do {						\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE)	\
 		sctp_log_lock(_inp, NULL, SCTP_LOG_LOCK_INP);			\
-	(void)pthread_mutex_lock(&(_inp)->inp_mtx);				\
+	(void)SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP);				\
 } while (0)
 #define SCTP_INP_WLOCK(_inp) do {						\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE)	\
 		sctp_log_lock(_inp, NULL, SCTP_LOG_LOCK_INP);			\
-	(void)pthread_mutex_lock(&(_inp)->inp_mtx);				\
+	(void)SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP);				\
 } while (0)
 #else
 #define SCTP_INP_RLOCK(_inp) \
-	(void)pthread_mutex_lock(&(_inp)->inp_mtx)
+	(void)SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP)
 #define SCTP_INP_WLOCK(_inp) \
-	(void)pthread_mutex_lock(&(_inp)->inp_mtx)
+	(void)SCTP_MTX_LOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP)
 #endif
 #define SCTP_INP_RUNLOCK(_inp) \
-	(void)pthread_mutex_unlock(&(_inp)->inp_mtx)
+	(void)SCTP_MTX_UNLOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP)
 #define SCTP_INP_WUNLOCK(_inp) \
-	(void)pthread_mutex_unlock(&(_inp)->inp_mtx)
+	(void)SCTP_MTX_UNLOCK(&(_inp)->inp_mtx, SCTP_LOCK_CLASS_INP)
 #endif
 #define SCTP_INP_INCR_REF(_inp) atomic_add_int(&((_inp)->refcount), 1)
 #define SCTP_INP_DECR_REF(_inp) atomic_add_int(&((_inp)->refcount), -1)
@@ -384,14 +384,14 @@
 	(void)pthread_mutex_destroy(&(_tcb)->tcb_send_mtx)
 #ifdef INVARIANTS
 #define SCTP_TCB_SEND_LOCK(_tcb) \
-	KASSERT(pthread_mutex_lock(&(_tcb)->tcb_send_mtx) == 0, ("%s: tcb_send_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&(_tcb)->tcb_send_mtx, SCTP_LOCK_CLASS_TCB_SEND) == 0, ("%s: tcb_send_mtx already locked", __func__))
 #define SCTP_TCB_SEND_UNLOCK(_tcb) \
-	KASSERT(pthread_mutex_unlock(&(_tcb)->tcb_send_mtx) == 0, ("%s: tcb_send_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&(_tcb)->tcb_send_mtx, SCTP_LOCK_CLASS_TCB_SEND) == 0, ("%s: tcb_send_mtx not locked", __func__))
 #else
 #define SCTP_TCB_SEND_LOCK(_tcb) \
-	(void)pthread_mutex_lock(&(_tcb)->tcb_send_mtx)
+	(void)SCTP_MTX_LOCK(&(_tcb)->tcb_send_mtx, SCTP_LOCK_CLASS_TCB_SEND)
 #define SCTP_TCB_SEND_UNLOCK(_tcb) \
-	(void)pthread_mutex_unlock(&(_tcb)->tcb_send_mtx)
+	(void)SCTP_MTX_UNLOCK(&(_tcb)->tcb_send_mtx, SCTP_LOCK_CLASS_TCB_SEND)
 #endif
 
 #define SCTP_ASOC_CREATE_LOCK_INIT(_inp) \
@@ -403,27 +403,27 @@
 #define SCTP_ASOC_CREATE_LOCK(_inp) do {										\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE)						\
 		sctp_log_lock(_inp, NULL, SCTP_LOG_LOCK_CREATE);							\
-	KASSERT(pthread_mutex_lock(&(_inp)->inp_create_mtx) == 0, ("%s: inp_create_mtx already locked", __func__))	\
+	KASSERT(SCTP_MTX_LOCK(&(_inp)->inp_create_mtx, SCTP_LOCK_CLASS_ASOC_CREATE) == 0, ("%s: inp_create_mtx already locked", __func__))	\
 } while (0)
 #else
 #define SCTP_ASOC_CREATE_LOCK(_inp) \
-	KASSERT(pthread_mutex_lock(&(_inp)->inp_create_mtx) == 0, ("%s: inp_create_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&(_inp)->inp_create_mtx, SCTP_LOCK_CLASS_ASOC_CREATE) == 0, ("%s: inp_create_mtx already locked", __func__))
 #endif
 #define SCTP_ASOC_CREATE_UNLOCK(_inp) \
-	KASSERT(pthread_mutex_unlock(&(_inp)->inp_create_mtx) == 0, ("%s: inp_create_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&(_inp)->inp_create_mtx, SCTP_LOCK_CLASS_ASOC_CREATE) == 0, ("%s: inp_create_mtx not locked", __func__))
 #else
 #ifdef SCTP_LOCK_LOGGING
 #define SCTP_ASOC_CREATE_LOCK(_inp) do {					\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE)	\
 		sctp_log_lock(_inp, NULL, SCTP_LOG_LOCK_CREATE);		\
-	(void)pthread_mutex_lock(&(_inp)->inp_create_mtx);			\
+	(void)SCTP_MTX_LOCK(&(_inp)->inp_create_mtx, SCTP_LOCK_CLASS_ASOC_CREATE);			\
 } while (0)
 #else
 #define SCTP_ASOC_CREATE_LOCK(_inp) \
-	(void)pthread_mutex_lock(&(_inp)->inp_create_mtx)
+	(void)SCTP_MTX_LOCK(&(_inp)->inp_create_mtx, SCTP_LOCK_CLASS_ASOC_CREATE)
 #endif
 #define SCTP_ASOC_CREATE_UNLOCK(_inp) \
-	(void)pthread_mutex_unlock(&(_inp)->inp_create_mtx)
+	(void)SCTP_MTX_UNLOCK(&(_inp)->inp_create_mtx, SCTP_LOCK_CLASS_ASOC_CREATE)
 #endif
 /*
  * For the majority of things (once we have found the association) we will
@@ -442,30 +442,30 @@
 #define SCTP_TCB_LOCK(_tcb) do {									\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE) 				\
 		sctp_log_lock(_tcb->sctp_ep, _tcb, SCTP_LOG_LOCK_TCB);					\
-	KASSERT(pthread_mutex_lock(&(_tcb)->tcb_mtx) == 0, ("%s: tcb_mtx already locked", __func__))	\
+	KASSERT(SCTP_MTX_LOCK(&(_tcb)->tcb_mtx, SCTP_LOCK_CLASS_TCB) == 0, ("%s: tcb_mtx already locked", __func__))	\
 } while (0)
 #else
 #define SCTP_TCB_LOCK(_tcb) \
-	KASSERT(pthread_mutex_lock(&(_tcb)->tcb_mtx) == 0, ("%s: tcb_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&(_tcb)->tcb_mtx, SCTP_LOCK_CLASS_TCB) == 0, ("%s: tcb_mtx already locked", __func__))
 #endif
 #define SCTP_TCB_UNLOCK(_tcb) \
-	KASSERT(pthread_mutex_unlock(&(_tcb)->tcb_mtx) == 0, ("%s: tcb_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&(_tcb)->tcb_mtx, SCTP_LOCK_CLASS_TCB) == 0, ("%s: tcb_mtx not locked", __func__))
 #else
 #ifdef SCTP_LOCK_LOGGING
 #define SCTP_TCB_LOCK(_tcb) do {						\
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_LOCK_LOGGING_ENABLE) 	\
 		sctp_log_lock(_tcb->sctp_ep, _tcb, SCTP_LOG_LOCK_TCB);		\
-	(void)pthread_mutex_lock(&(_tcb)->tcb_mtx);				\
+	(void)SCTP_MTX_LOCK(&(_tcb)->tcb_mtx, SCTP_LOCK_CLASS_TCB);				\
 } while (0)
 #else
 #define SCTP_TCB_LOCK(_tcb) \
-	(void)pthread_mutex_lock(&(_tcb)->tcb_mtx)
+	(void)SCTP_MTX_LOCK(&(_tcb)->tcb_mtx, SCTP_LOCK_CLASS_TCB)
 #endif
-#define SCTP_TCB_UNLOCK(_tcb) (void)pthread_mutex_unlock(&(_tcb)->tcb_mtx)
+#define SCTP_TCB_UNLOCK(_tcb) (void)SCTP_MTX_UNLOCK(&(_tcb)->tcb_mtx, SCTP_LOCK_CLASS_TCB)
 #endif
 #define SCTP_TCB_LOCK_ASSERT(_tcb) \
 	KASSERT(pthread_mutex_trylock(&(_tcb)->tcb_mtx) == EBUSY, ("%s: tcb_mtx not locked", __func__))
-#define SCTP_TCB_TRYLOCK(_tcb) (!(pthread_mutex_trylock(&(_tcb)->tcb_mtx)))
+#define SCTP_TCB_TRYLOCK(_tcb) SCTP_MTX_TRYLOCK(&(_tcb)->tcb_mtx, SCTP_LOCK_CLASS_TCB)
 #endif
 
 #endif /* SCTP_PER_SOCKET_LOCKING */
@@ -485,9 +485,9 @@
 #if defined(__Userspace_os_Windows)
 #define SOCKBUF_LOCK_ASSERT(_so_buf)
 #define SOCKBUF_LOCK(_so_buf) \
-	EnterCriticalSection(&(_so_buf)->sb_mtx)
+	SCTP_MTX_LOCK(&(_so_buf)->sb_mtx, SCTP_LOCK_CLASS_SOCKBUF)
 #define SOCKBUF_UNLOCK(_so_buf) \
-	LeaveCriticalSection(&(_so_buf)->sb_mtx)
+	SCTP_MTX_UNLOCK(&(_so_buf)->sb_mtx, SCTP_LOCK_CLASS_SOCKBUF)
 #define SOCK_LOCK(_so) \
 	SOCKBUF_LOCK(&(_so)->so_rcv)
 #define SOCK_UNLOCK(_so) \
@@ -497,14 +497,14 @@
 	KASSERT(pthread_mutex_trylock(SOCKBUF_MTX(_so_buf)) == EBUSY, ("%s: socket buffer not locked", __func__))
 #ifdef INVARIANTS
 #define SOCKBUF_LOCK(_so_buf) \
-	KASSERT(pthread_mutex_lock(SOCKBUF_MTX(_so_buf)) == 0, ("%s: sockbuf_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(SOCKBUF_MTX(_so_buf), SCTP_LOCK_CLASS_SOCKBUF) == 0, ("%s: sockbuf_mtx already locked", __func__))
 #define SOCKBUF_UNLOCK(_so_buf) \
-	KASSERT(pthread_mutex_unlock(SOCKBUF_MTX(_so_buf)) == 0, ("%s: sockbuf_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(SOCKBUF_MTX(_so_buf), SCTP_LOCK_CLASS_SOCKBUF) == 0, ("%s: sockbuf_mtx not locked", __func__))
 #else
 #define SOCKBUF_LOCK(_so_buf) \
-	pthread_mutex_lock(SOCKBUF_MTX(_so_buf))
+	SCTP_MTX_LOCK(SOCKBUF_MTX(_so_buf), SCTP_LOCK_CLASS_SOCKBUF)
 #define SOCKBUF_UNLOCK(_so_buf) \
-	pthread_mutex_unlock(SOCKBUF_MTX(_so_buf))
+	SCTP_MTX_UNLOCK(SOCKBUF_MTX(_so_buf), SCTP_LOCK_CLASS_SOCKBUF)
 #endif
 #define SOCK_LOCK(_so) \
 	SOCKBUF_LOCK(&(_so)->so_rcv)
@@ -524,13 +524,13 @@
 #define SCTP_IPI_ADDR_DESTROY() \
 	DeleteCriticalSection(&SCTP_BASE_INFO(ipi_addr_mtx))
 #define SCTP_IPI_ADDR_RLOCK() \
-	EnterCriticalSection(&SCTP_BASE_INFO(ipi_addr_mtx))
+	SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR)
 #define SCTP_IPI_ADDR_RUNLOCK() \
-	LeaveCriticalSection(&SCTP_BASE_INFO(ipi_addr_mtx))
+	SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR)
 #define SCTP_IPI_ADDR_WLOCK() \
-	EnterCriticalSection(&SCTP_BASE_INFO(ipi_addr_mtx))
+	SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR)
 #define SCTP_IPI_ADDR_WUNLOCK() \
-	LeaveCriticalSection(&SCTP_BASE_INFO(ipi_addr_mtx))
+	SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR)
 
 
 /* iterator locks */
@@ -539,18 +539,18 @@
 #define SCTP_ITERATOR_LOCK_DESTROY() \
 	DeleteCriticalSection(&sctp_it_ctl.it_mtx)
 #define SCTP_ITERATOR_LOCK() \
-		EnterCriticalSection(&sctp_it_ctl.it_mtx)
+		SCTP_MTX_LOCK(&sctp_it_ctl.it_mtx, SCTP_LOCK_CLASS_ITERATOR)
 #define SCTP_ITERATOR_UNLOCK() \
-	LeaveCriticalSection(&sctp_it_ctl.it_mtx)
+	SCTP_MTX_UNLOCK(&sctp_it_ctl.it_mtx, SCTP_LOCK_CLASS_ITERATOR)
 
 #define SCTP_IPI_ITERATOR_WQ_INIT() \
 	InitializeCriticalSection(&sctp_it_ctl.ipi_iterator_wq_mtx)
 #define SCTP_IPI_ITERATOR_WQ_DESTROY() \
 	DeleteCriticalSection(&sctp_it_ctl.ipi_iterator_wq_mtx)
 #define SCTP_IPI_ITERATOR_WQ_LOCK() \
-	EnterCriticalSection(&sctp_it_ctl.ipi_iterator_wq_mtx)
+	SCTP_MTX_LOCK(&sctp_it_ctl.ipi_iterator_wq_mtx, SCTP_LOCK_CLASS_ITERATOR_WQ)
 #define SCTP_IPI_ITERATOR_WQ_UNLOCK() \
-	LeaveCriticalSection(&sctp_it_ctl.ipi_iterator_wq_mtx)
+	SCTP_MTX_UNLOCK(&sctp_it_ctl.ipi_iterator_wq_mtx, SCTP_LOCK_CLASS_ITERATOR_WQ)
 
 #else /* end of __Userspace_os_Windows */
 /* address list locks */
@@ -560,22 +560,22 @@
 	(void)pthread_mutex_destroy(&SCTP_BASE_INFO(ipi_addr_mtx))
 #ifdef INVARIANTS
 #define SCTP_IPI_ADDR_RLOCK() \
-	KASSERT(pthread_mutex_lock(&SCTP_BASE_INFO(ipi_addr_mtx)) == 0, ("%s: ipi_addr_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR) == 0, ("%s: ipi_addr_mtx already locked", __func__))
 #define SCTP_IPI_ADDR_RUNLOCK() \
-	KASSERT(pthread_mutex_unlock(&SCTP_BASE_INFO(ipi_addr_mtx)) == 0, ("%s: ipi_addr_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR) == 0, ("%s: ipi_addr_mtx not locked", __func__))
 #define SCTP_IPI_ADDR_WLOCK() \
-	KASSERT(pthread_mutex_lock(&SCTP_BASE_INFO(ipi_addr_mtx)) == 0, ("%s: ipi_addr_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR) == 0, ("%s: ipi_addr_mtx already locked", __func__))
 #define SCTP_IPI_ADDR_WUNLOCK() \
-	KASSERT(pthread_mutex_unlock(&SCTP_BASE_INFO(ipi_addr_mtx)) == 0, ("%s: ipi_addr_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR) == 0, ("%s: ipi_addr_mtx not locked", __func__))
 #else
 #define SCTP_IPI_ADDR_RLOCK() \
-	(void)pthread_mutex_lock(&SCTP_BASE_INFO(ipi_addr_mtx))
+	(void)SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR)
 #define SCTP_IPI_ADDR_RUNLOCK() \
-	(void)pthread_mutex_unlock(&SCTP_BASE_INFO(ipi_addr_mtx))
+	(void)SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR)
 #define SCTP_IPI_ADDR_WLOCK() \
-	(void)pthread_mutex_lock(&SCTP_BASE_INFO(ipi_addr_mtx))
+	(void)SCTP_MTX_LOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR)
 #define SCTP_IPI_ADDR_WUNLOCK() \
-	(void)pthread_mutex_unlock(&SCTP_BASE_INFO(ipi_addr_mtx))
+	(void)SCTP_MTX_UNLOCK(&SCTP_BASE_INFO(ipi_addr_mtx), SCTP_LOCK_CLASS_IPI_ADDR)
 #endif
 
 /* iterator locks */
@@ -585,14 +585,14 @@
 	(void)pthread_mutex_destroy(&sctp_it_ctl.it_mtx)
 #ifdef INVARIANTS
 #define SCTP_ITERATOR_LOCK() \
-	KASSERT(pthread_mutex_lock(&sctp_it_ctl.it_mtx) == 0, ("%s: it_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&sctp_it_ctl.it_mtx, SCTP_LOCK_CLASS_ITERATOR) == 0, ("%s: it_mtx already locked", __func__))
 #define SCTP_ITERATOR_UNLOCK() \
-	KASSERT(pthread_mutex_unlock(&sctp_it_ctl.it_mtx) == 0, ("%s: it_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&sctp_it_ctl.it_mtx, SCTP_LOCK_CLASS_ITERATOR) == 0, ("%s: it_mtx not locked", __func__))
 #else
 #define SCTP_ITERATOR_LOCK() \
-	(void)pthread_mutex_lock(&sctp_it_ctl.it_mtx)
+	(void)SCTP_MTX_LOCK(&sctp_it_ctl.it_mtx, SCTP_LOCK_CLASS_ITERATOR)
 #define SCTP_ITERATOR_UNLOCK() \
-	(void)pthread_mutex_unlock(&sctp_it_ctl.it_mtx)
+	(void)SCTP_MTX_UNLOCK(&sctp_it_ctl.it_mtx, SCTP_LOCK_CLASS_ITERATOR)
 #endif
 
 #define SCTP_IPI_ITERATOR_WQ_INIT() \
@@ -601,14 +601,14 @@
 	(void)pthread_mutex_destroy(&sctp_it_ctl.ipi_iterator_wq_mtx)
 #ifdef INVARIANTS
 #define SCTP_IPI_ITERATOR_WQ_LOCK() \
-	KASSERT(pthread_mutex_lock(&sctp_it_ctl.ipi_iterator_wq_mtx) == 0, ("%s: ipi_iterator_wq_mtx already locked", __func__))
+	KASSERT(SCTP_MTX_LOCK(&sctp_it_ctl.ipi_iterator_wq_mtx, SCTP_LOCK_CLASS_ITERATOR_WQ) == 0, ("%s: ipi_iterator_wq_mtx already locked", __func__))
 #define SCTP_IPI_ITERATOR_WQ_UNLOCK() \
-	KASSERT(pthread_mutex_unlock(&sctp_it_ctl.ipi_iterator_wq_mtx) == 0, ("%s: ipi_iterator_wq_mtx not locked", __func__))
+	KASSERT(SCTP_MTX_UNLOCK(&sctp_it_ctl.ipi_iterator_wq_mtx, SCTP_LOCK_CLASS_ITERATOR_WQ) == 0, ("%s: ipi_iterator_wq_mtx not locked", __func__))
 #else
 #define SCTP_IPI_ITERATOR_WQ_LOCK() \
-	(void)pthread_mutex_lock(&sctp_it_ctl.ipi_iterator_wq_mtx)
+	(void)SCTP_MTX_LOCK(&sctp_it_ctl.ipi_iterator_wq_mtx, SCTP_LOCK_CLASS_ITERATOR_WQ)
 #define SCTP_IPI_ITERATOR_WQ_UNLOCK() \
-	(void)pthread_mutex_unlock(&sctp_it_ctl.ipi_iterator_wq_mtx)
+	(void)SCTP_MTX_UNLOCK(&sctp_it_ctl.ipi_iterator_wq_mtx, SCTP_LOCK_CLASS_ITERATOR_WQ)
 #endif
 #endif
 
@@ -87,6 +87,10 @@ sctp_sha1_final(unsigned char *digest, struct sctp_sha1_context *ctx)
 #elif !defined(__Windows__)
 #include <arpa/inet.h>
 #endif
+#if defined(SCTP_SHA_NI)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 
 #define F1(B,C,D) (((B & C) | ((~B) & D)))	/* 0  <= t <= 19 */
 #define F2(B,C,D) (B ^ C ^ D)	/* 20 <= t <= 39 */
@@ -107,117 +111,220 @@ sctp_sha1_final(unsigned char *digest, struct sctp_sha1_context *ctx)
 #define H3INIT 0x10325476
 #define H4INIT 0xc3d2e1f0
 
+#if defined(SCTP_SHA_NI)
+/*
+ * Returns 1 if the CPU implements the SHA extensions (and SSSE3/SSE4.1,
+ * which the kernels below also use), 0 otherwise. The result is cached.
+ */
+int
+sctp_sha_ni_available(void)
+{
+	static int sha_ni = -1;
+	unsigned int eax, ebx, ecx, edx;
+	int available;
+
+	if (sha_ni >= 0) {
+		return (sha_ni);
+	}
+	available = 0;
+	if ((__get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0) &&
+	    (ecx & (1 << 9)) &&		/* SSSE3 */
+	    (ecx & (1 << 19)) &&	/* SSE4.1 */
+	    (__get_cpuid_max(0, NULL) >= 7)) {
+		__cpuid_count(7, 0, eax, ebx, ecx, edx);
+		if (ebx & (1 << 29)) {	/* SHA */
+			available = 1;
+		}
+	}
+	sha_ni = available;
+	return (sha_ni);
+}
+
+/* One step of four rounds for the rounds 16 to 79. */
+#define SHA1_NI_ROUNDS(E_A, E_B, M0, M1, M2, M3, F)	\
+	E_A = _mm_sha1nexte_epu32(E_A, M0);		\
+	E_B = abcd;					\
+	M1 = _mm_sha1msg2_epu32(M1, M0);		\
+	abcd = _mm_sha1rnds4_epu32(abcd, E_A, F);	\
+	M3 = _mm_sha1msg1_epu32(M3, M0);		\
+	M2 = _mm_xor_si128(M2, M0)
+
+__attribute__((target("sha,ssse3,sse4.1")))
+static void
+sctp_sha1_process_blocks_ni(struct sctp_sha1_context *ctx, const unsigned char *data, unsigned int count)
+{
+	__m128i abcd, abcd_save, e0, e0_save, e1;
+	__m128i msg0, msg1, msg2, msg3;
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+	abcd = _mm_loadu_si128((const __m128i *)ctx->H);
+	abcd = _mm_shuffle_epi32(abcd, 0x1b);
+	e0 = _mm_set_epi32((int)ctx->H[4], 0, 0, 0);
+	while (count-- > 0) {
+		abcd_save = abcd;
+		e0_save = e0;
+		/* Rounds 0 to 3 */
+		msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), mask);
+		e0 = _mm_add_epi32(e0, msg0);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		/* Rounds 4 to 7 */
+		msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), mask);
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+		msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+		/* Rounds 8 to 11 */
+		msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), mask);
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+		msg0 = _mm_xor_si128(msg0, msg2);
+		/* Rounds 12 to 15 */
+		msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), mask);
+		SHA1_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 0);
+		/* Rounds 16 to 79 */
+		SHA1_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 0);
+		SHA1_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 1);
+		SHA1_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 1);
+		SHA1_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 1);
+		SHA1_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 1);
+		SHA1_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 1);
+		SHA1_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 2);
+		SHA1_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 2);
+		SHA1_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 2);
+		SHA1_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 2);
+		SHA1_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 2);
+		SHA1_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 3);
+		SHA1_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 3);
+		SHA1_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 3);
+		SHA1_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 3);
+		SHA1_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 3);
+		/* Add this block's hash to the result so far */
+		e0 = _mm_sha1nexte_epu32(e0, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+		data += 64;
+	}
+	abcd = _mm_shuffle_epi32(abcd, 0x1b);
+	_mm_storeu_si128((__m128i *)ctx->H, abcd);
+	ctx->H[4] = (unsigned int)_mm_extract_epi32(e0, 3);
+}
+#endif
+
 void
 sctp_sha1_init(struct sctp_sha1_context *ctx)
 {
 	/* Init the SHA-1 context structure */
-	ctx->A = 0;
-	ctx->B = 0;
-	ctx->C = 0;
-	ctx->D = 0;
-	ctx->E = 0;
-	ctx->H0 = H0INIT;
-	ctx->H1 = H1INIT;
-	ctx->H2 = H2INIT;
-	ctx->H3 = H3INIT;
-	ctx->H4 = H4INIT;
-	ctx->TEMP = 0;
-	memset(ctx->words, 0, sizeof(ctx->words));
+	ctx->H[0] = H0INIT;
+	ctx->H[1] = H1INIT;
+	ctx->H[2] = H2INIT;
+	ctx->H[3] = H3INIT;
+	ctx->H[4] = H4INIT;
 	ctx->how_many_in_block = 0;
 	ctx->running_total = 0;
 }
 
 static void
-sctp_sha1_process_a_block(struct sctp_sha1_context *ctx, unsigned int *block)
+sctp_sha1_process_a_block(struct sctp_sha1_context *ctx, const unsigned char *block)
 {
+	unsigned int words[80];
+	unsigned int A, B, C, D, E, TEMP;
 	int i;
 
 	/* init the W0-W15 to the block of words being hashed. */
 	/* step a) */
 	for (i = 0; i < 16; i++) {
-		ctx->words[i] = ntohl(block[i]);
+		words[i] = ((unsigned int)block[4 * i] << 24) |
+		    ((unsigned int)block[4 * i + 1] << 16) |
+		    ((unsigned int)block[4 * i + 2] << 8) |
+		    ((unsigned int)block[4 * i + 3]);
 	}
 	/* now init the rest based on the SHA-1 formula, step b) */
 	for (i = 16; i < 80; i++) {
-		ctx->words[i] = CSHIFT(1, ((ctx->words[(i - 3)]) ^
-		    (ctx->words[(i - 8)]) ^
-		    (ctx->words[(i - 14)]) ^
-		    (ctx->words[(i - 16)])));
+		words[i] = CSHIFT(1, ((words[(i - 3)]) ^
+		    (words[(i - 8)]) ^
+		    (words[(i - 14)]) ^
+		    (words[(i - 16)])));
 	}
 	/* step c) */
-	ctx->A = ctx->H0;
-	ctx->B = ctx->H1;
-	ctx->C = ctx->H2;
-	ctx->D = ctx->H3;
-	ctx->E = ctx->H4;
+	A = ctx->H[0];
+	B = ctx->H[1];
+	C = ctx->H[2];
+	D = ctx->H[3];
+	E = ctx->H[4];
 
 	/* step d) */
 	for (i = 0; i < 80; i++) {
 		if (i < 20) {
-			ctx->TEMP = ((CSHIFT(5, ctx->A)) +
-			    (F1(ctx->B, ctx->C, ctx->D)) +
-			    (ctx->E) +
-			    ctx->words[i] +
-			    K1);
+			TEMP = CSHIFT(5, A) + F1(B, C, D) + E + words[i] + K1;
 		} else if (i < 40) {
-			ctx->TEMP = ((CSHIFT(5, ctx->A)) +
-			    (F2(ctx->B, ctx->C, ctx->D)) +
-			    (ctx->E) +
-			    (ctx->words[i]) +
-			    K2);
+			TEMP = CSHIFT(5, A) + F2(B, C, D) + E + words[i] + K2;
 		} else if (i < 60) {
-			ctx->TEMP = ((CSHIFT(5, ctx->A)) +
-			    (F3(ctx->B, ctx->C, ctx->D)) +
-			    (ctx->E) +
-			    (ctx->words[i]) +
-			    K3);
+			TEMP = CSHIFT(5, A) + F3(B, C, D) + E + words[i] + K3;
 		} else {
-			ctx->TEMP = ((CSHIFT(5, ctx->A)) +
-			    (F4(ctx->B, ctx->C, ctx->D)) +
-			    (ctx->E) +
-			    (ctx->words[i]) +
-			    K4);
+			TEMP = CSHIFT(5, A) + F4(B, C, D) + E + words[i] + K4;
 		}
-		ctx->E = ctx->D;
-		ctx->D = ctx->C;
-		ctx->C = CSHIFT(30, ctx->B);
-		ctx->B = ctx->A;
-		ctx->A = ctx->TEMP;
+		E = D;
+		D = C;
+		C = CSHIFT(30, B);
+		B = A;
+		A = TEMP;
 	}
 	/* step e) */
-	ctx->H0 = (ctx->H0) + (ctx->A);
-	ctx->H1 = (ctx->H1) + (ctx->B);
-	ctx->H2 = (ctx->H2) + (ctx->C);
-	ctx->H3 = (ctx->H3) + (ctx->D);
-	ctx->H4 = (ctx->H4) + (ctx->E);
+	ctx->H[0] += A;
+	ctx->H[1] += B;
+	ctx->H[2] += C;
+	ctx->H[3] += D;
+	ctx->H[4] += E;
+}
+
+static void
+sctp_sha1_process_blocks(struct sctp_sha1_context *ctx, const unsigned char *data, unsigned int count)
+{
+#if defined(SCTP_SHA_NI)
+	if (sctp_sha_ni_available()) {
+		sctp_sha1_process_blocks_ni(ctx, data, count);
+		return;
+	}
+#endif
+	while (count-- > 0) {
+		sctp_sha1_process_a_block(ctx, data);
+		data += 64;
+	}
 }
 
 void
 sctp_sha1_update(struct sctp_sha1_context *ctx, const unsigned char *ptr, unsigned int siz)
 {
-	unsigned int number_left, left_to_fill;
+	unsigned int left_to_fill, count;
 
-	number_left = siz;
-	while (number_left > 0) {
+	ctx->running_total += siz;
+	if (ctx->how_many_in_block > 0) {
 		left_to_fill = sizeof(ctx->sha_block) - ctx->how_many_in_block;
-		if (left_to_fill > number_left) {
+		if (left_to_fill > siz) {
 			/* can only partially fill up this one */
-			memcpy(&ctx->sha_block[ctx->how_many_in_block],
-			    ptr, number_left);
-			ctx->how_many_in_block += number_left;
-			ctx->running_total += number_left;
-			break;
-		} else {
-			/* block is now full, process it */
-			memcpy(&ctx->sha_block[ctx->how_many_in_block],
-			    ptr, left_to_fill);
-			sctp_sha1_process_a_block(ctx,
-			    (unsigned int *)ctx->sha_block);
-			number_left -= left_to_fill;
-			ctx->running_total += left_to_fill;
-			ctx->how_many_in_block = 0;
-			ptr = (const unsigned char *)(ptr + left_to_fill);
+			memcpy(&ctx->sha_block[ctx->how_many_in_block], ptr, siz);
+			ctx->how_many_in_block += siz;
+			return;
 		}
+		/* block is now full, process it */
+		memcpy(&ctx->sha_block[ctx->how_many_in_block], ptr, left_to_fill);
+		sctp_sha1_process_blocks(ctx, ctx->sha_block, 1);
+		ctx->how_many_in_block = 0;
+		ptr += left_to_fill;
+		siz -= left_to_fill;
+	}
+	/* process all complete blocks directly from the input */
+	count = siz / sizeof(ctx->sha_block);
+	if (count > 0) {
+		sctp_sha1_process_blocks(ctx, ptr, count);
+		ptr += count * sizeof(ctx->sha_block);
+		siz -= count * sizeof(ctx->sha_block);
+	}
+	if (siz > 0) {
+		memcpy(ctx->sha_block, ptr, siz);
+		ctx->how_many_in_block = siz;
 	}
 }
 
@@ -236,92 +343,33 @@ sctp_sha1_final(unsigned char *digest, struct sctp_sha1_context *ctx)
 	 * and run this block through by itself.  Also the 64 bit int must
 	 * be in network byte order.
 	 */
-	int left_to_fill;
-	unsigned int i, *ptr;
+	unsigned int i;
 
+	ctx->sha_block[ctx->how_many_in_block] = 0x80;
+	memset(&ctx->sha_block[ctx->how_many_in_block + 1], 0,
+	    sizeof(ctx->sha_block) - ctx->how_many_in_block - 1);
 	if (ctx->how_many_in_block > 55) {
 		/*
 		 * special case, we need to process two blocks here. One for
-		 * the current stuff plus possibly the pad. The other for
-		 * the size.
+		 * the current stuff plus the pad. The other for the size.
 		 */
-		left_to_fill = sizeof(ctx->sha_block) - ctx->how_many_in_block;
-		if (left_to_fill == 0) {
-			/* Should not really happen but I am paranoid */
-			sctp_sha1_process_a_block(ctx,
-			    (unsigned int *)ctx->sha_block);
-			/* init last block, a bit different than the rest */
-			ctx->sha_block[0] = '\x80';
-			for (i = 1; i < sizeof(ctx->sha_block); i++) {
-				ctx->sha_block[i] = 0x0;
-			}
-		} else if (left_to_fill == 1) {
-			ctx->sha_block[ctx->how_many_in_block] = '\x80';
-			sctp_sha1_process_a_block(ctx,
-			    (unsigned int *)ctx->sha_block);
-			/* init last block */
-			memset(ctx->sha_block, 0, sizeof(ctx->sha_block));
-		} else {
-			ctx->sha_block[ctx->how_many_in_block] = '\x80';
-			for (i = (ctx->how_many_in_block + 1);
-			    i < sizeof(ctx->sha_block);
-			    i++) {
-				ctx->sha_block[i] = 0x0;
-			}
-			sctp_sha1_process_a_block(ctx,
-			    (unsigned int *)ctx->sha_block);
-			/* init last block */
-			memset(ctx->sha_block, 0, sizeof(ctx->sha_block));
-		}
-		/* This is in bits so multiply by 8 */
-		ctx->running_total *= 8;
-		ptr = (unsigned int *)&ctx->sha_block[60];
-		*ptr = htonl(ctx->running_total);
-		sctp_sha1_process_a_block(ctx, (unsigned int *)ctx->sha_block);
-	} else {
-		/*
-		 * easy case, we just pad this message to size - end with 0
-		 * add the magic 0x80 to the next word and then put the
-		 * network byte order size in the last spot and process the
-		 * block.
-		 */
-		ctx->sha_block[ctx->how_many_in_block] = '\x80';
-		for (i = (ctx->how_many_in_block + 1);
-		    i < sizeof(ctx->sha_block);
-		    i++) {
-			ctx->sha_block[i] = 0x0;
-		}
-		/* get last int spot */
-		ctx->running_total *= 8;
-		ptr = (unsigned int *)&ctx->sha_block[60];
-		*ptr = htonl(ctx->running_total);
-		sctp_sha1_process_a_block(ctx, (unsigned int *)ctx->sha_block);
+		sctp_sha1_process_blocks(ctx, ctx->sha_block, 1);
+		memset(ctx->sha_block, 0, sizeof(ctx->sha_block));
 	}
+	/* This is in bits so multiply by 8 */
+	ctx->sha_block[59] = (ctx->running_total >> 29) & 0xff;
+	ctx->sha_block[60] = (ctx->running_total >> 21) & 0xff;
+	ctx->sha_block[61] = (ctx->running_total >> 13) & 0xff;
+	ctx->sha_block[62] = (ctx->running_total >> 5) & 0xff;
+	ctx->sha_block[63] = (ctx->running_total << 3) & 0xff;
+	sctp_sha1_process_blocks(ctx, ctx->sha_block, 1);
 	/* transfer the digest back to the user */
-	digest[3] = (ctx->H0 & 0xff);
-	digest[2] = ((ctx->H0 >> 8) & 0xff);
-	digest[1] = ((ctx->H0 >> 16) & 0xff);
-	digest[0] = ((ctx->H0 >> 24) & 0xff);
-
-	digest[7] = (ctx->H1 & 0xff);
-	digest[6] = ((ctx->H1 >> 8) & 0xff);
-	digest[5] = ((ctx->H1 >> 16) & 0xff);
-	digest[4] = ((ctx->H1 >> 24) & 0xff);
-
-	digest[11] = (ctx->H2 & 0xff);
-	digest[10] = ((ctx->H2 >> 8) & 0xff);
-	digest[9] = ((ctx->H2 >> 16) & 0xff);
-	digest[8] = ((ctx->H2 >> 24) & 0xff);
-
-	digest[15] = (ctx->H3 & 0xff);
-	digest[14] = ((ctx->H3 >> 8) & 0xff);
-	digest[13] = ((ctx->H3 >> 16) & 0xff);
-	digest[12] = ((ctx->H3 >> 24) & 0xff);
-
-	digest[19] = (ctx->H4 & 0xff);
-	digest[18] = ((ctx->H4 >> 8) & 0xff);
-	digest[17] = ((ctx->H4 >> 16) & 0xff);
-	digest[16] = ((ctx->H4 >> 24) & 0xff);
+	for (i = 0; i < 5; i++) {
+		digest[4 * i] = (ctx->H[i] >> 24) & 0xff;
+		digest[4 * i + 1] = (ctx->H[i] >> 16) & 0xff;
+		digest[4 * i + 2] = (ctx->H[i] >> 8) & 0xff;
+		digest[4 * i + 3] = ctx->H[i] & 0xff;
+	}
 }
 
 #endif
@@ -55,28 +55,28 @@ __FBSDID("$FreeBSD$");
 #include <openssl/sha.h>
 #endif
 
+/*
+ * Use the SHA extensions of x86 CPUs, if available at runtime, for the
+ * internal SHA-1 and SHA-256 implementations.
+ */
+#if !defined(SCTP_USE_NSS_SHA1) && !defined(SCTP_USE_OPENSSL_SHA1) && \
+    !defined(SCTP_NO_SHA_NI) && \
+    (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ >= 5)))
+#define SCTP_SHA_NI 1
+#endif
+
 struct sctp_sha1_context {
 #if defined(SCTP_USE_NSS_SHA1)
 	struct PK11Context *pk11_ctx;
 #elif defined(SCTP_USE_OPENSSL_SHA1)
 	SHA_CTX sha_ctx;
 #else
-	unsigned int A;
-	unsigned int B;
-	unsigned int C;
-	unsigned int D;
-	unsigned int E;
-	unsigned int H0;
-	unsigned int H1;
-	unsigned int H2;
-	unsigned int H3;
-	unsigned int H4;
-	unsigned int words[80];
-	unsigned int TEMP;
+	unsigned int H[5];
 	/* block I am collecting to process */
-	char sha_block[64];
+	unsigned char sha_block[64];
 	/* collected so far */
-	int how_many_in_block;
+	unsigned int how_many_in_block;
 	unsigned int running_total;
 #endif
 };
@@ -92,6 +92,9 @@ struct sctp_sha1_context {
 void sctp_sha1_init(struct sctp_sha1_context *);
 void sctp_sha1_update(struct sctp_sha1_context *, const unsigned char *, unsigned int);
 void sctp_sha1_final(unsigned char *, struct sctp_sha1_context *);
+#if defined(SCTP_SHA_NI)
+int sctp_sha_ni_available(void);
+#endif
 
 #endif
 #endif
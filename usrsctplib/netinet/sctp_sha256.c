@@ -0,0 +1,278 @@
+/*-
+ * Copyright (c) 2001-2007, by Cisco Systems, Inc. All rights reserved.
+ * Copyright (c) 2008-2012, by Randall Stewart. All rights reserved.
+ * Copyright (c) 2008-2012, by Michael Tuexen. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * a) Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ * b) Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the distribution.
+ *
+ * c) Neither the name of Cisco Systems, Inc. nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <netinet/sctp_sha1.h>
+#include <netinet/sctp_sha256.h>
+
+#include <string.h>
+#if defined(SCTP_SHA_NI)
+#include <immintrin.h>
+#endif
+
+/* FIPS 180-4 SHA-256 */
+
+#define ROTR(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)	(((x) & (y)) ^ ((~(x)) & (z)))
+#define MAJ(x, y, z)	(((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define BSIG0(x)	(ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define BSIG1(x)	(ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define SSIG0(x)	(ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define SSIG1(x)	(ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+static const unsigned int sctp_sha256_K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#if defined(SCTP_SHA_NI)
+/* Four rounds for the rounds 12 to 63, also extending the schedule. */
+#define SHA256_NI_ROUNDS(I, M0, M1, M2, M3)				\
+	msg = _mm_add_epi32(M0,						\
+	    _mm_loadu_si128((const __m128i *)&sctp_sha256_K[4 * (I)]));	\
+	state1 = _mm_sha256rnds2_epu32(state1, state0, msg);		\
+	tmp = _mm_alignr_epi8(M0, M3, 4);				\
+	M1 = _mm_add_epi32(M1, tmp);					\
+	M1 = _mm_sha256msg2_epu32(M1, M0);				\
+	msg = _mm_shuffle_epi32(msg, 0x0e);				\
+	state0 = _mm_sha256rnds2_epu32(state0, state1, msg);		\
+	M3 = _mm_sha256msg1_epu32(M3, M0)
+
+/* Four rounds for the rounds 0 to 11. */
+#define SHA256_NI_ROUNDS_LOAD(I, M0)					\
+	M0 = _mm_shuffle_epi8(						\
+	    _mm_loadu_si128((const __m128i *)(data + 16 * (I))), mask);\
+	msg = _mm_add_epi32(M0,						\
+	    _mm_loadu_si128((const __m128i *)&sctp_sha256_K[4 * (I)]));	\
+	state1 = _mm_sha256rnds2_epu32(state1, state0, msg);		\
+	msg = _mm_shuffle_epi32(msg, 0x0e);				\
+	state0 = _mm_sha256rnds2_epu32(state0, state1, msg)
+
+__attribute__((target("sha,ssse3,sse4.1")))
+static void
+sctp_sha256_process_blocks_ni(struct sctp_sha256_context *ctx, const unsigned char *data, unsigned int count)
+{
+	__m128i state0, state1, abef_save, cdgh_save;
+	__m128i msg, tmp, msg0, msg1, msg2, msg3;
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+	/* The instructions expect the state as ABEF and CDGH. */
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&ctx->H[0]), 0xb1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&ctx->H[4]), 0x1b);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+	while (count-- > 0) {
+		abef_save = state0;
+		cdgh_save = state1;
+		SHA256_NI_ROUNDS_LOAD(0, msg0);
+		SHA256_NI_ROUNDS_LOAD(1, msg1);
+		msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+		SHA256_NI_ROUNDS_LOAD(2, msg2);
+		msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+		msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), mask);
+		SHA256_NI_ROUNDS(3, msg3, msg0, msg1, msg2);
+		SHA256_NI_ROUNDS(4, msg0, msg1, msg2, msg3);
+		SHA256_NI_ROUNDS(5, msg1, msg2, msg3, msg0);
+		SHA256_NI_ROUNDS(6, msg2, msg3, msg0, msg1);
+		SHA256_NI_ROUNDS(7, msg3, msg0, msg1, msg2);
+		SHA256_NI_ROUNDS(8, msg0, msg1, msg2, msg3);
+		SHA256_NI_ROUNDS(9, msg1, msg2, msg3, msg0);
+		SHA256_NI_ROUNDS(10, msg2, msg3, msg0, msg1);
+		SHA256_NI_ROUNDS(11, msg3, msg0, msg1, msg2);
+		SHA256_NI_ROUNDS(12, msg0, msg1, msg2, msg3);
+		SHA256_NI_ROUNDS(13, msg1, msg2, msg3, msg0);
+		SHA256_NI_ROUNDS(14, msg2, msg3, msg0, msg1);
+		SHA256_NI_ROUNDS(15, msg3, msg0, msg1, msg2);
+		state0 = _mm_add_epi32(state0, abef_save);
+		state1 = _mm_add_epi32(state1, cdgh_save);
+		data += 64;
+	}
+	tmp = _mm_shuffle_epi32(state0, 0x1b);
+	state1 = _mm_shuffle_epi32(state1, 0xb1);
+	state0 = _mm_blend_epi16(tmp, state1, 0xf0);
+	state1 = _mm_alignr_epi8(state1, tmp, 8);
+	_mm_storeu_si128((__m128i *)&ctx->H[0], state0);
+	_mm_storeu_si128((__m128i *)&ctx->H[4], state1);
+}
+#endif
+
+void
+sctp_sha256_init(struct sctp_sha256_context *ctx)
+{
+	ctx->H[0] = 0x6a09e667;
+	ctx->H[1] = 0xbb67ae85;
+	ctx->H[2] = 0x3c6ef372;
+	ctx->H[3] = 0xa54ff53a;
+	ctx->H[4] = 0x510e527f;
+	ctx->H[5] = 0x9b05688c;
+	ctx->H[6] = 0x1f83d9ab;
+	ctx->H[7] = 0x5be0cd19;
+	ctx->how_many_in_block = 0;
+	ctx->running_total = 0;
+}
+
+static void
+sctp_sha256_process_a_block(struct sctp_sha256_context *ctx, const unsigned char *block)
+{
+	unsigned int W[64];
+	unsigned int a, b, c, d, e, f, g, h, T1, T2;
+	int i;
+
+	for (i = 0; i < 16; i++) {
+		W[i] = ((unsigned int)block[4 * i] << 24) |
+		    ((unsigned int)block[4 * i + 1] << 16) |
+		    ((unsigned int)block[4 * i + 2] << 8) |
+		    ((unsigned int)block[4 * i + 3]);
+	}
+	for (i = 16; i < 64; i++) {
+		W[i] = SSIG1(W[i - 2]) + W[i - 7] + SSIG0(W[i - 15]) + W[i - 16];
+	}
+	a = ctx->H[0];
+	b = ctx->H[1];
+	c = ctx->H[2];
+	d = ctx->H[3];
+	e = ctx->H[4];
+	f = ctx->H[5];
+	g = ctx->H[6];
+	h = ctx->H[7];
+	for (i = 0; i < 64; i++) {
+		T1 = h + BSIG1(e) + CH(e, f, g) + sctp_sha256_K[i] + W[i];
+		T2 = BSIG0(a) + MAJ(a, b, c);
+		h = g;
+		g = f;
+		f = e;
+		e = d + T1;
+		d = c;
+		c = b;
+		b = a;
+		a = T1 + T2;
+	}
+	ctx->H[0] += a;
+	ctx->H[1] += b;
+	ctx->H[2] += c;
+	ctx->H[3] += d;
+	ctx->H[4] += e;
+	ctx->H[5] += f;
+	ctx->H[6] += g;
+	ctx->H[7] += h;
+}
+
+static void
+sctp_sha256_process_blocks(struct sctp_sha256_context *ctx, const unsigned char *data, unsigned int count)
+{
+#if defined(SCTP_SHA_NI)
+	if (sctp_sha_ni_available()) {
+		sctp_sha256_process_blocks_ni(ctx, data, count);
+		return;
+	}
+#endif
+	while (count-- > 0) {
+		sctp_sha256_process_a_block(ctx, data);
+		data += 64;
+	}
+}
+
+void
+sctp_sha256_update(struct sctp_sha256_context *ctx, const unsigned char *ptr, unsigned int siz)
+{
+	unsigned int left_to_fill, count;
+
+	ctx->running_total += siz;
+	if (ctx->how_many_in_block > 0) {
+		left_to_fill = sizeof(ctx->sha_block) - ctx->how_many_in_block;
+		if (left_to_fill > siz) {
+			/* can only partially fill up this one */
+			memcpy(&ctx->sha_block[ctx->how_many_in_block], ptr, siz);
+			ctx->how_many_in_block += siz;
+			return;
+		}
+		/* block is now full, process it */
+		memcpy(&ctx->sha_block[ctx->how_many_in_block], ptr, left_to_fill);
+		sctp_sha256_process_blocks(ctx, ctx->sha_block, 1);
+		ctx->how_many_in_block = 0;
+		ptr += left_to_fill;
+		siz -= left_to_fill;
+	}
+	/* process all complete blocks directly from the input */
+	count = siz / sizeof(ctx->sha_block);
+	if (count > 0) {
+		sctp_sha256_process_blocks(ctx, ptr, count);
+		ptr += count * sizeof(ctx->sha_block);
+		siz -= count * sizeof(ctx->sha_block);
+	}
+	if (siz > 0) {
+		memcpy(ctx->sha_block, ptr, siz);
+		ctx->how_many_in_block = siz;
+	}
+}
+
+void
+sctp_sha256_final(unsigned char *digest, struct sctp_sha256_context *ctx)
+{
+	unsigned int i;
+
+	/* append the 1 bit, then pad with 0's up to the length */
+	ctx->sha_block[ctx->how_many_in_block] = 0x80;
+	memset(&ctx->sha_block[ctx->how_many_in_block + 1], 0,
+	    sizeof(ctx->sha_block) - ctx->how_many_in_block - 1);
+	if (ctx->how_many_in_block > 55) {
+		/* no room for the length, it goes into an extra block */
+		sctp_sha256_process_blocks(ctx, ctx->sha_block, 1);
+		memset(ctx->sha_block, 0, sizeof(ctx->sha_block));
+	}
+	/* the length in bits as a 64 bit number in network byte order */
+	ctx->sha_block[59] = (ctx->running_total >> 29) & 0xff;
+	ctx->sha_block[60] = (ctx->running_total >> 21) & 0xff;
+	ctx->sha_block[61] = (ctx->running_total >> 13) & 0xff;
+	ctx->sha_block[62] = (ctx->running_total >> 5) & 0xff;
+	ctx->sha_block[63] = (ctx->running_total << 3) & 0xff;
+	sctp_sha256_process_blocks(ctx, ctx->sha_block, 1);
+	for (i = 0; i < 8; i++) {
+		digest[4 * i] = (ctx->H[i] >> 24) & 0xff;
+		digest[4 * i + 1] = (ctx->H[i] >> 16) & 0xff;
+		digest[4 * i + 2] = (ctx->H[i] >> 8) & 0xff;
+		digest[4 * i + 3] = ctx->H[i] & 0xff;
+	}
+}
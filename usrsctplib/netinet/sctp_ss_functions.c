@@ -55,7 +55,7 @@ static void
 sctp_ss_default_init(struct sctp_tcb *stcb, struct sctp_association *asoc,
                      int holds_lock)
 {
-	uint16_t i;
+	uint32_t i;
 
 	asoc->ss_data.locked_on_sending = NULL;
 	asoc->ss_data.last_out_stream = NULL;
@@ -67,8 +67,13 @@ sctp_ss_default_init(struct sctp_tcb *stcb, struct sctp_association *asoc,
 	 * to the wheel.
 	 */
 	for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
+		if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+			/* Streams not allocated yet have no data queued. */
+			i |= SCTP_STREAM_PAGE_MASK;
+			continue;
+		}
 		stcb->asoc.ss_functions.sctp_ss_add_to_stream(stcb, &stcb->asoc,
-		                                              &stcb->asoc.strmout[i],
+		                                              SCTP_STRMOUT(&stcb->asoc, i),
 		                                              NULL, holds_lock);
 	}
 	return;
@@ -387,10 +392,129 @@ rrp_again:
 }
 
 
+/*
+ * Pairing heap of stream queues.
+ * Used by the priority and WFQ schedulers so that adding, removing and
+ * selecting a stream does not depend on the number of streams with data.
+ * Inserting is O(1), removing is O(log n) amortized and the minimum is
+ * the root.
+ */
+static struct ss_heap_entry *
+sctp_ss_heap_meld(struct ss_heap_entry *a, struct ss_heap_entry *b)
+{
+	struct ss_heap_entry *t;
+
+	if (a == NULL) {
+		return (b);
+	}
+	if (b == NULL) {
+		return (a);
+	}
+	if (b->key < a->key) {
+		t = a;
+		a = b;
+		b = t;
+	}
+	/* b becomes the leftmost child of a */
+	b->prev = a;
+	b->sibling = a->child;
+	if (a->child != NULL) {
+		a->child->prev = b;
+	}
+	a->child = b;
+	return (a);
+}
+
+static struct ss_heap_entry *
+sctp_ss_heap_merge_pairs(struct ss_heap_entry *first)
+{
+	struct ss_heap_entry *a, *b, *next, *pairs, *root;
+
+	/* Meld pairs from left to right, keeping the results in reverse order. */
+	pairs = NULL;
+	while (first != NULL) {
+		a = first;
+		b = a->sibling;
+		next = (b != NULL) ? b->sibling : NULL;
+		a->sibling = NULL;
+		a->prev = NULL;
+		if (b != NULL) {
+			b->sibling = NULL;
+			b->prev = NULL;
+		}
+		a = sctp_ss_heap_meld(a, b);
+		a->sibling = pairs;
+		pairs = a;
+		first = next;
+	}
+	/* Meld the results from right to left. */
+	root = NULL;
+	while (pairs != NULL) {
+		next = pairs->sibling;
+		pairs->sibling = NULL;
+		root = sctp_ss_heap_meld(root, pairs);
+		pairs = next;
+	}
+	return (root);
+}
+
+static void
+sctp_ss_heap_insert(struct ss_heap_entry **root, struct ss_heap_entry *e)
+{
+	e->child = NULL;
+	e->sibling = NULL;
+	e->prev = NULL;
+	*root = sctp_ss_heap_meld(*root, e);
+	return;
+}
+
+static void
+sctp_ss_heap_remove(struct ss_heap_entry **root, struct ss_heap_entry *e)
+{
+	struct ss_heap_entry *sub;
+
+	sub = sctp_ss_heap_merge_pairs(e->child);
+	if (e == *root) {
+		*root = sub;
+	} else {
+		if (e->prev->child == e) {
+			e->prev->child = e->sibling;
+		} else {
+			e->prev->sibling = e->sibling;
+		}
+		if (e->sibling != NULL) {
+			e->sibling->prev = e->prev;
+		}
+		*root = sctp_ss_heap_meld(*root, sub);
+	}
+	e->child = NULL;
+	e->sibling = NULL;
+	e->prev = NULL;
+	return;
+}
+
 /*
  * Priority algorithm.
  * Always prefers streams based on their priority id.
+ * Streams with data are kept on the wheel and in a heap ordered by
+ * the priority and the time they were added or last scheduled. This
+ * gives round-robin between streams of the same priority.
  */
+#define SCTP_SS_PRIO_KEY(priority, seq) \
+	(((uint64_t)(priority) << 48) | ((seq) & 0x0000ffffffffffffULL))
+#define SCTP_SS_PRIO_STRQ(e) \
+	((struct sctp_stream_out *)((caddr_t)(e) - offsetof(struct sctp_stream_out, ss_params.prio.heap)))
+
+static void
+sctp_ss_prio_init(struct sctp_tcb *stcb, struct sctp_association *asoc,
+                  int holds_lock)
+{
+	asoc->ss_data.heap = NULL;
+	asoc->ss_data.heap_seq = 0;
+	sctp_ss_default_init(stcb, asoc, holds_lock);
+	return;
+}
+
 static void
 sctp_ss_prio_clear(struct sctp_tcb *stcb, struct sctp_association *asoc,
                    int clear_values, int holds_lock)
@@ -406,8 +530,11 @@ sctp_ss_prio_clear(struct sctp_tcb *stcb, struct sctp_association *asoc,
 		TAILQ_REMOVE(&asoc->ss_data.out.wheel, TAILQ_FIRST(&asoc->ss_data.out.wheel), ss_params.prio.next_spoke);
 		strq->ss_params.prio.next_spoke.tqe_next = NULL;
 		strq->ss_params.prio.next_spoke.tqe_prev = NULL;
-
+		strq->ss_params.prio.heap.child = NULL;
+		strq->ss_params.prio.heap.sibling = NULL;
+		strq->ss_params.prio.heap.prev = NULL;
 	}
+	asoc->ss_data.heap = NULL;
 	asoc->ss_data.last_out_stream = NULL;
 	if (holds_lock == 0) {
 		SCTP_TCB_SEND_UNLOCK(stcb);
@@ -428,6 +555,10 @@ sctp_ss_prio_init_stream(struct sctp_tcb *stcb, struct sctp_stream_out *strq, st
 	}
 	strq->ss_params.prio.next_spoke.tqe_next = NULL;
 	strq->ss_params.prio.next_spoke.tqe_prev = NULL;
+	strq->ss_params.prio.heap.child = NULL;
+	strq->ss_params.prio.heap.sibling = NULL;
+	strq->ss_params.prio.heap.prev = NULL;
+	strq->ss_params.prio.heap.key = 0;
 	if (with_strq != NULL) {
 		strq->ss_params.prio.priority = with_strq->ss_params.prio.priority;
 	} else {
@@ -441,8 +572,6 @@ sctp_ss_prio_add(struct sctp_tcb *stcb, struct sctp_association *asoc,
                  struct sctp_stream_out *strq, struct sctp_stream_queue_pending *sp SCTP_UNUSED,
                  int holds_lock)
 {
-	struct sctp_stream_out *strqt;
-
 	if (holds_lock == 0) {
 		SCTP_TCB_SEND_LOCK(stcb);
 	}
@@ -450,19 +579,10 @@ sctp_ss_prio_add(struct sctp_tcb *stcb, struct sctp_association *asoc,
 	if (!TAILQ_EMPTY(&strq->outqueue) &&
 	    (strq->ss_params.prio.next_spoke.tqe_next == NULL) &&
 	    (strq->ss_params.prio.next_spoke.tqe_prev == NULL)) {
-		if (TAILQ_EMPTY(&asoc->ss_data.out.wheel)) {
-			TAILQ_INSERT_HEAD(&asoc->ss_data.out.wheel, strq, ss_params.prio.next_spoke);
-		} else {
-			strqt = TAILQ_FIRST(&asoc->ss_data.out.wheel);
-			while (strqt != NULL && strqt->ss_params.prio.priority < strq->ss_params.prio.priority) {
-				strqt = TAILQ_NEXT(strqt, ss_params.prio.next_spoke);
-			}
-			if (strqt != NULL) {
-				TAILQ_INSERT_BEFORE(strqt, strq, ss_params.prio.next_spoke);
-			} else {
-				TAILQ_INSERT_TAIL(&asoc->ss_data.out.wheel, strq, ss_params.prio.next_spoke);
-			}
-		}
+		TAILQ_INSERT_TAIL(&asoc->ss_data.out.wheel, strq, ss_params.prio.next_spoke);
+		strq->ss_params.prio.heap.key = SCTP_SS_PRIO_KEY(strq->ss_params.prio.priority,
+		                                                 asoc->ss_data.heap_seq++);
+		sctp_ss_heap_insert(&asoc->ss_data.heap, &strq->ss_params.prio.heap);
 	}
 	if (holds_lock == 0) {
 		SCTP_TCB_SEND_UNLOCK(stcb);
@@ -496,6 +616,7 @@ sctp_ss_prio_remove(struct sctp_tcb *stcb, struct sctp_association *asoc,
 		TAILQ_REMOVE(&asoc->ss_data.out.wheel, strq, ss_params.prio.next_spoke);
 		strq->ss_params.prio.next_spoke.tqe_next = NULL;
 		strq->ss_params.prio.next_spoke.tqe_prev = NULL;
+		sctp_ss_heap_remove(&asoc->ss_data.heap, &strq->ss_params.prio.heap);
 	}
 	if (holds_lock == 0) {
 		SCTP_TCB_SEND_UNLOCK(stcb);
@@ -507,50 +628,63 @@ static struct sctp_stream_out*
 sctp_ss_prio_select(struct sctp_tcb *stcb SCTP_UNUSED, struct sctp_nets *net,
                     struct sctp_association *asoc)
 {
-	struct sctp_stream_out *strq, *strqt, *strqn;
+	struct sctp_stream_out *strq, *strqt;
 
-	strqt = asoc->ss_data.last_out_stream;
-prio_again:
-	/* Find the next stream to use */
-	if (strqt == NULL) {
-		strq = TAILQ_FIRST(&asoc->ss_data.out.wheel);
-	} else {
-		strqn = TAILQ_NEXT(strqt, ss_params.prio.next_spoke);
-		if (strqn != NULL &&
-		    strqn->ss_params.prio.priority == strqt->ss_params.prio.priority) {
-			strq = strqn;
-		} else {
-			strq = TAILQ_FIRST(&asoc->ss_data.out.wheel);
-		}
+	if (asoc->ss_data.heap == NULL) {
+		return (NULL);
 	}
+	strq = SCTP_SS_PRIO_STRQ(asoc->ss_data.heap);
 
 	/* If CMT is off, we must validate that
 	 * the stream in question has the first
 	 * item pointed towards are network destination
-	 * requested by the caller. Note that if we
-	 * turn out to be locked to a stream (assigning
-	 * TSN's then we must stop, since we cannot
-	 * look for another stream with data to send
-	 * to that destination). In CMT's case, by
+	 * requested by the caller. In CMT's case, by
 	 * skipping this check, we will send one
 	 * data packet towards the requested net.
+	 * If the preferred stream can't be used, fall
+	 * back to looking at all streams with data
+	 * and take the preferred one of these.
 	 */
-	if (net != NULL && strq != NULL &&
+	if (net != NULL &&
 	    SCTP_BASE_SYSCTL(sctp_cmt_on_off) == 0) {
 		if (TAILQ_FIRST(&strq->outqueue) &&
 		    TAILQ_FIRST(&strq->outqueue)->net != NULL &&
 		    TAILQ_FIRST(&strq->outqueue)->net != net) {
-			if (strq == asoc->ss_data.last_out_stream) {
-				return (NULL);
-			} else {
-				strqt = strq;
-				goto prio_again;
+			strq = NULL;
+			TAILQ_FOREACH(strqt, &asoc->ss_data.out.wheel, ss_params.prio.next_spoke) {
+				if (TAILQ_FIRST(&strqt->outqueue) &&
+				    TAILQ_FIRST(&strqt->outqueue)->net != NULL &&
+				    TAILQ_FIRST(&strqt->outqueue)->net != net) {
+					continue;
+				}
+				if (strq == NULL ||
+				    strqt->ss_params.prio.heap.key < strq->ss_params.prio.heap.key) {
+					strq = strqt;
+				}
 			}
 		}
 	}
 	return (strq);
 }
 
+static void
+sctp_ss_prio_scheduled(struct sctp_tcb *stcb, struct sctp_nets *net,
+                       struct sctp_association *asoc, struct sctp_stream_out *strq,
+                       int moved_how_much)
+{
+	sctp_ss_default_scheduled(stcb, net, asoc, strq, moved_how_much);
+	/* Move the stream behind the other streams with the same priority. */
+	if ((strq->ss_params.prio.next_spoke.tqe_next != NULL ||
+	     strq->ss_params.prio.next_spoke.tqe_prev != NULL) &&
+	    (TAILQ_FIRST(&asoc->ss_data.out.wheel) != TAILQ_LAST(&asoc->ss_data.out.wheel, sctpwheel_listhead))) {
+		sctp_ss_heap_remove(&asoc->ss_data.heap, &strq->ss_params.prio.heap);
+		strq->ss_params.prio.heap.key = SCTP_SS_PRIO_KEY(strq->ss_params.prio.priority,
+		                                                 asoc->ss_data.heap_seq++);
+		sctp_ss_heap_insert(&asoc->ss_data.heap, &strq->ss_params.prio.heap);
+	}
+	return;
+}
+
 static int
 sctp_ss_prio_get_value(struct sctp_tcb *stcb SCTP_UNUSED, struct sctp_association *asoc SCTP_UNUSED,
                        struct sctp_stream_out *strq, uint16_t *value)
@@ -563,15 +697,19 @@ sctp_ss_prio_get_value(struct sctp_tcb *stcb SCTP_UNUSED, struct sctp_associatio
 }
 
 static int
-sctp_ss_prio_set_value(struct sctp_tcb *stcb, struct sctp_association *asoc,
+sctp_ss_prio_set_value(struct sctp_tcb *stcb SCTP_UNUSED, struct sctp_association *asoc,
                        struct sctp_stream_out *strq, uint16_t value)
 {
 	if (strq == NULL) {
 		return (-1);
 	}
 	strq->ss_params.prio.priority = value;
-	sctp_ss_prio_remove(stcb, asoc, strq, NULL, 1);
-	sctp_ss_prio_add(stcb, asoc, strq, NULL, 1);
+	if (strq->ss_params.prio.next_spoke.tqe_next != NULL ||
+	    strq->ss_params.prio.next_spoke.tqe_prev != NULL) {
+		sctp_ss_heap_remove(&asoc->ss_data.heap, &strq->ss_params.prio.heap);
+		strq->ss_params.prio.heap.key = SCTP_SS_PRIO_KEY(value, asoc->ss_data.heap_seq++);
+		sctp_ss_heap_insert(&asoc->ss_data.heap, &strq->ss_params.prio.heap);
+	}
 	return (1);
 }
 
@@ -759,7 +897,7 @@ sctp_ss_fcfs_init(struct sctp_tcb *stcb, struct sctp_association *asoc,
 {
 	uint32_t x, n = 0, add_more = 1;
 	struct sctp_stream_queue_pending *sp;
-	uint16_t i;
+	uint32_t i;
 
 	TAILQ_INIT(&asoc->ss_data.out.list);
 	/*
@@ -772,7 +910,11 @@ sctp_ss_fcfs_init(struct sctp_tcb *stcb, struct sctp_association *asoc,
 	while (add_more) {
 		add_more = 0;
 		for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-			sp = TAILQ_FIRST(&stcb->asoc.strmout[i].outqueue);
+			if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			sp = TAILQ_FIRST(&SCTP_STRMOUT(&stcb->asoc, i)->outqueue);
 			x = 0;
 			/* Find n. message in current stream queue */
 			while (sp != NULL && x < n) {
@@ -780,7 +922,7 @@ sctp_ss_fcfs_init(struct sctp_tcb *stcb, struct sctp_association *asoc,
 				x++;
 			}
 			if (sp != NULL) {
-				sctp_ss_fcfs_add(stcb, &stcb->asoc, &stcb->asoc.strmout[i], sp, holds_lock);
+				sctp_ss_fcfs_add(stcb, &stcb->asoc, SCTP_STRMOUT(&stcb->asoc, i), sp, holds_lock);
 				add_more = 1;
 			}
 		}
@@ -879,7 +1021,7 @@ sctp_ss_fcfs_select(struct sctp_tcb *stcb SCTP_UNUSED, struct sctp_nets *net,
 	sp = TAILQ_FIRST(&asoc->ss_data.out.list);
 default_again:
 	if (sp != NULL) {
-		strq = &asoc->strmout[sp->sid];
+		strq = SCTP_STRMOUT(asoc, sp->sid);
 	} else {
 		strq = NULL;
 	}
@@ -908,6 +1050,243 @@ default_again:
 	return (strq);
 }
 
+/*
+ * Weighted fair queueing algorithm.
+ * Shares the bandwidth between the streams according to their weights.
+ * Implemented as start-time fair queueing: each stream with data is kept
+ * in a heap ordered by the virtual time at which it can start sending.
+ * When a stream is scheduled, its next start time is advanced by the
+ * number of bytes moved divided by its weight and the virtual time of
+ * the association is advanced to the start time of the stream served.
+ */
+#define SCTP_SS_WFQ_DEFAULT_WEIGHT 1
+#define SCTP_SS_WFQ_SCALE 65536
+#define SCTP_SS_WFQ_STRQ(e) \
+	((struct sctp_stream_out *)((caddr_t)(e) - offsetof(struct sctp_stream_out, ss_params.wfq.heap)))
+
+static void
+sctp_ss_wfq_init(struct sctp_tcb *stcb, struct sctp_association *asoc,
+                 int holds_lock)
+{
+	asoc->ss_data.heap = NULL;
+	sctp_ss_default_init(stcb, asoc, holds_lock);
+	return;
+}
+
+static void
+sctp_ss_wfq_clear(struct sctp_tcb *stcb, struct sctp_association *asoc,
+                  int clear_values, int holds_lock)
+{
+	if (holds_lock == 0) {
+		SCTP_TCB_SEND_LOCK(stcb);
+	}
+	while (!TAILQ_EMPTY(&asoc->ss_data.out.wheel)) {
+		struct sctp_stream_out *strq = TAILQ_FIRST(&asoc->ss_data.out.wheel);
+		if (clear_values) {
+			strq->ss_params.wfq.weight = SCTP_SS_WFQ_DEFAULT_WEIGHT;
+			strq->ss_params.wfq.finish = 0;
+		}
+		TAILQ_REMOVE(&asoc->ss_data.out.wheel, TAILQ_FIRST(&asoc->ss_data.out.wheel), ss_params.wfq.next_spoke);
+		strq->ss_params.wfq.next_spoke.tqe_next = NULL;
+		strq->ss_params.wfq.next_spoke.tqe_prev = NULL;
+		strq->ss_params.wfq.heap.child = NULL;
+		strq->ss_params.wfq.heap.sibling = NULL;
+		strq->ss_params.wfq.heap.prev = NULL;
+	}
+	if (clear_values) {
+		asoc->ss_data.virtual_time = 0;
+	}
+	asoc->ss_data.heap = NULL;
+	asoc->ss_data.last_out_stream = NULL;
+	if (holds_lock == 0) {
+		SCTP_TCB_SEND_UNLOCK(stcb);
+	}
+	return;
+}
+
+static void
+sctp_ss_wfq_init_stream(struct sctp_tcb *stcb, struct sctp_stream_out *strq, struct sctp_stream_out *with_strq)
+{
+	if (with_strq != NULL) {
+		if (stcb->asoc.ss_data.locked_on_sending == with_strq) {
+			stcb->asoc.ss_data.locked_on_sending = strq;
+		}
+		if (stcb->asoc.ss_data.last_out_stream == with_strq) {
+			stcb->asoc.ss_data.last_out_stream = strq;
+		}
+	}
+	strq->ss_params.wfq.next_spoke.tqe_next = NULL;
+	strq->ss_params.wfq.next_spoke.tqe_prev = NULL;
+	strq->ss_params.wfq.heap.child = NULL;
+	strq->ss_params.wfq.heap.sibling = NULL;
+	strq->ss_params.wfq.heap.prev = NULL;
+	strq->ss_params.wfq.heap.key = 0;
+	if (with_strq != NULL) {
+		strq->ss_params.wfq.weight = with_strq->ss_params.wfq.weight;
+		strq->ss_params.wfq.finish = with_strq->ss_params.wfq.finish;
+	} else {
+		strq->ss_params.wfq.weight = SCTP_SS_WFQ_DEFAULT_WEIGHT;
+		strq->ss_params.wfq.finish = 0;
+	}
+	return;
+}
+
+static void
+sctp_ss_wfq_add(struct sctp_tcb *stcb, struct sctp_association *asoc,
+                struct sctp_stream_out *strq, struct sctp_stream_queue_pending *sp SCTP_UNUSED,
+                int holds_lock)
+{
+	if (holds_lock == 0) {
+		SCTP_TCB_SEND_LOCK(stcb);
+	}
+	/* Add to wheel if not already on it and stream queue not empty */
+	if (!TAILQ_EMPTY(&strq->outqueue) &&
+	    (strq->ss_params.wfq.next_spoke.tqe_next == NULL) &&
+	    (strq->ss_params.wfq.next_spoke.tqe_prev == NULL)) {
+		TAILQ_INSERT_TAIL(&asoc->ss_data.out.wheel, strq, ss_params.wfq.next_spoke);
+		/* A stream becoming active gets no credit for being idle. */
+		if (strq->ss_params.wfq.finish > asoc->ss_data.virtual_time) {
+			strq->ss_params.wfq.heap.key = strq->ss_params.wfq.finish;
+		} else {
+			strq->ss_params.wfq.heap.key = asoc->ss_data.virtual_time;
+		}
+		sctp_ss_heap_insert(&asoc->ss_data.heap, &strq->ss_params.wfq.heap);
+	}
+	if (holds_lock == 0) {
+		SCTP_TCB_SEND_UNLOCK(stcb);
+	}
+	return;
+}
+
+static void
+sctp_ss_wfq_remove(struct sctp_tcb *stcb, struct sctp_association *asoc,
+                   struct sctp_stream_out *strq, struct sctp_stream_queue_pending *sp SCTP_UNUSED,
+                   int holds_lock)
+{
+	if (holds_lock == 0) {
+		SCTP_TCB_SEND_LOCK(stcb);
+	}
+	/* Remove from wheel if stream queue is empty and actually is on the wheel */
+	if (TAILQ_EMPTY(&strq->outqueue) &&
+	    (strq->ss_params.wfq.next_spoke.tqe_next != NULL ||
+	    strq->ss_params.wfq.next_spoke.tqe_prev != NULL)) {
+		if (asoc->ss_data.last_out_stream == strq) {
+			asoc->ss_data.last_out_stream = TAILQ_PREV(asoc->ss_data.last_out_stream, sctpwheel_listhead,
+			                                   ss_params.wfq.next_spoke);
+			if (asoc->ss_data.last_out_stream == NULL) {
+				asoc->ss_data.last_out_stream = TAILQ_LAST(&asoc->ss_data.out.wheel,
+				                                   sctpwheel_listhead);
+			}
+			if (asoc->ss_data.last_out_stream == strq) {
+				asoc->ss_data.last_out_stream = NULL;
+			}
+		}
+		TAILQ_REMOVE(&asoc->ss_data.out.wheel, strq, ss_params.wfq.next_spoke);
+		strq->ss_params.wfq.next_spoke.tqe_next = NULL;
+		strq->ss_params.wfq.next_spoke.tqe_prev = NULL;
+		sctp_ss_heap_remove(&asoc->ss_data.heap, &strq->ss_params.wfq.heap);
+	}
+	if (holds_lock == 0) {
+		SCTP_TCB_SEND_UNLOCK(stcb);
+	}
+	return;
+}
+
+static struct sctp_stream_out *
+sctp_ss_wfq_select(struct sctp_tcb *stcb SCTP_UNUSED, struct sctp_nets *net,
+                   struct sctp_association *asoc)
+{
+	struct sctp_stream_out *strq, *strqt;
+
+	if (asoc->ss_data.locked_on_sending) {
+		return (asoc->ss_data.locked_on_sending);
+	}
+	if (asoc->ss_data.heap == NULL) {
+		return (NULL);
+	}
+	strq = SCTP_SS_WFQ_STRQ(asoc->ss_data.heap);
+
+	/* If CMT is off, we must validate that
+	 * the stream in question has the first
+	 * item pointed towards are network destination
+	 * requested by the caller. In CMT's case, by
+	 * skipping this check, we will send one
+	 * data packet towards the requested net.
+	 * If the preferred stream can't be used, fall
+	 * back to looking at all streams with data
+	 * and take the preferred one of these.
+	 */
+	if (net != NULL &&
+	    SCTP_BASE_SYSCTL(sctp_cmt_on_off) == 0) {
+		if (TAILQ_FIRST(&strq->outqueue) &&
+		    TAILQ_FIRST(&strq->outqueue)->net != NULL &&
+		    TAILQ_FIRST(&strq->outqueue)->net != net) {
+			strq = NULL;
+			TAILQ_FOREACH(strqt, &asoc->ss_data.out.wheel, ss_params.wfq.next_spoke) {
+				if (TAILQ_FIRST(&strqt->outqueue) &&
+				    TAILQ_FIRST(&strqt->outqueue)->net != NULL &&
+				    TAILQ_FIRST(&strqt->outqueue)->net != net) {
+					continue;
+				}
+				if (strq == NULL ||
+				    strqt->ss_params.wfq.heap.key < strq->ss_params.wfq.heap.key) {
+					strq = strqt;
+				}
+			}
+		}
+	}
+	return (strq);
+}
+
+static void
+sctp_ss_wfq_scheduled(struct sctp_tcb *stcb, struct sctp_nets *net,
+                      struct sctp_association *asoc, struct sctp_stream_out *strq,
+                      int moved_how_much)
+{
+	uint64_t start;
+
+	sctp_ss_default_scheduled(stcb, net, asoc, strq, moved_how_much);
+	if (moved_how_much <= 0) {
+		return;
+	}
+	start = strq->ss_params.wfq.heap.key;
+	if (start > asoc->ss_data.virtual_time) {
+		asoc->ss_data.virtual_time = start;
+	}
+	strq->ss_params.wfq.finish = start +
+	    (uint64_t)moved_how_much * SCTP_SS_WFQ_SCALE / strq->ss_params.wfq.weight;
+	if (strq->ss_params.wfq.next_spoke.tqe_next != NULL ||
+	    strq->ss_params.wfq.next_spoke.tqe_prev != NULL) {
+		sctp_ss_heap_remove(&asoc->ss_data.heap, &strq->ss_params.wfq.heap);
+		strq->ss_params.wfq.heap.key = strq->ss_params.wfq.finish;
+		sctp_ss_heap_insert(&asoc->ss_data.heap, &strq->ss_params.wfq.heap);
+	}
+	return;
+}
+
+static int
+sctp_ss_wfq_get_value(struct sctp_tcb *stcb SCTP_UNUSED, struct sctp_association *asoc SCTP_UNUSED,
+                      struct sctp_stream_out *strq, uint16_t *value)
+{
+	if (strq == NULL) {
+		return (-1);
+	}
+	*value = strq->ss_params.wfq.weight;
+	return (1);
+}
+
+static int
+sctp_ss_wfq_set_value(struct sctp_tcb *stcb SCTP_UNUSED, struct sctp_association *asoc SCTP_UNUSED,
+                      struct sctp_stream_out *strq, uint16_t value)
+{
+	if ((strq == NULL) || (value == 0)) {
+		return (-1);
+	}
+	/* The new weight applies to the data scheduled from now on. */
+	strq->ss_params.wfq.weight = value;
+	return (1);
+}
+
 const struct sctp_ss_functions sctp_ss_functions[] = {
 /* SCTP_SS_DEFAULT */
 {
@@ -1002,27 +1381,27 @@ const struct sctp_ss_functions sctp_ss_functions[] = {
 /* SCTP_SS_PRIORITY */
 {
 #if defined(__Windows__) || defined(__Userspace_os_Windows)
-	sctp_ss_default_init,
+	sctp_ss_prio_init,
 	sctp_ss_prio_clear,
 	sctp_ss_prio_init_stream,
 	sctp_ss_prio_add,
 	sctp_ss_default_is_empty,
 	sctp_ss_prio_remove,
 	sctp_ss_prio_select,
-	sctp_ss_default_scheduled,
+	sctp_ss_prio_scheduled,
 	sctp_ss_default_packet_done,
 	sctp_ss_prio_get_value,
 	sctp_ss_prio_set_value,
 	sctp_ss_default_is_user_msgs_incomplete
 #else
-	.sctp_ss_init = sctp_ss_default_init,
+	.sctp_ss_init = sctp_ss_prio_init,
 	.sctp_ss_clear = sctp_ss_prio_clear,
 	.sctp_ss_init_stream = sctp_ss_prio_init_stream,
 	.sctp_ss_add_to_stream = sctp_ss_prio_add,
 	.sctp_ss_is_empty = sctp_ss_default_is_empty,
 	.sctp_ss_remove_from_stream = sctp_ss_prio_remove,
 	.sctp_ss_select_stream = sctp_ss_prio_select,
-	.sctp_ss_scheduled = sctp_ss_default_scheduled,
+	.sctp_ss_scheduled = sctp_ss_prio_scheduled,
 	.sctp_ss_packet_done = sctp_ss_default_packet_done,
 	.sctp_ss_get_value = sctp_ss_prio_get_value,
 	.sctp_ss_set_value = sctp_ss_prio_set_value,
@@ -1088,5 +1467,35 @@ const struct sctp_ss_functions sctp_ss_functions[] = {
 	.sctp_ss_set_value = sctp_ss_default_set_value,
 	.sctp_ss_is_user_msgs_incomplete = sctp_ss_default_is_user_msgs_incomplete
 #endif
+},
+/* SCTP_SS_WFQ */
+{
+#if defined(__Windows__) || defined(__Userspace_os_Windows)
+	sctp_ss_wfq_init,
+	sctp_ss_wfq_clear,
+	sctp_ss_wfq_init_stream,
+	sctp_ss_wfq_add,
+	sctp_ss_default_is_empty,
+	sctp_ss_wfq_remove,
+	sctp_ss_wfq_select,
+	sctp_ss_wfq_scheduled,
+	sctp_ss_default_packet_done,
+	sctp_ss_wfq_get_value,
+	sctp_ss_wfq_set_value,
+	sctp_ss_default_is_user_msgs_incomplete
+#else
+	.sctp_ss_init = sctp_ss_wfq_init,
+	.sctp_ss_clear = sctp_ss_wfq_clear,
+	.sctp_ss_init_stream = sctp_ss_wfq_init_stream,
+	.sctp_ss_add_to_stream = sctp_ss_wfq_add,
+	.sctp_ss_is_empty = sctp_ss_default_is_empty,
+	.sctp_ss_remove_from_stream = sctp_ss_wfq_remove,
+	.sctp_ss_select_stream = sctp_ss_wfq_select,
+	.sctp_ss_scheduled = sctp_ss_wfq_scheduled,
+	.sctp_ss_packet_done = sctp_ss_default_packet_done,
+	.sctp_ss_get_value = sctp_ss_wfq_get_value,
+	.sctp_ss_set_value = sctp_ss_wfq_set_value,
+	.sctp_ss_is_user_msgs_incomplete = sctp_ss_default_is_user_msgs_incomplete
+#endif
 }
 };
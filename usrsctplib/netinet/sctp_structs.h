@@ -301,6 +301,49 @@ struct rtcc_cc {
 	uint8_t  last_inst_ind; /* Last saved inst indication */
 };
 
+#define SCTP_BBR_BW_WINDOW 10
+
+struct bbr {
+	uint64_t bw_samples[SCTP_BBR_BW_WINDOW]; /* Delivery rate per round in bytes/s */
+	uint64_t btl_bw;        /* Max of bw_samples, bottleneck bw estimate */
+	uint64_t full_bw;       /* btl_bw when the pipe was last seen growing */
+	uint64_t pacing_rate;   /* pacing_gain * btl_bw in bytes/s, 0 if unknown */
+	uint64_t delivered;     /* Bytes delivered in the current round */
+	uint64_t round_start;   /* Time the current round started in us */
+	uint64_t min_rtt_stamp; /* Time min_rtt was measured in us */
+	uint64_t probe_rtt_done; /* Time PROBE_RTT may end in us */
+	uint32_t min_rtt;       /* Min RTT in us, 0 if unknown */
+	uint32_t round_end_tsn; /* The round ends when this TSN is cum-acked */
+	uint32_t round_count;   /* Number of rounds seen */
+	uint32_t prior_cwnd;    /* cwnd saved on entering PROBE_RTT or recovery */
+	uint32_t inflight_hi;   /* Upper bound for cwnd learned from loss, 0 if none */
+	uint16_t pacing_gain;   /* Fixed point arith, << 8 */
+	uint16_t cwnd_gain;     /* Fixed point arith, << 8 */
+	uint8_t  state;         /* SCTP_BBR_STARTUP, ... */
+	uint8_t  cycle_idx;     /* Position in the PROBE_BW gain cycle */
+	uint8_t  full_bw_cnt;   /* Rounds without significant bw growth */
+	uint8_t  full_bw_reached; /* Startup has filled the pipe */
+	uint8_t  app_limited;   /* The current round was application limited */
+	uint8_t  in_recovery;   /* In fast recovery, prior_cwnd is restored at the end */
+	uint8_t  packet_conservation; /* First round of recovery */
+};
+
+struct cubic {
+	uint64_t epoch_start;   /* Time the current epoch started in us, 0 if none */
+	uint64_t cwnd_rem;      /* Remainder of the cwnd increase */
+	uint64_t w_est_rem;     /* Remainder of the w_est increase */
+	uint32_t k;             /* Time to reach w_max in ms */
+	uint32_t w_max;         /* cwnd at the last congestion event */
+	uint32_t origin;        /* Plateau of the cubic function */
+	uint32_t w_est;         /* Estimate of a Reno cwnd */
+	uint32_t min_rtt;       /* Min RTT in us, 0 if unknown */
+	/* HyStart */
+	uint32_t round_end_tsn; /* The round ends when this TSN is cum-acked */
+	uint32_t round_min_rtt; /* Min RTT of the current round in us */
+	uint32_t last_round_min_rtt; /* Min RTT of the last round in us */
+	uint8_t  hystart_done;  /* Slow start was left because of delay increase */
+};
+
 
 struct sctp_nets {
 	TAILQ_ENTRY(sctp_nets) sctp_next;	/* next link */
@@ -311,6 +354,7 @@ struct sctp_nets {
 	 */
 	struct sctp_timer pmtu_timer;
 	struct sctp_timer hb_timer;
+	struct sctp_timer pacing_timer;
 
 	/*
 	 * The following two in combination equate to a route entry for v6
@@ -339,6 +383,8 @@ struct sctp_nets {
 	union cc_control_data {
 		struct htcp htcp_ca; 	/* JRS - struct used in HTCP algorithm */
 		struct rtcc_cc rtcc;    /* rtcc module cc stuff  */
+		struct bbr bbr;         /* bbr module cc stuff */
+		struct cubic cubic;     /* cubic module cc stuff */
 	} cc_mod;
 	int ref_count;
 
@@ -352,6 +398,11 @@ struct sctp_nets {
 	uint32_t prev_cwnd;	/* cwnd before any processing */
 	uint32_t ecn_prev_cwnd;	/* ECN prev cwnd at first ecn_echo seen in new window */
 	uint32_t partial_bytes_acked;	/* in CA tracks when to incr a MTU */
+	/*
+	 * Earliest time (in usec) the next packet may leave when the CC
+	 * module supplies a pacing rate, see sctp_pacing_blocked().
+	 */
+	uint64_t pacing_next;
 	/* tracking variables to avoid the aloc/free in sack processing */
 	unsigned int net_ack;
 	unsigned int net_ack2;
@@ -458,6 +509,7 @@ struct sctp_data_chunkrec {
 	 */
 	uint32_t fast_retran_tsn;	/* sending_seq at the time of FR */
 	struct timeval timetodrop;	/* time we drop it from queue */
+	struct timeval queued_time;	/* time the message was sent */
 	uint32_t fsn;			/* Fragment Sequence Number */
 	uint8_t doing_fast_retransmit;
 	uint8_t rcv_flags;	/* flags pulled from data chunk on inbound for
@@ -533,6 +585,7 @@ struct sctp_queued_to_read {	/* sinfo structure Pluse more */
 	struct mbuf *tail_mbuf;	/* used for multi-part data */
 	struct mbuf *aux_data;  /* used to hold/cache  control if o/s does not take it from us */
 	struct sctp_tcb *stcb;	/* assoc, used for window update */
+	struct timeval queued_time;	/* time put on the read queue */
 	TAILQ_ENTRY(sctp_queued_to_read) next;
 	TAILQ_ENTRY(sctp_queued_to_read) next_instrm;
 	struct sctpchunk_listhead reasm;
@@ -574,6 +627,7 @@ struct sctp_stream_queue_pending {
 	struct mbuf *data;
 	struct mbuf *tail_mbuf;
 	struct timeval ts;
+	struct timeval queued_time;
 	struct sctp_nets *net;
 	TAILQ_ENTRY (sctp_stream_queue_pending) next;
 	TAILQ_ENTRY (sctp_stream_queue_pending) ss_next;
@@ -618,14 +672,42 @@ struct ss_rr {
 	TAILQ_ENTRY(sctp_stream_out) next_spoke;
 };
 
+/*
+ * Entry of the pairing heap used by the priority and WFQ schedulers to
+ * find the next stream in O(log n) amortized time.
+ */
+struct ss_heap_entry {
+	/* leftmost child */
+	struct ss_heap_entry *child;
+	/* next sibling */
+	struct ss_heap_entry *sibling;
+	/* previous sibling or parent if leftmost child, NULL for the root */
+	struct ss_heap_entry *prev;
+	uint64_t key;
+};
+
 /* Priority scheduler */
 struct ss_prio {
 	/* next link in wheel */
 	TAILQ_ENTRY(sctp_stream_out) next_spoke;
+	/* position in the heap of streams with data */
+	struct ss_heap_entry heap;
 	/* priority id */
 	uint16_t priority;
 };
 
+/* Weighted fair queueing scheduler */
+struct ss_wfq {
+	/* next link in wheel */
+	TAILQ_ENTRY(sctp_stream_out) next_spoke;
+	/* position in the heap of streams with data, keyed by virtual start time */
+	struct ss_heap_entry heap;
+	/* virtual finish time of the data scheduled last */
+	uint64_t finish;
+	/* share of the bandwidth relative to the other streams */
+	uint16_t weight;
+};
+
 /* Fair Bandwidth scheduler */
 struct ss_fb {
 	/* next link in wheel */
@@ -646,6 +728,11 @@ struct scheduling_data {
 		struct sctpwheel_listhead wheel;
 		struct sctplist_listhead list;
 	} out;
+	/* heap of streams with data and its round-robin counter */
+	struct ss_heap_entry *heap;
+	uint64_t heap_seq;
+	/* virtual time of the WFQ scheduler */
+	uint64_t virtual_time;
 };
 
 /*
@@ -656,6 +743,7 @@ union scheduling_parameters {
 	struct ss_rr rr;
 	struct ss_prio prio;
 	struct ss_fb fb;
+	struct ss_wfq wfq;
 };
 
 /* States for outgoing streams */
@@ -690,6 +778,27 @@ struct sctp_stream_out {
 	uint8_t state;
 };
 
+/*
+ * The stream state of an association is kept in two-level tables. The
+ * strmin and strmout members of the association point to directories of
+ * pages, each holding SCTP_STREAM_PAGE_SIZE consecutive streams, and a page
+ * is only allocated when one of its streams is used. This keeps associations
+ * negotiating many streams, but using only a few of them, small.
+ * SCTP_STRMIN() and SCTP_STRMOUT() must only be used for streams which are
+ * known to be allocated, for example because data is queued on them. Use
+ * sctp_get_strmin() and sctp_get_strmout() for stream identifiers provided
+ * by the peer or the application.
+ */
+#define SCTP_STREAM_PAGE_SHIFT	5
+#define SCTP_STREAM_PAGE_SIZE	(1 << SCTP_STREAM_PAGE_SHIFT)
+#define SCTP_STREAM_PAGE_MASK	(SCTP_STREAM_PAGE_SIZE - 1)
+#define SCTP_STREAM_PAGES(cnt)	(((uint32_t)(cnt) + SCTP_STREAM_PAGE_MASK) >> SCTP_STREAM_PAGE_SHIFT)
+
+#define SCTP_STRMIN_PAGE(asoc, sid)	((asoc)->strmin[(sid) >> SCTP_STREAM_PAGE_SHIFT])
+#define SCTP_STRMOUT_PAGE(asoc, sid)	((asoc)->strmout[(sid) >> SCTP_STREAM_PAGE_SHIFT])
+#define SCTP_STRMIN(asoc, sid)		(&SCTP_STRMIN_PAGE(asoc, sid)[(sid) & SCTP_STREAM_PAGE_MASK])
+#define SCTP_STRMOUT(asoc, sid)		(&SCTP_STRMOUT_PAGE(asoc, sid)[(sid) & SCTP_STREAM_PAGE_MASK])
+
 /* used to keep track of the addresses yet to try to add/delete */
 TAILQ_HEAD(sctp_asconf_addrhead, sctp_asconf_addr);
 struct sctp_asconf_addr {
@@ -788,6 +897,8 @@ struct sctp_cc_functions {
 			struct sctp_nets *net);
 	int (*sctp_cwnd_socket_option)(struct sctp_tcb *stcb, int set, struct sctp_cc_option *);
 	void (*sctp_rtt_calculated)(struct sctp_tcb *, struct sctp_nets *, struct timeval *);
+	/* Rate in bytes per second to pace packets to net at, 0 disables pacing. */
+	uint64_t (*sctp_pacing_rate)(struct sctp_tcb *, struct sctp_nets *);
 };
 
 /*
@@ -915,9 +1026,9 @@ struct sctp_association {
 	 */
 	struct sctp_laddr *last_used_address;
 
-	/* stream arrays */
-	struct sctp_stream_in *strmin;
-	struct sctp_stream_out *strmout;
+	/* stream tables */
+	struct sctp_stream_in **strmin;
+	struct sctp_stream_out **strmout;
 	uint8_t *mapping_array;
 	/* primary destination to use */
 	struct sctp_nets *primary_destination;
@@ -1261,6 +1372,8 @@ struct sctp_association {
 	uint8_t seen_a_sack_this_pkt;
 	uint8_t stream_reset_outstanding;
 	uint8_t stream_reset_out_is_outstanding;
+	/* state of the outgoing streams not allocated yet */
+	uint8_t strmout_state;
 	uint8_t delayed_connection;
 	uint8_t ifp_had_enobuf;
 	uint8_t saw_sack_with_frags;
@@ -1299,6 +1412,8 @@ struct sctp_association {
 	struct timeval discontinuity_time;
 	uint64_t abandoned_unsent[SCTP_PR_SCTP_MAX + 1];
 	uint64_t abandoned_sent[SCTP_PR_SCTP_MAX + 1];
+	/* latency histograms, allocated on the first sample if enabled */
+	struct sctp_assoc_perf_stats *perf_stats;
 };
 
 #endif
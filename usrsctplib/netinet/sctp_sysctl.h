@@ -93,6 +93,8 @@ struct sctp_sysctl {
 	uint32_t sctp_L2_abc_variable;
 	uint32_t sctp_mbuf_threshold_count;
 	uint32_t sctp_do_drain;
+	uint32_t sctp_idle_compact_time;
+	uint32_t sctp_perf_stats_enable;
 	uint32_t sctp_hb_maxburst;
 	uint32_t sctp_abort_if_one_2_one_hits_limit;
 	uint32_t sctp_min_residual;
@@ -433,6 +435,18 @@ struct sctp_sysctl {
 #define SCTPCTL_DO_SCTP_DRAIN_MAX	1
 #define SCTPCTL_DO_SCTP_DRAIN_DEFAULT	1
 
+/* idle_compact_time: Quiet time after which idle associations are compacted */
+#define SCTPCTL_IDLE_COMPACT_TIME_DESC	"Quiet time in ms after which idle associations are compacted (0 = disabled)"
+#define SCTPCTL_IDLE_COMPACT_TIME_MIN	0
+#define SCTPCTL_IDLE_COMPACT_TIME_MAX	86400000
+#define SCTPCTL_IDLE_COMPACT_TIME_DEFAULT	0
+
+/* perf_stats_enable: Collect per association latency histograms */
+#define SCTPCTL_PERF_STATS_ENABLE_DESC	"Collect per association latency histograms"
+#define SCTPCTL_PERF_STATS_ENABLE_MIN	0
+#define SCTPCTL_PERF_STATS_ENABLE_MAX	1
+#define SCTPCTL_PERF_STATS_ENABLE_DEFAULT	0
+
 /* hb_max_burst: Confirmation Heartbeat max burst? */
 #define SCTPCTL_HB_MAX_BURST_DESC	"Confirmation Heartbeat max burst"
 #define SCTPCTL_HB_MAX_BURST_MIN	1
@@ -466,13 +480,13 @@ struct sctp_sysctl {
 /* JRS - default congestion control module sysctl */
 #define SCTPCTL_DEFAULT_CC_MODULE_DESC		"Default congestion control module"
 #define SCTPCTL_DEFAULT_CC_MODULE_MIN		0
-#define SCTPCTL_DEFAULT_CC_MODULE_MAX		2
+#define SCTPCTL_DEFAULT_CC_MODULE_MAX		5
 #define SCTPCTL_DEFAULT_CC_MODULE_DEFAULT	0
 
 /* RS - default stream scheduling module sysctl */
 #define SCTPCTL_DEFAULT_SS_MODULE_DESC		"Default stream scheduling module"
 #define SCTPCTL_DEFAULT_SS_MODULE_MIN		0
-#define SCTPCTL_DEFAULT_SS_MODULE_MAX		5
+#define SCTPCTL_DEFAULT_SS_MODULE_MAX		6
 #define SCTPCTL_DEFAULT_SS_MODULE_DEFAULT	0
 
 /* RRS - default fragment interleave */
@@ -433,13 +433,13 @@ sctp_recover_sent_list(struct sctp_tcb *stcb)
 			SCTP_PRINTF("Found chk:%p tsn:%x <= last_acked_seq:%x\n",
 			            (void *)chk, chk->rec.data.tsn, asoc->last_acked_seq);
 			if (chk->sent != SCTP_DATAGRAM_NR_ACKED) {
-				if (asoc->strmout[chk->rec.data.sid].chunks_on_queues > 0) {
-					asoc->strmout[chk->rec.data.sid].chunks_on_queues--;
+				if (SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues > 0) {
+					SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues--;
 				}
 			}
-			if ((asoc->strmout[chk->rec.data.sid].chunks_on_queues == 0) &&
-			    (asoc->strmout[chk->rec.data.sid].state == SCTP_STREAM_RESET_PENDING) &&
-			    TAILQ_EMPTY(&asoc->strmout[chk->rec.data.sid].outqueue)) {
+			if ((SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues == 0) &&
+			    (SCTP_STRMOUT(asoc, chk->rec.data.sid)->state == SCTP_STREAM_RESET_PENDING) &&
+			    TAILQ_EMPTY(&SCTP_STRMOUT(asoc, chk->rec.data.sid)->outqueue)) {
 				asoc->trigger_reset = 1;
 			}
 			TAILQ_REMOVE(&asoc->sent_queue, chk, sctp_next);
@@ -1363,8 +1363,12 @@ sctp_audit_stream_queues_for_size(struct sctp_inpcb *inp,
 	}
 	/* Check to see if some data queued, if so report it */
 	for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
-		if (!TAILQ_EMPTY(&stcb->asoc.strmout[i].outqueue)) {
-			TAILQ_FOREACH(sp, &stcb->asoc.strmout[i].outqueue, next) {
+		if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+			i |= SCTP_STREAM_PAGE_MASK;
+			continue;
+		}
+		if (!TAILQ_EMPTY(&SCTP_STRMOUT(&stcb->asoc, i)->outqueue)) {
+			TAILQ_FOREACH(sp, &SCTP_STRMOUT(&stcb->asoc, i)->outqueue, next) {
 				if (sp->msg_is_complete)
 					being_filled++;
 				chks_in_queue++;
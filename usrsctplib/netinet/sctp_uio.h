@@ -259,6 +259,29 @@ struct sctp_sendv_spa {
 #define SCTP_SEND_PRINFO_VALID   0x00000002
 #define SCTP_SEND_AUTHINFO_VALID 0x00000004
 
+#if defined(__Userspace__)
+/* One message of usrsctp_sendmmsg(). */
+struct sctp_sndmmsg {
+	const void *sm_data;
+	size_t sm_len;
+	void *sm_info;
+	socklen_t sm_infolen;
+	unsigned int sm_infotype;
+	size_t sm_sent;
+};
+
+/* One message of usrsctp_recvmmsg(). */
+struct sctp_rcvmmsg {
+	void *rm_data;
+	size_t rm_len;
+	struct sockaddr *rm_from;
+	socklen_t rm_fromlen;
+	struct sctp_rcvinfo rm_rcvinfo;
+	size_t rm_received;
+	int rm_flags;
+};
+#endif
+
 struct sctp_snd_all_completes {
 	uint16_t sall_stream;
 	uint16_t sall_flags;
@@ -770,6 +793,52 @@ struct sctp_prstatus {
 	uint64_t sprstat_abandoned_sent;
 };
 
+/*
+ * Log-linear histogram: values below 8 have a bucket each, every larger
+ * power of two range is split into 8 buckets. So a bucket covers at most
+ * 12.5% of its lower bound.
+ */
+#define SCTP_PERF_HIST_SUB_BITS	3
+#define SCTP_PERF_HIST_BUCKETS	((32 - SCTP_PERF_HIST_SUB_BITS + 1) << SCTP_PERF_HIST_SUB_BITS)
+/* Smallest value counted in bucket i. */
+#define SCTP_PERF_HIST_BUCKET_LOW(i) \
+	(((i) < (1 << SCTP_PERF_HIST_SUB_BITS)) ? (uint32_t)(i) : \
+	 (uint32_t)(((1 << SCTP_PERF_HIST_SUB_BITS) | ((i) & ((1 << SCTP_PERF_HIST_SUB_BITS) - 1))) << \
+	            (((i) >> SCTP_PERF_HIST_SUB_BITS) - 1)))
+
+struct sctp_perf_histogram {
+	uint64_t sph_count;
+	uint64_t sph_sum;
+	uint32_t sph_min;
+	uint32_t sph_max;
+	uint32_t sph_buckets[SCTP_PERF_HIST_BUCKETS];
+};
+
+/* Times are in microseconds. */
+struct sctp_assoc_perf_stats {
+	sctp_assoc_t sps_assoc_id;
+	struct sctp_perf_histogram sps_rtt;	/* RTT samples */
+	struct sctp_perf_histogram sps_send_to_ack;	/* send call to cum-ack of the message */
+	struct sctp_perf_histogram sps_recv_dwell;	/* read queue to application */
+	struct sctp_perf_histogram sps_sack_bytes;	/* bytes newly acked per SACK */
+};
+
+/*
+ * Memory held by an association in bytes. For SCTP_ALL_ASSOC the numbers
+ * are summed up over all associations of the endpoint and include the
+ * endpoint itself.
+ */
+struct sctp_assoc_mem_stats {
+	sctp_assoc_t sams_assoc_id;
+	uint32_t sams_assocs;		/* number of associations summed up */
+	uint64_t sams_total;
+	uint64_t sams_control;		/* endpoint, association and path control blocks */
+	uint64_t sams_streams;		/* stream tables */
+	uint64_t sams_mapping;		/* TSN mapping arrays */
+	uint64_t sams_queues;		/* chunk, message and read queue entries */
+	uint64_t sams_mbufs;		/* mbufs and clusters on these queues */
+};
+
 struct sctp_cwnd_args {
 	struct sctp_nets *net;	/* network to */ /* FIXME: LP64 issue */
 	uint32_t cwnd_new_value;/* cwnd in k */
@@ -1114,7 +1183,8 @@ struct sctpstat {
 	uint32_t  sctps_send_cwnd_avoid;  /* Send cwnd full  avoidance, already max burst inflight to net */
 	uint32_t  sctps_fwdtsn_map_over;  /* number of map array over-runs via fwd-tsn's */
 	uint32_t  sctps_queue_upd_ecne;  /* Number of times we queued or updated an ECN chunk on send queue */
-	uint32_t  sctps_reserved[31];     /* Future ABI compat - remove int's from here when adding new */
+	uint32_t  sctps_idle_compactions; /* Number of times an idle association was compacted */
+	uint32_t  sctps_reserved[30];     /* Future ABI compat - remove int's from here when adding new */
 };
 
 #define SCTP_STAT_INCR(_x) SCTP_STAT_INCR_BY(_x,1)
@@ -1145,6 +1215,15 @@ union sctp_sockstore {
 	struct sockaddr_conn sconn;
 	struct sockaddr sa;
 };
+
+/* One message of a batched receive callback. */
+struct sctp_recvbatch_msg {
+	union sctp_sockstore rb_addr;
+	void *rb_data;
+	size_t rb_datalen;
+	struct sctp_rcvinfo rb_rcvinfo;
+	int rb_flags;
+};
 #else
 union sctp_sockstore {
 	struct sockaddr_in sin;
@@ -1377,6 +1456,24 @@ sctp_sorecvmsg(struct socket *so,
     int *msg_flags,
     struct sctp_sndrcvinfo *sinfo,
     int filling_sinfo);
+
+#if defined(__Userspace__)
+/*
+ * Same as sctp_sorecvmsg() copying into uio and filling in sinfo, but
+ * window updates are only sent before blocking. The caller calls
+ * sctp_window_update() when it is done reading.
+ */
+int
+sctp_sorecvmsg_no_window_update(struct socket *so,
+    struct uio *uio,
+    struct sockaddr *from,
+    int fromlen,
+    int *msg_flags,
+    struct sctp_sndrcvinfo *sinfo);
+
+void
+sctp_window_update(struct socket *so, sctp_assoc_t assoc_id);
+#endif
 #endif
 
 /*
@@ -75,7 +75,7 @@ void
 #if defined(__Userspace__)
 sctp_init(uint16_t port,
           int (*conn_output)(void *addr, void *buffer, size_t length, uint8_t tos, uint8_t set_df),
-          void (*debug_printf)(const char *format, ...))
+          void (*debug_printf)(const char *format, ...), int virtual_clock)
 #elif defined(__APPLE__) && (!defined(APPLE_LEOPARD) && !defined(APPLE_SNOWLEOPARD) &&!defined(APPLE_LION) && !defined(APPLE_MOUNTAINLION))
 sctp_init(struct protosw *pp SCTP_UNUSED, struct domain *dp SCTP_UNUSED)
 #else
@@ -145,9 +145,16 @@ sctp_init(void)
 	SCTP_BASE_VAR(userspace_udpsctp6) = -1;
 #endif
 	SCTP_BASE_VAR(timer_thread_should_exit) = 0;
+	SCTP_BASE_VAR(virtual_clock) = (uint8_t)virtual_clock;
 	SCTP_BASE_VAR(conn_output) = conn_output;
 	SCTP_BASE_VAR(debug_printf) = debug_printf;
 	SCTP_BASE_VAR(crc32c_offloaded) = 0;
+#endif
+#if defined(__Userspace__)
+	if (virtual_clock) {
+		/* The clock has to be set before anything takes a timestamp. */
+		sctp_os_virtual_clock_init();
+	}
 #endif
 	sctp_pcb_init();
 #if defined(__Userspace__)
@@ -232,12 +239,14 @@ sctp_finish(void)
 	}
 #endif
 	SCTP_BASE_VAR(timer_thread_should_exit) = 1;
+	if (!SCTP_BASE_VAR(virtual_clock)) {
 #if defined(__Userspace_os_Windows)
-	WaitForSingleObject(SCTP_BASE_VAR(timer_thread), INFINITE);
-	CloseHandle(SCTP_BASE_VAR(timer_thread));
+		WaitForSingleObject(SCTP_BASE_VAR(timer_thread), INFINITE);
+		CloseHandle(SCTP_BASE_VAR(timer_thread));
 #else
-	pthread_join(SCTP_BASE_VAR(timer_thread), NULL);
+		pthread_join(SCTP_BASE_VAR(timer_thread), NULL);
 #endif
+	}
 #endif
 	sctp_pcb_finish();
 #if defined(__Windows__)
@@ -2406,7 +2415,8 @@ sctp_getopt(struct socket *so, int optname, void *optval, size_t *optsize,
 		SCTP_FIND_STCB(inp, stcb, av->assoc_id);
 		if (stcb) {
 			if ((av->stream_id >= stcb->asoc.streamoutcnt) ||
-			    (stcb->asoc.ss_functions.sctp_ss_get_value(stcb, &stcb->asoc, &stcb->asoc.strmout[av->stream_id],
+			    (sctp_get_strmout(stcb, av->stream_id) == NULL) ||
+			    (stcb->asoc.ss_functions.sctp_ss_get_value(stcb, &stcb->asoc, SCTP_STRMOUT(&stcb->asoc, av->stream_id),
 			                                               &av->stream_value) < 0)) {
 				SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
 				error = EINVAL;
@@ -4337,19 +4347,29 @@ sctp_getopt(struct socket *so, int optname, void *optval, size_t *optsize,
 		    (policy != SCTP_PR_SCTP_NONE) &&
 		    ((policy <= SCTP_PR_SCTP_MAX) ||
 		     (policy == SCTP_PR_SCTP_ALL))) {
-			if (policy == SCTP_PR_SCTP_ALL) {
-				sprstat->sprstat_abandoned_unsent = stcb->asoc.strmout[sid].abandoned_unsent[0];
-				sprstat->sprstat_abandoned_sent = stcb->asoc.strmout[sid].abandoned_sent[0];
+			if (SCTP_STRMOUT_PAGE(&stcb->asoc, sid) == NULL) {
+				/* Nothing was sent on the stream yet. */
+				sprstat->sprstat_abandoned_unsent = 0;
+				sprstat->sprstat_abandoned_sent = 0;
+			} else if (policy == SCTP_PR_SCTP_ALL) {
+				sprstat->sprstat_abandoned_unsent = SCTP_STRMOUT(&stcb->asoc, sid)->abandoned_unsent[0];
+				sprstat->sprstat_abandoned_sent = SCTP_STRMOUT(&stcb->asoc, sid)->abandoned_sent[0];
 			} else {
-				sprstat->sprstat_abandoned_unsent = stcb->asoc.strmout[sid].abandoned_unsent[policy];
-				sprstat->sprstat_abandoned_sent = stcb->asoc.strmout[sid].abandoned_sent[policy];
+				sprstat->sprstat_abandoned_unsent = SCTP_STRMOUT(&stcb->asoc, sid)->abandoned_unsent[policy];
+				sprstat->sprstat_abandoned_sent = SCTP_STRMOUT(&stcb->asoc, sid)->abandoned_sent[policy];
 			}
 #else
 		if ((stcb != NULL) &&
 		    (sid < stcb->asoc.streamoutcnt) &&
 		    (policy == SCTP_PR_SCTP_ALL)) {
-			sprstat->sprstat_abandoned_unsent = stcb->asoc.strmout[sid].abandoned_unsent[0];
-			sprstat->sprstat_abandoned_sent = stcb->asoc.strmout[sid].abandoned_sent[0];
+			if (SCTP_STRMOUT_PAGE(&stcb->asoc, sid) == NULL) {
+				/* Nothing was sent on the stream yet. */
+				sprstat->sprstat_abandoned_unsent = 0;
+				sprstat->sprstat_abandoned_sent = 0;
+			} else {
+				sprstat->sprstat_abandoned_unsent = SCTP_STRMOUT(&stcb->asoc, sid)->abandoned_unsent[0];
+				sprstat->sprstat_abandoned_sent = SCTP_STRMOUT(&stcb->asoc, sid)->abandoned_sent[0];
+			}
 #endif
 		} else {
 			SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
@@ -4395,6 +4415,62 @@ sctp_getopt(struct socket *so, int optname, void *optval, size_t *optsize,
 		}
 		break;
 	}
+	case SCTP_GET_ASSOC_PERF_STATS:
+	{
+		struct sctp_assoc_perf_stats *sps;
+
+		SCTP_CHECK_AND_CAST(sps, optval, struct sctp_assoc_perf_stats, *optsize);
+		SCTP_FIND_STCB(inp, stcb, sps->sps_assoc_id);
+
+		if (stcb) {
+			if (stcb->asoc.perf_stats != NULL) {
+				memcpy(sps, stcb->asoc.perf_stats, sizeof(struct sctp_assoc_perf_stats));
+			} else {
+				memset(sps, 0, sizeof(struct sctp_assoc_perf_stats));
+			}
+			sps->sps_assoc_id = sctp_get_associd(stcb);
+			SCTP_TCB_UNLOCK(stcb);
+			*optsize = sizeof(struct sctp_assoc_perf_stats);
+		} else {
+			SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
+			error = EINVAL;
+		}
+		break;
+	}
+	case SCTP_GET_ASSOC_MEM_STATS:
+	{
+		struct sctp_assoc_mem_stats *sams;
+		sctp_assoc_t assoc_id;
+
+		SCTP_CHECK_AND_CAST(sams, optval, struct sctp_assoc_mem_stats, *optsize);
+		SCTP_FIND_STCB(inp, stcb, sams->sams_assoc_id);
+
+		assoc_id = sams->sams_assoc_id;
+		memset(sams, 0, sizeof(struct sctp_assoc_mem_stats));
+		if (stcb) {
+			sctp_assoc_mem_usage(stcb, sams);
+			sams->sams_assoc_id = sctp_get_associd(stcb);
+			SCTP_TCB_UNLOCK(stcb);
+			*optsize = sizeof(struct sctp_assoc_mem_stats);
+		} else if (assoc_id == SCTP_ALL_ASSOC) {
+			sams->sams_assoc_id = SCTP_ALL_ASSOC;
+			sams->sams_control = sizeof(struct sctp_inpcb);
+			SCTP_INP_RLOCK(inp);
+			LIST_FOREACH(stcb, &inp->sctp_asoc_list, sctp_tcblist) {
+				SCTP_TCB_LOCK(stcb);
+				sctp_assoc_mem_usage(stcb, sams);
+				SCTP_TCB_UNLOCK(stcb);
+			}
+			SCTP_INP_RUNLOCK(inp);
+			sams->sams_total = sams->sams_control + sams->sams_streams +
+			                   sams->sams_mapping + sams->sams_queues + sams->sams_mbufs;
+			*optsize = sizeof(struct sctp_assoc_mem_stats);
+		} else {
+			SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
+			error = EINVAL;
+		}
+		break;
+	}
 	case SCTP_MAX_CWND:
 	{
 		struct sctp_assoc_value *av;
@@ -4617,6 +4693,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 						error = EINVAL;
 					}
 				}
+				sctp_build_initack_params(inp);
 				SCTP_INP_WUNLOCK(inp);
 			} else {
 				SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
@@ -4673,7 +4750,9 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 		if ((av->assoc_value != SCTP_CC_RFC2581) &&
 		    (av->assoc_value != SCTP_CC_HSTCP) &&
 		    (av->assoc_value != SCTP_CC_HTCP) &&
-		    (av->assoc_value != SCTP_CC_RTCC)) {
+		    (av->assoc_value != SCTP_CC_RTCC) &&
+		    (av->assoc_value != SCTP_CC_BBR) &&
+		    (av->assoc_value != SCTP_CC_CUBIC)) {
 			SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
 			error = EINVAL;
 			break;
@@ -4750,6 +4829,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 	case SCTP_PLUGGABLE_SS:
 	{
 		struct sctp_assoc_value *av;
+		uint32_t i;
 
 		SCTP_CHECK_AND_CAST(av, optval, struct sctp_assoc_value, optsize);
 		if ((av->assoc_value != SCTP_SS_DEFAULT) &&
@@ -4757,7 +4837,8 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 		    (av->assoc_value != SCTP_SS_ROUND_ROBIN_PACKET) &&
 		    (av->assoc_value != SCTP_SS_PRIORITY) &&
 		    (av->assoc_value != SCTP_SS_FAIR_BANDWITH) &&
-		    (av->assoc_value != SCTP_SS_FIRST_COME)) {
+		    (av->assoc_value != SCTP_SS_FIRST_COME) &&
+		    (av->assoc_value != SCTP_SS_WFQ)) {
 			SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
 			error = EINVAL;
 			break;
@@ -4767,6 +4848,15 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 			stcb->asoc.ss_functions.sctp_ss_clear(stcb, &stcb->asoc, 1, 1);
 			stcb->asoc.ss_functions = sctp_ss_functions[av->assoc_value];
 			stcb->asoc.stream_scheduling_module = av->assoc_value;
+			/* The per stream parameters are shared by all schedulers. */
+			for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
+				if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+					/* Initialized by the new scheduler when allocated. */
+					i |= SCTP_STREAM_PAGE_MASK;
+					continue;
+				}
+				stcb->asoc.ss_functions.sctp_ss_init_stream(stcb, SCTP_STRMOUT(&stcb->asoc, i), NULL);
+			}
 			stcb->asoc.ss_functions.sctp_ss_init(stcb, &stcb->asoc, 1);
 			SCTP_TCB_UNLOCK(stcb);
 		} else {
@@ -4786,6 +4876,13 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 					stcb->asoc.ss_functions.sctp_ss_clear(stcb, &stcb->asoc, 1, 1);
 					stcb->asoc.ss_functions = sctp_ss_functions[av->assoc_value];
 					stcb->asoc.stream_scheduling_module = av->assoc_value;
+					for (i = 0; i < stcb->asoc.streamoutcnt; i++) {
+						if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+							i |= SCTP_STREAM_PAGE_MASK;
+							continue;
+						}
+						stcb->asoc.ss_functions.sctp_ss_init_stream(stcb, SCTP_STRMOUT(&stcb->asoc, i), NULL);
+					}
 					stcb->asoc.ss_functions.sctp_ss_init(stcb, &stcb->asoc, 1);
 					SCTP_TCB_UNLOCK(stcb);
 				}
@@ -4802,7 +4899,8 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 		SCTP_FIND_STCB(inp, stcb, av->assoc_id);
 		if (stcb) {
 			if ((av->stream_id >= stcb->asoc.streamoutcnt) ||
-			    (stcb->asoc.ss_functions.sctp_ss_set_value(stcb, &stcb->asoc, &stcb->asoc.strmout[av->stream_id],
+			    (sctp_get_strmout(stcb, av->stream_id) == NULL) ||
+			    (stcb->asoc.ss_functions.sctp_ss_set_value(stcb, &stcb->asoc, SCTP_STRMOUT(&stcb->asoc, av->stream_id),
 			                                               av->stream_value) < 0)) {
 				SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
 				error = EINVAL;
@@ -4813,10 +4911,11 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 				SCTP_INP_RLOCK(inp);
 				LIST_FOREACH(stcb, &inp->sctp_asoc_list, sctp_tcblist) {
 					SCTP_TCB_LOCK(stcb);
-					if (av->stream_id < stcb->asoc.streamoutcnt) {
+					if ((av->stream_id < stcb->asoc.streamoutcnt) &&
+					    (sctp_get_strmout(stcb, av->stream_id) != NULL)) {
 						stcb->asoc.ss_functions.sctp_ss_set_value(stcb,
 						                                          &stcb->asoc,
-						                                          &stcb->asoc.strmout[av->stream_id],
+						                                          SCTP_STRMOUT(&stcb->asoc, av->stream_id),
 						                                          av->stream_value);
 					}
 					SCTP_TCB_UNLOCK(stcb);
@@ -5068,6 +5167,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 			SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
 			error = EINVAL;
 		}
+		sctp_build_initack_params(inp);
 		SCTP_INP_WUNLOCK(inp);
 		break;
 	}
@@ -5244,6 +5344,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 		if (inp->sctp_ep.local_hmacs)
 			sctp_free_hmaclist(inp->sctp_ep.local_hmacs);
 		inp->sctp_ep.local_hmacs = hmaclist;
+		sctp_build_initack_params(inp);
 		SCTP_INP_WUNLOCK(inp);
 	sctp_set_hmac_done:
 		break;
@@ -5460,17 +5561,28 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 		}
 		for (i = 0; i < strrst->srs_number_streams; i++) {
 			if ((send_in) &&
-			    (strrst->srs_stream_list[i] > stcb->asoc.streamincnt)) {
+			    (strrst->srs_stream_list[i] >= stcb->asoc.streamincnt)) {
 				SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
 				error = EINVAL;
 				break;
 			}
 			if ((send_out) &&
-			    (strrst->srs_stream_list[i] > stcb->asoc.streamoutcnt)) {
+			    (strrst->srs_stream_list[i] >= stcb->asoc.streamoutcnt)) {
 				SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
 				error = EINVAL;
 				break;
 			}
+			if ((send_out) &&
+			    (sctp_get_strmout(stcb, strrst->srs_stream_list[i]) == NULL)) {
+				SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, ENOMEM);
+				error = ENOMEM;
+				break;
+			}
+		}
+		if ((error == 0) && send_out && (strrst->srs_number_streams == 0) &&
+		    (sctp_alloc_all_strmout(stcb) != 0)) {
+			SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, ENOMEM);
+			error = ENOMEM;
 		}
 		if (error) {
 			SCTP_TCB_UNLOCK(stcb);
@@ -5482,16 +5594,16 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 			if (strrst->srs_number_streams) {
 				for (i = 0, cnt = 0; i < strrst->srs_number_streams; i++) {
 					strm = strrst->srs_stream_list[i];
-					if (stcb->asoc.strmout[strm].state == SCTP_STREAM_OPEN) {
-						stcb->asoc.strmout[strm].state = SCTP_STREAM_RESET_PENDING;
+					if (SCTP_STRMOUT(&stcb->asoc, strm)->state == SCTP_STREAM_OPEN) {
+						SCTP_STRMOUT(&stcb->asoc, strm)->state = SCTP_STREAM_RESET_PENDING;
 						cnt++;
 					}
 				}
 			} else {
 				/* Its all */
 				for (i = 0, cnt = 0; i < stcb->asoc.streamoutcnt; i++) {
-					if (stcb->asoc.strmout[i].state == SCTP_STREAM_OPEN) {
-						stcb->asoc.strmout[i].state = SCTP_STREAM_RESET_PENDING;
+					if (SCTP_STRMOUT(&stcb->asoc, i)->state == SCTP_STREAM_OPEN) {
+						SCTP_STRMOUT(&stcb->asoc, i)->state = SCTP_STREAM_RESET_PENDING;
 						cnt++;
 					}
 				}
@@ -5624,7 +5736,11 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 		}
 		/* Do any streams have data queued? */
 		for ( i = 0; i< stcb->asoc.streamoutcnt; i++) {
-			if (!TAILQ_EMPTY(&stcb->asoc.strmout[i].outqueue)) {
+			if (SCTP_STRMOUT_PAGE(&stcb->asoc, i) == NULL) {
+				i |= SCTP_STREAM_PAGE_MASK;
+				continue;
+			}
+			if (!TAILQ_EMPTY(&SCTP_STRMOUT(&stcb->asoc, i)->outqueue)) {
 				goto busy_out;
 			}
 		}
@@ -5936,6 +6052,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 		SCTP_INP_WLOCK(inp);
 		inp->sctp_ep.adaptation_layer_indicator = adap_bits->ssb_adaptation_ind;
 		inp->sctp_ep.adaptation_layer_indicator_provided = 1;
+		sctp_build_initack_params(inp);
 		SCTP_INP_WUNLOCK(inp);
 		break;
 	}
@@ -7413,6 +7530,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 				} else {
 					inp->ecn_supported = 1;
 				}
+				sctp_build_initack_params(inp);
 				SCTP_INP_WUNLOCK(inp);
 			} else {
 				SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
@@ -7442,6 +7560,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 				} else {
 					inp->prsctp_supported = 1;
 				}
+				sctp_build_initack_params(inp);
 				SCTP_INP_WUNLOCK(inp);
 			} else {
 				SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
@@ -7477,6 +7596,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 					} else {
 						inp->auth_supported = 1;
 					}
+					sctp_build_initack_params(inp);
 					SCTP_INP_WUNLOCK(inp);
 				}
 			} else {
@@ -7521,6 +7641,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 						sctp_auth_add_chunk(SCTP_ASCONF_ACK,
 						                    inp->sctp_ep.local_auth_chunks);
 					}
+					sctp_build_initack_params(inp);
 					SCTP_INP_WUNLOCK(inp);
 				}
 			} else {
@@ -7551,6 +7672,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 				} else {
 					inp->reconfig_supported = 1;
 				}
+				sctp_build_initack_params(inp);
 				SCTP_INP_WUNLOCK(inp);
 			} else {
 				SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
@@ -7580,6 +7702,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 				} else {
 					inp->nrsack_supported = 1;
 				}
+				sctp_build_initack_params(inp);
 				SCTP_INP_WUNLOCK(inp);
 			} else {
 				SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
@@ -7609,6 +7732,7 @@ sctp_setopt(struct socket *so, int optname, void *optval, size_t optsize,
 				} else {
 					inp->pktdrop_supported = 1;
 				}
+				sctp_build_initack_params(inp);
 				SCTP_INP_WUNLOCK(inp);
 			} else {
 				SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTP_USRREQ, EINVAL);
@@ -8980,6 +9104,27 @@ register_recv_cb(struct socket *so,
 	return (1);
 }
 
+int
+register_recv_batch_cb(struct socket *so,
+                       int (*receive_batch_cb)(struct socket *sock, struct sctp_recvbatch_msg *msgs,
+                       int count, void *ulp_info))
+{
+	struct sctp_inpcb *inp;
+
+	inp = (struct sctp_inpcb *) so->so_pcb;
+	if (inp == NULL) {
+		return (0);
+	}
+	SCTP_INP_WLOCK(inp);
+	if (inp->recv_callback == NULL) {
+		SCTP_INP_WUNLOCK(inp);
+		return (0);
+	}
+	inp->recv_batch_callback = receive_batch_cb;
+	SCTP_INP_WUNLOCK(inp);
+	return (1);
+}
+
 int
 register_send_cb(struct socket *so, uint32_t sb_threshold, int (*send_cb)(struct socket *sock, uint32_t sb_free))
 {
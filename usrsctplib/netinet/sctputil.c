@@ -89,7 +89,7 @@ extern const struct sctp_ss_functions sctp_ss_functions[];
 void
 sctp_sblog(struct sockbuf *sb, struct sctp_tcb *stcb, int from, int incr)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.sb.stcb = stcb;
@@ -112,7 +112,7 @@ sctp_sblog(struct sockbuf *sb, struct sctp_tcb *stcb, int from, int incr)
 void
 sctp_log_closing(struct sctp_inpcb *inp, struct sctp_tcb *stcb, int16_t loc)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.close.inp = (void *)inp;
@@ -138,7 +138,16 @@ sctp_log_closing(struct sctp_inpcb *inp, struct sctp_tcb *stcb, int16_t loc)
 void
 rto_logging(struct sctp_nets *net, int from)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__Userspace__)
+	/* The union starts with a pointer, which does not fit on LP64. */
+	SCTP_CTR6(KTR_SCTP, "SCTP:%d[%d]:%x-%x-%x-%x",
+	     SCTP_LOG_EVENT_RTT,
+	     from,
+	     (uint32_t)net->rtt,
+	     (uint32_t)net->RTO,
+	     (uint32_t)net->lastsa,
+	     (uint32_t)net->lastsv);
+#elif defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
 	struct sctp_cwnd_log sctp_clog;
 
 	memset(&sctp_clog, 0, sizeof(sctp_clog));
@@ -157,7 +166,7 @@ rto_logging(struct sctp_nets *net, int from)
 void
 sctp_log_strm_del_alt(struct sctp_tcb *stcb, uint32_t tsn, uint16_t sseq, uint16_t stream, int from)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.strlog.stcb = stcb;
@@ -179,7 +188,7 @@ sctp_log_strm_del_alt(struct sctp_tcb *stcb, uint32_t tsn, uint16_t sseq, uint16
 void
 sctp_log_nagle_event(struct sctp_tcb *stcb, int action)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.nagle.stcb = (void *)stcb;
@@ -200,7 +209,7 @@ sctp_log_nagle_event(struct sctp_tcb *stcb, int action)
 void
 sctp_log_sack(uint32_t old_cumack, uint32_t cumack, uint32_t tsn, uint16_t gaps, uint16_t dups, int from)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.sack.cumack = cumack;
@@ -221,7 +230,7 @@ sctp_log_sack(uint32_t old_cumack, uint32_t cumack, uint32_t tsn, uint16_t gaps,
 void
 sctp_log_map(uint32_t map, uint32_t cum, uint32_t high, int from)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	memset(&sctp_clog, 0, sizeof(sctp_clog));
@@ -241,7 +250,7 @@ sctp_log_map(uint32_t map, uint32_t cum, uint32_t high, int from)
 void
 sctp_log_fr(uint32_t biggest_tsn, uint32_t biggest_new_tsn, uint32_t tsn, int from)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	memset(&sctp_clog, 0, sizeof(sctp_clog));
@@ -262,7 +271,7 @@ sctp_log_fr(uint32_t biggest_tsn, uint32_t biggest_new_tsn, uint32_t tsn, int fr
 void
 sctp_log_mb(struct mbuf *m, int from)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.mb.mp = m;
@@ -304,7 +313,7 @@ sctp_log_mbc(struct mbuf *m, int from)
 void
 sctp_log_strm_del(struct sctp_queued_to_read *control, struct sctp_queued_to_read *poschk, int from)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	if (control == NULL) {
@@ -335,7 +344,16 @@ sctp_log_strm_del(struct sctp_queued_to_read *control, struct sctp_queued_to_rea
 void
 sctp_log_cwnd(struct sctp_tcb *stcb, struct sctp_nets *net, int augment, uint8_t from)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__Userspace__)
+	/* The union starts with a pointer, which does not fit on LP64. */
+	SCTP_CTR6(KTR_SCTP, "SCTP:%d[%d]:%x-%x-%x-%x",
+	     SCTP_LOG_EVENT_CWND,
+	     from,
+	     net ? net->cwnd : 0,
+	     net ? net->flight_size : 0,
+	     (uint32_t)augment,
+	     stcb->asoc.peers_rwnd);
+#elif defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.cwnd.net = net;
@@ -373,7 +391,7 @@ sctp_log_cwnd(struct sctp_tcb *stcb, struct sctp_nets *net, int augment, uint8_t
 void
 sctp_log_lock(struct sctp_inpcb *inp, struct sctp_tcb *stcb, uint8_t from)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	memset(&sctp_clog, 0, sizeof(sctp_clog));
@@ -426,7 +444,16 @@ sctp_log_lock(struct sctp_inpcb *inp, struct sctp_tcb *stcb, uint8_t from)
 void
 sctp_log_maxburst(struct sctp_tcb *stcb, struct sctp_nets *net, int error, int burst, uint8_t from)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__Userspace__)
+	/* The union starts with a pointer, which does not fit on LP64. */
+	SCTP_CTR6(KTR_SCTP, "SCTP:%d[%d]:%x-%x-%x-%x",
+	     SCTP_LOG_EVENT_MAXBURST,
+	     from,
+	     (uint32_t)error,
+	     (uint32_t)burst,
+	     net->cwnd,
+	     net->flight_size);
+#elif defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
 	struct sctp_cwnd_log sctp_clog;
 
 	memset(&sctp_clog, 0, sizeof(sctp_clog));
@@ -455,7 +482,7 @@ sctp_log_maxburst(struct sctp_tcb *stcb, struct sctp_nets *net, int error, int b
 void
 sctp_log_rwnd(uint8_t from, uint32_t peers_rwnd, uint32_t snd_size, uint32_t overhead)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.rwnd.rwnd = peers_rwnd;
@@ -475,7 +502,7 @@ sctp_log_rwnd(uint8_t from, uint32_t peers_rwnd, uint32_t snd_size, uint32_t ove
 void
 sctp_log_rwnd_set(uint8_t from, uint32_t peers_rwnd, uint32_t flight_size, uint32_t overhead, uint32_t a_rwndval)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.rwnd.rwnd = peers_rwnd;
@@ -496,7 +523,7 @@ sctp_log_rwnd_set(uint8_t from, uint32_t peers_rwnd, uint32_t flight_size, uint3
 static void
 sctp_log_mbcnt(uint8_t from, uint32_t total_oq, uint32_t book, uint32_t total_mbcnt_q, uint32_t mbcnt)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.mbcnt.total_queue_size = total_oq;
@@ -517,7 +544,7 @@ sctp_log_mbcnt(uint8_t from, uint32_t total_oq, uint32_t book, uint32_t total_mb
 void
 sctp_misc_ints(uint8_t from, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	SCTP_CTR6(KTR_SCTP, "SCTP:%d[%d]:%x-%x-%x-%x",
 	     SCTP_LOG_MISC_EVENT,
 	     from,
@@ -528,7 +555,7 @@ sctp_misc_ints(uint8_t from, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
 void
 sctp_wakeup_log(struct sctp_tcb *stcb, uint32_t wake_cnt, int from)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.wake.stcb = (void *)stcb;
@@ -576,7 +603,7 @@ sctp_wakeup_log(struct sctp_tcb *stcb, uint32_t wake_cnt, int from)
 void
 sctp_log_block(uint8_t from, struct sctp_association *asoc, size_t sendlen)
 {
-#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF)
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
 	struct sctp_cwnd_log sctp_clog;
 
 	sctp_clog.x.blk.onsb = asoc->total_output_queue_size;
@@ -596,6 +623,48 @@ sctp_log_block(uint8_t from, struct sctp_association *asoc, size_t sendlen)
 #endif
 }
 
+void
+sctp_log_timer(struct sctp_tcb *stcb, struct sctp_nets *net, int type)
+{
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
+	SCTP_CTR6(KTR_SCTP, "SCTP:%d[%d]:%x-%x-%x-%x",
+	     SCTP_LOG_EVENT_TIMER,
+	     type,
+	     stcb ? sctp_get_associd(stcb) : 0,
+	     stcb ? stcb->asoc.total_flight : 0,
+	     net ? net->RTO : 0,
+	     net ? net->error_count : 0);
+#endif
+}
+
+void
+sctp_log_rtx(struct sctp_tcb *stcb, struct sctp_tmit_chunk *chk, uint8_t from)
+{
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
+	SCTP_CTR6(KTR_SCTP, "SCTP:%d[%d]:%x-%x-%x-%x",
+	     SCTP_LOG_EVENT_RTX,
+	     from,
+	     sctp_get_associd(stcb),
+	     chk->rec.data.tsn,
+	     chk->send_size,
+	     chk->snd_count);
+#endif
+}
+
+void
+sctp_log_packet(struct sctp_tcb *stcb, uint32_t vtag, uint32_t len, uint8_t chunk_type, uint8_t from)
+{
+#if defined(__FreeBSD__) || defined(SCTP_LOCAL_TRACE_BUF) || defined(__Userspace__)
+	SCTP_CTR6(KTR_SCTP, "SCTP:%d[%d]:%x-%x-%x-%x",
+	     SCTP_LOG_EVENT_PACKET,
+	     from,
+	     stcb ? sctp_get_associd(stcb) : 0,
+	     ntohl(vtag),
+	     len,
+	     chunk_type);
+#endif
+}
+
 int
 sctp_fill_stat_log(void *optval SCTP_UNUSED, size_t *optsize SCTP_UNUSED)
 {
@@ -603,6 +672,229 @@ sctp_fill_stat_log(void *optval SCTP_UNUSED, size_t *optsize SCTP_UNUSED)
 	return (0);
 }
 
+static void
+sctp_perf_hist_add(struct sctp_perf_histogram *hist, uint32_t value)
+{
+	uint32_t i, shift;
+
+	if (value < (1 << SCTP_PERF_HIST_SUB_BITS)) {
+		i = value;
+	} else {
+		shift = 0;
+		while ((value >> shift) >= (2 << SCTP_PERF_HIST_SUB_BITS)) {
+			shift++;
+		}
+		i = ((shift + 1) << SCTP_PERF_HIST_SUB_BITS) |
+		    ((value >> shift) & ((1 << SCTP_PERF_HIST_SUB_BITS) - 1));
+	}
+	if ((hist->sph_count == 0) || (value < hist->sph_min)) {
+		hist->sph_min = value;
+	}
+	if (value > hist->sph_max) {
+		hist->sph_max = value;
+	}
+	hist->sph_count++;
+	hist->sph_sum += value;
+	hist->sph_buckets[i]++;
+}
+
+/*
+ * Adds a sample to one of the per association histograms if the sysctl
+ * sctp_perf_stats_enable is set. The histograms are allocated on the first
+ * sample. Must be called with the TCB lock held.
+ */
+void
+sctp_perf_record(struct sctp_tcb *stcb, int which, uint32_t value)
+{
+	struct sctp_assoc_perf_stats *stats;
+
+	if (SCTP_BASE_SYSCTL(sctp_perf_stats_enable) == 0) {
+		return;
+	}
+	stats = stcb->asoc.perf_stats;
+	if (stats == NULL) {
+		SCTP_MALLOC(stats, struct sctp_assoc_perf_stats *,
+		            sizeof(struct sctp_assoc_perf_stats), SCTP_M_PERF);
+		if (stats == NULL) {
+			return;
+		}
+		memset(stats, 0, sizeof(struct sctp_assoc_perf_stats));
+		stcb->asoc.perf_stats = stats;
+	}
+	switch (which) {
+	case SCTP_PERF_RTT:
+		sctp_perf_hist_add(&stats->sps_rtt, value);
+		break;
+	case SCTP_PERF_SEND_TO_ACK:
+		sctp_perf_hist_add(&stats->sps_send_to_ack, value);
+		break;
+	case SCTP_PERF_RECV_DWELL:
+		sctp_perf_hist_add(&stats->sps_recv_dwell, value);
+		break;
+	case SCTP_PERF_SACK_BYTES:
+		sctp_perf_hist_add(&stats->sps_sack_bytes, value);
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Records the time in microseconds since then. A cleared time means the
+ * start was not taken because the histograms were disabled.
+ */
+void
+sctp_perf_record_since(struct sctp_tcb *stcb, int which, struct timeval *then)
+{
+	struct timeval now;
+	uint64_t usec;
+
+	if ((SCTP_BASE_SYSCTL(sctp_perf_stats_enable) == 0) ||
+	    ((then->tv_sec == 0) && (then->tv_usec == 0))) {
+		return;
+	}
+	(void)SCTP_GETTIME_TIMEVAL(&now);
+	timevalsub(&now, then);
+	if (now.tv_sec < 0) {
+		/* The clock was set back. */
+		return;
+	}
+	usec = (uint64_t)1000000 * (uint64_t)now.tv_sec + (uint64_t)now.tv_usec;
+	sctp_perf_record(stcb, which, usec > UINT32_MAX ? UINT32_MAX : (uint32_t)usec);
+}
+
+void
+sctp_perf_free(struct sctp_tcb *stcb)
+{
+	if (stcb->asoc.perf_stats != NULL) {
+		SCTP_FREE(stcb->asoc.perf_stats, SCTP_M_PERF);
+		stcb->asoc.perf_stats = NULL;
+	}
+}
+
+/* Memory used by an mbuf chain, external storage not owned by the stack is not counted. */
+static uint64_t
+sctp_mbuf_mem(struct mbuf *m)
+{
+	uint64_t bytes;
+
+	for (bytes = 0; m != NULL; m = SCTP_BUF_NEXT(m)) {
+		bytes += MSIZE;
+		if (SCTP_BUF_IS_EXTENDED(m) && EXT_IS_CLUSTER(m->m_ext.ext_type)) {
+			bytes += SCTP_BUF_EXTEND_SIZE(m);
+		}
+	}
+	return (bytes);
+}
+
+static void
+sctp_chunks_mem(struct sctpchunk_listhead *head, struct sctp_assoc_mem_stats *sams)
+{
+	struct sctp_tmit_chunk *chk;
+
+	TAILQ_FOREACH(chk, head, sctp_next) {
+		sams->sams_queues += sizeof(struct sctp_tmit_chunk);
+		sams->sams_mbufs += sctp_mbuf_mem(chk->data);
+	}
+}
+
+static void
+sctp_readq_mem(struct sctp_queued_to_read *control, struct sctp_assoc_mem_stats *sams)
+{
+	sams->sams_queues += sizeof(struct sctp_queued_to_read);
+	sams->sams_mbufs += sctp_mbuf_mem(control->data);
+	sctp_chunks_mem(&control->reasm, sams);
+}
+
+/*
+ * Adds the memory held by the association to sams. The numbers are
+ * computed by walking the queues, so they are exact but not cheap. Must
+ * be called with the TCB lock held.
+ */
+void
+sctp_assoc_mem_usage(struct sctp_tcb *stcb, struct sctp_assoc_mem_stats *sams)
+{
+	struct sctp_association *asoc;
+	struct sctp_stream_out *strmout;
+	struct sctp_stream_in *strmin;
+	struct sctp_stream_queue_pending *sp;
+	struct sctp_queued_to_read *control;
+	uint32_t i, j, pages;
+
+	SCTP_TCB_LOCK_ASSERT(stcb);
+	asoc = &stcb->asoc;
+	sams->sams_assocs++;
+	sams->sams_control += sizeof(struct sctp_tcb);
+	sams->sams_control += asoc->numnets * sizeof(struct sctp_nets);
+	if (asoc->perf_stats != NULL) {
+		sams->sams_control += sizeof(struct sctp_assoc_perf_stats);
+	}
+	sams->sams_mapping += 2 * (uint64_t)asoc->mapping_array_size;
+
+	SCTP_TCB_SEND_LOCK(stcb);
+	if (asoc->strmout != NULL) {
+		pages = SCTP_STREAM_PAGES(asoc->strm_realoutsize);
+		if (pages == 0) {
+			pages = 1;
+		}
+		sams->sams_streams += pages * sizeof(struct sctp_stream_out *);
+		for (i = 0; i < pages; i++) {
+			if (asoc->strmout[i] == NULL) {
+				continue;
+			}
+			sams->sams_streams += SCTP_STREAM_PAGE_SIZE * sizeof(struct sctp_stream_out);
+			for (j = 0; j < SCTP_STREAM_PAGE_SIZE; j++) {
+				strmout = &asoc->strmout[i][j];
+				TAILQ_FOREACH(sp, &strmout->outqueue, next) {
+					sams->sams_queues += sizeof(struct sctp_stream_queue_pending);
+					sams->sams_mbufs += sctp_mbuf_mem(sp->data);
+				}
+			}
+		}
+	}
+	SCTP_TCB_SEND_UNLOCK(stcb);
+	if (asoc->strmin != NULL) {
+		pages = SCTP_STREAM_PAGES(asoc->streamincnt);
+		if (pages == 0) {
+			pages = 1;
+		}
+		sams->sams_streams += pages * sizeof(struct sctp_stream_in *);
+		for (i = 0; i < pages; i++) {
+			if (asoc->strmin[i] == NULL) {
+				continue;
+			}
+			sams->sams_streams += SCTP_STREAM_PAGE_SIZE * sizeof(struct sctp_stream_in);
+			for (j = 0; j < SCTP_STREAM_PAGE_SIZE; j++) {
+				strmin = &asoc->strmin[i][j];
+				TAILQ_FOREACH(control, &strmin->inqueue, next_instrm) {
+					sctp_readq_mem(control, sams);
+				}
+				TAILQ_FOREACH(control, &strmin->uno_inqueue, next_instrm) {
+					sctp_readq_mem(control, sams);
+				}
+			}
+		}
+	}
+	sctp_chunks_mem(&asoc->send_queue, sams);
+	sctp_chunks_mem(&asoc->sent_queue, sams);
+	sctp_chunks_mem(&asoc->control_send_queue, sams);
+	sctp_chunks_mem(&asoc->asconf_send_queue, sams);
+	sctp_chunks_mem(&asoc->free_chunks, sams);
+	TAILQ_FOREACH(control, &asoc->pending_reply_queue, next) {
+		sctp_readq_mem(control, sams);
+	}
+	/* Messages delivered to the socket but not read yet. */
+	SCTP_INP_READ_LOCK(stcb->sctp_ep);
+	TAILQ_FOREACH(control, &stcb->sctp_ep->read_queue, next) {
+		if (control->stcb == stcb) {
+			sctp_readq_mem(control, sams);
+		}
+	}
+	SCTP_INP_READ_UNLOCK(stcb->sctp_ep);
+	sams->sams_total = sams->sams_control + sams->sams_streams +
+	                   sams->sams_mapping + sams->sams_queues + sams->sams_mbufs;
+}
+
 #ifdef SCTP_AUDITING_ENABLED
 uint8_t sctp_audit_data[SCTP_AUDIT_SIZE][2];
 static int sctp_audit_indx = 0;
@@ -821,6 +1113,7 @@ sctp_stop_timers_for_shutdown(struct sctp_tcb *stcb)
 	TAILQ_FOREACH(net, &asoc->nets, sctp_next) {
 		(void)SCTP_OS_TIMER_STOP(&net->pmtu_timer.timer);
 		(void)SCTP_OS_TIMER_STOP(&net->hb_timer.timer);
+		(void)SCTP_OS_TIMER_STOP(&net->pacing_timer.timer);
 	}
 }
 
@@ -914,9 +1207,12 @@ sctp_select_initial_TSN(struct sctp_pcb *inp)
 	 * the initial stream sequence number, using RFC1750 as a good
 	 * guideline
 	 */
-	uint32_t x, *xp;
+	uint32_t x;
+#if !defined(__Userspace__)
+	uint32_t *xp;
 	uint8_t *p;
 	int store_at, new_store;
+#endif
 
 	if (inp->initial_sequence_debug != 0) {
 		uint32_t ret;
@@ -925,6 +1221,13 @@ sctp_select_initial_TSN(struct sctp_pcb *inp)
 		inp->initial_sequence_debug++;
 		return (ret);
 	}
+#if defined(__Userspace__)
+	/*
+	 * read_random() is a per thread CSPRNG, which is cheaper than
+	 * the shared random store and doesn't bounce its cache line.
+	 */
+	SCTP_READ_RANDOM(&x, sizeof(x));
+#else
  retry:
 	store_at = inp->store_at;
 	new_store = store_at + sizeof(uint32_t);
@@ -941,6 +1244,7 @@ sctp_select_initial_TSN(struct sctp_pcb *inp)
 	p = &inp->random_store[store_at];
 	xp = (uint32_t *)p;
 	x = *xp;
+#endif
 	return (x);
 }
 
@@ -1009,6 +1313,226 @@ sctp_map_assoc_state(int kernel_state)
 	return (user_state);
 }
 
+void
+sctp_init_stream_out(struct sctp_tcb *stcb, struct sctp_stream_out *strm,
+                     uint16_t sid, uint8_t state)
+{
+#if defined(SCTP_DETAILED_STR_STATS)
+	int j;
+#endif
+
+	TAILQ_INIT(&strm->outqueue);
+	strm->chunks_on_queues = 0;
+#if defined(SCTP_DETAILED_STR_STATS)
+	for (j = 0; j < SCTP_PR_SCTP_MAX + 1; j++) {
+		strm->abandoned_sent[j] = 0;
+		strm->abandoned_unsent[j] = 0;
+	}
+#else
+	strm->abandoned_sent[0] = 0;
+	strm->abandoned_unsent[0] = 0;
+#endif
+	strm->next_mid_ordered = 0;
+	strm->next_mid_unordered = 0;
+	strm->sid = sid;
+	strm->last_msg_incomplete = 0;
+	strm->state = state;
+	stcb->asoc.ss_functions.sctp_ss_init_stream(stcb, strm, NULL);
+}
+
+void
+sctp_init_stream_in(struct sctp_stream_in *strm, uint16_t sid)
+{
+	strm->sid = sid;
+	/* inbound side must be set to 0xffffffff */
+	strm->last_mid_delivered = 0xffffffff;
+	TAILQ_INIT(&strm->inqueue);
+	TAILQ_INIT(&strm->uno_inqueue);
+	strm->pd_api_started = 0;
+	strm->delivery_started = 0;
+}
+
+/*
+ * Make the directory of the outgoing stream table large enough for cnt
+ * streams. The pages already allocated are kept, so pointers to streams
+ * stay valid.
+ */
+int
+sctp_grow_strmout(struct sctp_association *asoc, uint16_t cnt)
+{
+	struct sctp_stream_out **dir;
+	uint32_t old_pages, pages;
+
+	if ((asoc->strmout != NULL) && (cnt <= asoc->strm_realoutsize)) {
+		return (0);
+	}
+	old_pages = (asoc->strmout == NULL) ? 0 : SCTP_STREAM_PAGES(asoc->strm_realoutsize);
+	pages = SCTP_STREAM_PAGES(cnt);
+	if (pages == 0) {
+		pages = 1;
+	}
+	if ((pages > old_pages) || (asoc->strmout == NULL)) {
+		SCTP_MALLOC(dir, struct sctp_stream_out **,
+		            pages * sizeof(struct sctp_stream_out *),
+		            SCTP_M_STRMO);
+		if (dir == NULL) {
+			return (ENOMEM);
+		}
+		memset(dir, 0, pages * sizeof(struct sctp_stream_out *));
+		if (asoc->strmout != NULL) {
+			memcpy(dir, asoc->strmout, old_pages * sizeof(struct sctp_stream_out *));
+			SCTP_FREE(asoc->strmout, SCTP_M_STRMO);
+		}
+		asoc->strmout = dir;
+	}
+	asoc->strm_realoutsize = cnt;
+	return (0);
+}
+
+/*
+ * Same for the incoming stream table, which is sized by streamincnt.
+ */
+int
+sctp_grow_strmin(struct sctp_association *asoc, uint16_t cnt)
+{
+	struct sctp_stream_in **dir;
+	uint32_t old_pages, pages;
+
+	if ((asoc->strmin != NULL) && (cnt <= asoc->streamincnt)) {
+		return (0);
+	}
+	old_pages = (asoc->strmin == NULL) ? 0 : SCTP_STREAM_PAGES(asoc->streamincnt);
+	pages = SCTP_STREAM_PAGES(cnt);
+	if (pages == 0) {
+		pages = 1;
+	}
+	if ((pages > old_pages) || (asoc->strmin == NULL)) {
+		SCTP_MALLOC(dir, struct sctp_stream_in **,
+		            pages * sizeof(struct sctp_stream_in *),
+		            SCTP_M_STRMI);
+		if (dir == NULL) {
+			return (ENOMEM);
+		}
+		memset(dir, 0, pages * sizeof(struct sctp_stream_in *));
+		if (asoc->strmin != NULL) {
+			memcpy(dir, asoc->strmin, old_pages * sizeof(struct sctp_stream_in *));
+			SCTP_FREE(asoc->strmin, SCTP_M_STRMI);
+		}
+		asoc->strmin = dir;
+	}
+	asoc->streamincnt = cnt;
+	return (0);
+}
+
+void
+sctp_free_strmout(struct sctp_association *asoc)
+{
+	uint32_t i;
+
+	if (asoc->strmout == NULL) {
+		return;
+	}
+	for (i = 0; i < SCTP_STREAM_PAGES(asoc->strm_realoutsize); i++) {
+		if (asoc->strmout[i] != NULL) {
+			SCTP_FREE(asoc->strmout[i], SCTP_M_STRMO);
+		}
+	}
+	SCTP_FREE(asoc->strmout, SCTP_M_STRMO);
+	asoc->strmout = NULL;
+}
+
+void
+sctp_free_strmin(struct sctp_association *asoc)
+{
+	uint32_t i;
+
+	if (asoc->strmin == NULL) {
+		return;
+	}
+	for (i = 0; i < SCTP_STREAM_PAGES(asoc->streamincnt); i++) {
+		if (asoc->strmin[i] != NULL) {
+			SCTP_FREE(asoc->strmin[i], SCTP_M_STRMI);
+		}
+	}
+	SCTP_FREE(asoc->strmin, SCTP_M_STRMI);
+	asoc->strmin = NULL;
+}
+
+/*
+ * Return the outgoing stream sid, allocating the page holding it if needed.
+ * Streams in a new page start with the default state of the association.
+ * The caller must hold the TCB lock and check sid against the stream count.
+ * Returns NULL if no memory is available.
+ */
+struct sctp_stream_out *
+sctp_get_strmout(struct sctp_tcb *stcb, uint16_t sid)
+{
+	struct sctp_association *asoc;
+	struct sctp_stream_out *page;
+	uint16_t base;
+	int i;
+
+	asoc = &stcb->asoc;
+	page = SCTP_STRMOUT_PAGE(asoc, sid);
+	if (page == NULL) {
+		SCTP_MALLOC(page, struct sctp_stream_out *,
+		            SCTP_STREAM_PAGE_SIZE * sizeof(struct sctp_stream_out),
+		            SCTP_M_STRMO);
+		if (page == NULL) {
+			return (NULL);
+		}
+		base = sid & ~SCTP_STREAM_PAGE_MASK;
+		for (i = 0; i < SCTP_STREAM_PAGE_SIZE; i++) {
+			sctp_init_stream_out(stcb, &page[i], base + i, asoc->strmout_state);
+		}
+		SCTP_STRMOUT_PAGE(asoc, sid) = page;
+	}
+	return (&page[sid & SCTP_STREAM_PAGE_MASK]);
+}
+
+/*
+ * Allocate all outgoing streams. This is needed before changing the state
+ * of all streams, for example when all of them are reset.
+ */
+int
+sctp_alloc_all_strmout(struct sctp_tcb *stcb)
+{
+	uint32_t i;
+
+	for (i = 0; i < stcb->asoc.streamoutcnt; i += SCTP_STREAM_PAGE_SIZE) {
+		if (sctp_get_strmout(stcb, (uint16_t)i) == NULL) {
+			return (ENOMEM);
+		}
+	}
+	return (0);
+}
+
+struct sctp_stream_in *
+sctp_get_strmin(struct sctp_tcb *stcb, uint16_t sid)
+{
+	struct sctp_association *asoc;
+	struct sctp_stream_in *page;
+	uint16_t base;
+	int i;
+
+	asoc = &stcb->asoc;
+	page = SCTP_STRMIN_PAGE(asoc, sid);
+	if (page == NULL) {
+		SCTP_MALLOC(page, struct sctp_stream_in *,
+		            SCTP_STREAM_PAGE_SIZE * sizeof(struct sctp_stream_in),
+		            SCTP_M_STRMI);
+		if (page == NULL) {
+			return (NULL);
+		}
+		base = sid & ~SCTP_STREAM_PAGE_MASK;
+		for (i = 0; i < SCTP_STREAM_PAGE_SIZE; i++) {
+			sctp_init_stream_in(&page[i], base + i);
+		}
+		SCTP_STRMIN_PAGE(asoc, sid) = page;
+	}
+	return (&page[sid & SCTP_STREAM_PAGE_MASK]);
+}
+
 int
 sctp_init_asoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb,
                uint32_t override_tag, uint32_t vrf_id, uint16_t o_strms)
@@ -1026,9 +1550,6 @@ sctp_init_asoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb,
 	 * caller in the sctp_aloc_assoc() function.
 	 */
 	int i;
-#if defined(SCTP_DETAILED_STR_STATS)
-	int j;
-#endif
 
 	asoc = &stcb->asoc;
 	/* init all variables to a known value. */
@@ -1180,46 +1701,21 @@ sctp_init_asoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb,
 	stcb->asoc.ss_functions = sctp_ss_functions[inp->sctp_ep.sctp_default_ss_module];
 
 	/*
-	 * Now the stream parameters, here we allocate space for all streams
-	 * that we request by default.
+	 * Now the stream parameters, here we allocate the directory for all
+	 * streams that we request by default. The streams themselves are
+	 * allocated when they are used. NOTE when we get the INIT-ACK back
+	 * (for INIT sender) we MUST reduce the count (streamoutcnt) but
+	 * first check if we sent to any of the upper streams that were
+	 * dropped (if some were). Those that were dropped must be notified
+	 * to the upper layer as failed to send.
 	 */
-	asoc->strm_realoutsize = asoc->streamoutcnt = asoc->pre_open_streams =
-	    o_strms;
-	SCTP_MALLOC(asoc->strmout, struct sctp_stream_out *,
-		    asoc->streamoutcnt * sizeof(struct sctp_stream_out),
-		    SCTP_M_STRMO);
-	if (asoc->strmout == NULL) {
+	asoc->strmout_state = SCTP_STREAM_OPENING;
+	if (sctp_grow_strmout(asoc, o_strms) != 0) {
 		/* big trouble no memory */
 		SCTP_LTRACE_ERR_RET(NULL, stcb, NULL, SCTP_FROM_SCTPUTIL, ENOMEM);
 		return (ENOMEM);
 	}
-	for (i = 0; i < asoc->streamoutcnt; i++) {
-		/*
-		 * inbound side must be set to 0xffff, also NOTE when we get
-		 * the INIT-ACK back (for INIT sender) we MUST reduce the
-		 * count (streamoutcnt) but first check if we sent to any of
-		 * the upper streams that were dropped (if some were). Those
-		 * that were dropped must be notified to the upper layer as
-		 * failed to send.
-		 */
-		asoc->strmout[i].next_mid_ordered = 0;
-		asoc->strmout[i].next_mid_unordered = 0;
-		TAILQ_INIT(&asoc->strmout[i].outqueue);
-		asoc->strmout[i].chunks_on_queues = 0;
-#if defined(SCTP_DETAILED_STR_STATS)
-		for (j = 0; j < SCTP_PR_SCTP_MAX + 1; j++) {
-			asoc->strmout[i].abandoned_sent[j] = 0;
-			asoc->strmout[i].abandoned_unsent[j] = 0;
-		}
-#else
-		asoc->strmout[i].abandoned_sent[0] = 0;
-		asoc->strmout[i].abandoned_unsent[0] = 0;
-#endif
-		asoc->strmout[i].sid = i;
-		asoc->strmout[i].last_msg_incomplete = 0;
-		asoc->strmout[i].state = SCTP_STREAM_OPENING;
-		asoc->ss_functions.sctp_ss_init_stream(stcb, &asoc->strmout[i], NULL);
-	}
+	asoc->streamoutcnt = asoc->pre_open_streams = o_strms;
 	asoc->ss_functions.sctp_ss_init(stcb, asoc, 0);
 
 	/* Now the mapping array */
@@ -1227,7 +1723,7 @@ sctp_init_asoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb,
 	SCTP_MALLOC(asoc->mapping_array, uint8_t *, asoc->mapping_array_size,
 		    SCTP_M_MAP);
 	if (asoc->mapping_array == NULL) {
-		SCTP_FREE(asoc->strmout, SCTP_M_STRMO);
+		sctp_free_strmout(asoc);
 		SCTP_LTRACE_ERR_RET(NULL, stcb, NULL, SCTP_FROM_SCTPUTIL, ENOMEM);
 		return (ENOMEM);
 	}
@@ -1235,7 +1731,7 @@ sctp_init_asoc(struct sctp_inpcb *inp, struct sctp_tcb *stcb,
 	SCTP_MALLOC(asoc->nr_mapping_array, uint8_t *, asoc->mapping_array_size,
 	    SCTP_M_MAP);
 	if (asoc->nr_mapping_array == NULL) {
-		SCTP_FREE(asoc->strmout, SCTP_M_STRMO);
+		sctp_free_strmout(asoc);
 		SCTP_FREE(asoc->mapping_array, SCTP_M_MAP);
 		SCTP_LTRACE_ERR_RET(NULL, stcb, NULL, SCTP_FROM_SCTPUTIL, ENOMEM);
 		return (ENOMEM);
@@ -1592,6 +2088,16 @@ sctp_handle_addr_wq(void)
 	}
 }
 
+/* Returns the current precise time in microseconds. */
+uint64_t
+sctp_get_time_usec(void)
+{
+	struct timeval now;
+
+	(void)SCTP_GETPTIME_TIMEVAL(&now);
+	return ((uint64_t)1000000 * (uint64_t)now.tv_sec + (uint64_t)now.tv_usec);
+}
+
 void
 sctp_timeout_handler(void *t)
 {
@@ -1657,6 +2163,7 @@ sctp_timeout_handler(void *t)
 		    ((tmr->type != SCTP_TIMER_TYPE_INPKILL) &&
 		     (tmr->type != SCTP_TIMER_TYPE_INIT) &&
 		     (tmr->type != SCTP_TIMER_TYPE_SEND) &&
+		     (tmr->type != SCTP_TIMER_TYPE_PACING) &&
 		     (tmr->type != SCTP_TIMER_TYPE_RECV) &&
 		     (tmr->type != SCTP_TIMER_TYPE_HEARTBEAT) &&
 		     (tmr->type != SCTP_TIMER_TYPE_SHUTDOWN) &&
@@ -1740,6 +2247,9 @@ sctp_timeout_handler(void *t)
 		goto get_out;
 	}
 	SCTP_OS_TIMER_DEACTIVATE(&tmr->timer);
+	if (SCTP_BASE_SYSCTL(sctp_logging_level) & SCTP_TIMER_LOGGING_ENABLE) {
+		sctp_log_timer(stcb, net, type);
+	}
 
 	/* call the handler for the appropriate timer type */
 	switch (type) {
@@ -1882,6 +2392,9 @@ sctp_timeout_handler(void *t)
 				inp->sctp_ep.secret_key[secret][i] =
 				    sctp_select_initial_TSN(&inp->sctp_ep);
 			}
+			(void)sctp_hmac_state_init(&inp->sctp_ep.secret_hmac_state[secret],
+			    SCTP_HMAC, (uint8_t *)inp->sctp_ep.secret_key[secret],
+			    SCTP_SECRET_SIZE);
 			sctp_timer_start(SCTP_TIMER_TYPE_NEWCOOKIE, inp, stcb, net);
 		}
 		did_output = 0;
@@ -1952,6 +2465,12 @@ sctp_timeout_handler(void *t)
 		sctp_delete_prim_timer(inp, stcb, net);
 		SCTP_STAT_INCR(sctps_timodelprim);
 		break;
+	case SCTP_TIMER_TYPE_PACING:
+		if ((stcb == NULL) || (inp == NULL)) {
+			break;
+		}
+		sctp_chunk_output(inp, stcb, SCTP_OUTPUT_FROM_PACING_TMR, SCTP_SO_NOT_LOCKED);
+		break;
 
 	case SCTP_TIMER_TYPE_AUTOCLOSE:
 		if ((stcb == NULL) || (inp == NULL)) {
@@ -2058,12 +2577,14 @@ sctp_timer_start(int t_type, struct sctp_inpcb *inp, struct sctp_tcb *stcb,
     struct sctp_nets *net)
 {
 	uint32_t to_ticks;
+	uint32_t to_usecs;
 	struct sctp_timer *tmr;
 
 	if ((t_type != SCTP_TIMER_TYPE_ADDR_WQ) && (inp == NULL))
 		return;
 
 	tmr = NULL;
+	to_usecs = 0;
 	if (stcb) {
 		SCTP_TCB_LOCK_ASSERT(stcb);
 	}
@@ -2300,6 +2821,29 @@ sctp_timer_start(int t_type, struct sctp_inpcb *inp, struct sctp_tcb *stcb,
 		to_ticks = stcb->asoc.sctp_autoclose_ticks;
 		tmr = &stcb->asoc.autoclose_timer;
 		break;
+	case SCTP_TIMER_TYPE_PACING:
+		/* Fires when the next packet may be sent to net. */
+		{
+			uint64_t now;
+
+			if ((stcb == NULL) || (net == NULL)) {
+				return;
+			}
+			now = sctp_get_time_usec();
+			if (net->pacing_next > now + 0xffffffff) {
+				to_usecs = 0xffffffff;
+			} else if (net->pacing_next > now) {
+				to_usecs = (uint32_t)(net->pacing_next - now);
+			} else {
+				to_usecs = 1;
+			}
+			to_ticks = MSEC_TO_TICKS((to_usecs + 999) / 1000);
+			if (to_ticks == 0) {
+				to_ticks = 1;
+			}
+			tmr = &net->pacing_timer;
+		}
+		break;
 	default:
 		SCTPDBG(SCTP_DEBUG_TIMER1, "%s: Unknown timer type %d\n",
 			__func__, t_type);
@@ -2333,6 +2877,12 @@ sctp_timer_start(int t_type, struct sctp_inpcb *inp, struct sctp_tcb *stcb,
 #endif
 #ifndef __Panda__
 	tmr->ticks = sctp_get_tick_count();
+#endif
+#if defined(__Userspace__)
+	if (t_type == SCTP_TIMER_TYPE_PACING) {
+		SCTP_OS_TIMER_START_US(&tmr->timer, to_usecs, sctp_timeout_handler, tmr);
+		return;
+	}
 #endif
 	(void)SCTP_OS_TIMER_START(&tmr->timer, to_ticks, sctp_timeout_handler, tmr);
 	return;
@@ -2460,6 +3010,12 @@ sctp_timer_stop(int t_type, struct sctp_inpcb *inp, struct sctp_tcb *stcb,
 		}
 		tmr = &stcb->asoc.autoclose_timer;
 		break;
+	case SCTP_TIMER_TYPE_PACING:
+		if ((stcb == NULL) || (net == NULL)) {
+			return;
+		}
+		tmr = &net->pacing_timer;
+		break;
 	default:
 		SCTPDBG(SCTP_DEBUG_TIMER1, "%s: Unknown timer type %d\n",
 			__func__, t_type);
@@ -2580,6 +3136,8 @@ sctp_calculate_rto(struct sctp_tcb *stcb,
 	/* store the current RTT in us */
 	net->rtt = (uint64_t)1000000 * (uint64_t)now.tv_sec +
 	           (uint64_t)now.tv_usec;
+	sctp_perf_record(stcb, SCTP_PERF_RTT,
+	                 net->rtt > UINT32_MAX ? UINT32_MAX : (uint32_t)net->rtt);
 	/* compute rtt in ms */
 	rtt = (int32_t)(net->rtt / 1000);
 	if ((asoc->cc_functions.sctp_rtt_calculated) && (rtt_from_sack == SCTP_RTT_FROM_DATA)) {
@@ -3754,6 +4312,16 @@ sctp_notify_remote_error(struct sctp_tcb *stcb, uint16_t error, struct sctp_erro
 	}
 }
 
+#if defined(__Userspace__)
+static int
+sctp_recv_batch_add(struct sctp_inpcb *, struct sctp_tcb *, struct socket *,
+                    union sctp_sockstore *, void *, size_t,
+                    struct sctp_rcvinfo *, int);
+static void
+sctp_recv_upcall(struct sctp_inpcb *, struct socket *,
+                 union sctp_sockstore *, void *, size_t,
+                 struct sctp_rcvinfo *, int);
+#endif
 
 void
 sctp_ulp_notify(uint32_t notification, struct sctp_tcb *stcb,
@@ -3817,11 +4385,13 @@ sctp_ulp_notify(uint32_t notification, struct sctp_tcb *stcb,
 
 				memset(&addr, 0, sizeof(union sctp_sockstore));
 				memset(&rcv, 0, sizeof(struct sctp_rcvinfo));
-				atomic_add_int(&stcb->asoc.refcnt, 1);
-				SCTP_TCB_UNLOCK(stcb);
-				stcb->sctp_ep->recv_callback(stcb->sctp_socket, addr, NULL, 0, rcv, 0, stcb->sctp_ep->ulp_info);
-				SCTP_TCB_LOCK(stcb);
-				atomic_subtract_int(&stcb->asoc.refcnt, 1);
+				if (sctp_recv_batch_add(stcb->sctp_ep, stcb, stcb->sctp_socket, &addr, NULL, 0, &rcv, 0) == 0) {
+					atomic_add_int(&stcb->asoc.refcnt, 1);
+					SCTP_TCB_UNLOCK(stcb);
+					sctp_recv_upcall(stcb->sctp_ep, stcb->sctp_socket, &addr, NULL, 0, &rcv, 0);
+					SCTP_TCB_LOCK(stcb);
+					atomic_subtract_int(&stcb->asoc.refcnt, 1);
+				}
 			}
 		}
 #endif
@@ -4003,8 +4573,8 @@ sctp_report_all_outbound(struct sctp_tcb *stcb, uint16_t error, int holds_lock,
 		TAILQ_REMOVE(&asoc->sent_queue, chk, sctp_next);
 		asoc->sent_queue_cnt--;
 		if (chk->sent != SCTP_DATAGRAM_NR_ACKED) {
-			if (asoc->strmout[chk->rec.data.sid].chunks_on_queues > 0) {
-				asoc->strmout[chk->rec.data.sid].chunks_on_queues--;
+			if (SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues > 0) {
+				SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues--;
 #ifdef INVARIANTS
 			} else {
 				panic("No chunks on the queues for sid %u.", chk->rec.data.sid);
@@ -4027,8 +4597,8 @@ sctp_report_all_outbound(struct sctp_tcb *stcb, uint16_t error, int holds_lock,
 	TAILQ_FOREACH_SAFE(chk, &asoc->send_queue, sctp_next, nchk) {
 		TAILQ_REMOVE(&asoc->send_queue, chk, sctp_next);
 		asoc->send_queue_cnt--;
-		if (asoc->strmout[chk->rec.data.sid].chunks_on_queues > 0) {
-			asoc->strmout[chk->rec.data.sid].chunks_on_queues--;
+		if (SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues > 0) {
+			SCTP_STRMOUT(asoc, chk->rec.data.sid)->chunks_on_queues--;
 #ifdef INVARIANTS
 		} else {
 			panic("No chunks on the queues for sid %u.", chk->rec.data.sid);
@@ -4047,8 +4617,13 @@ sctp_report_all_outbound(struct sctp_tcb *stcb, uint16_t error, int holds_lock,
 		/*sa_ignore FREED_MEMORY*/
 	}
 	for (i = 0; i < asoc->streamoutcnt; i++) {
+		if (SCTP_STRMOUT_PAGE(asoc, i) == NULL) {
+			/* Nothing was sent on these streams. */
+			i |= SCTP_STREAM_PAGE_MASK;
+			continue;
+		}
 		/* For each stream */
-		outs = &asoc->strmout[i];
+		outs = SCTP_STRMOUT(asoc, i);
 		/* clean up any sends there */
 		TAILQ_FOREACH_SAFE(sp, &outs->outqueue, next, nsp) {
 			atomic_subtract_int(&asoc->stream_queue_cnt, 1);
@@ -4771,6 +5346,239 @@ sctp_wakeup_the_read_socket(struct sctp_inpcb *inp,
 	}
 }
 #if defined(__Userspace__)
+/*
+ * Batched receive callbacks. While a packet is processed, messages for
+ * endpoints with a recv_batch_callback are collected in per thread chunks
+ * instead of being handed up one at a time, which would drop and retake
+ * the TCB and read locks for every message. When the processing is done,
+ * sctp_recv_batch_end() delivers the consecutive messages of each socket
+ * in one call of its recv_batch_callback. Endpoints with only a
+ * recv_callback get their messages right away, as before. The callbacks
+ * are taken when a message is collected, so changing them while messages
+ * are pending is safe. Chunks never move, so a callback may process input
+ * again, for example by sending on an AF_CONN socket whose peer is in the
+ * same process. The messages collected by that nested processing are
+ * appended and delivered by the outer loop, which keeps them in order.
+ * A message delivered right away, because the callback was removed or no
+ * chunk could be allocated, first flushes the pending messages if some
+ * are for the same socket. The first chunk is part of the per thread
+ * state, further ones are only allocated for packets carrying more
+ * messages.
+ */
+#if defined(_MSC_VER)
+#define SCTP_RECV_BATCH_THREAD_LOCAL __declspec(thread)
+#else
+#define SCTP_RECV_BATCH_THREAD_LOCAL __thread
+#endif
+
+#define SCTP_RECV_BATCH_CHUNK 32
+
+struct sctp_recv_batch_entry {
+	struct sctp_tcb *stcb;
+	struct socket *so;
+	int (*batch_cb)(struct socket *, struct sctp_recvbatch_msg *, int, void *);
+	int (*recv_cb)(struct socket *, union sctp_sockstore, void *, size_t,
+	               struct sctp_rcvinfo, int, void *);
+	void *ulp_info;
+};
+
+struct sctp_recv_batch_chunk {
+	struct sctp_recv_batch_chunk *next;
+	int count;
+	struct sctp_recv_batch_entry entries[SCTP_RECV_BATCH_CHUNK];
+	struct sctp_recvbatch_msg msgs[SCTP_RECV_BATCH_CHUNK];
+};
+
+struct sctp_recv_batch {
+	int depth;		/* nesting of input processing */
+	int delivering;
+	struct sctp_recv_batch_chunk *head;
+	struct sctp_recv_batch_chunk *tail;
+	struct sctp_recv_batch_chunk *next;	/* first undelivered message */
+	int next_index;
+	struct sctp_recv_batch_chunk first;
+};
+
+static SCTP_RECV_BATCH_THREAD_LOCAL struct sctp_recv_batch sctp_recv_batch;
+
+void
+sctp_recv_batch_begin(void)
+{
+	sctp_recv_batch.depth++;
+}
+
+/*
+ * Delivers the pending messages. The position of the first undelivered
+ * message is advanced before a callback is called, so a nested call
+ * continues after the messages being delivered. Messages may be appended
+ * while delivering, count and next are reread.
+ */
+static void
+sctp_recv_batch_deliver(void)
+{
+	struct sctp_recv_batch_chunk *chunk;
+	struct sctp_recv_batch_entry *entry;
+	struct sctp_recvbatch_msg *msg;
+	int i, j, k;
+
+	while ((chunk = sctp_recv_batch.next) != NULL) {
+		i = sctp_recv_batch.next_index;
+		if (i == chunk->count) {
+			if (chunk->next == NULL) {
+				break;
+			}
+			sctp_recv_batch.next = chunk->next;
+			sctp_recv_batch.next_index = 0;
+			continue;
+		}
+		entry = &chunk->entries[i];
+		if (entry->batch_cb != NULL) {
+			for (j = i + 1; j < chunk->count; j++) {
+				if ((chunk->entries[j].so != entry->so) ||
+				    (chunk->entries[j].batch_cb != entry->batch_cb)) {
+					break;
+				}
+			}
+			sctp_recv_batch.next_index = j;
+			entry->batch_cb(entry->so, &chunk->msgs[i], j - i, entry->ulp_info);
+		} else {
+			j = i + 1;
+			sctp_recv_batch.next_index = j;
+			msg = &chunk->msgs[i];
+			entry->recv_cb(entry->so, msg->rb_addr, msg->rb_data, msg->rb_datalen,
+			               msg->rb_rcvinfo, msg->rb_flags, entry->ulp_info);
+		}
+		for (k = i; k < j; k++) {
+			atomic_subtract_int(&chunk->entries[k].stcb->asoc.refcnt, 1);
+		}
+	}
+}
+
+void
+sctp_recv_batch_end(void)
+{
+	struct sctp_recv_batch_chunk *chunk;
+
+	if ((--sctp_recv_batch.depth > 0) || sctp_recv_batch.delivering) {
+		return;
+	}
+	sctp_recv_batch.delivering = 1;
+	sctp_recv_batch_deliver();
+	while ((chunk = sctp_recv_batch.head) != NULL) {
+		sctp_recv_batch.head = chunk->next;
+		if (chunk != &sctp_recv_batch.first) {
+			free(chunk);
+		}
+	}
+	sctp_recv_batch.tail = NULL;
+	sctp_recv_batch.next = NULL;
+	sctp_recv_batch.delivering = 0;
+}
+
+/*
+ * Delivers the pending messages if one of them is for so, so that a
+ * message for so handed up right away doesn't overtake them. Must be
+ * called without the TCB lock held.
+ */
+static void
+sctp_recv_batch_flush(struct socket *so)
+{
+	struct sctp_recv_batch_chunk *chunk;
+	int delivering, i;
+
+	i = sctp_recv_batch.next_index;
+	for (chunk = sctp_recv_batch.next; chunk != NULL; chunk = chunk->next) {
+		for (; i < chunk->count; i++) {
+			if (chunk->entries[i].so == so) {
+				delivering = sctp_recv_batch.delivering;
+				sctp_recv_batch.delivering = 1;
+				sctp_recv_batch_deliver();
+				sctp_recv_batch.delivering = delivering;
+				return;
+			}
+		}
+		i = 0;
+	}
+}
+
+/*
+ * Queues the message if the thread is processing input and the endpoint
+ * has a recv_batch_callback. Returns 0 if the caller has to deliver it,
+ * using sctp_recv_upcall().
+ */
+static int
+sctp_recv_batch_add(struct sctp_inpcb *inp, struct sctp_tcb *stcb, struct socket *so,
+                    union sctp_sockstore *addr, void *buffer, size_t length,
+                    struct sctp_rcvinfo *rcv, int flags)
+{
+	struct sctp_recv_batch_chunk *chunk;
+	struct sctp_recv_batch_entry *entry;
+	struct sctp_recvbatch_msg *msg;
+	int i;
+
+	if ((inp->recv_batch_callback == NULL) ||
+	    ((sctp_recv_batch.depth == 0) && (sctp_recv_batch.delivering == 0))) {
+		return (0);
+	}
+	chunk = sctp_recv_batch.tail;
+	if ((chunk == NULL) || (chunk->count == SCTP_RECV_BATCH_CHUNK)) {
+		if (chunk == NULL) {
+			chunk = &sctp_recv_batch.first;
+		} else if ((chunk = malloc(sizeof(struct sctp_recv_batch_chunk))) == NULL) {
+			return (0);
+		}
+		chunk->next = NULL;
+		chunk->count = 0;
+		if (sctp_recv_batch.tail == NULL) {
+			sctp_recv_batch.head = chunk;
+			sctp_recv_batch.next = chunk;
+			sctp_recv_batch.next_index = 0;
+		} else {
+			sctp_recv_batch.tail->next = chunk;
+		}
+		sctp_recv_batch.tail = chunk;
+	}
+	i = chunk->count;
+	entry = &chunk->entries[i];
+	entry->stcb = stcb;
+	entry->so = so;
+	entry->batch_cb = inp->recv_batch_callback;
+	entry->recv_cb = inp->recv_callback;
+	entry->ulp_info = inp->ulp_info;
+	msg = &chunk->msgs[i];
+	msg->rb_addr = *addr;
+	msg->rb_data = buffer;
+	msg->rb_datalen = length;
+	msg->rb_rcvinfo = *rcv;
+	msg->rb_flags = flags;
+	atomic_add_int(&stcb->asoc.refcnt, 1);
+	chunk->count++;
+	return (1);
+}
+
+/*
+ * Hands a single message to the receive callback of the endpoint. Must be
+ * called without the TCB lock held.
+ */
+static void
+sctp_recv_upcall(struct sctp_inpcb *inp, struct socket *so,
+                 union sctp_sockstore *addr, void *buffer, size_t length,
+                 struct sctp_rcvinfo *rcv, int flags)
+{
+	struct sctp_recvbatch_msg msg;
+
+	sctp_recv_batch_flush(so);
+	if (inp->recv_batch_callback != NULL) {
+		msg.rb_addr = *addr;
+		msg.rb_data = buffer;
+		msg.rb_datalen = length;
+		msg.rb_rcvinfo = *rcv;
+		msg.rb_flags = flags;
+		inp->recv_batch_callback(so, &msg, 1, inp->ulp_info);
+	} else {
+		inp->recv_callback(so, *addr, buffer, length, *rcv, flags, inp->ulp_info);
+	}
+}
 
 void
 sctp_invoke_recv_callback(struct sctp_inpcb *inp,
@@ -4852,18 +5660,27 @@ sctp_invoke_recv_callback(struct sctp_inpcb *inp,
 		control->tail_mbuf = NULL;
 		control->length = 0;
 		if (control->end_added) {
+			if ((control->spec_flags & M_NOTIFICATION) == 0) {
+				sctp_perf_record_since(stcb, SCTP_PERF_RECV_DWELL, &control->queued_time);
+			}
 			TAILQ_REMOVE(&stcb->sctp_ep->read_queue, control, next);
 			control->on_read_q = 0;
 			sctp_free_remote_addr(control->whoFrom);
 			control->whoFrom = NULL;
 			sctp_free_a_readq(stcb, control);
 		}
+		if (sctp_recv_batch_add(inp, stcb, so, &addr, buffer, length, &rcv, flags)) {
+			if (inp_read_lock_held == 0) {
+				SCTP_INP_READ_UNLOCK(inp);
+			}
+			return;
+		}
 		atomic_add_int(&stcb->asoc.refcnt, 1);
 		SCTP_TCB_UNLOCK(stcb);
 		if (inp_read_lock_held == 0) {
 			SCTP_INP_READ_UNLOCK(inp);
 		}
-		inp->recv_callback(so, addr, buffer, length, rcv, flags, inp->ulp_info);
+		sctp_recv_upcall(inp, so, &addr, buffer, length, &rcv, flags);
 		SCTP_TCB_LOCK(stcb);
 		atomic_subtract_int(&stcb->asoc.refcnt, 1);
 	}
@@ -4966,6 +5783,12 @@ sctp_add_to_readq(struct sctp_inpcb *inp,
 	if (end) {
 		control->end_added = 1;
 	}
+	if (SCTP_BASE_SYSCTL(sctp_perf_stats_enable)) {
+		(void)SCTP_GETTIME_TIMEVAL(&control->queued_time);
+	} else {
+		control->queued_time.tv_sec = 0;
+		control->queued_time.tv_usec = 0;
+	}
 	TAILQ_INSERT_TAIL(&inp->read_queue, control, next);
 	control->on_read_q = 1;
 	if (inp_read_lock_held == 0)
@@ -5097,16 +5920,16 @@ sctp_release_pr_sctp_chunk(struct sctp_tcb *stcb, struct sctp_tmit_chunk *tp1,
 	if (sent || !(tp1->rec.data.rcv_flags & SCTP_DATA_FIRST_FRAG)) {
 		stcb->asoc.abandoned_sent[0]++;
 		stcb->asoc.abandoned_sent[PR_SCTP_POLICY(tp1->flags)]++;
-		stcb->asoc.strmout[sid].abandoned_sent[0]++;
+		SCTP_STRMOUT(&stcb->asoc, sid)->abandoned_sent[0]++;
 #if defined(SCTP_DETAILED_STR_STATS)
-		stcb->asoc.strmout[stream].abandoned_sent[PR_SCTP_POLICY(tp1->flags)]++;
+		SCTP_STRMOUT(&stcb->asoc, stream)->abandoned_sent[PR_SCTP_POLICY(tp1->flags)]++;
 #endif
 	} else {
 		stcb->asoc.abandoned_unsent[0]++;
 		stcb->asoc.abandoned_unsent[PR_SCTP_POLICY(tp1->flags)]++;
-		stcb->asoc.strmout[sid].abandoned_unsent[0]++;
+		SCTP_STRMOUT(&stcb->asoc, sid)->abandoned_unsent[0]++;
 #if defined(SCTP_DETAILED_STR_STATS)
-		stcb->asoc.strmout[stream].abandoned_unsent[PR_SCTP_POLICY(tp1->flags)]++;
+		SCTP_STRMOUT(&stcb->asoc, stream)->abandoned_unsent[PR_SCTP_POLICY(tp1->flags)]++;
 #endif
 	}
 	do {
@@ -5199,7 +6022,7 @@ sctp_release_pr_sctp_chunk(struct sctp_tcb *stcb, struct sctp_tmit_chunk *tp1,
 		 * is stuff left on the stream out queue.. yuck.
 		 */
 		SCTP_TCB_SEND_LOCK(stcb);
-		strq = &stcb->asoc.strmout[sid];
+		strq = SCTP_STRMOUT(&stcb->asoc, sid);
 		sp = TAILQ_FIRST(&strq->outqueue);
 		if (sp != NULL) {
 			sp->discard_rest = 1;
@@ -5591,15 +6414,89 @@ sctp_user_rcvd(struct sctp_tcb *stcb, uint32_t *freed_so_far, int hold_rlock,
 	return;
 }
 
-int
-sctp_sorecvmsg(struct socket *so,
+#if defined(__Userspace__)
+/*
+ * Sends the window update sctp_sorecvmsg_no_window_update() held back, if
+ * the reads freed enough space. For one-to-one
+ * style sockets assoc_id is ignored.
+ */
+void
+sctp_window_update(struct socket *so, sctp_assoc_t assoc_id)
+{
+	struct sctp_inpcb *inp;
+	struct sctp_tcb *stcb;
+	uint32_t freed_so_far, rwnd_req;
+
+	inp = (struct sctp_inpcb *)so->so_pcb;
+	if (inp == NULL) {
+		return;
+	}
+	if ((inp->sctp_flags & SCTP_PCB_FLAGS_TCPTYPE) ||
+	    (inp->sctp_flags & SCTP_PCB_FLAGS_IN_TCPPOOL)) {
+		SCTP_INP_RLOCK(inp);
+		stcb = LIST_FIRST(&inp->sctp_asoc_list);
+		if (stcb) {
+			SCTP_TCB_LOCK(stcb);
+		}
+		SCTP_INP_RUNLOCK(inp);
+	} else {
+		stcb = sctp_findassociation_ep_asocid(inp, assoc_id, 1);
+	}
+	if (stcb == NULL) {
+		return;
+	}
+	atomic_add_int(&stcb->asoc.refcnt, 1);
+	SCTP_TCB_UNLOCK(stcb);
+	rwnd_req = (SCTP_SB_LIMIT_RCV(so) >> SCTP_RWND_HIWAT_SHIFT);
+	if (rwnd_req < SCTP_MIN_RWND)
+		rwnd_req = SCTP_MIN_RWND;
+	if (stcb->freed_by_sorcv_sincelast >= rwnd_req) {
+		freed_so_far = 0;
+		sctp_user_rcvd(stcb, &freed_so_far, 0, rwnd_req);
+	}
+	atomic_add_int(&stcb->asoc.refcnt, -1);
+}
+#endif
+
+/*
+ * Data on the read queue might belong to a stream which is not allocated
+ * anymore, for example after the association was restarted.
+ */
+static int
+sctp_delivery_started(struct sctp_tcb *stcb, struct sctp_queued_to_read *control)
+{
+	if ((control->sinfo_stream >= stcb->asoc.streamincnt) ||
+	    (SCTP_STRMIN_PAGE(&stcb->asoc, control->sinfo_stream) == NULL)) {
+		return (0);
+	}
+	return (SCTP_STRMIN(&stcb->asoc, control->sinfo_stream)->delivery_started);
+}
+
+static void
+sctp_set_delivery_started(struct sctp_tcb *stcb, struct sctp_queued_to_read *control,
+                          uint8_t started)
+{
+	if ((control->sinfo_stream >= stcb->asoc.streamincnt) ||
+	    (SCTP_STRMIN_PAGE(&stcb->asoc, control->sinfo_stream) == NULL)) {
+		return;
+	}
+	SCTP_STRMIN(&stcb->asoc, control->sinfo_stream)->delivery_started = started;
+}
+
+/*
+ * With no_window_update set, no window updates are sent, except before
+ * blocking; the caller calls sctp_window_update() when it is done.
+ */
+static int
+sctp_sorecvmsg_internal(struct socket *so,
     struct uio *uio,
     struct mbuf **mp,
     struct sockaddr *from,
     int fromlen,
     int *msg_flags,
     struct sctp_sndrcvinfo *sinfo,
-    int filling_sinfo)
+    int filling_sinfo,
+    int no_window_update)
 {
 	/*
 	 * MSG flags we will look at MSG_DONTWAIT - non-blocking IO.
@@ -5628,10 +6525,13 @@ sctp_sorecvmsg(struct socket *so,
 	int hold_rlock = 0;
 	ssize_t slen = 0;
 	uint32_t held_length = 0;
+	struct timeval dwell_start;
 #if defined(__FreeBSD__) && __FreeBSD_version >= 700000
 	int sockbuf_lock = 0;
 #endif
 
+	dwell_start.tv_sec = 0;
+	dwell_start.tv_usec = 0;
 	if (uio == NULL) {
 		SCTP_LTRACE_ERR_RET(inp, NULL, NULL, SCTP_FROM_SCTPUTIL, EINVAL);
 		return (EINVAL);
@@ -5932,7 +6832,7 @@ sctp_sorecvmsg(struct socket *so,
 				    (ctl->some_taken ||
 				     (ctl->spec_flags & M_NOTIFICATION) ||
 				     ((ctl->do_not_ref_stcb == 0) &&
-				      (ctl->stcb->asoc.strmin[ctl->sinfo_stream].delivery_started == 0)))
+				      (sctp_delivery_started(ctl->stcb, ctl) == 0)))
 					) {
 					/*-
 					 * If we have a different TCB next, and there is data
@@ -5948,7 +6848,7 @@ sctp_sorecvmsg(struct socket *so,
 					   ((ctl->some_taken) ||
 					    ((ctl->do_not_ref_stcb == 0) &&
 					     ((ctl->spec_flags & M_NOTIFICATION) == 0) &&
-					     (ctl->stcb->asoc.strmin[ctl->sinfo_stream].delivery_started == 0)))) {
+					     (sctp_delivery_started(ctl->stcb, ctl) == 0)))) {
 					/*-
 					 * If we have the same tcb, and there is data present, and we
 					 * have the strm interleave feature present. Then if we have
@@ -6024,7 +6924,7 @@ sctp_sorecvmsg(struct socket *so,
 	if (stcb &&
 	    ((control->spec_flags & M_NOTIFICATION) == 0) &&
 	    control->do_not_ref_stcb == 0) {
-		stcb->asoc.strmin[control->sinfo_stream].delivery_started = 1;
+		sctp_set_delivery_started(stcb, control, 1);
 	}
 
 	/* First lets get off the sinfo and sockaddr info */
@@ -6225,7 +7125,7 @@ sctp_sorecvmsg(struct socket *so,
 					if ((control->do_not_ref_stcb == 0)  &&
 					    (control->stcb != NULL) &&
 					    ((control->spec_flags & M_NOTIFICATION) == 0))
-						control->stcb->asoc.strmin[control->sinfo_stream].delivery_started = 0;
+						sctp_set_delivery_started(control->stcb, control, 0);
 				}
 				if (control->spec_flags & M_NOTIFICATION) {
 					out_flags |= MSG_NOTIFICATION;
@@ -6316,7 +7216,8 @@ sctp_sorecvmsg(struct socket *so,
 			}
 			if (((stcb) && (in_flags & MSG_PEEK) == 0) &&
 			    (control->do_not_ref_stcb == 0) &&
-			    (freed_so_far >= rwnd_req)) {
+			    (freed_so_far >= rwnd_req) &&
+			    (no_window_update == 0)) {
 				sctp_user_rcvd(stcb, &freed_so_far, hold_rlock, rwnd_req);
 			}
 		} /* end while(m) */
@@ -6343,6 +7244,12 @@ sctp_sorecvmsg(struct socket *so,
 					hold_rlock = 1;
 				}
 				TAILQ_REMOVE(&inp->read_queue, control, next);
+				if ((stcb != NULL) &&
+				    (control->do_not_ref_stcb == 0) &&
+				    ((control->spec_flags & M_NOTIFICATION) == 0)) {
+					/* Recorded below, with the TCB lock held. */
+					dwell_start = control->queued_time;
+				}
 				/* Add back any hiddend data */
 				if (control->held_length) {
 					held_length = 0;
@@ -6365,7 +7272,8 @@ sctp_sorecvmsg(struct socket *so,
 				sctp_free_a_readq(stcb, control);
 				control = NULL;
 				if ((freed_so_far >= rwnd_req) &&
-				    (no_rcv_needed == 0))
+				    (no_rcv_needed == 0) &&
+				    (no_window_update == 0))
 					sctp_user_rcvd(stcb, &freed_so_far, hold_rlock, rwnd_req);
 
 			} else {
@@ -6480,12 +7388,12 @@ sctp_sorecvmsg(struct socket *so,
 				out_flags |= MSG_EOR;
 				if (control->pdapi_aborted) {
 					if ((control->do_not_ref_stcb == 0) && ((control->spec_flags & M_NOTIFICATION) == 0))
-						control->stcb->asoc.strmin[control->sinfo_stream].delivery_started = 0;
+						sctp_set_delivery_started(control->stcb, control, 0);
 
 					out_flags |= MSG_TRUNC;
 				} else {
 					if ((control->do_not_ref_stcb == 0) && ((control->spec_flags & M_NOTIFICATION) == 0))
-						control->stcb->asoc.strmin[control->sinfo_stream].delivery_started = 0;
+						sctp_set_delivery_started(control->stcb, control, 0);
 				}
 				goto done_with_control;
 			}
@@ -6533,7 +7441,7 @@ sctp_sorecvmsg(struct socket *so,
 			if ((control->do_not_ref_stcb == 0) &&
 			    (control->stcb != NULL) &&
 			    ((control->spec_flags & M_NOTIFICATION) == 0))
-				control->stcb->asoc.strmin[control->sinfo_stream].delivery_started = 0;
+				sctp_set_delivery_started(control->stcb, control, 0);
 		}
 		if (control->spec_flags & M_NOTIFICATION) {
 			out_flags |= MSG_NOTIFICATION;
@@ -6605,7 +7513,8 @@ sctp_sorecvmsg(struct socket *so,
 	if ((stcb) && (in_flags & MSG_PEEK) == 0) {
 		if ((freed_so_far >= rwnd_req) &&
 		    (control && (control->do_not_ref_stcb == 0)) &&
-		    (no_rcv_needed == 0))
+		    (no_rcv_needed == 0) &&
+		    (no_window_update == 0))
 			sctp_user_rcvd(stcb, &freed_so_far, hold_rlock, rwnd_req);
 	}
  out:
@@ -6650,6 +7559,11 @@ sctp_sorecvmsg(struct socket *so,
 		}
 		/* Save the value back for next time */
 		stcb->freed_by_sorcv_sincelast = freed_so_far;
+		if ((dwell_start.tv_sec != 0) || (dwell_start.tv_usec != 0)) {
+			SCTP_TCB_LOCK(stcb);
+			sctp_perf_record_since(stcb, SCTP_PERF_RECV_DWELL, &dwell_start);
+			SCTP_TCB_UNLOCK(stcb);
+		}
 		atomic_add_int(&stcb->asoc.refcnt, -1);
 	}
 	if (SCTP_BASE_SYSCTL(sctp_logging_level) &SCTP_RECV_RWND_LOGGING_ENABLE) {
@@ -6690,6 +7604,34 @@ sctp_sorecvmsg(struct socket *so,
 	return (error);
 }
 
+int
+sctp_sorecvmsg(struct socket *so,
+    struct uio *uio,
+    struct mbuf **mp,
+    struct sockaddr *from,
+    int fromlen,
+    int *msg_flags,
+    struct sctp_sndrcvinfo *sinfo,
+    int filling_sinfo)
+{
+	return (sctp_sorecvmsg_internal(so, uio, mp, from, fromlen, msg_flags,
+	                                sinfo, filling_sinfo, 0));
+}
+
+#if defined(__Userspace__)
+int
+sctp_sorecvmsg_no_window_update(struct socket *so,
+    struct uio *uio,
+    struct sockaddr *from,
+    int fromlen,
+    int *msg_flags,
+    struct sctp_sndrcvinfo *sinfo)
+{
+	return (sctp_sorecvmsg_internal(so, uio, NULL, from, fromlen, msg_flags,
+	                                sinfo, 1, 1));
+}
+#endif
+
 
 #ifdef SCTP_MBUF_LOGGING
 struct mbuf *
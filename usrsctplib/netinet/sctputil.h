@@ -84,6 +84,24 @@ uint32_t sctp_select_a_tag(struct sctp_inpcb *, uint16_t lport, uint16_t rport,
 
 int sctp_init_asoc(struct sctp_inpcb *, struct sctp_tcb *, uint32_t, uint32_t, uint16_t);
 
+void sctp_init_stream_out(struct sctp_tcb *, struct sctp_stream_out *, uint16_t, uint8_t);
+
+void sctp_init_stream_in(struct sctp_stream_in *, uint16_t);
+
+int sctp_grow_strmout(struct sctp_association *, uint16_t);
+
+int sctp_grow_strmin(struct sctp_association *, uint16_t);
+
+void sctp_free_strmout(struct sctp_association *);
+
+void sctp_free_strmin(struct sctp_association *);
+
+struct sctp_stream_out *sctp_get_strmout(struct sctp_tcb *, uint16_t);
+
+struct sctp_stream_in *sctp_get_strmin(struct sctp_tcb *, uint16_t);
+
+int sctp_alloc_all_strmout(struct sctp_tcb *);
+
 void sctp_fill_random_store(struct sctp_pcb *);
 
 void
@@ -120,6 +138,9 @@ void sctp_invoke_recv_callback(struct sctp_inpcb *,
     struct sctp_queued_to_read *,
     int);
 
+void sctp_recv_batch_begin(void);
+void sctp_recv_batch_end(void);
+
 #endif
 void
 sctp_add_to_readq(struct sctp_inpcb *inp,
@@ -139,6 +160,8 @@ void sctp_iterator_worker(void);
 uint32_t sctp_get_prev_mtu(uint32_t);
 uint32_t sctp_get_next_mtu(uint32_t);
 
+uint64_t sctp_get_time_usec(void);
+
 void
 sctp_timeout_handler(void *);
 
@@ -146,6 +169,11 @@ uint32_t
 sctp_calculate_rto(struct sctp_tcb *, struct sctp_association *,
     struct sctp_nets *, struct timeval *, int, int);
 
+void sctp_perf_record(struct sctp_tcb *, int, uint32_t);
+void sctp_perf_record_since(struct sctp_tcb *, int, struct timeval *);
+void sctp_perf_free(struct sctp_tcb *);
+void sctp_assoc_mem_usage(struct sctp_tcb *, struct sctp_assoc_mem_stats *);
+
 uint32_t sctp_calculate_len(struct mbuf *);
 
 caddr_t sctp_m_getptr(struct mbuf *, int, int, uint8_t *);
@@ -402,6 +430,9 @@ void sctp_log_closing(struct sctp_inpcb *inp, struct sctp_tcb *stcb, int16_t loc
 void sctp_log_lock(struct sctp_inpcb *inp, struct sctp_tcb *stcb, uint8_t from);
 void sctp_log_maxburst(struct sctp_tcb *stcb, struct sctp_nets *, int, int, uint8_t);
 void sctp_log_block(uint8_t, struct sctp_association *, size_t);
+void sctp_log_timer(struct sctp_tcb *, struct sctp_nets *, int);
+void sctp_log_rtx(struct sctp_tcb *, struct sctp_tmit_chunk *, uint8_t);
+void sctp_log_packet(struct sctp_tcb *, uint32_t, uint32_t, uint8_t, uint8_t);
 void sctp_log_rwnd(uint8_t, uint32_t, uint32_t, uint32_t);
 void sctp_log_rwnd_set(uint8_t, uint32_t, uint32_t, uint32_t, uint32_t);
 int sctp_fill_stat_log(void *, size_t *);
@@ -0,0 +1,532 @@
+/*-
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/* __Userspace__ */
+
+/*
+ * Packet capture in pcapng format. Packets are copied into a ring of
+ * fixed size slots, which producers claim with a compare-and-swap on the
+ * enqueue position, so capturing takes no lock. A writer thread drains
+ * the ring into the file. If the ring is full the packet is dropped and
+ * counted, the count is reported in the interface statistics block
+ * written when the capture is stopped.
+ *
+ * The SCTP packet is captured and an IPv4 or IPv6 header, and a UDP
+ * header for UDP encapsulated packets, is synthesized from the addresses,
+ * so the file uses the raw IP link type. Packets sent or received via
+ * AF_CONN have no IP addresses: they are framed as SCTP over UDP on port
+ * 9899 between 127.0.0.1 (local) and 127.0.0.2 (peer).
+ */
+
+#include <netinet/sctp_os.h>
+#include <netinet/sctp_constants.h>
+#include <netinet/sctp_pcb.h>
+#include <stdio.h>
+#include <string.h>
+#if !defined(__Userspace_os_Windows)
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+#include <user_capture.h>
+
+#define CAPTURE_RING_BYTES (8 * 1024 * 1024)
+#define CAPTURE_MIN_SLOTS 64
+#define CAPTURE_MAX_SNAPLEN 65535
+#define CAPTURE_MAX_FRAMING (40 + 8)	/* IPv6 and UDP header */
+#define CAPTURE_SLOT_HEADER 24
+
+#define PCAPNG_SHB 0x0a0d0d0a
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_ISB 0x00000005
+#define PCAPNG_EPB 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4d
+#define PCAPNG_LINKTYPE_RAW 101
+#define PCAPNG_EPB_INBOUND 0x00000001
+#define PCAPNG_EPB_OUTBOUND 0x00000002
+#define PCAPNG_OPT_EPB_FLAGS 2
+#define PCAPNG_OPT_ISB_IFDROP 5
+
+/* struct udphdr is not available on all platforms without INET. */
+struct capture_udphdr {
+	uint16_t uh_sport;
+	uint16_t uh_dport;
+	uint16_t uh_ulen;
+	uint16_t uh_sum;
+};
+
+struct capture_slot {
+	volatile uint32_t seq;
+	uint32_t flags;
+	uint32_t caplen;
+	uint32_t len;
+	uint64_t time;		/* microseconds since the epoch */
+	uint8_t data[CAPTURE_MAX_FRAMING];	/* continues up to the slot size */
+};
+
+volatile int sctp_capture_active;
+static volatile uint32_t sctp_capture_users;
+
+static struct {
+	uint8_t *ring;
+	size_t slot_size;
+	uint32_t mask;
+	uint32_t snaplen;
+	uint32_t sample;
+	volatile uint32_t enqueue_pos;
+	uint32_t dequeue_pos;
+	volatile uint32_t counter;
+	volatile uint32_t dropped;
+	volatile int stop;
+	FILE *file;
+	userland_thread_t thread;
+} capture;
+
+#if defined(__Userspace_os_Windows)
+static SRWLOCK capture_lock = SRWLOCK_INIT;
+
+#define CAPTURE_LOCK() AcquireSRWLockExclusive(&capture_lock)
+#define CAPTURE_UNLOCK() ReleaseSRWLockExclusive(&capture_lock)
+#define capture_cas(p, o, n) \
+	(InterlockedCompareExchange((volatile LONG *)(p), (LONG)(n), (LONG)(o)) == (LONG)(o))
+
+static __inline uint32_t
+capture_load_acquire(volatile uint32_t *p)
+{
+	uint32_t v;
+
+	v = *p;
+	MemoryBarrier();
+	return (v);
+}
+
+static __inline void
+capture_store_release(volatile uint32_t *p, uint32_t v)
+{
+	MemoryBarrier();
+	*p = v;
+}
+#else
+static pthread_mutex_t capture_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#define CAPTURE_LOCK() pthread_mutex_lock(&capture_lock)
+#define CAPTURE_UNLOCK() pthread_mutex_unlock(&capture_lock)
+#define capture_cas(p, o, n) __sync_bool_compare_and_swap((p), (o), (n))
+#define capture_load_acquire(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define capture_store_release(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+static uint64_t
+capture_time(void)
+{
+#if defined(__Userspace_os_Windows)
+	FILETIME ft;
+	uint64_t t;
+
+	if (SCTP_BASE_VAR(virtual_clock)) {
+		return (sctp_os_timer_now_us());
+	}
+	GetSystemTimeAsFileTime(&ft);
+	t = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+	/* 100 ns units since 1601 */
+	return (t / 10 - 11644473600000000ULL);
+#else
+	struct timeval tv;
+
+	if (SCTP_BASE_VAR(virtual_clock)) {
+		return (sctp_os_timer_now_us());
+	}
+	gettimeofday(&tv, NULL);
+	return ((uint64_t)tv.tv_sec * 1000000 + (uint64_t)tv.tv_usec);
+#endif
+}
+
+static void
+capture_sleep(void)
+{
+#if defined(__Userspace_os_Windows)
+	Sleep(1);
+#else
+	usleep(1000);
+#endif
+}
+
+static uint16_t
+capture_ip_cksum(const uint8_t *hdr, int len)
+{
+	uint32_t sum;
+	int i;
+
+	sum = 0;
+	for (i = 0; i < len; i += 2) {
+		sum += (uint32_t)(hdr[i] << 8 | hdr[i + 1]);
+	}
+	while (sum >> 16) {
+		sum = (sum & 0xffff) + (sum >> 16);
+	}
+	return (htons((uint16_t)~sum));
+}
+
+/*
+ * Writes the IP and UDP header for an SCTP packet of len bytes into hdr,
+ * returns the number of bytes written. Ports are in network byte order,
+ * a source port of 0 means the packet is not UDP encapsulated.
+ */
+static int
+capture_framing(uint8_t *hdr, struct sockaddr *src, struct sockaddr *dst,
+                uint16_t sport, uint16_t dport, int outbound, int len)
+{
+	struct ip *ip;
+#if defined(INET6)
+	struct ip6_hdr *ip6;
+#endif
+	struct capture_udphdr *udp;
+	int hlen, family;
+
+	family = dst->sa_family;
+	if (family == AF_CONN) {
+		sport = dport = htons(SCTP_OVER_UDP_TUNNELING_PORT);
+	}
+	hlen = (sport != 0) ? (int)sizeof(struct capture_udphdr) : 0;
+#if defined(INET6)
+	if (family == AF_INET6) {
+		ip6 = (struct ip6_hdr *)hdr;
+		memset(ip6, 0, sizeof(struct ip6_hdr));
+		ip6->ip6_vfc = IPV6_VERSION;
+		ip6->ip6_plen = htons((uint16_t)(hlen + len));
+		ip6->ip6_nxt = (sport != 0) ? IPPROTO_UDP : IPPROTO_SCTP;
+		ip6->ip6_hlim = 64;
+		ip6->ip6_src = ((struct sockaddr_in6 *)src)->sin6_addr;
+		ip6->ip6_dst = ((struct sockaddr_in6 *)dst)->sin6_addr;
+		hlen += (int)sizeof(struct ip6_hdr);
+	} else
+#endif
+	{
+		ip = (struct ip *)hdr;
+		memset(ip, 0, sizeof(struct ip));
+		ip->ip_v = IPVERSION;
+		ip->ip_hl = sizeof(struct ip) >> 2;
+		ip->ip_len = htons((uint16_t)(sizeof(struct ip) + hlen + len));
+		ip->ip_ttl = 64;
+		ip->ip_p = (sport != 0) ? IPPROTO_UDP : IPPROTO_SCTP;
+		if (family == AF_INET) {
+			ip->ip_src = ((struct sockaddr_in *)src)->sin_addr;
+			ip->ip_dst = ((struct sockaddr_in *)dst)->sin_addr;
+		} else {
+			ip->ip_src.s_addr = htonl(outbound ? 0x7f000001 : 0x7f000002);
+			ip->ip_dst.s_addr = htonl(outbound ? 0x7f000002 : 0x7f000001);
+		}
+		ip->ip_sum = capture_ip_cksum(hdr, sizeof(struct ip));
+		hlen += (int)sizeof(struct ip);
+	}
+	if (sport != 0) {
+		udp = (struct capture_udphdr *)(hdr + hlen - sizeof(struct capture_udphdr));
+		udp->uh_sport = sport;
+		udp->uh_dport = dport;
+		udp->uh_ulen = htons((uint16_t)(sizeof(struct capture_udphdr) + len));
+		udp->uh_sum = 0;
+	}
+	return (hlen);
+}
+
+/*
+ * Captures the len bytes of the SCTP packet starting at offset off of the
+ * mbuf chain m. For AF_CONN src may be NULL.
+ */
+void
+sctp_capture_packet(struct mbuf *m, int off, int len, struct sockaddr *src, struct sockaddr *dst,
+                    uint16_t sport, uint16_t dport, int outbound)
+{
+	struct capture_slot *slot;
+	uint32_t pos, seq, caplen;
+	int hlen;
+
+	atomic_add_int(&sctp_capture_users, 1);
+	if (!sctp_capture_active || (len <= 0) ||
+	    ((src == NULL) && (dst->sa_family != AF_CONN))) {
+		goto out;
+	}
+	if ((capture.sample > 1) &&
+	    (atomic_fetchadd_int(&capture.counter, 1) % capture.sample != 0)) {
+		goto out;
+	}
+	pos = capture.enqueue_pos;
+	for (;;) {
+		slot = (struct capture_slot *)(capture.ring + (pos & capture.mask) * capture.slot_size);
+		seq = capture_load_acquire(&slot->seq);
+		if (seq == pos) {
+			if (capture_cas(&capture.enqueue_pos, pos, pos + 1)) {
+				break;
+			}
+			pos = capture.enqueue_pos;
+		} else if ((int32_t)(seq - pos) < 0) {
+			/* The writer has not caught up. */
+			atomic_add_int(&capture.dropped, 1);
+			goto out;
+		} else {
+			pos = capture.enqueue_pos;
+		}
+	}
+	slot->time = capture_time();
+	slot->flags = outbound ? PCAPNG_EPB_OUTBOUND : PCAPNG_EPB_INBOUND;
+	hlen = capture_framing(slot->data, src, dst, sport, dport, outbound, len);
+	slot->len = (uint32_t)(hlen + len);
+	caplen = slot->len;
+	if (caplen > capture.snaplen) {
+		caplen = capture.snaplen;
+	}
+	if (caplen > (uint32_t)hlen) {
+		m_copydata(m, off, (int)caplen - hlen, (caddr_t)slot->data + hlen);
+	}
+	/* The writer pads the data to 4 bytes. */
+	memset(slot->data + caplen, 0, (4 - (caplen & 3)) & 3);
+	slot->caplen = caplen;
+	capture_store_release(&slot->seq, pos + 1);
+out:
+	atomic_subtract_int(&sctp_capture_users, 1);
+}
+
+/*
+ * Option headers hold a 16 bit code and a 16 bit length, in the byte
+ * order of the section, which is the host byte order.
+ */
+static uint32_t
+capture_option(uint16_t code, uint16_t len)
+{
+	uint16_t opt[2];
+	uint32_t v;
+
+	opt[0] = code;
+	opt[1] = len;
+	memcpy(&v, opt, sizeof(v));
+	return (v);
+}
+
+static void
+capture_write_epb(struct capture_slot *slot)
+{
+	uint32_t block[7], trailer[4];
+	uint32_t padlen;
+
+	padlen = (4 - (slot->caplen & 3)) & 3;
+	block[0] = PCAPNG_EPB;
+	block[1] = 44 + slot->caplen + padlen;
+	block[2] = 0;
+	block[3] = (uint32_t)(slot->time >> 32);
+	block[4] = (uint32_t)slot->time;
+	block[5] = slot->caplen;
+	block[6] = slot->len;
+	trailer[0] = capture_option(PCAPNG_OPT_EPB_FLAGS, 4);
+	trailer[1] = slot->flags;
+	trailer[2] = 0;		/* opt_endofopt */
+	trailer[3] = block[1];
+	fwrite(block, sizeof(block), 1, capture.file);
+	fwrite(slot->data, 1, slot->caplen + padlen, capture.file);
+	fwrite(trailer, sizeof(trailer), 1, capture.file);
+}
+
+static void
+capture_write_header(void)
+{
+	uint32_t shb[7], idb[5];
+
+	shb[0] = PCAPNG_SHB;
+	shb[1] = sizeof(shb);
+	shb[2] = PCAPNG_BYTE_ORDER_MAGIC;
+	shb[3] = capture_option(1, 0);	/* version 1.0 */
+	shb[4] = 0xffffffff;		/* section length not specified */
+	shb[5] = 0xffffffff;
+	shb[6] = sizeof(shb);
+	idb[0] = PCAPNG_IDB;
+	idb[1] = sizeof(idb);
+	idb[2] = PCAPNG_LINKTYPE_RAW;
+	idb[3] = capture.snaplen;
+	idb[4] = sizeof(idb);
+	fwrite(shb, sizeof(shb), 1, capture.file);
+	fwrite(idb, sizeof(idb), 1, capture.file);
+}
+
+static void
+capture_write_statistics(void)
+{
+	uint32_t isb[10];
+	uint64_t t, drops;
+
+	t = capture_time();
+	drops = capture.dropped;
+	isb[0] = PCAPNG_ISB;
+	isb[1] = sizeof(isb);
+	isb[2] = 0;
+	isb[3] = (uint32_t)(t >> 32);
+	isb[4] = (uint32_t)t;
+	isb[5] = capture_option(PCAPNG_OPT_ISB_IFDROP, 8);
+	memcpy(&isb[6], &drops, sizeof(drops));
+	isb[8] = 0;
+	isb[9] = sizeof(isb);
+	fwrite(isb, sizeof(isb), 1, capture.file);
+}
+
+/* Writes all complete slots to the file, returns the number written. */
+static int
+capture_drain(void)
+{
+	struct capture_slot *slot;
+	int n;
+
+	for (n = 0;; n++) {
+		slot = (struct capture_slot *)(capture.ring + (capture.dequeue_pos & capture.mask) * capture.slot_size);
+		if (capture_load_acquire(&slot->seq) != capture.dequeue_pos + 1) {
+			break;
+		}
+		capture_write_epb(slot);
+		capture_store_release(&slot->seq, capture.dequeue_pos + capture.mask + 1);
+		capture.dequeue_pos++;
+	}
+	return (n);
+}
+
+static void *
+capture_writer(void *arg)
+{
+	sctp_userspace_set_threadname("SCTP capture");
+	for (;;) {
+		if (capture_drain() > 0) {
+			continue;
+		}
+		if (capture.stop) {
+			/* Producers are gone, pick up what they completed last. */
+			capture_drain();
+			break;
+		}
+		fflush(capture.file);
+		capture_sleep();
+	}
+	return (NULL);
+}
+
+/*
+ * Starts writing the packets sent and received by the stack to the
+ * pcapng file filename. Packets are truncated to snaplen bytes, including
+ * the synthesized IP and UDP header, 0 means no truncation. If sample is
+ * larger than 1, only every sample-th packet is captured.
+ */
+int
+usrsctp_capture_start(const char *filename, uint32_t snaplen, uint32_t sample)
+{
+	size_t slot_size;
+	uint32_t slots, i;
+
+	CAPTURE_LOCK();
+	if (capture.file != NULL) {
+		CAPTURE_UNLOCK();
+		errno = EALREADY;
+		return (-1);
+	}
+	if (filename == NULL) {
+		CAPTURE_UNLOCK();
+		errno = EINVAL;
+		return (-1);
+	}
+	if ((snaplen == 0) || (snaplen > CAPTURE_MAX_SNAPLEN)) {
+		snaplen = CAPTURE_MAX_SNAPLEN;
+	}
+	if (snaplen < CAPTURE_MAX_FRAMING) {
+		snaplen = CAPTURE_MAX_FRAMING;
+	}
+	slot_size = (CAPTURE_SLOT_HEADER + snaplen + 7) & ~(size_t)7;
+	slots = CAPTURE_MIN_SLOTS;
+	while (slots * slot_size < CAPTURE_RING_BYTES) {
+		slots <<= 1;
+	}
+	capture.ring = malloc(slots * slot_size);
+	if (capture.ring == NULL) {
+		CAPTURE_UNLOCK();
+		errno = ENOMEM;
+		return (-1);
+	}
+	capture.file = fopen(filename, "wb");
+	if (capture.file == NULL) {
+		free(capture.ring);
+		capture.ring = NULL;
+		CAPTURE_UNLOCK();
+		return (-1);
+	}
+	for (i = 0; i < slots; i++) {
+		((struct capture_slot *)(capture.ring + i * slot_size))->seq = i;
+	}
+	capture.slot_size = slot_size;
+	capture.mask = slots - 1;
+	capture.snaplen = snaplen;
+	capture.sample = sample;
+	capture.enqueue_pos = 0;
+	capture.dequeue_pos = 0;
+	capture.counter = 0;
+	capture.dropped = 0;
+	capture.stop = 0;
+	capture_write_header();
+	if (sctp_userspace_thread_create(&capture.thread, capture_writer) != 0) {
+		fclose(capture.file);
+		capture.file = NULL;
+		free(capture.ring);
+		capture.ring = NULL;
+		CAPTURE_UNLOCK();
+		errno = ENOMEM;
+		return (-1);
+	}
+	atomic_add_int(&sctp_capture_active, 1);
+	CAPTURE_UNLOCK();
+	return (0);
+}
+
+void
+usrsctp_capture_stop(void)
+{
+	CAPTURE_LOCK();
+	if (capture.file == NULL) {
+		CAPTURE_UNLOCK();
+		return;
+	}
+	atomic_subtract_int(&sctp_capture_active, 1);
+	while (capture_load_acquire(&sctp_capture_users) != 0) {
+		capture_sleep();
+	}
+	capture.stop = 1;
+#if defined(__Userspace_os_Windows)
+	WaitForSingleObject(capture.thread, INFINITE);
+	CloseHandle(capture.thread);
+#else
+	pthread_join(capture.thread, NULL);
+#endif
+	capture_write_statistics();
+	fclose(capture.file);
+	capture.file = NULL;
+	free(capture.ring);
+	capture.ring = NULL;
+	CAPTURE_UNLOCK();
+}
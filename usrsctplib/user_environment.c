@@ -30,10 +30,23 @@
 
 /* __Userspace__ */
 
+#if defined (__Userspace_os_Windows)
+#define _CRT_RAND_S
+#endif
 #include <stdlib.h>
+#if defined (__Userspace_os_Windows)
+#include <process.h>
+#endif
 #if !defined (__Userspace_os_Windows)
 #include <stdint.h>
 #include <netinet/sctp_os_userspace.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#if defined(__Userspace_os_Linux)
+#include <sys/syscall.h>
+#endif
 #endif
 #include <user_environment.h>
 #include <sys/types.h>
@@ -42,6 +55,7 @@
 #define MIN(arg1,arg2) ((arg1) < (arg2) ? (arg1) : (arg2))
 #endif
 #include <string.h>
+#include <time.h>
 
 #define uHZ 1000
 
@@ -60,11 +74,8 @@ u_short ip_id = 0; /*__Userspace__ TODO Should it be initialized to zero? */
  */
 userland_mutex_t atomic_mtx;
 
-/* If the entropy device is not loaded, make a token effort to
- * provide _some_ kind of randomness. This should only be used
- * inside other RNG's, like arc4random(9).
- */
 #if defined(__Userspace_os_FreeBSD) || defined(__Userspace_os_Darwin)
+/* arc4random_buf() is a per process ChaCha20 based CSPRNG already. */
 static int
 read_random_phony(void *buf, int count)
 {
@@ -73,27 +84,268 @@ read_random_phony(void *buf, int count)
 	}
 	return (count);
 }
+
+static int (*read_func)(void *, int) = read_random_phony;
+#else
+/*
+ * ChaCha20 based generator using fast key erasure: each refill of the
+ * buffer produces the key for the next refill, so earlier output can't be
+ * reconstructed from the state. The state is per thread, so no locking is
+ * required. It is seeded from the operating system on first use, after
+ * RNG_RESEED_BYTES bytes and, on POSIX systems, in the child after a fork.
+ * If the operating system fails to provide entropy, the generator is only
+ * as strong as the weak seed built by chacha20_weak_seed().
+ */
+#if defined(_MSC_VER)
+#define RNG_THREAD_LOCAL __declspec(thread)
 #else
+#define RNG_THREAD_LOCAL __thread
+#endif
+
+#define RNG_KEY_WORDS 8
+#define RNG_BLOCK_SIZE 64
+#define RNG_BUFFER_SIZE (16 * RNG_BLOCK_SIZE)
+#define RNG_RESEED_BYTES 1600000
+
+struct chacha20_rng {
+	uint32_t key[RNG_KEY_WORDS];
+	uint8_t buffer[RNG_BUFFER_SIZE];
+	size_t available;	/* unused bytes at the end of buffer */
+	size_t count;		/* bytes produced since the last reseed */
+	unsigned int generation;
+	int seeded;
+};
+
+static RNG_THREAD_LOCAL struct chacha20_rng chacha20_rng;
+/* Incremented in the child after a fork, forcing every thread to reseed. */
+static volatile unsigned int chacha20_generation;
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define QUARTERROUND(a, b, c, d) \
+	a += b; d ^= a; d = ROTL32(d, 16); \
+	c += d; b ^= c; b = ROTL32(b, 12); \
+	a += b; d ^= a; d = ROTL32(d, 8); \
+	c += d; b ^= c; b = ROTL32(b, 7);
+
+static void
+chacha20_block(const uint32_t key[RNG_KEY_WORDS], uint32_t counter, uint8_t *out)
+{
+	uint32_t input[16], x[16];
+	int i;
+
+	/* "expand 32-byte k" */
+	input[0] = 0x61707865;
+	input[1] = 0x3320646e;
+	input[2] = 0x79622d32;
+	input[3] = 0x6b206574;
+	for (i = 0; i < RNG_KEY_WORDS; i++) {
+		input[4 + i] = key[i];
+	}
+	input[12] = counter;
+	input[13] = 0;
+	input[14] = 0;
+	input[15] = 0;
+	memcpy(x, input, sizeof(x));
+	for (i = 0; i < 10; i++) {
+		QUARTERROUND(x[0], x[4], x[8], x[12])
+		QUARTERROUND(x[1], x[5], x[9], x[13])
+		QUARTERROUND(x[2], x[6], x[10], x[14])
+		QUARTERROUND(x[3], x[7], x[11], x[15])
+		QUARTERROUND(x[0], x[5], x[10], x[15])
+		QUARTERROUND(x[1], x[6], x[11], x[12])
+		QUARTERROUND(x[2], x[7], x[8], x[13])
+		QUARTERROUND(x[3], x[4], x[9], x[14])
+	}
+	for (i = 0; i < 16; i++) {
+		x[i] += input[i];
+		out[4 * i] = (uint8_t)x[i];
+		out[4 * i + 1] = (uint8_t)(x[i] >> 8);
+		out[4 * i + 2] = (uint8_t)(x[i] >> 16);
+		out[4 * i + 3] = (uint8_t)(x[i] >> 24);
+	}
+}
+
+static void
+chacha20_rng_refill(struct chacha20_rng *rng)
+{
+	uint32_t counter;
+
+	for (counter = 0; counter < RNG_BUFFER_SIZE / RNG_BLOCK_SIZE; counter++) {
+		chacha20_block(rng->key, counter, rng->buffer + counter * RNG_BLOCK_SIZE);
+	}
+	/* The first bytes become the next key and are never handed out. */
+	memcpy(rng->key, rng->buffer, sizeof(rng->key));
+	memset(rng->buffer, 0, sizeof(rng->key));
+	rng->available = RNG_BUFFER_SIZE - sizeof(rng->key);
+}
+
+#if defined(__Userspace_os_Windows)
 static int
-read_random_phony(void *buf, int count)
+get_os_entropy(void *buf, size_t len)
 {
-	uint32_t randval;
-	int size, i;
+	unsigned int r;
+	size_t i, size;
 
-	/* srandom() is called in kern/init_main.c:proc0_post() */
+	for (i = 0; i < len; i += sizeof(unsigned int)) {
+		if (rand_s(&r) != 0) {
+			return (-1);
+		}
+		size = MIN(len - i, sizeof(unsigned int));
+		memcpy((uint8_t *)buf + i, &r, size);
+	}
+	return (0);
+}
+#else
+static void
+chacha20_atfork_child(void)
+{
+	chacha20_generation++;
+}
 
-	/* Fill buf[] with random(9) output */
-	for (i = 0; i < count; i+= (int)sizeof(uint32_t)) {
-		randval = random();
-		size = MIN(count - i, (int)sizeof(uint32_t));
-		memcpy(&((char *)buf)[i], &randval, (size_t)size);
+static void
+chacha20_register_atfork(void)
+{
+	(void)pthread_atfork(NULL, NULL, chacha20_atfork_child);
+}
+
+static int
+get_os_entropy(void *buf, size_t len)
+{
+	ssize_t n;
+	size_t done;
+	int fd;
+
+#if defined(__Userspace_os_Linux) && defined(SYS_getrandom)
+	for (done = 0; done < len; done += (size_t)n) {
+		n = syscall(SYS_getrandom, (uint8_t *)buf + done, len - done, 0);
+		if (n < 0) {
+			if (errno == EINTR) {
+				n = 0;
+				continue;
+			}
+			break;
+		}
+	}
+	if (done == len) {
+		return (0);
 	}
+	/* Kernel without getrandom(), use the device. */
+#endif
+	if ((fd = open("/dev/urandom", O_RDONLY)) < 0) {
+		return (-1);
+	}
+	for (done = 0; done < len; done += (size_t)n) {
+		n = read(fd, (uint8_t *)buf + done, len - done);
+		if (n <= 0) {
+			if ((n < 0) && (errno == EINTR)) {
+				n = 0;
+				continue;
+			}
+			break;
+		}
+	}
+	close(fd);
+	return ((done == len) ? 0 : -1);
+}
+#endif
 
-	return (count);
+/*
+ * Used only if the operating system can't provide entropy. The whole seed
+ * is derived from the time, the process id and some addresses by running
+ * them through the block function. This is guessable, so the generator is
+ * weak until the next successful reseed.
+ */
+static void
+chacha20_weak_seed(struct chacha20_rng *rng, uint32_t seed[RNG_KEY_WORDS])
+{
+	uint32_t input[RNG_KEY_WORDS];
+	uint8_t out[RNG_BLOCK_SIZE];
+	time_t now;
+
+	now = time(NULL);
+	input[0] = (uint32_t)now;
+	input[1] = (uint32_t)((uint64_t)now >> 32);
+	input[2] = (uint32_t)clock();
+#if defined(__Userspace_os_Windows)
+	input[3] = (uint32_t)_getpid();
+#else
+	input[3] = (uint32_t)getpid();
+#endif
+	input[4] = (uint32_t)(uintptr_t)rng;
+	input[5] = (uint32_t)(uintptr_t)&input;
+	input[6] = chacha20_generation;
+	input[7] = (uint32_t)rng->count;
+	chacha20_block(input, 0, out);
+	memcpy(seed, out, RNG_KEY_WORDS * sizeof(uint32_t));
+	memset(input, 0, sizeof(input));
+	memset(out, 0, sizeof(out));
 }
+
+static void
+chacha20_rng_reseed(struct chacha20_rng *rng)
+{
+	uint32_t seed[RNG_KEY_WORDS];
+	int i;
+#if !defined(__Userspace_os_Windows)
+	static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+
+	(void)pthread_once(&atfork_once, chacha20_register_atfork);
 #endif
+	if (get_os_entropy(seed, sizeof(seed)) < 0) {
+		/*
+		 * Should not happen. Don't fail, but use a fully initialized
+		 * weak seed. The existing key still contributes if there
+		 * is one.
+		 */
+		chacha20_weak_seed(rng, seed);
+	}
+	for (i = 0; i < RNG_KEY_WORDS; i++) {
+		rng->key[i] ^= seed[i];
+	}
+	memset(seed, 0, sizeof(seed));
+	rng->count = 0;
+	rng->generation = chacha20_generation;
+	rng->seeded = 1;
+	chacha20_rng_refill(rng);
+}
 
-static int (*read_func)(void *, int) = read_random_phony;
+static int
+read_random_chacha20(void *buf, int count)
+{
+	struct chacha20_rng *rng;
+	uint8_t *p, *src;
+	size_t len, size;
+
+	if (count <= 0) {
+		return (count);
+	}
+	rng = &chacha20_rng;
+	if ((rng->seeded == 0) ||
+	    (rng->generation != chacha20_generation) ||
+	    (rng->count >= RNG_RESEED_BYTES)) {
+		chacha20_rng_reseed(rng);
+	}
+	p = (uint8_t *)buf;
+	len = (size_t)count;
+	while (len > 0) {
+		if (rng->available == 0) {
+			chacha20_rng_refill(rng);
+		}
+		size = MIN(len, rng->available);
+		src = rng->buffer + RNG_BUFFER_SIZE - rng->available;
+		memcpy(p, src, size);
+		/* Don't keep handed out bytes around. */
+		memset(src, 0, size);
+		rng->available -= size;
+		p += size;
+		len -= size;
+	}
+	rng->count += (size_t)count;
+	return (count);
+}
+
+static int (*read_func)(void *, int) = read_random_chacha20;
+#endif
 
 /* Userland-visible version of read_random */
 int
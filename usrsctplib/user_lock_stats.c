@@ -0,0 +1,299 @@
+/*-
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/* __Userspace__ */
+
+/*
+ * Lock statistics, compiled in with SCTP_LOCK_STATS. The lock macros go
+ * through sctp_lock_stats_lock() and sctp_lock_stats_unlock(), which try
+ * the mutex first and only read the clock for the wait time when that
+ * fails. Hold times are measured with a small per thread stack of the
+ * mutexes currently held; mutexes acquired while the stack is full are
+ * counted but their hold time is not. The counters of each class live
+ * on their own cache line and are updated with atomic adds, so the
+ * instrumentation does not add a lock of its own.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <netinet/sctp_os_userspace.h>
+#if !defined(__Userspace_os_Windows)
+#include <time.h>
+#endif
+
+#if defined(SCTP_LOCK_STATS)
+#if defined(_MSC_VER)
+#define LOCK_STATS_THREAD_LOCAL __declspec(thread)
+#else
+#define LOCK_STATS_THREAD_LOCAL __thread
+#endif
+
+#define LOCK_STATS_HELD_MAX 32
+
+struct sctp_lock_class {
+	volatile uint64_t acquisitions;
+	volatile uint64_t contended;
+	volatile uint64_t wait_time;
+	volatile uint64_t max_hold_time;
+	uint8_t pad[32];
+};
+
+struct sctp_lock_held {
+	userland_mutex_t *mtx;
+	int cls;
+	uint64_t since;		/* 0 while sleeping on a condition variable */
+};
+
+static struct sctp_lock_class sctp_lock_classes[SCTP_LOCK_CLASS_MAX];
+static LOCK_STATS_THREAD_LOCAL struct sctp_lock_held sctp_lock_held[LOCK_STATS_HELD_MAX];
+static LOCK_STATS_THREAD_LOCAL int sctp_lock_nheld;
+
+#if defined(__Userspace_os_Windows)
+static LARGE_INTEGER sctp_lock_freq;
+
+#define LOCK_STATS_ADD(p, v) \
+	InterlockedExchangeAdd64((volatile LONG64 *)(p), (LONG64)(v))
+#define LOCK_STATS_LOAD(p) (*(p))
+#else
+#define LOCK_STATS_ADD(p, v) \
+	(void)__atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define LOCK_STATS_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#endif
+
+static const char *sctp_lock_names[SCTP_LOCK_CLASS_MAX] = {
+	"INP_INFO",
+	"INP",
+	"INP_READ",
+	"ASOC_CREATE",
+	"TCB",
+	"TCB_SEND",
+	"WQ_ADDR",
+	"IPI_ADDR",
+	"IP_PKTLOG",
+	"ITERATOR",
+	"ITERATOR_WQ",
+	"TIMERQ",
+	"SOCKBUF",
+	"ACCEPT",
+	"POLLSET"
+};
+
+static uint64_t
+sctp_lock_now(void)
+{
+#if defined(__Userspace_os_Windows)
+	LARGE_INTEGER now;
+
+	if (sctp_lock_freq.QuadPart == 0) {
+		QueryPerformanceFrequency(&sctp_lock_freq);
+	}
+	QueryPerformanceCounter(&now);
+	return ((uint64_t)(now.QuadPart / sctp_lock_freq.QuadPart) * 1000000000 +
+	        (uint64_t)(now.QuadPart % sctp_lock_freq.QuadPart) * 1000000000 / sctp_lock_freq.QuadPart);
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+static void
+sctp_lock_update_max(volatile uint64_t *max, uint64_t value)
+{
+	uint64_t old;
+
+	old = LOCK_STATS_LOAD(max);
+	while (value > old) {
+#if defined(__Userspace_os_Windows)
+		uint64_t prev;
+
+		prev = (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)max, (LONG64)value, (LONG64)old);
+		if (prev == old) {
+			break;
+		}
+		old = prev;
+#else
+		if (__atomic_compare_exchange_n(max, &old, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+			break;
+		}
+#endif
+	}
+}
+
+static struct sctp_lock_held *
+sctp_lock_find(userland_mutex_t *mtx)
+{
+	int i;
+
+	for (i = sctp_lock_nheld - 1; i >= 0; i--) {
+		if (sctp_lock_held[i].mtx == mtx) {
+			return (&sctp_lock_held[i]);
+		}
+	}
+	return (NULL);
+}
+
+static void
+sctp_lock_acquired(userland_mutex_t *mtx, int cls, uint64_t now)
+{
+	LOCK_STATS_ADD(&sctp_lock_classes[cls].acquisitions, 1);
+	if (sctp_lock_nheld < LOCK_STATS_HELD_MAX) {
+		sctp_lock_held[sctp_lock_nheld].mtx = mtx;
+		sctp_lock_held[sctp_lock_nheld].cls = cls;
+		sctp_lock_held[sctp_lock_nheld].since = now;
+		sctp_lock_nheld++;
+	}
+}
+
+int
+sctp_lock_stats_lock(userland_mutex_t *mtx, int cls)
+{
+	uint64_t start, now;
+	int error;
+
+#if defined(__Userspace_os_Windows)
+	error = 0;
+	if (TryEnterCriticalSection(mtx)) {
+		now = sctp_lock_now();
+	} else {
+		start = sctp_lock_now();
+		EnterCriticalSection(mtx);
+		now = sctp_lock_now();
+		LOCK_STATS_ADD(&sctp_lock_classes[cls].contended, 1);
+		LOCK_STATS_ADD(&sctp_lock_classes[cls].wait_time, now - start);
+	}
+#else
+	error = pthread_mutex_trylock(mtx);
+	if (error == 0) {
+		now = sctp_lock_now();
+	} else {
+		start = sctp_lock_now();
+		error = pthread_mutex_lock(mtx);
+		if (error != 0) {
+			return (error);
+		}
+		now = sctp_lock_now();
+		LOCK_STATS_ADD(&sctp_lock_classes[cls].contended, 1);
+		LOCK_STATS_ADD(&sctp_lock_classes[cls].wait_time, now - start);
+	}
+#endif
+	sctp_lock_acquired(mtx, cls, now);
+	return (error);
+}
+
+/* Returns non-zero if the mutex was acquired. */
+int
+sctp_lock_stats_trylock(userland_mutex_t *mtx, int cls)
+{
+#if defined(__Userspace_os_Windows)
+	if (!TryEnterCriticalSection(mtx)) {
+		return (0);
+	}
+#else
+	if (pthread_mutex_trylock(mtx) != 0) {
+		return (0);
+	}
+#endif
+	sctp_lock_acquired(mtx, cls, sctp_lock_now());
+	return (1);
+}
+
+int
+sctp_lock_stats_unlock(userland_mutex_t *mtx, int cls)
+{
+	struct sctp_lock_held *held;
+
+	held = sctp_lock_find(mtx);
+	if (held != NULL) {
+		if (held->since != 0) {
+			sctp_lock_update_max(&sctp_lock_classes[cls].max_hold_time,
+			                     sctp_lock_now() - held->since);
+		}
+		*held = sctp_lock_held[--sctp_lock_nheld];
+	}
+#if defined(__Userspace_os_Windows)
+	LeaveCriticalSection(mtx);
+	return (0);
+#else
+	return (pthread_mutex_unlock(mtx));
+#endif
+}
+
+void
+sctp_lock_stats_sleep(userland_mutex_t *mtx)
+{
+	struct sctp_lock_held *held;
+
+	held = sctp_lock_find(mtx);
+	if ((held != NULL) && (held->since != 0)) {
+		sctp_lock_update_max(&sctp_lock_classes[held->cls].max_hold_time,
+		                     sctp_lock_now() - held->since);
+		held->since = 0;
+	}
+}
+
+void
+sctp_lock_stats_wakeup(userland_mutex_t *mtx)
+{
+	struct sctp_lock_held *held;
+
+	held = sctp_lock_find(mtx);
+	if (held != NULL) {
+		held->since = sctp_lock_now();
+	}
+}
+#endif
+
+int
+usrsctp_get_lock_stats(struct sctp_lock_stats *stats, int max)
+{
+#if defined(SCTP_LOCK_STATS)
+	int i;
+
+	if ((stats == NULL) || (max < 0)) {
+		errno = EINVAL;
+		return (-1);
+	}
+	for (i = 0; (i < max) && (i < SCTP_LOCK_CLASS_MAX); i++) {
+		stats[i].sls_name = sctp_lock_names[i];
+		stats[i].sls_acquisitions = LOCK_STATS_LOAD(&sctp_lock_classes[i].acquisitions);
+		stats[i].sls_contended = LOCK_STATS_LOAD(&sctp_lock_classes[i].contended);
+		stats[i].sls_wait_time = LOCK_STATS_LOAD(&sctp_lock_classes[i].wait_time);
+		stats[i].sls_max_hold_time = LOCK_STATS_LOAD(&sctp_lock_classes[i].max_hold_time);
+	}
+	return (i);
+#else
+	(void)stats;
+	(void)max;
+	errno = EOPNOTSUPP;
+	return (-1);
+#endif
+}
@@ -0,0 +1,99 @@
+/*-
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _USER_LOCK_STATS_H_
+#define _USER_LOCK_STATS_H_
+
+#include <stdint.h>
+
+/*
+ * Lock classes. Every mutex taken through the macros in
+ * sctp_process_lock.h, sctp_callout.h and user_socketvar.h belongs to
+ * one of them.
+ */
+#define SCTP_LOCK_CLASS_INP_INFO     0
+#define SCTP_LOCK_CLASS_INP          1
+#define SCTP_LOCK_CLASS_INP_READ     2
+#define SCTP_LOCK_CLASS_ASOC_CREATE  3
+#define SCTP_LOCK_CLASS_TCB          4
+#define SCTP_LOCK_CLASS_TCB_SEND     5
+#define SCTP_LOCK_CLASS_WQ_ADDR      6
+#define SCTP_LOCK_CLASS_IPI_ADDR     7
+#define SCTP_LOCK_CLASS_IP_PKTLOG    8
+#define SCTP_LOCK_CLASS_ITERATOR     9
+#define SCTP_LOCK_CLASS_ITERATOR_WQ 10
+#define SCTP_LOCK_CLASS_TIMERQ      11
+#define SCTP_LOCK_CLASS_SOCKBUF     12
+#define SCTP_LOCK_CLASS_ACCEPT      13
+#define SCTP_LOCK_CLASS_POLLSET     14
+#define SCTP_LOCK_CLASS_MAX         15
+
+/* Must match the definition in usrsctp.h. */
+struct sctp_lock_stats {
+	const char *sls_name;
+	uint64_t sls_acquisitions;
+	uint64_t sls_contended;		/* acquisitions which had to wait */
+	uint64_t sls_wait_time;		/* in nanoseconds */
+	uint64_t sls_max_hold_time;	/* in nanoseconds */
+};
+
+int usrsctp_get_lock_stats(struct sctp_lock_stats *, int);
+
+#if defined(SCTP_LOCK_STATS)
+int sctp_lock_stats_lock(userland_mutex_t *, int);
+int sctp_lock_stats_trylock(userland_mutex_t *, int);
+int sctp_lock_stats_unlock(userland_mutex_t *, int);
+void sctp_lock_stats_sleep(userland_mutex_t *);
+void sctp_lock_stats_wakeup(userland_mutex_t *);
+
+#define SCTP_MTX_LOCK(m, cls)    sctp_lock_stats_lock((m), (cls))
+#define SCTP_MTX_TRYLOCK(m, cls) sctp_lock_stats_trylock((m), (cls))
+#define SCTP_MTX_UNLOCK(m, cls)  sctp_lock_stats_unlock((m), (cls))
+/*
+ * A thread sleeping on a condition variable does not hold the mutex,
+ * bracket the sleep so it is not accounted as hold time.
+ */
+#define SCTP_MTX_SLEEP(m)        sctp_lock_stats_sleep((m))
+#define SCTP_MTX_WAKEUP(m)       sctp_lock_stats_wakeup((m))
+#else
+#if defined(__Userspace_os_Windows)
+#define SCTP_MTX_LOCK(m, cls)    EnterCriticalSection((m))
+#define SCTP_MTX_TRYLOCK(m, cls) TryEnterCriticalSection((m))
+#define SCTP_MTX_UNLOCK(m, cls)  LeaveCriticalSection((m))
+#else
+#define SCTP_MTX_LOCK(m, cls)    pthread_mutex_lock((m))
+#define SCTP_MTX_TRYLOCK(m, cls) (!(pthread_mutex_trylock((m))))
+#define SCTP_MTX_UNLOCK(m, cls)  pthread_mutex_unlock((m))
+#endif
+#define SCTP_MTX_SLEEP(m)
+#define SCTP_MTX_WAKEUP(m)
+#endif
+
+#endif
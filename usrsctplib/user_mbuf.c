@@ -57,6 +57,9 @@ int max_protohdr = KIPC_MAX_PROTOHDR; /* Size of largest protocol layer header.
  */
 sctp_zone_t	zone_mbuf;
 sctp_zone_t	zone_clust;
+sctp_zone_t	zone_jumbop;
+sctp_zone_t	zone_jumbo9;
+sctp_zone_t	zone_jumbo16;
 sctp_zone_t	zone_ext_refcnt;
 
 /* __Userspace__ clust_mb_args will be passed as callback data to mb_ctor_clust
@@ -204,18 +207,54 @@ m_free(struct mbuf *m)
 }
 
 
+/*
+ * Map a cluster size to its zone and external storage type. Only the sizes
+ * of the cluster zones are valid.
+ */
+static sctp_zone_t
+m_getzone(int size)
+{
+	switch (size) {
+	case MCLBYTES:
+		return (zone_clust);
+	case MJUMPAGESIZE:
+		return (zone_jumbop);
+	case MJUM9BYTES:
+		return (zone_jumbo9);
+	case MJUM16BYTES:
+		return (zone_jumbo16);
+	default:
+		return (NULL);
+	}
+}
+
+static int
+m_gettype(int size)
+{
+	switch (size) {
+	case MCLBYTES:
+		return (EXT_CLUSTER);
+	case MJUMPAGESIZE:
+		return (EXT_JUMBOP);
+	case MJUM9BYTES:
+		return (EXT_JUMBO9);
+	case MJUM16BYTES:
+		return (EXT_JUMBO16);
+	default:
+		return (0);
+	}
+}
+
 static void
-clust_constructor_dup(caddr_t m_clust, struct mbuf* m)
+clust_constructor_dup(caddr_t m_clust, int size, struct mbuf* m)
 {
 	u_int *refcnt;
-	int type, size;
+	int type;
 
-	if (m == NULL) {
+	if ((m == NULL) || (m_clust == NULL)) {
 		return;
 	}
-	/* Assigning cluster of MCLBYTES. TODO: Add jumbo frame functionality */
-	type = EXT_CLUSTER;
-	size = MCLBYTES;
+	type = m_gettype(size);
 
 	refcnt = SCTP_ZONE_GET(zone_ext_refcnt, u_int);
 	/*refcnt = (u_int *)umem_cache_alloc(zone_ext_refcnt, UMEM_DEFAULT);*/
@@ -226,6 +265,11 @@ clust_constructor_dup(caddr_t m_clust, struct mbuf* m)
 		/*refcnt = (u_int *)umem_cache_alloc(zone_ext_refcnt, UMEM_DEFAULT);*/
 	}
 #endif
+	if (refcnt == NULL) {
+		/* Leave the mbuf without M_EXT, callers check for that. */
+		SCTP_ZONE_FREE(m_getzone(size), m_clust);
+		return;
+	}
 	*refcnt = 1;
 	m->m_ext.ext_buf = (caddr_t)m_clust;
 	m->m_data = m->m_ext.ext_buf;
@@ -242,11 +286,29 @@ clust_constructor_dup(caddr_t m_clust, struct mbuf* m)
 /* __Userspace__ */
 void
 m_clget(struct mbuf *m, int how)
+{
+	m_cljget(m, how, MCLBYTES);
+}
+
+/*
+ * __Userspace__
+ * Attach a cluster of size bytes to the mbuf m, size must be one of
+ * MCLBYTES, MJUMPAGESIZE, MJUM9BYTES and MJUM16BYTES. On failure m is
+ * left without M_EXT.
+ */
+void
+m_cljget(struct mbuf *m, int how, int size)
 {
 	caddr_t mclust_ret;
+	sctp_zone_t zone;
 #if defined(SCTP_SIMPLE_ALLOCATOR)
 	struct clust_args clust_mb_args_l;
 #endif
+	zone = m_getzone(size);
+	if (zone == NULL) {
+		SCTPDBG(SCTP_DEBUG_USR, "%s: invalid cluster size %d\n", __func__, size);
+		return;
+	}
 	if (m->m_flags & M_EXT) {
 		SCTPDBG(SCTP_DEBUG_USR, "%s: %p mbuf already has cluster\n", __func__, (void *)m);
 	}
@@ -254,7 +316,7 @@ m_clget(struct mbuf *m, int how)
 #if defined(SCTP_SIMPLE_ALLOCATOR)
 	clust_mb_args_l.parent_mbuf = m;
 #endif
-	mclust_ret = SCTP_ZONE_GET(zone_clust, char);
+	mclust_ret = SCTP_ZONE_GET(zone, char);
 #if defined(SCTP_SIMPLE_ALLOCATOR)
 	mb_ctor_clust(mclust_ret, &clust_mb_args_l, 0);
 #endif
@@ -269,23 +331,53 @@ m_clget(struct mbuf *m, int how)
 		mb_ctor_clust(mclust_ret, &clust_mb_args, 0);
 #else*/
 		umem_reap();
-		mclust_ret = SCTP_ZONE_GET(zone_clust, char);
+		mclust_ret = SCTP_ZONE_GET(zone, char);
 #endif
 		/*mclust_ret = umem_cache_alloc(zone_clust, UMEM_DEFAULT);*/
 		if (NULL == mclust_ret) {
 			SCTPDBG(SCTP_DEBUG_USR, "Memory allocation failure in %s\n", __func__);
+			return;
 		}
 	}
 
 #if USING_MBUF_CONSTRUCTOR
 	if ((m->m_ext.ext_buf == NULL)) {
-		clust_constructor_dup(mclust_ret, m);
+		clust_constructor_dup(mclust_ret, size, m);
 	}
 #else
-	clust_constructor_dup(mclust_ret, m);
+	clust_constructor_dup(mclust_ret, size, m);
 #endif
 }
 
+/*
+ * __Userspace__
+ * Attach size bytes of external storage at buf to the mbuf m. When the last
+ * reference to it goes away, freef is called with buf and args, the storage
+ * itself is never freed by the stack. Returns 0 or ENOMEM.
+ */
+int
+m_extadd(struct mbuf *m, caddr_t buf, u_int size,
+         void (*freef)(void *, void *), void *args, int flags, int type)
+{
+	u_int *refcnt;
+
+	KASSERT(!EXT_IS_CLUSTER(type), ("%s: use m_cljget() for clusters", __func__));
+	refcnt = SCTP_ZONE_GET(zone_ext_refcnt, u_int);
+	if (refcnt == NULL) {
+		return (ENOMEM);
+	}
+	*refcnt = 1;
+	m->m_flags |= (M_EXT | flags);
+	m->m_ext.ext_buf = buf;
+	m->m_data = m->m_ext.ext_buf;
+	m->m_ext.ext_size = size;
+	m->m_ext.ext_free = freef;
+	m->m_ext.ext_args = args;
+	m->m_ext.ext_type = type;
+	m->m_ext.ref_cnt = refcnt;
+	return (0);
+}
+
 /*
  * Unlink a tag from the list of tags associated with an mbuf.
  */
@@ -369,6 +461,10 @@ mbuf_initialize(void *dummy)
 								   &clust_mb_args,
 								   NULL, 0);
 #endif
+	/* Jumbo clusters, so that large messages and packets need fewer mbufs. */
+	SCTP_ZONE_INIT(zone_jumbop, MBUF_JUMBOP_MEM_NAME, MJUMPAGESIZE, 0);
+	SCTP_ZONE_INIT(zone_jumbo9, MBUF_JUMBO9_MEM_NAME, MJUM9BYTES, 0);
+	SCTP_ZONE_INIT(zone_jumbo16, MBUF_JUMBO16_MEM_NAME, MJUM16BYTES, 0);
 
 	/* uma_prealloc() goes here... */
 
@@ -627,8 +723,6 @@ mb_free_ext(struct mbuf *m)
 
 	/* Free the external attached storage if this
 	 * mbuf is the only reference to it.
-	 *__Userspace__ TODO: jumbo frames
-	 *
 	*/
 	/* NOTE: We had the same code that SCTP_DECREMENT_AND_CHECK_REFCOUNT
 	         reduces to here before but the IPHONE malloc commit had changed
@@ -641,11 +735,18 @@ mb_free_ext(struct mbuf *m)
 	if (SCTP_DECREMENT_AND_CHECK_REFCOUNT(m->m_ext.ref_cnt))
 #endif
 	{
-		if (m->m_ext.ext_type == EXT_CLUSTER){
+		if (EXT_IS_CLUSTER(m->m_ext.ext_type)) {
 #if defined(SCTP_SIMPLE_ALLOCATOR)
 			mb_dtor_clust(m->m_ext.ext_buf, &clust_mb_args);
 #endif
-			SCTP_ZONE_FREE(zone_clust, m->m_ext.ext_buf);
+			SCTP_ZONE_FREE(m_getzone(m->m_ext.ext_size), m->m_ext.ext_buf);
+			SCTP_ZONE_FREE(zone_ext_refcnt, (u_int*)m->m_ext.ref_cnt);
+			m->m_ext.ref_cnt = NULL;
+		} else {
+			/* Storage attached by m_extadd(), the owner frees it. */
+			if (m->m_ext.ext_free != NULL) {
+				(*(m->m_ext.ext_free))(m->m_ext.ext_buf, m->m_ext.ext_args);
+			}
 			SCTP_ZONE_FREE(zone_ext_refcnt, (u_int*)m->m_ext.ref_cnt);
 			m->m_ext.ref_cnt = NULL;
 		}
@@ -832,7 +933,7 @@ m_pulldown(struct mbuf *m, int off, int len, int *offp)
 
 	writable = 0;
 	if ((n->m_flags & M_EXT) == 0 ||
-	    (n->m_ext.ext_type == EXT_CLUSTER && M_WRITABLE(n)))
+	    (EXT_IS_CLUSTER(n->m_ext.ext_type) && M_WRITABLE(n)))
 		writable = 1;
 
 	/*
@@ -966,6 +1067,8 @@ mb_dupcl(struct mbuf *n, struct mbuf *m)
 	n->m_ext.ref_cnt = m->m_ext.ref_cnt;
 	n->m_ext.ext_type = m->m_ext.ext_type;
 	n->m_flags |= M_EXT;
+	/* Read-only storage stays read-only in every reference. */
+	n->m_flags |= m->m_flags & M_RDONLY;
 }
 
 
@@ -50,11 +50,17 @@
 #ifndef MCLBYTES
 #define MCLBYTES 2048
 #endif
+#ifndef MJUMPAGESIZE
+#define MJUMPAGESIZE 4096
+#endif
+#define MJUM9BYTES (9 * 1024)
+#define MJUM16BYTES (16 * 1024)
 
 struct mbuf * m_gethdr(int how, short type);
 struct mbuf * m_get(int how, short type);
 struct mbuf * m_free(struct mbuf *m);
 void m_clget(struct mbuf *m, int how);
+void m_cljget(struct mbuf *m, int how, int size);
 
 
 /* mbuf initialization function */
@@ -76,13 +82,16 @@ void mbuf_initialize(void *);
  * Note:umem_zone_t is a pointer.
  */
 #if defined(SCTP_SIMPLE_ALLOCATOR)
-typedef size_t sctp_zone_t;
+typedef struct sctp_mem_zone *sctp_zone_t;
 #else
 typedef umem_cache_t *sctp_zone_t;
 #endif
 
 extern sctp_zone_t zone_mbuf;
 extern sctp_zone_t zone_clust;
+extern sctp_zone_t zone_jumbop;
+extern sctp_zone_t zone_jumbo9;
+extern sctp_zone_t zone_jumbo16;
 extern sctp_zone_t zone_ext_refcnt;
 
 /*-
@@ -110,6 +119,7 @@ void  m_freem(struct mbuf *);
 struct m_tag	*m_tag_alloc(u_int32_t, int, int, int);
 struct mbuf	*m_copym(struct mbuf *, int, int, int);
 void		 m_copyback(struct mbuf *, int, int, caddr_t);
+int		 m_extadd(struct mbuf *, caddr_t, u_int, void (*)(void *, void *), void *, int, int);
 struct mbuf	*m_pullup(struct mbuf *, int);
 struct mbuf	*m_pulldown(struct mbuf *, int off, int len, int *offp);
 int		 m_dup_pkthdr(struct mbuf *, struct mbuf *, int);
@@ -120,6 +130,9 @@ void		 m_copydata(const struct mbuf *, int, int, caddr_t);
 
 #define MBUF_MEM_NAME "mbuf"
 #define MBUF_CLUSTER_MEM_NAME "mbuf_cluster"
+#define MBUF_JUMBOP_MEM_NAME "mbuf_jumbo_page"
+#define MBUF_JUMBO9_MEM_NAME "mbuf_jumbo_9k"
+#define MBUF_JUMBO16_MEM_NAME "mbuf_jumbo_16k"
 #define	MBUF_EXTREFCNT_MEM_NAME	"mbuf_ext_refcnt"
 
 #define	MT_NOINIT	255	/* Not a type but a flag to allocate
@@ -307,6 +320,11 @@ struct mbuf {
 #define	EXT_DISPOSABLE	300	/* can throw this buffer away w/page flipping */
 #define	EXT_EXTREF	400	/* has externally maintained ref_cnt ptr */
 
+/* Storage allocated from one of the cluster zones by m_cljget(). */
+#define	EXT_IS_CLUSTER(type)						\
+	(((type) == EXT_CLUSTER) || ((type) == EXT_JUMBOP) ||		\
+	 ((type) == EXT_JUMBO9) || ((type) == EXT_JUMBO16))
+
 
 /*
  * mbuf types.
@@ -0,0 +1,373 @@
+/*-
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/* __Userspace__ */
+
+/*
+ * Memory accounting. With SCTP_SIMPLE_ALLOCATOR a zone is a handle which
+ * records the element size and the class here holding its counters. Each
+ * zone has its own class, unless there are more zones than classes: the
+ * remaining ones share the last class, "other". Allocations through SCTP_MALLOC() are accounted with the usable size
+ * reported by the C library, so freeing them does not need the size. On
+ * platforms without such a function only the number of objects is known.
+ * The counters of each class live on their own cache line and are
+ * updated with atomic adds.
+ *
+ * The zones are also accounted in a global total, which is checked
+ * against the limits set with usrsctp_set_mem_limits(). Above the hard
+ * limit zone allocations fail and the callers take their M_NOWAIT error
+ * paths. The pressure level is evaluated on every timer tick by
+ * sctp_mem_pressure_update(), which notifies the application of changes.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__Userspace_os_Windows) || defined(__Userspace_os_Linux)
+#include <malloc.h>
+#elif defined(__Userspace_os_FreeBSD)
+#include <malloc_np.h>
+#elif defined(__Userspace_os_Darwin)
+#include <malloc/malloc.h>
+#endif
+#include <netinet/sctp_os.h>
+#include <netinet/sctp_pcb.h>
+
+struct sctp_mem_class {
+	const char *name;
+	volatile uint64_t in_use;
+	volatile uint64_t objects;
+	volatile uint64_t allocs;
+	volatile uint64_t failures;
+	uint8_t pad[24];
+};
+
+struct sctp_mem_zone {
+	struct sctp_mem_class *class;
+	size_t size;
+	const char *name;
+	struct sctp_mem_zone *next;	/* zones accounted as other */
+};
+
+#define SCTP_MEM_CLASS_OTHER (SCTP_MEM_CLASS_MAX - 1)
+
+static struct sctp_mem_class sctp_mem_classes[SCTP_MEM_CLASS_MAX] = {
+	{ "malloc", 0, 0, 0, 0, { 0 } }
+};
+static int sctp_mem_nclasses = 1;
+/* The zones with their own class use the entry of the same index. */
+static struct sctp_mem_zone sctp_mem_zones[SCTP_MEM_CLASS_OTHER];
+static struct sctp_mem_zone *sctp_mem_other_zones;
+/* Used for the zones accounted as other if no handle can be allocated. */
+static struct sctp_mem_zone sctp_mem_other_zone = {
+	&sctp_mem_classes[SCTP_MEM_CLASS_OTHER], 0, "other", NULL
+};
+
+static volatile uint64_t sctp_mem_zones_in_use;
+static volatile uint64_t sctp_mem_soft_limit;
+static volatile uint64_t sctp_mem_hard_limit;
+static volatile int sctp_mem_hard_limit_hit;
+static volatile int sctp_mem_level = SCTP_MEM_PRESSURE_NONE;
+static void (*sctp_mem_pressure_cb)(int, uint64_t, void *);
+static void *sctp_mem_pressure_arg;
+
+#if defined(__Userspace_os_Windows)
+#define MEM_STATS_ADD(p, v) \
+	InterlockedExchangeAdd64((volatile LONG64 *)(p), (LONG64)(v))
+#define MEM_STATS_SUB(p, v) \
+	InterlockedExchangeAdd64((volatile LONG64 *)(p), -(LONG64)(v))
+#define MEM_STATS_LOAD(p) (*(p))
+#define MEM_STATS_STORE(p, v) InterlockedExchange64((volatile LONG64 *)(p), (LONG64)(v))
+#else
+#define MEM_STATS_ADD(p, v) \
+	(void)__atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define MEM_STATS_SUB(p, v) \
+	(void)__atomic_fetch_sub((p), (v), __ATOMIC_RELAXED)
+#define MEM_STATS_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define MEM_STATS_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#endif
+
+static size_t
+sctp_mem_usable_size(void *ptr)
+{
+#if defined(__Userspace_os_Windows)
+	return (_msize(ptr));
+#elif defined(__Userspace_os_Linux) || defined(__Userspace_os_FreeBSD)
+	return (malloc_usable_size(ptr));
+#elif defined(__Userspace_os_Darwin)
+	return (malloc_size(ptr));
+#else
+	(void)ptr;
+	return (0);
+#endif
+}
+
+static void
+sctp_mem_account(struct sctp_mem_class *class, void *ptr, size_t size)
+{
+	if (ptr == NULL) {
+		MEM_STATS_ADD(&class->failures, 1);
+		return;
+	}
+	MEM_STATS_ADD(&class->allocs, 1);
+	MEM_STATS_ADD(&class->objects, 1);
+	MEM_STATS_ADD(&class->in_use, size);
+}
+
+/*
+ * Called from SCTP_ZONE_INIT() while the stack is initialized. A zone
+ * initialized again after usrsctp_finish() keeps its class and counters.
+ * If SCTP_MEM_CLASS_MAX is too small for all zones, the remaining ones are
+ * accounted as other. Their handles are allocated and kept for the next
+ * initialization. If that fails, they share one handle with the largest
+ * of their sizes.
+ */
+struct sctp_mem_zone *
+sctp_mem_zone_init(const char *name, size_t size)
+{
+	struct sctp_mem_zone *zone;
+	int i;
+
+	for (i = 1; (i < sctp_mem_nclasses) && (i < SCTP_MEM_CLASS_OTHER); i++) {
+		if (strcmp(sctp_mem_zones[i].name, name) == 0) {
+			sctp_mem_zones[i].size = size;
+			return (&sctp_mem_zones[i]);
+		}
+	}
+	for (zone = sctp_mem_other_zones; zone != NULL; zone = zone->next) {
+		if (strcmp(zone->name, name) == 0) {
+			zone->size = size;
+			return (zone);
+		}
+	}
+	if (sctp_mem_nclasses < SCTP_MEM_CLASS_OTHER) {
+		i = sctp_mem_nclasses++;
+		sctp_mem_classes[i].name = name;
+		zone = &sctp_mem_zones[i];
+		zone->class = &sctp_mem_classes[i];
+		zone->name = name;
+		zone->size = size;
+		return (zone);
+	}
+	if (sctp_mem_nclasses == SCTP_MEM_CLASS_OTHER) {
+		SCTP_PRINTF("More than %d memory zones, accounting %s and further ones as other.\n",
+		            SCTP_MEM_CLASS_OTHER - 1, name);
+		sctp_mem_classes[SCTP_MEM_CLASS_OTHER].name = "other";
+		sctp_mem_nclasses++;
+	}
+	if ((zone = malloc(sizeof(struct sctp_mem_zone))) == NULL) {
+		zone = &sctp_mem_other_zone;
+		if (zone->size < size) {
+			zone->size = size;
+		}
+		return (zone);
+	}
+	zone->class = &sctp_mem_classes[SCTP_MEM_CLASS_OTHER];
+	zone->size = size;
+	zone->name = name;
+	zone->next = sctp_mem_other_zones;
+	sctp_mem_other_zones = zone;
+	return (zone);
+}
+
+/*
+ * The hard limit is checked without reserving the memory first, so
+ * concurrent allocations may exceed it by a few elements.
+ */
+void *
+sctp_mem_zone_alloc(struct sctp_mem_zone *zone)
+{
+	uint64_t hard_limit;
+	void *ptr;
+
+	hard_limit = MEM_STATS_LOAD(&sctp_mem_hard_limit);
+	if ((hard_limit != 0) &&
+	    (MEM_STATS_LOAD(&sctp_mem_zones_in_use) + zone->size > hard_limit)) {
+		sctp_mem_hard_limit_hit = 1;
+		MEM_STATS_ADD(&zone->class->failures, 1);
+		return (NULL);
+	}
+	ptr = malloc(zone->size);
+	sctp_mem_account(zone->class, ptr, zone->size);
+	if (ptr != NULL) {
+		MEM_STATS_ADD(&sctp_mem_zones_in_use, zone->size);
+	}
+	return (ptr);
+}
+
+void
+sctp_mem_zone_free(struct sctp_mem_zone *zone, void *ptr)
+{
+	if (ptr == NULL) {
+		return;
+	}
+	MEM_STATS_SUB(&zone->class->objects, 1);
+	MEM_STATS_SUB(&zone->class->in_use, zone->size);
+	MEM_STATS_SUB(&sctp_mem_zones_in_use, zone->size);
+	free(ptr);
+}
+
+size_t
+sctp_mem_zone_size(struct sctp_mem_zone *zone)
+{
+	return (zone->size);
+}
+
+void
+sctp_mem_malloced(void *ptr)
+{
+	sctp_mem_account(&sctp_mem_classes[SCTP_MEM_CLASS_MALLOC], ptr,
+	                 ptr != NULL ? sctp_mem_usable_size(ptr) : 0);
+}
+
+void
+sctp_mem_freed(void *ptr)
+{
+	struct sctp_mem_class *class;
+
+	if (ptr == NULL) {
+		return;
+	}
+	class = &sctp_mem_classes[SCTP_MEM_CLASS_MALLOC];
+	MEM_STATS_SUB(&class->objects, 1);
+	MEM_STATS_SUB(&class->in_use, sctp_mem_usable_size(ptr));
+}
+
+int
+usrsctp_get_mem_stats(struct sctp_mem_stats *stats, int max)
+{
+	int i;
+
+	if ((stats == NULL) || (max < 0)) {
+		errno = EINVAL;
+		return (-1);
+	}
+	for (i = 0; (i < max) && (i < sctp_mem_nclasses); i++) {
+		stats[i].sms_name = sctp_mem_classes[i].name;
+		stats[i].sms_in_use = MEM_STATS_LOAD(&sctp_mem_classes[i].in_use);
+		stats[i].sms_objects = MEM_STATS_LOAD(&sctp_mem_classes[i].objects);
+		stats[i].sms_allocs = MEM_STATS_LOAD(&sctp_mem_classes[i].allocs);
+		stats[i].sms_failures = MEM_STATS_LOAD(&sctp_mem_classes[i].failures);
+	}
+	return (i);
+}
+
+int
+usrsctp_set_mem_limits(uint64_t soft_limit, uint64_t hard_limit)
+{
+	if ((soft_limit != 0) && (hard_limit != 0) && (soft_limit > hard_limit)) {
+		errno = EINVAL;
+		return (-1);
+	}
+	MEM_STATS_STORE(&sctp_mem_soft_limit, soft_limit);
+	MEM_STATS_STORE(&sctp_mem_hard_limit, hard_limit);
+	return (0);
+}
+
+void
+usrsctp_set_mem_pressure_cb(void (*cb)(int level, uint64_t in_use, void *arg), void *arg)
+{
+	sctp_mem_pressure_arg = arg;
+	sctp_mem_pressure_cb = cb;
+}
+
+int
+sctp_mem_pressure(void)
+{
+	return (sctp_mem_level);
+}
+
+/*
+ * Returns 0 if no new user data should be queued, which is the case
+ * at the soft limit or, without one, at 7/8 of the hard limit. Unlike
+ * sctp_mem_pressure() this uses the current usage.
+ */
+int
+sctp_mem_accept_data(void)
+{
+	uint64_t in_use, soft_limit, hard_limit;
+
+	soft_limit = MEM_STATS_LOAD(&sctp_mem_soft_limit);
+	hard_limit = MEM_STATS_LOAD(&sctp_mem_hard_limit);
+	if ((soft_limit == 0) && (hard_limit == 0)) {
+		return (1);
+	}
+	in_use = MEM_STATS_LOAD(&sctp_mem_zones_in_use);
+	if (soft_limit != 0) {
+		return (in_use < soft_limit);
+	}
+	return (in_use < hard_limit - hard_limit / 8);
+}
+
+/*
+ * Called by the timer thread on every tick. A level is left only after
+ * the usage dropped below 7/8 of the limit which caused it, to avoid
+ * notifying the application of every allocation around the limit. A
+ * failed allocation enters the hard level even if the usage is below
+ * the limit again when this runs.
+ */
+int
+sctp_mem_pressure_update(void)
+{
+	void (*cb)(int, uint64_t, void *);
+	uint64_t in_use, soft_limit, hard_limit;
+	int level, old_level;
+
+	soft_limit = MEM_STATS_LOAD(&sctp_mem_soft_limit);
+	hard_limit = MEM_STATS_LOAD(&sctp_mem_hard_limit);
+	old_level = sctp_mem_level;
+	if ((soft_limit == 0) && (hard_limit == 0) &&
+	    (old_level == SCTP_MEM_PRESSURE_NONE)) {
+		return (SCTP_MEM_PRESSURE_NONE);
+	}
+	in_use = MEM_STATS_LOAD(&sctp_mem_zones_in_use);
+	if (sctp_mem_hard_limit_hit ||
+	    ((hard_limit != 0) && (in_use >= hard_limit)) ||
+	    ((hard_limit != 0) && (old_level == SCTP_MEM_PRESSURE_HARD) &&
+	     (in_use >= hard_limit - hard_limit / 8))) {
+		level = SCTP_MEM_PRESSURE_HARD;
+	} else if (((soft_limit != 0) && (in_use >= soft_limit)) ||
+	           ((soft_limit != 0) && (old_level != SCTP_MEM_PRESSURE_NONE) &&
+	            (in_use >= soft_limit - soft_limit / 8))) {
+		level = SCTP_MEM_PRESSURE_SOFT;
+	} else {
+		level = SCTP_MEM_PRESSURE_NONE;
+	}
+	sctp_mem_hard_limit_hit = 0;
+	sctp_mem_level = level;
+	if (level != old_level) {
+		cb = sctp_mem_pressure_cb;
+		if (cb != NULL) {
+			cb(level, in_use, sctp_mem_pressure_arg);
+		}
+	}
+	return (level);
+}
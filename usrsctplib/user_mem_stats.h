@@ -0,0 +1,78 @@
+/*-
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _USER_MEM_STATS_H_
+#define _USER_MEM_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Memory accounting. Every allocation through SCTP_MALLOC() and from the
+ * SCTP and mbuf zones is counted in one of the classes below, see
+ * usrsctp_get_mem_stats(). Class 0 holds all SCTP_MALLOC() allocations,
+ * every zone gets its own class when it is initialized. If there are more
+ * zones than classes, the last class, "other", holds the remaining ones.
+ */
+#define SCTP_MEM_CLASS_MALLOC 0
+#define SCTP_MEM_CLASS_MAX   20
+
+/* Must match the definition in usrsctp.h. */
+struct sctp_mem_stats {
+	const char *sms_name;
+	uint64_t sms_in_use;		/* bytes currently allocated */
+	uint64_t sms_objects;		/* objects currently allocated */
+	uint64_t sms_allocs;
+	uint64_t sms_failures;		/* allocations which failed */
+};
+
+int usrsctp_get_mem_stats(struct sctp_mem_stats *, int);
+
+/* Must match the definitions in usrsctp.h. */
+#define SCTP_MEM_PRESSURE_NONE 0
+#define SCTP_MEM_PRESSURE_SOFT 1
+#define SCTP_MEM_PRESSURE_HARD 2
+
+int usrsctp_set_mem_limits(uint64_t, uint64_t);
+void usrsctp_set_mem_pressure_cb(void (*)(int, uint64_t, void *), void *);
+
+struct sctp_mem_zone;
+
+struct sctp_mem_zone *sctp_mem_zone_init(const char *, size_t);
+void *sctp_mem_zone_alloc(struct sctp_mem_zone *);
+void sctp_mem_zone_free(struct sctp_mem_zone *, void *);
+size_t sctp_mem_zone_size(struct sctp_mem_zone *);
+void sctp_mem_malloced(void *);
+void sctp_mem_freed(void *);
+int sctp_mem_pressure(void);
+int sctp_mem_accept_data(void);
+int sctp_mem_pressure_update(void);
+
+#endif
@@ -0,0 +1,486 @@
+/*-
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/* __Userspace__ */
+
+/*
+ * Edge triggered readiness sets. A socket in a set has SB_UPCALL set on
+ * both socket buffers, so every sorwakeup() and sowwakeup() ends up in
+ * sowakeup(), which calls sctp_pollset_wakeup() after releasing the
+ * socket buffer lock. The event is recorded in the entry of the socket
+ * and the entry is put on the ready list of its set, unless it is already
+ * there. usrsctp_pollset_wait() takes entries off that list, so a socket
+ * is reported again only after a new event.
+ *
+ * All sets share one mutex, which is a leaf lock: no other lock is taken
+ * while holding it. It protects the entries, the ready lists and the
+ * so_pollset pointer of the sockets, so a wakeup racing with the removal
+ * of its socket finds so_pollset cleared.
+ *
+ * With SCTP_POLLSET_FD the set has a file descriptor, an eventfd on Linux
+ * and a pipe on other POSIX systems. It is readable while the ready list
+ * is not empty, so the set can be waited for with poll(), select() or
+ * epoll next to other descriptors.
+ */
+
+#include <netinet/sctp_os.h>
+#include <netinet/sctp_pcb.h>
+#include <errno.h>
+#include <stdlib.h>
+#if !defined(__Userspace_os_Windows)
+#include <fcntl.h>
+#include <sys/time.h>
+#include <unistd.h>
+#if defined(__Userspace_os_Linux)
+#include <sys/eventfd.h>
+#endif
+#endif
+#include <user_socketvar.h>
+#include <user_pollset.h>
+
+struct sctp_pollset_entry {
+	TAILQ_ENTRY(sctp_pollset_entry) next;
+	TAILQ_ENTRY(sctp_pollset_entry) ready_next;
+	struct sctp_pollset *set;
+	struct socket *so;
+	void *data;
+	int events;		/* requested */
+	int pending;		/* occurred since the last report */
+	int ready;		/* on the ready list */
+};
+
+struct sctp_pollset {
+	TAILQ_HEAD(, sctp_pollset_entry) entries;
+	TAILQ_HEAD(, sctp_pollset_entry) ready;
+	userland_cond_t cond;
+	int fd[2];		/* fd[0] is returned, fd[1] written */
+	int signaled;		/* the fd is readable */
+};
+
+static userland_mutex_t sctp_pollset_mtx;
+
+#define POLLSET_LOCK()   SCTP_MTX_LOCK(&sctp_pollset_mtx, SCTP_LOCK_CLASS_POLLSET)
+#define POLLSET_UNLOCK() SCTP_MTX_UNLOCK(&sctp_pollset_mtx, SCTP_LOCK_CLASS_POLLSET)
+
+void
+sctp_pollset_init(void)
+{
+#if defined(__Userspace_os_Windows)
+	InitializeCriticalSection(&sctp_pollset_mtx);
+#else
+	pthread_mutexattr_t mutex_attr;
+
+	pthread_mutexattr_init(&mutex_attr);
+#ifdef INVARIANTS
+	pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_ERRORCHECK);
+#endif
+	pthread_mutex_init(&sctp_pollset_mtx, &mutex_attr);
+	pthread_mutexattr_destroy(&mutex_attr);
+#endif
+}
+
+void
+sctp_pollset_finish(void)
+{
+#if defined(__Userspace_os_Windows)
+	DeleteCriticalSection(&sctp_pollset_mtx);
+#else
+	pthread_mutex_destroy(&sctp_pollset_mtx);
+#endif
+}
+
+/* Called with the pollset mutex held. */
+static void
+pollset_signal(struct sctp_pollset *set)
+{
+#if !defined(__Userspace_os_Windows)
+#if defined(__Userspace_os_Linux)
+	uint64_t one = 1;
+#else
+	char one = 1;
+#endif
+
+	if ((set->fd[1] != -1) && (set->signaled == 0)) {
+		if (write(set->fd[1], &one, sizeof(one)) == (ssize_t)sizeof(one)) {
+			set->signaled = 1;
+		}
+	}
+#endif
+#if defined(__Userspace_os_Windows)
+	WakeAllConditionVariable(&set->cond);
+#else
+	pthread_cond_broadcast(&set->cond);
+#endif
+}
+
+/* Called with the pollset mutex held. */
+static void
+pollset_clear(struct sctp_pollset *set)
+{
+#if !defined(__Userspace_os_Windows)
+	char buf[64];
+
+	if ((set->fd[0] != -1) && set->signaled) {
+		while (read(set->fd[0], buf, sizeof(buf)) > 0) {
+			continue;
+		}
+		set->signaled = 0;
+	}
+#endif
+}
+
+/* Called with the pollset mutex held. */
+static void
+pollset_post(struct sctp_pollset_entry *entry, int events)
+{
+	if (entry->so->so_error) {
+		events |= SCTP_EVENT_ERROR;
+	}
+	events &= entry->events | SCTP_EVENT_ERROR;
+	if (events == 0) {
+		return;
+	}
+	entry->pending |= events;
+	if (entry->ready == 0) {
+		entry->ready = 1;
+		if (TAILQ_EMPTY(&entry->set->ready)) {
+			pollset_signal(entry->set);
+		}
+		TAILQ_INSERT_TAIL(&entry->set->ready, entry, ready_next);
+	}
+}
+
+/* Called with the pollset mutex held. */
+static void
+pollset_unlink(struct sctp_pollset_entry *entry)
+{
+	struct sctp_pollset *set;
+	struct socket *so;
+
+	set = entry->set;
+	so = entry->so;
+	if (entry->ready) {
+		TAILQ_REMOVE(&set->ready, entry, ready_next);
+		if (TAILQ_EMPTY(&set->ready)) {
+			pollset_clear(set);
+		}
+	}
+	TAILQ_REMOVE(&set->entries, entry, next);
+	so->so_pollset = NULL;
+	free(entry);
+}
+
+void
+sctp_pollset_wakeup(struct socket *so, int events)
+{
+	POLLSET_LOCK();
+	if (so->so_pollset != NULL) {
+		pollset_post(so->so_pollset, events);
+	}
+	POLLSET_UNLOCK();
+}
+
+/* Removes the socket from set, or from any set if set is NULL. */
+static int
+pollset_detach(struct sctp_pollset *set, struct socket *so)
+{
+	int error;
+
+	POLLSET_LOCK();
+	if ((so->so_pollset == NULL) ||
+	    ((set != NULL) && (so->so_pollset->set != set))) {
+		error = ENOENT;
+	} else {
+		pollset_unlink(so->so_pollset);
+		error = 0;
+	}
+	POLLSET_UNLOCK();
+	if (error == 0) {
+		SOCKBUF_LOCK(&so->so_rcv);
+		so->so_rcv.sb_flags &= ~SB_UPCALL;
+		SOCKBUF_UNLOCK(&so->so_rcv);
+		SOCKBUF_LOCK(&so->so_snd);
+		so->so_snd.sb_flags &= ~SB_UPCALL;
+		SOCKBUF_UNLOCK(&so->so_snd);
+	}
+	return (error);
+}
+
+/* Called by usrsctp_close(). */
+void
+sctp_pollset_close(struct socket *so)
+{
+	if (so->so_pollset != NULL) {
+		(void)pollset_detach(NULL, so);
+	}
+}
+
+struct sctp_pollset *
+usrsctp_pollset_create(int flags)
+{
+	struct sctp_pollset *set;
+
+	if ((flags & ~SCTP_POLLSET_FD) != 0) {
+		errno = EINVAL;
+		return (NULL);
+	}
+	if ((set = malloc(sizeof(struct sctp_pollset))) == NULL) {
+		errno = ENOMEM;
+		return (NULL);
+	}
+	TAILQ_INIT(&set->entries);
+	TAILQ_INIT(&set->ready);
+	set->fd[0] = -1;
+	set->fd[1] = -1;
+	set->signaled = 0;
+	if (flags & SCTP_POLLSET_FD) {
+#if defined(__Userspace_os_Windows)
+		free(set);
+		errno = EOPNOTSUPP;
+		return (NULL);
+#elif defined(__Userspace_os_Linux)
+		if ((set->fd[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+			free(set);
+			return (NULL);
+		}
+		set->fd[1] = set->fd[0];
+#else
+		if (pipe(set->fd) == -1) {
+			free(set);
+			return (NULL);
+		}
+		fcntl(set->fd[0], F_SETFL, fcntl(set->fd[0], F_GETFL) | O_NONBLOCK);
+		fcntl(set->fd[1], F_SETFL, fcntl(set->fd[1], F_GETFL) | O_NONBLOCK);
+		fcntl(set->fd[0], F_SETFD, FD_CLOEXEC);
+		fcntl(set->fd[1], F_SETFD, FD_CLOEXEC);
+#endif
+	}
+#if defined(__Userspace_os_Windows)
+	InitializeConditionVariable(&set->cond);
+#else
+	pthread_cond_init(&set->cond, NULL);
+#endif
+	return (set);
+}
+
+/*
+ * The sockets still in the set are removed. No thread may be waiting on
+ * the set.
+ */
+int
+usrsctp_pollset_destroy(struct sctp_pollset *set)
+{
+	struct sctp_pollset_entry *entry;
+
+	if (set == NULL) {
+		errno = EINVAL;
+		return (-1);
+	}
+	POLLSET_LOCK();
+	/*
+	 * SB_UPCALL stays set, clearing it needs the socket buffer locks,
+	 * which are taken before the pollset mutex. It only results in calls
+	 * of sctp_pollset_wakeup() which find no entry.
+	 */
+	while ((entry = TAILQ_FIRST(&set->entries)) != NULL) {
+		pollset_unlink(entry);
+	}
+	POLLSET_UNLOCK();
+#if !defined(__Userspace_os_Windows)
+	if (set->fd[0] != -1) {
+		close(set->fd[0]);
+	}
+	if ((set->fd[1] != -1) && (set->fd[1] != set->fd[0])) {
+		close(set->fd[1]);
+	}
+	pthread_cond_destroy(&set->cond);
+#else
+	DeleteConditionVariable(&set->cond);
+#endif
+	free(set);
+	return (0);
+}
+
+/*
+ * The socket is reported right away if it is already readable or
+ * writable, later on only when a new event occurs.
+ */
+int
+usrsctp_pollset_add(struct sctp_pollset *set, struct socket *so, int events, void *data)
+{
+	struct sctp_pollset_entry *entry;
+	int ready;
+
+	if ((set == NULL) || (so == NULL) ||
+	    ((events & ~(SCTP_EVENT_READ | SCTP_EVENT_WRITE | SCTP_EVENT_ERROR)) != 0)) {
+		errno = EINVAL;
+		return (-1);
+	}
+	if ((entry = malloc(sizeof(struct sctp_pollset_entry))) == NULL) {
+		errno = ENOMEM;
+		return (-1);
+	}
+	entry->set = set;
+	entry->so = so;
+	entry->data = data;
+	entry->events = events;
+	entry->pending = 0;
+	entry->ready = 0;
+	POLLSET_LOCK();
+	if (so->so_pollset != NULL) {
+		POLLSET_UNLOCK();
+		free(entry);
+		errno = EEXIST;
+		return (-1);
+	}
+	TAILQ_INSERT_TAIL(&set->entries, entry, next);
+	so->so_pollset = entry;
+	POLLSET_UNLOCK();
+	ready = 0;
+	SOCKBUF_LOCK(&so->so_rcv);
+	so->so_rcv.sb_flags |= SB_UPCALL;
+	if (soreadable(so)) {
+		ready |= SCTP_EVENT_READ;
+	}
+	SOCKBUF_UNLOCK(&so->so_rcv);
+	SOCKBUF_LOCK(&so->so_snd);
+	so->so_snd.sb_flags |= SB_UPCALL;
+	if (sowriteable(so)) {
+		ready |= SCTP_EVENT_WRITE;
+	}
+	SOCKBUF_UNLOCK(&so->so_snd);
+	sctp_pollset_wakeup(so, ready);
+	return (0);
+}
+
+int
+usrsctp_pollset_remove(struct sctp_pollset *set, struct socket *so)
+{
+	int error;
+
+	if ((set == NULL) || (so == NULL)) {
+		errno = EINVAL;
+		return (-1);
+	}
+	if ((error = pollset_detach(set, so)) != 0) {
+		errno = error;
+		return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Waits up to timeout milliseconds, forever if timeout is negative, for
+ * events and returns at most maxevents of them.
+ */
+int
+usrsctp_pollset_wait(struct sctp_pollset *set, struct sctp_pollevent *events, int maxevents, int timeout)
+{
+	struct sctp_pollset_entry *entry;
+#if defined(__Userspace_os_Windows)
+	ULONGLONG deadline = 0, now;
+	DWORD wait;
+#else
+	struct timeval tv;
+	struct timespec deadline;
+	int error;
+#endif
+	int n;
+
+	if ((set == NULL) || (events == NULL) || (maxevents <= 0)) {
+		errno = EINVAL;
+		return (-1);
+	}
+	if (timeout > 0) {
+#if defined(__Userspace_os_Windows)
+		deadline = GetTickCount64() + (ULONGLONG)timeout;
+#else
+		gettimeofday(&tv, NULL);
+		deadline.tv_sec = tv.tv_sec + timeout / 1000;
+		deadline.tv_nsec = tv.tv_usec * 1000 + (timeout % 1000) * 1000000;
+		if (deadline.tv_nsec >= 1000000000) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+#endif
+	}
+	POLLSET_LOCK();
+	while (TAILQ_EMPTY(&set->ready) && (timeout != 0)) {
+		SCTP_MTX_SLEEP(&sctp_pollset_mtx);
+#if defined(__Userspace_os_Windows)
+		if (timeout < 0) {
+			wait = INFINITE;
+		} else {
+			now = GetTickCount64();
+			wait = (now < deadline) ? (DWORD)(deadline - now) : 0;
+		}
+		if (!SleepConditionVariableCS(&set->cond, &sctp_pollset_mtx, wait)) {
+			SCTP_MTX_WAKEUP(&sctp_pollset_mtx);
+			break;
+		}
+#else
+		if (timeout < 0) {
+			error = pthread_cond_wait(&set->cond, &sctp_pollset_mtx);
+		} else {
+			error = pthread_cond_timedwait(&set->cond, &sctp_pollset_mtx, &deadline);
+		}
+		if (error != 0) {
+			SCTP_MTX_WAKEUP(&sctp_pollset_mtx);
+			break;
+		}
+#endif
+		SCTP_MTX_WAKEUP(&sctp_pollset_mtx);
+	}
+	n = 0;
+	while ((n < maxevents) && ((entry = TAILQ_FIRST(&set->ready)) != NULL)) {
+		TAILQ_REMOVE(&set->ready, entry, ready_next);
+		entry->ready = 0;
+		events[n].pe_socket = entry->so;
+		events[n].pe_data = entry->data;
+		events[n].pe_events = entry->pending;
+		entry->pending = 0;
+		n++;
+	}
+	if (TAILQ_EMPTY(&set->ready)) {
+		pollset_clear(set);
+	}
+	POLLSET_UNLOCK();
+	return (n);
+}
+
+int
+usrsctp_pollset_fd(struct sctp_pollset *set)
+{
+	if (set == NULL) {
+		errno = EINVAL;
+		return (-1);
+	}
+	return (set->fd[0]);
+}
@@ -0,0 +1,62 @@
+/*-
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _USER_POLLSET_H_
+#define _USER_POLLSET_H_
+
+/* Must match the definitions in usrsctp.h. */
+#define SCTP_EVENT_READ  0x0001
+#define SCTP_EVENT_WRITE 0x0002
+#define SCTP_EVENT_ERROR 0x0004
+
+#define SCTP_POLLSET_FD  0x0001
+
+struct socket;
+struct sctp_pollset;
+
+struct sctp_pollevent {
+	struct socket *pe_socket;
+	void *pe_data;
+	int pe_events;
+};
+
+void sctp_pollset_init(void);
+void sctp_pollset_finish(void);
+void sctp_pollset_wakeup(struct socket *, int);
+void sctp_pollset_close(struct socket *);
+
+struct sctp_pollset *usrsctp_pollset_create(int);
+int usrsctp_pollset_destroy(struct sctp_pollset *);
+int usrsctp_pollset_add(struct sctp_pollset *, struct socket *, int, void *);
+int usrsctp_pollset_remove(struct sctp_pollset *, struct socket *);
+int usrsctp_pollset_wait(struct sctp_pollset *, struct sctp_pollevent *, int, int);
+int usrsctp_pollset_fd(struct sctp_pollset *);
+
+#endif
@@ -65,7 +65,25 @@
 #endif
 
 void recv_thread_destroy(void);
-#define MAXLEN_MBUF_CHAIN 32 /* What should this value be? */
+/*
+ * Packets are received into a chain of mbufs. The first one has a regular
+ * cluster, which holds packets up to the common MTUs. Larger packets
+ * continue in 9k clusters, so that a 9000 byte jumbo frame needs two mbufs
+ * instead of five. MAXLEN_MBUF_CHAIN buffers hold the largest IP packet.
+ */
+#define MAXLEN_MBUF_CHAIN 8
+#define RECV_IOVLEN(i) (((i) == 0) ? MCLBYTES : MJUM9BYTES)
+#if defined(__Userspace_os_Windows)
+#define RECV_IOV_SET(iov, base, length) do { \
+	(iov).buf = (caddr_t)(base); \
+	(iov).len = (length); \
+} while (0)
+#else
+#define RECV_IOV_SET(iov, base, length) do { \
+	(iov).iov_base = (caddr_t)(base); \
+	(iov).iov_len = (length); \
+} while (0)
+#endif
 #define ROUNDUP(a, size) (((a) & ((size)-1)) ? (1 + ((a) | ((size)-1))) : (a))
 #if defined(__Userspace_os_Darwin) || defined(__Userspace_os_DragonFly) || defined(__Userspace_os_FreeBSD)
 #define NEXT_SA(ap) ap = (struct sockaddr *) \
@@ -258,6 +276,40 @@ recv_function_route(void *arg)
 }
 #endif
 
+#if defined(INET) || defined(INET6)
+/*
+ * Allocates the buffers of the chain which were passed up with the last
+ * packet, the first to_fill ones, and those missing since an earlier call.
+ * A buffer which cannot be allocated, for example above the hard memory
+ * limit, is replaced in the iovec by the scratch buffer. The next packet
+ * is then still read from the socket, but has to be dropped. Returns 0 in
+ * that case.
+ */
+static int
+#if defined(__Userspace_os_Windows)
+recv_thread_fill(struct mbuf **mbufs, WSABUF *iov, int to_fill, char *scratch)
+#else
+recv_thread_fill(struct mbuf **mbufs, struct iovec *iov, int to_fill, char *scratch)
+#endif
+{
+	int i, complete;
+
+	complete = 1;
+	for (i = 0; i < MAXLEN_MBUF_CHAIN; i++) {
+		if ((i < to_fill) || (mbufs[i] == NULL)) {
+			mbufs[i] = sctp_get_mbuf_for_msg(RECV_IOVLEN(i), 0, M_NOWAIT, 1, MT_DATA);
+		}
+		if (mbufs[i] != NULL) {
+			RECV_IOV_SET(iov[i], mbufs[i]->m_data, RECV_IOVLEN(i));
+		} else {
+			RECV_IOV_SET(iov[i], scratch, RECV_IOVLEN(i));
+			complete = 0;
+		}
+	}
+	return (complete);
+}
+#endif
+
 #ifdef INET
 static void *
 recv_function_raw(void *arg)
@@ -287,34 +339,21 @@ recv_function_raw(void *arg)
 	/*Initially the entire set of mbufs is to be allocated.
 	  to_fill indicates this amount. */
 	int to_fill = MAXLEN_MBUF_CHAIN;
-	/* iovlen is the size of each mbuf in the chain */
+	/* iovlen is the size of the first mbuf in the chain */
 	int i, n;
 	unsigned int iovlen = MCLBYTES;
-	int want_ext = (iovlen > MLEN)? 1 : 0;
-	int want_header = 0;
+	int complete;
+	char scratch[MJUM9BYTES];
 
 	sctp_userspace_set_threadname("SCTP/IP4 rcv");
 
 	memset(&src, 0, sizeof(struct sockaddr_in));
 	memset(&dst, 0, sizeof(struct sockaddr_in));
 
-	recvmbuf = malloc(sizeof(struct mbuf *) * MAXLEN_MBUF_CHAIN);
+	recvmbuf = calloc(MAXLEN_MBUF_CHAIN, sizeof(struct mbuf *));
 
 	while (1) {
-		for (i = 0; i < to_fill; i++) {
-			/* Not getting the packet header. Tests with chain of one run
-			   as usual without having the packet header.
-			   Have tried both sending and receiving
-			 */
-			recvmbuf[i] = sctp_get_mbuf_for_msg(iovlen, want_header, M_NOWAIT, want_ext, MT_DATA);
-#if !defined(__Userspace_os_Windows)
-			recv_iovec[i].iov_base = (caddr_t)recvmbuf[i]->m_data;
-			recv_iovec[i].iov_len = iovlen;
-#else
-			recv_iovec[i].buf = (caddr_t)recvmbuf[i]->m_data;
-			recv_iovec[i].len = iovlen;
-#endif
-		}
+		complete = recv_thread_fill(recvmbuf, recv_iovec, to_fill, scratch);
 		to_fill = 0;
 #if defined(__Userspace_os_Windows)
 		flags = 0;
@@ -350,6 +389,10 @@ recv_function_raw(void *arg)
 			}
 		}
 #endif
+		if (!complete) {
+			/* Read into the scratch buffer, drop it. */
+			continue;
+		}
 		SCTP_HEADER_LEN(recvmbuf[0]) = n; /* length of total packet */
 		SCTP_STAT_INCR(sctps_recvpackets);
 		SCTP_STAT_INCR_COUNTER64(sctps_inpackets);
@@ -365,9 +408,9 @@ recv_function_raw(void *arg)
 			(to_fill)++;
 			do {
 				recvmbuf[i]->m_next = recvmbuf[i+1];
-				SCTP_BUF_LEN(recvmbuf[i]->m_next) = min(ncounter, iovlen);
+				SCTP_BUF_LEN(recvmbuf[i]->m_next) = min(ncounter, RECV_IOVLEN(i + 1));
 				i++;
-				ncounter -= iovlen;
+				ncounter -= SCTP_BUF_LEN(recvmbuf[i]);
 				(to_fill)++;
 			} while (ncounter > 0);
 		}
@@ -436,7 +479,9 @@ recv_function_raw(void *arg)
 		}
 	}
 	for (i = 0; i < MAXLEN_MBUF_CHAIN; i++) {
-		m_free(recvmbuf[i]);
+		if (recvmbuf[i] != NULL) {
+			m_free(recvmbuf[i]);
+		}
 	}
 	/* free the array itself */
 	free(recvmbuf);
@@ -475,34 +520,21 @@ recv_function_raw6(void *arg)
 	/*Initially the entire set of mbufs is to be allocated.
 	  to_fill indicates this amount. */
 	int to_fill = MAXLEN_MBUF_CHAIN;
-	/* iovlen is the size of each mbuf in the chain */
+	/* iovlen is the size of the first mbuf in the chain */
 	int i, n;
 #if !defined(SCTP_WITH_NO_CSUM)
 	int compute_crc = 1;
 #endif
 	unsigned int iovlen = MCLBYTES;
-	int want_ext = (iovlen > MLEN)? 1 : 0;
-	int want_header = 0;
+	int complete;
+	char scratch[MJUM9BYTES];
 
 	sctp_userspace_set_threadname("SCTP/IP6 rcv");
 
-	recvmbuf6 = malloc(sizeof(struct mbuf *) * MAXLEN_MBUF_CHAIN);
+	recvmbuf6 = calloc(MAXLEN_MBUF_CHAIN, sizeof(struct mbuf *));
 
 	for (;;) {
-		for (i = 0; i < to_fill; i++) {
-			/* Not getting the packet header. Tests with chain of one run
-			   as usual without having the packet header.
-			   Have tried both sending and receiving
-			 */
-			recvmbuf6[i] = sctp_get_mbuf_for_msg(iovlen, want_header, M_NOWAIT, want_ext, MT_DATA);
-#if !defined(__Userspace_os_Windows)
-			recv_iovec[i].iov_base = (caddr_t)recvmbuf6[i]->m_data;
-			recv_iovec[i].iov_len = iovlen;
-#else
-			recv_iovec[i].buf = (caddr_t)recvmbuf6[i]->m_data;
-			recv_iovec[i].len = iovlen;
-#endif
-		}
+		complete = recv_thread_fill(recvmbuf6, recv_iovec, to_fill, scratch);
 		to_fill = 0;
 #if defined(__Userspace_os_Windows)
 		flags = 0;
@@ -553,6 +585,10 @@ recv_function_raw6(void *arg)
 			}
 		}
 #endif
+		if (!complete) {
+			/* Read into the scratch buffer, drop it. */
+			continue;
+		}
 		SCTP_HEADER_LEN(recvmbuf6[0]) = n; /* length of total packet */
 		SCTP_STAT_INCR(sctps_recvpackets);
 		SCTP_STAT_INCR_COUNTER64(sctps_inpackets);
@@ -568,9 +604,9 @@ recv_function_raw6(void *arg)
 			(to_fill)++;
 			do {
 				recvmbuf6[i]->m_next = recvmbuf6[i+1];
-				SCTP_BUF_LEN(recvmbuf6[i]->m_next) = min(ncounter, iovlen);
+				SCTP_BUF_LEN(recvmbuf6[i]->m_next) = min(ncounter, RECV_IOVLEN(i + 1));
 				i++;
-				ncounter -= iovlen;
+				ncounter -= SCTP_BUF_LEN(recvmbuf6[i]);
 				(to_fill)++;
 			} while (ncounter > 0);
 		}
@@ -632,7 +668,9 @@ recv_function_raw6(void *arg)
 		}
 	}
 	for (i = 0; i < MAXLEN_MBUF_CHAIN; i++) {
-		m_free(recvmbuf6[i]);
+		if (recvmbuf6[i] != NULL) {
+			m_free(recvmbuf6[i]);
+		}
 	}
 	/* free the array itself */
 	free(recvmbuf6);
@@ -648,11 +686,11 @@ recv_function_udp(void *arg)
 	/*Initially the entire set of mbufs is to be allocated.
 	  to_fill indicates this amount. */
 	int to_fill = MAXLEN_MBUF_CHAIN;
-	/* iovlen is the size of each mbuf in the chain */
+	/* iovlen is the size of the first mbuf in the chain */
 	int i, n, offset;
 	unsigned int iovlen = MCLBYTES;
-	int want_ext = (iovlen > MLEN)? 1 : 0;
-	int want_header = 0;
+	int complete;
+	char scratch[MJUM9BYTES];
 	struct sctphdr *sh;
 	uint16_t port;
 	struct sctp_chunkhdr *ch;
@@ -683,23 +721,10 @@ recv_function_udp(void *arg)
 
 	sctp_userspace_set_threadname("SCTP/UDP/IP4 rcv");
 
-	udprecvmbuf = malloc(sizeof(struct mbuf *) * MAXLEN_MBUF_CHAIN);
+	udprecvmbuf = calloc(MAXLEN_MBUF_CHAIN, sizeof(struct mbuf *));
 
 	while (1) {
-		for (i = 0; i < to_fill; i++) {
-			/* Not getting the packet header. Tests with chain of one run
-			   as usual without having the packet header.
-			   Have tried both sending and receiving
-			 */
-			udprecvmbuf[i] = sctp_get_mbuf_for_msg(iovlen, want_header, M_NOWAIT, want_ext, MT_DATA);
-#if !defined(__Userspace_os_Windows)
-			iov[i].iov_base = (caddr_t)udprecvmbuf[i]->m_data;
-			iov[i].iov_len = iovlen;
-#else
-			iov[i].buf = (caddr_t)udprecvmbuf[i]->m_data;
-			iov[i].len = iovlen;
-#endif
-		}
+		complete = recv_thread_fill(udprecvmbuf, iov, to_fill, scratch);
 		to_fill = 0;
 #if !defined(__Userspace_os_Windows)
 		memset(&msg, 0, sizeof(struct msghdr));
@@ -753,6 +778,10 @@ recv_function_udp(void *arg)
 		}
 		n = ncounter;
 #endif
+		if (!complete) {
+			/* Read into the scratch buffer, drop it. */
+			continue;
+		}
 		SCTP_HEADER_LEN(udprecvmbuf[0]) = n; /* length of total packet */
 		SCTP_STAT_INCR(sctps_recvpackets);
 		SCTP_STAT_INCR_COUNTER64(sctps_inpackets);
@@ -768,9 +797,9 @@ recv_function_udp(void *arg)
 			(to_fill)++;
 			do {
 				udprecvmbuf[i]->m_next = udprecvmbuf[i+1];
-				SCTP_BUF_LEN(udprecvmbuf[i]->m_next) = min(ncounter, iovlen);
+				SCTP_BUF_LEN(udprecvmbuf[i]->m_next) = min(ncounter, RECV_IOVLEN(i + 1));
 				i++;
-				ncounter -= iovlen;
+				ncounter -= SCTP_BUF_LEN(udprecvmbuf[i]);
 				(to_fill)++;
 			} while (ncounter > 0);
 		}
@@ -846,7 +875,9 @@ recv_function_udp(void *arg)
 		}
 	}
 	for (i = 0; i < MAXLEN_MBUF_CHAIN; i++) {
-		m_free(udprecvmbuf[i]);
+		if (udprecvmbuf[i] != NULL) {
+			m_free(udprecvmbuf[i]);
+		}
 	}
 	/* free the array itself */
 	free(udprecvmbuf);
@@ -862,11 +893,11 @@ recv_function_udp6(void *arg)
 	/*Initially the entire set of mbufs is to be allocated.
 	  to_fill indicates this amount. */
 	int to_fill = MAXLEN_MBUF_CHAIN;
-	/* iovlen is the size of each mbuf in the chain */
+	/* iovlen is the size of the first mbuf in the chain */
 	int i, n, offset;
 	unsigned int iovlen = MCLBYTES;
-	int want_ext = (iovlen > MLEN)? 1 : 0;
-	int want_header = 0;
+	int complete;
+	char scratch[MJUM9BYTES];
 	struct sockaddr_in6 src, dst;
 	struct sctphdr *sh;
 	uint16_t port;
@@ -893,22 +924,9 @@ recv_function_udp6(void *arg)
 
 	sctp_userspace_set_threadname("SCTP/UDP/IP6 rcv");
 
-	udprecvmbuf6 = malloc(sizeof(struct mbuf *) * MAXLEN_MBUF_CHAIN);
+	udprecvmbuf6 = calloc(MAXLEN_MBUF_CHAIN, sizeof(struct mbuf *));
 	while (1) {
-		for (i = 0; i < to_fill; i++) {
-			/* Not getting the packet header. Tests with chain of one run
-			   as usual without having the packet header.
-			   Have tried both sending and receiving
-			 */
-			udprecvmbuf6[i] = sctp_get_mbuf_for_msg(iovlen, want_header, M_NOWAIT, want_ext, MT_DATA);
-#if !defined(__Userspace_os_Windows)
-			iov[i].iov_base = (caddr_t)udprecvmbuf6[i]->m_data;
-			iov[i].iov_len = iovlen;
-#else
-			iov[i].buf = (caddr_t)udprecvmbuf6[i]->m_data;
-			iov[i].len = iovlen;
-#endif
-		}
+		complete = recv_thread_fill(udprecvmbuf6, iov, to_fill, scratch);
 		to_fill = 0;
 
 #if !defined(__Userspace_os_Windows)
@@ -967,6 +985,10 @@ recv_function_udp6(void *arg)
 		}
 		n = ncounter;
 #endif
+		if (!complete) {
+			/* Read into the scratch buffer, drop it. */
+			continue;
+		}
 		SCTP_HEADER_LEN(udprecvmbuf6[0]) = n; /* length of total packet */
 		SCTP_STAT_INCR(sctps_recvpackets);
 		SCTP_STAT_INCR_COUNTER64(sctps_inpackets);
@@ -982,9 +1004,9 @@ recv_function_udp6(void *arg)
 			(to_fill)++;
 			do {
 				udprecvmbuf6[i]->m_next = udprecvmbuf6[i+1];
-				SCTP_BUF_LEN(udprecvmbuf6[i]->m_next) = min(ncounter, iovlen);
+				SCTP_BUF_LEN(udprecvmbuf6[i]->m_next) = min(ncounter, RECV_IOVLEN(i + 1));
 				i++;
-				ncounter -= iovlen;
+				ncounter -= SCTP_BUF_LEN(udprecvmbuf6[i]);
 				(to_fill)++;
 			} while (ncounter > 0);
 		}
@@ -1042,7 +1064,9 @@ recv_function_udp6(void *arg)
 		}
 	}
 	for (i = 0; i < MAXLEN_MBUF_CHAIN; i++) {
-		m_free(udprecvmbuf6[i]);
+		if (udprecvmbuf6[i] != NULL) {
+			m_free(udprecvmbuf6[i]);
+		}
 	}
 	/* free the array itself */
 	free(udprecvmbuf6);
@@ -38,8 +38,10 @@
 #include <netinet/sctp_var.h>
 #include <netinet/sctp_sysctl.h>
 #include <netinet/sctp_input.h>
+#include <netinet/sctp_output.h>
 #include <netinet/sctp_peeloff.h>
 #include <netinet/sctp_crc32.h>
+#include <limits.h>
 #ifdef INET6
 #include <netinet6/sctp6_var.h>
 #endif
@@ -57,6 +59,7 @@
 #else
 #include <user_socketvar.h>
 #endif
+#include <user_pollset.h>
 userland_mutex_t accept_mtx;
 userland_cond_t accept_cond;
 #ifdef _WIN32
@@ -77,10 +80,11 @@ extern int sctp_sosend(struct socket *so, struct sockaddr *addr, struct uio *uio
 extern int sctp_attach(struct socket *so, int proto, uint32_t vrf_id);
 extern int sctpconn_attach(struct socket *so, int proto, uint32_t vrf_id);
 
-void
-usrsctp_init(uint16_t port,
-             int (*conn_output)(void *addr, void *buffer, size_t length, uint8_t tos, uint8_t set_df),
-             void (*debug_printf)(const char *format, ...))
+static void
+init_sync(uint16_t port,
+          int (*conn_output)(void *addr, void *buffer, size_t length, uint8_t tos, uint8_t set_df),
+          void (*debug_printf)(const char *format, ...),
+          int virtual_clock)
 {
 #if defined(__Userspace_os_Windows)
 #if defined(INET) || defined(INET6)
@@ -104,7 +108,48 @@ usrsctp_init(uint16_t port,
 	pthread_mutexattr_destroy(&mutex_attr);
 	pthread_cond_init(&accept_cond, NULL);
 #endif
-	sctp_init(port, conn_output, debug_printf);
+	sctp_pollset_init();
+	sctp_init(port, conn_output, debug_printf, virtual_clock);
+}
+
+void
+usrsctp_init(uint16_t port,
+             int (*conn_output)(void *addr, void *buffer, size_t length, uint8_t tos, uint8_t set_df),
+             void (*debug_printf)(const char *format, ...))
+{
+	init_sync(port, conn_output, debug_printf, 0);
+}
+
+void
+usrsctp_init_virtual_clock(uint16_t port,
+                           int (*conn_output)(void *addr, void *buffer, size_t length, uint8_t tos, uint8_t set_df),
+                           void (*debug_printf)(const char *format, ...))
+{
+	init_sync(port, conn_output, debug_printf, 1);
+}
+
+uint64_t
+usrsctp_get_clock(void)
+{
+	return (sctp_os_timer_now_us());
+}
+
+uint64_t
+usrsctp_next_timer(void)
+{
+	if (!SCTP_BASE_VAR(virtual_clock)) {
+		return (0);
+	}
+	return (sctp_os_virtual_clock_next());
+}
+
+void
+usrsctp_advance_clock(uint64_t usecs)
+{
+	if (!SCTP_BASE_VAR(virtual_clock)) {
+		return;
+	}
+	sctp_os_virtual_clock_advance(usecs);
 }
 
 
@@ -155,18 +200,22 @@ int
 sbwait(struct sockbuf *sb)
 {
 #if defined(__Userspace__) /* __Userspace__ */
+	int error;
 
 	SOCKBUF_LOCK_ASSERT(sb);
 
 	sb->sb_flags |= SB_WAIT;
+	SCTP_MTX_SLEEP(&(sb->sb_mtx));
 #if defined (__Userspace_os_Windows)
 	if (SleepConditionVariableCS(&(sb->sb_cond), &(sb->sb_mtx), INFINITE))
-		return 0;
+		error = 0;
 	else
-		return -1;
+		error = -1;
 #else
-	return (pthread_cond_wait(&(sb->sb_cond), &(sb->sb_mtx)));
+	error = pthread_cond_wait(&(sb->sb_cond), &(sb->sb_mtx));
 #endif
+	SCTP_MTX_WAKEUP(&(sb->sb_mtx));
+	return (error);
 
 #else
 	SOCKBUF_LOCK_ASSERT(sb);
@@ -824,95 +873,104 @@ userspace_sctp_sendmsg(struct socket *so,
 }
 
 
-ssize_t
-usrsctp_sendv(struct socket *so,
-              const void *data,
-              size_t len,
-              struct sockaddr *to,
-              int addrcnt,
-              void *info,
-              socklen_t infolen,
-              unsigned int infotype,
-              int flags)
+/*
+ * Translates the info argument of usrsctp_sendv() into sinfo. Returns 0 or
+ * an errno value. *assoc_id is set if the association id has to be reported
+ * back to the caller.
+ */
+static int
+sendv_get_sinfo(void *info, socklen_t infolen, unsigned int infotype,
+                struct sctp_sndrcvinfo *sinfo, int *use_sinfo, sctp_assoc_t **assoc_id)
 {
-	struct sctp_sndrcvinfo sinfo;
-	struct uio auio;
-	struct iovec iov[1];
-	int use_sinfo;
-	sctp_assoc_t *assoc_id;
-
-	if (so == NULL) {
-		errno = EBADF;
-		return (-1);
-	}
-	if (data == NULL) {
-		errno = EFAULT;
-		return (-1);
-	}
-	memset(&sinfo, 0, sizeof(struct sctp_sndrcvinfo));
-	assoc_id = NULL;
-	use_sinfo = 0;
+	memset(sinfo, 0, sizeof(struct sctp_sndrcvinfo));
+	*assoc_id = NULL;
+	*use_sinfo = 0;
 	switch (infotype) {
 	case SCTP_SENDV_NOINFO:
 		if ((infolen != 0) || (info != NULL)) {
-			errno = EINVAL;
-			return (-1);
+			return (EINVAL);
 		}
 		break;
 	case SCTP_SENDV_SNDINFO:
 		if ((info == NULL) || (infolen != sizeof(struct sctp_sndinfo))) {
-			errno = EINVAL;
-			return (-1);
+			return (EINVAL);
 		}
-		sinfo.sinfo_stream = ((struct sctp_sndinfo *)info)->snd_sid;
-		sinfo.sinfo_flags = ((struct sctp_sndinfo *)info)->snd_flags;
-		sinfo.sinfo_ppid = ((struct sctp_sndinfo *)info)->snd_ppid;
-		sinfo.sinfo_context = ((struct sctp_sndinfo *)info)->snd_context;
-		sinfo.sinfo_assoc_id = ((struct sctp_sndinfo *)info)->snd_assoc_id;
-		assoc_id = &(((struct sctp_sndinfo *)info)->snd_assoc_id);
-		use_sinfo = 1;
+		sinfo->sinfo_stream = ((struct sctp_sndinfo *)info)->snd_sid;
+		sinfo->sinfo_flags = ((struct sctp_sndinfo *)info)->snd_flags;
+		sinfo->sinfo_ppid = ((struct sctp_sndinfo *)info)->snd_ppid;
+		sinfo->sinfo_context = ((struct sctp_sndinfo *)info)->snd_context;
+		sinfo->sinfo_assoc_id = ((struct sctp_sndinfo *)info)->snd_assoc_id;
+		*assoc_id = &(((struct sctp_sndinfo *)info)->snd_assoc_id);
+		*use_sinfo = 1;
 		break;
 	case SCTP_SENDV_PRINFO:
 		if ((info == NULL) || (infolen != sizeof(struct sctp_prinfo))) {
-			errno = EINVAL;
-			return (-1);
+			return (EINVAL);
 		}
-		sinfo.sinfo_stream = 0;
-		sinfo.sinfo_flags = PR_SCTP_POLICY(((struct sctp_prinfo *)info)->pr_policy);
-		sinfo.sinfo_timetolive = ((struct sctp_prinfo *)info)->pr_value;
-		use_sinfo = 1;
+		sinfo->sinfo_stream = 0;
+		sinfo->sinfo_flags = PR_SCTP_POLICY(((struct sctp_prinfo *)info)->pr_policy);
+		sinfo->sinfo_timetolive = ((struct sctp_prinfo *)info)->pr_value;
+		*use_sinfo = 1;
 		break;
 	case SCTP_SENDV_AUTHINFO:
-		errno = EINVAL;
-		return (-1);
+		return (EINVAL);
 	case SCTP_SENDV_SPA:
 		if ((info == NULL) || (infolen != sizeof(struct sctp_sendv_spa))) {
-			errno = EINVAL;
-			return (-1);
+			return (EINVAL);
 		}
 		if (((struct sctp_sendv_spa *)info)->sendv_flags & SCTP_SEND_SNDINFO_VALID) {
-			sinfo.sinfo_stream = ((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_sid;
-			sinfo.sinfo_flags = ((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_flags;
-			sinfo.sinfo_ppid = ((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_ppid;
-			sinfo.sinfo_context = ((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_context;
-			sinfo.sinfo_assoc_id = ((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_assoc_id;
-			assoc_id = &(((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_assoc_id);
+			sinfo->sinfo_stream = ((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_sid;
+			sinfo->sinfo_flags = ((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_flags;
+			sinfo->sinfo_ppid = ((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_ppid;
+			sinfo->sinfo_context = ((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_context;
+			sinfo->sinfo_assoc_id = ((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_assoc_id;
+			*assoc_id = &(((struct sctp_sendv_spa *)info)->sendv_sndinfo.snd_assoc_id);
 		} else {
-			sinfo.sinfo_flags = 0;
-			sinfo.sinfo_stream = 0;
+			sinfo->sinfo_flags = 0;
+			sinfo->sinfo_stream = 0;
 		}
 		if (((struct sctp_sendv_spa *)info)->sendv_flags & SCTP_SEND_PRINFO_VALID) {
-			sinfo.sinfo_flags |= PR_SCTP_POLICY(((struct sctp_sendv_spa *)info)->sendv_prinfo.pr_policy);
-			sinfo.sinfo_timetolive = ((struct sctp_sendv_spa *)info)->sendv_prinfo.pr_value;
+			sinfo->sinfo_flags |= PR_SCTP_POLICY(((struct sctp_sendv_spa *)info)->sendv_prinfo.pr_policy);
+			sinfo->sinfo_timetolive = ((struct sctp_sendv_spa *)info)->sendv_prinfo.pr_value;
 		}
 		if (((struct sctp_sendv_spa *)info)->sendv_flags & SCTP_SEND_AUTHINFO_VALID) {
-			errno = EINVAL;
-			return (-1);
+			return (EINVAL);
 		}
-		use_sinfo = 1;
+		*use_sinfo = 1;
 		break;
 	default:
-		errno = EINVAL;
+		return (EINVAL);
+	}
+	return (0);
+}
+
+ssize_t
+usrsctp_sendv(struct socket *so,
+              const void *data,
+              size_t len,
+              struct sockaddr *to,
+              int addrcnt,
+              void *info,
+              socklen_t infolen,
+              unsigned int infotype,
+              int flags)
+{
+	struct sctp_sndrcvinfo sinfo;
+	struct uio auio;
+	struct iovec iov[1];
+	int use_sinfo;
+	sctp_assoc_t *assoc_id;
+
+	if (so == NULL) {
+		errno = EBADF;
+		return (-1);
+	}
+	if (data == NULL) {
+		errno = EFAULT;
+		return (-1);
+	}
+	errno = sendv_get_sinfo(info, infolen, infotype, &sinfo, &use_sinfo, &assoc_id);
+	if (errno != 0) {
 		return (-1);
 	}
 
@@ -931,6 +989,7 @@ usrsctp_sendv(struct socket *so,
 	auio.uio_rw = UIO_WRITE;
 	auio.uio_offset = 0;			/* XXX */
 	auio.uio_resid = len;
+	flags &= ~SCTP_SEND_NO_OUTPUT;
 	errno = sctp_lower_sosend(so, to, &auio, NULL, NULL, flags, use_sinfo ? &sinfo : NULL);
 	if (errno == 0) {
 		if ((to != NULL) && (assoc_id != NULL)) {
@@ -942,6 +1001,178 @@ usrsctp_sendv(struct socket *so,
 	}
 }
 
+/*
+ * Every message is queued by sctp_lower_sosend() with SCTP_SEND_NO_OUTPUT,
+ * so no packet is built until the association changes or the batch ends.
+ * Then a single output pass bundles the queued messages.
+ */
+int
+usrsctp_sendmmsg(struct socket *so,
+                 struct sctp_sndmmsg *msgs,
+                 unsigned int count,
+                 struct sockaddr *to,
+                 int addrcnt,
+                 int flags)
+{
+	struct sctp_sndrcvinfo sinfo;
+	struct uio auio;
+	struct iovec iov[1];
+	struct sctp_sndmmsg *msg;
+	sctp_assoc_t *assoc_id;
+	sctp_assoc_t id, to_id, pending_id;
+	unsigned int i;
+	int use_sinfo, pending, error;
+
+	if (so == NULL) {
+		errno = EBADF;
+		return (-1);
+	}
+	if ((msgs == NULL) && (count > 0)) {
+		errno = EFAULT;
+		return (-1);
+	}
+	if (addrcnt > 1) {
+		errno = EINVAL;
+		return (-1);
+	}
+	flags &= ~SCTP_SEND_NO_OUTPUT;
+	to_id = SCTP_FUTURE_ASSOC;
+	pending_id = SCTP_FUTURE_ASSOC;
+	pending = 0;
+	error = 0;
+	for (i = 0; i < count; i++) {
+		msg = &msgs[i];
+		msg->sm_sent = 0;
+		if (msg->sm_data == NULL) {
+			error = EFAULT;
+			break;
+		}
+		error = sendv_get_sinfo(msg->sm_info, msg->sm_infolen, msg->sm_infotype, &sinfo, &use_sinfo, &assoc_id);
+		if (error != 0) {
+			break;
+		}
+		iov[0].iov_base = (caddr_t)msg->sm_data;
+		iov[0].iov_len = msg->sm_len;
+		auio.uio_iov = iov;
+		auio.uio_iovcnt = 1;
+		auio.uio_segflg = UIO_USERSPACE;
+		auio.uio_rw = UIO_WRITE;
+		auio.uio_offset = 0;
+		auio.uio_resid = msg->sm_len;
+		error = sctp_lower_sosend(so, to, &auio, NULL, NULL, flags | SCTP_SEND_NO_OUTPUT,
+		                          use_sinfo ? &sinfo : NULL);
+		if (error != 0) {
+			break;
+		}
+		msg->sm_sent = msg->sm_len - auio.uio_resid;
+		if (to != NULL) {
+			if (to_id == SCTP_FUTURE_ASSOC) {
+				to_id = usrsctp_getassocid(so, to);
+			}
+			id = to_id;
+			if (assoc_id != NULL) {
+				*assoc_id = id;
+			}
+		} else if (use_sinfo) {
+			id = sinfo.sinfo_assoc_id;
+		} else {
+			id = SCTP_FUTURE_ASSOC;
+		}
+		if (pending && (id != pending_id)) {
+			(void)sctp_output_flush(so, pending_id);
+		}
+		pending = 1;
+		pending_id = id;
+		if (msg->sm_sent < msg->sm_len) {
+			/* Only part of an explicit EOR message fitted. */
+			i++;
+			break;
+		}
+	}
+	if (pending) {
+		(void)sctp_output_flush(so, pending_id);
+	}
+	if (i == 0 && count > 0) {
+		errno = error;
+		return (-1);
+	}
+	return ((int)i);
+}
+
+/*
+ * The buffer becomes read-only external storage of a single mbuf, which
+ * takes the mbuf path of sctp_lower_sosend(). free_cb is its ext_free
+ * routine, so it runs when the last mbuf referencing the buffer is freed.
+ * sctp_lower_sosend() frees the chain itself when it fails, failures
+ * before the mbuf exists call free_cb directly.
+ */
+ssize_t
+usrsctp_sendv_zerocopy(struct socket *so,
+                       const void *data,
+                       size_t len,
+                       struct sockaddr *to,
+                       int addrcnt,
+                       void *info,
+                       socklen_t infolen,
+                       unsigned int infotype,
+                       int flags,
+                       void (*free_cb)(void *data, void *arg),
+                       void *arg)
+{
+	struct sctp_sndrcvinfo sinfo;
+	struct mbuf *m;
+	int error, use_sinfo;
+	sctp_assoc_t *assoc_id;
+
+	if (free_cb == NULL) {
+		errno = EFAULT;
+		return (-1);
+	}
+	if (so == NULL) {
+		error = EBADF;
+		goto out;
+	}
+	if (data == NULL) {
+		error = EFAULT;
+		goto out;
+	}
+	if ((len == 0) || (len > INT_MAX)) {
+		error = EINVAL;
+		goto out;
+	}
+	error = sendv_get_sinfo(info, infolen, infotype, &sinfo, &use_sinfo, &assoc_id);
+	if (error != 0) {
+		goto out;
+	}
+	if (addrcnt > 1) {
+		error = EINVAL;
+		goto out;
+	}
+	if ((m = m_gethdr(M_NOWAIT, MT_DATA)) == NULL) {
+		error = ENOMEM;
+		goto out;
+	}
+	if (m_extadd(m, (caddr_t)data, (u_int)len, free_cb, arg, M_RDONLY, EXT_MOD_TYPE) != 0) {
+		m_freem(m);
+		error = ENOMEM;
+		goto out;
+	}
+	SCTP_BUF_LEN(m) = (int)len;
+	m->m_pkthdr.len = (int)len;
+	flags &= ~SCTP_SEND_NO_OUTPUT;
+	errno = sctp_lower_sosend(so, to, NULL, m, NULL, flags, use_sinfo ? &sinfo : NULL);
+	if (errno != 0) {
+		return (-1);
+	}
+	if ((to != NULL) && (assoc_id != NULL)) {
+		*assoc_id = usrsctp_getassocid(so, to);
+	}
+	return ((ssize_t)len);
+out:
+	free_cb((void *)data, arg);
+	errno = error;
+	return (-1);
+}
 
 ssize_t
 userspace_sctp_sendmbuf(struct socket *so,
@@ -1242,6 +1473,138 @@ usrsctp_recvv(struct socket *so,
 	}
 }
 
+/*
+ * Reads messages like repeated calls of usrsctp_recvv(), but
+ * sctp_sorecvmsg() holds back the window updates, which are sent once
+ * per association when the batch is done. Only the first read may block.
+ */
+int
+usrsctp_recvmmsg(struct socket *so,
+                 struct sctp_rcvmmsg *msgs,
+                 unsigned int count,
+                 int flags)
+{
+	struct uio auio;
+	struct iovec iov[1];
+	struct sctp_rcvmmsg *msg;
+	struct sctp_extrcvinfo seinfo;
+	struct sctp_rcvinfo *rcv;
+	sctp_assoc_t pending_id;
+	ssize_t ulen;
+	socklen_t fromlen;
+	unsigned int i;
+	int msg_flags, pending, error;
+
+	if (so == NULL) {
+		errno = EBADF;
+		return (-1);
+	}
+	if ((msgs == NULL) && (count > 0)) {
+		errno = EFAULT;
+		return (-1);
+	}
+	pending_id = SCTP_FUTURE_ASSOC;
+	pending = 0;
+	error = 0;
+	for (i = 0; i < count; i++) {
+		msg = &msgs[i];
+		msg->rm_received = 0;
+		msg->rm_flags = 0;
+		if ((msg->rm_data == NULL) || (msg->rm_len == 0)) {
+			error = EINVAL;
+			break;
+		}
+		iov[0].iov_base = msg->rm_data;
+		iov[0].iov_len = msg->rm_len;
+		auio.uio_iov = iov;
+		auio.uio_iovcnt = 1;
+		auio.uio_segflg = UIO_USERSPACE;
+		auio.uio_rw = UIO_READ;
+		auio.uio_offset = 0;
+		auio.uio_resid = msg->rm_len;
+		ulen = auio.uio_resid;
+		if (msg->rm_from != NULL) {
+			fromlen = msg->rm_fromlen;
+		} else {
+			fromlen = 0;
+		}
+		msg_flags = flags;
+		if (i > 0) {
+			msg_flags |= MSG_DONTWAIT;
+		}
+		memset(&seinfo, 0, sizeof(struct sctp_extrcvinfo));
+		error = sctp_sorecvmsg_no_window_update(so, &auio,
+		                                        msg->rm_from, fromlen, &msg_flags,
+		                                        (struct sctp_sndrcvinfo *)&seinfo);
+		if (error != 0) {
+			if (auio.uio_resid == ulen) {
+				break;
+			}
+			/* Return what was read, the error shows up on the next call. */
+			error = 0;
+		}
+		if ((auio.uio_resid == ulen) && ((msg_flags & MSG_NOTIFICATION) == 0)) {
+			/* The peer has shut down the association. */
+			break;
+		}
+		msg->rm_received = ulen - auio.uio_resid;
+		msg->rm_flags = msg_flags;
+		rcv = &msg->rm_rcvinfo;
+		memset(rcv, 0, sizeof(struct sctp_rcvinfo));
+		if ((msg_flags & MSG_NOTIFICATION) == 0) {
+			rcv->rcv_sid = seinfo.sinfo_stream;
+			rcv->rcv_ssn = seinfo.sinfo_ssn;
+			rcv->rcv_flags = seinfo.sinfo_flags;
+			rcv->rcv_ppid = seinfo.sinfo_ppid;
+			rcv->rcv_context = seinfo.sinfo_context;
+			rcv->rcv_tsn = seinfo.sinfo_tsn;
+			rcv->rcv_cumtsn = seinfo.sinfo_cumtsn;
+			rcv->rcv_assoc_id = seinfo.sinfo_assoc_id;
+			if (pending && (pending_id != seinfo.sinfo_assoc_id)) {
+				sctp_window_update(so, pending_id);
+			}
+			pending = 1;
+			pending_id = seinfo.sinfo_assoc_id;
+		}
+		if ((msg->rm_from != NULL) && (fromlen > 0)) {
+			switch (msg->rm_from->sa_family) {
+#if defined(INET)
+			case AF_INET:
+				msg->rm_fromlen = sizeof(struct sockaddr_in);
+				break;
+#endif
+#if defined(INET6)
+			case AF_INET6:
+				msg->rm_fromlen = sizeof(struct sockaddr_in6);
+				break;
+#endif
+			case AF_CONN:
+				msg->rm_fromlen = sizeof(struct sockaddr_conn);
+				break;
+			default:
+				msg->rm_fromlen = 0;
+				break;
+			}
+			if (msg->rm_fromlen > fromlen) {
+				msg->rm_fromlen = fromlen;
+			}
+		}
+		if ((msg_flags & MSG_EOR) == 0) {
+			/* The rest of the message is returned by the next call. */
+			i++;
+			break;
+		}
+	}
+	if (pending) {
+		sctp_window_update(so, pending_id);
+	}
+	if ((i == 0) && (error != 0)) {
+		errno = error;
+		return (-1);
+	}
+	return ((int)i);
+}
+
 
 
 
@@ -1563,8 +1926,9 @@ sowakeup(struct socket *so, struct sockbuf *sb)
 #endif
 	}
 	SOCKBUF_UNLOCK(sb);
-	/*__Userspace__ what todo about so_upcall?*/
-
+	if ((sb->sb_flags & SB_UPCALL) && (so->so_pollset != NULL)) {
+		sctp_pollset_wakeup(so, (sb == &so->so_rcv) ? SCTP_EVENT_READ : SCTP_EVENT_WRITE);
+	}
 }
 #else /* kernel version for reference */
 /*
@@ -1774,6 +2138,7 @@ user_accept(struct socket *head,  struct sockaddr **name, socklen_t *namelen, st
 			head->so_error = ECONNABORTED;
 			break;
 		}
+		SCTP_MTX_SLEEP(&accept_mtx);
 #if defined (__Userspace_os_Windows)
 		if (SleepConditionVariableCS(&accept_cond, &accept_mtx, INFINITE))
 			error = 0;
@@ -1782,6 +2147,7 @@ user_accept(struct socket *head,  struct sockaddr **name, socklen_t *namelen, st
 #else
 		error = pthread_cond_wait(&accept_cond, &accept_mtx);
 #endif
+		SCTP_MTX_WAKEUP(&accept_mtx);
 		if (error) {
 			ACCEPT_UNLOCK();
 			goto noconnection;
@@ -2095,6 +2461,7 @@ int user_connect(struct socket *so, struct sockaddr *sa)
 
 	SOCK_LOCK(so);
 	while ((so->so_state & SS_ISCONNECTING) && so->so_error == 0) {
+		SCTP_MTX_SLEEP(SOCK_MTX(so));
 #if defined (__Userspace_os_Windows)
 		if (SleepConditionVariableCS(SOCK_COND(so), SOCK_MTX(so), INFINITE))
 			error = 0;
@@ -2103,6 +2470,7 @@ int user_connect(struct socket *so, struct sockaddr *sa)
 #else
 		error = pthread_cond_wait(SOCK_COND(so), SOCK_MTX(so));
 #endif
+		SCTP_MTX_WAKEUP(SOCK_MTX(so));
 		if (error) {
 #if defined(__Userspace_os_NetBSD)
 			if (error == EINTR) {
@@ -2160,6 +2528,7 @@ int userspace_connect(struct socket *so, struct sockaddr *name, int namelen)
 void
 usrsctp_close(struct socket *so) {
 	if (so != NULL) {
+		sctp_pollset_close(so);
 		if (so->so_options & SCTP_SO_ACCEPTCONN) {
 			struct socket *sp;
 
@@ -2233,7 +2602,10 @@ usrsctp_finish(void)
 	} else {
 		return (-1);
 	}
+	usrsctp_capture_stop();
 	sctp_finish();
+	sctp_pollset_finish();
+	sctp_trace_finish();
 #if defined(__Userspace_os_Windows)
 	DeleteConditionVariable(&accept_cond);
 	DeleteCriticalSection(&accept_mtx);
@@ -2441,6 +2813,22 @@ usrsctp_set_ulpinfo(struct socket *so, void *ulp_info)
 	return (register_ulp_info(so, ulp_info));
 }
 
+int
+usrsctp_set_recv_batch_cb(struct socket *so,
+                          int (*receive_batch_cb)(struct socket *sock, struct sctp_recvbatch_msg *msgs,
+                                                  int count, void *ulp_info))
+{
+	if (so == NULL) {
+		errno = EBADF;
+		return (-1);
+	}
+	if (register_recv_batch_cb(so, receive_batch_cb) == 0) {
+		errno = EINVAL;
+		return (-1);
+	}
+	return (0);
+}
+
 int
 usrsctp_bindx(struct socket *so, struct sockaddr *addrs, int addrcnt, int flags)
 {
@@ -2901,7 +3289,7 @@ sctp_userspace_ip_output(int *result, struct mbuf *o_pak,
 #if !defined (__Userspace_os_Windows)
 	int res;
 #endif
-	struct sockaddr_in dst;
+	struct sockaddr_in src, dst;
 #if defined (__Userspace_os_Windows)
 	WSAMSG win_msg_hdr;
 	DWORD win_sent_len;
@@ -2967,6 +3355,15 @@ sctp_userspace_ip_output(int *result, struct mbuf *o_pak,
 		dst.sin_port = 0;
 	}
 
+	if (sctp_capture_active) {
+		memset(&src, 0, sizeof(struct sockaddr_in));
+		src.sin_family = AF_INET;
+		src.sin_addr = ip->ip_src;
+		sctp_capture_packet(m, len, SCTP_HEADER_LEN(m) - len,
+		                    (struct sockaddr *)&src, (struct sockaddr *)&dst,
+		                    udp ? udp->uh_sport : 0, udp ? udp->uh_dport : 0, 1);
+	}
+
 	/* tweak the mbuf chain */
 	if (use_udp_tunneling) {
 		m_adj(m, sizeof(struct ip) + sizeof(struct udphdr));
@@ -3056,7 +3453,7 @@ void sctp_userspace_ip6_output(int *result, struct mbuf *o_pak,
 #if !defined (__Userspace_os_Windows)
 	int res;
 #endif
-	struct sockaddr_in6 dst;
+	struct sockaddr_in6 src, dst;
 #if defined (__Userspace_os_Windows)
 	WSAMSG win_msg_hdr;
 	DWORD win_sent_len;
@@ -3124,6 +3521,15 @@ void sctp_userspace_ip6_output(int *result, struct mbuf *o_pak,
 		dst.sin6_port = 0;
 	}
 
+	if (sctp_capture_active) {
+		memset(&src, 0, sizeof(struct sockaddr_in6));
+		src.sin6_family = AF_INET6;
+		src.sin6_addr = ip6->ip6_src;
+		sctp_capture_packet(m, len, SCTP_HEADER_LEN(m) - len,
+		                    (struct sockaddr *)&src, (struct sockaddr *)&dst,
+		                    udp ? udp->uh_sport : 0, udp ? udp->uh_dport : 0, 1);
+	}
+
 	/* tweak the mbuf chain */
 	if (use_udp_tunneling) {
 		m_adj(m, sizeof(struct ip6_hdr) + sizeof(struct udphdr));
@@ -3362,6 +3768,11 @@ usrsctp_conninput(void *addr, const void *buffer, size_t length, uint8_t ecn_bit
 		return;
 	}
 	m_copyback(m, 0, (int)length, (caddr_t)buffer);
+	if (SCTP_HEADER_LEN(m) < (int)length) {
+		/* Extending the chain failed. */
+		sctp_m_freem(m);
+		return;
+	}
 	if (SCTP_BUF_LEN(m) < (int)(sizeof(struct sctphdr) + sizeof(struct sctp_chunkhdr))) {
 		if ((m = m_pullup(m, sizeof(struct sctphdr) + sizeof(struct sctp_chunkhdr))) == NULL) {
 			SCTP_STAT_INCR(sctps_hdrops);
@@ -3440,6 +3851,8 @@ USRSCTP_SYSCTL_SET_DEF(sctp_nat_friendly)
 USRSCTP_SYSCTL_SET_DEF(sctp_L2_abc_variable)
 USRSCTP_SYSCTL_SET_DEF(sctp_mbuf_threshold_count)
 USRSCTP_SYSCTL_SET_DEF(sctp_do_drain)
+USRSCTP_SYSCTL_SET_DEF(sctp_idle_compact_time)
+USRSCTP_SYSCTL_SET_DEF(sctp_perf_stats_enable)
 USRSCTP_SYSCTL_SET_DEF(sctp_hb_maxburst)
 USRSCTP_SYSCTL_SET_DEF(sctp_abort_if_one_2_one_hits_limit)
 USRSCTP_SYSCTL_SET_DEF(sctp_min_residual)
@@ -3521,6 +3934,8 @@ USRSCTP_SYSCTL_GET_DEF(sctp_nat_friendly)
 USRSCTP_SYSCTL_GET_DEF(sctp_L2_abc_variable)
 USRSCTP_SYSCTL_GET_DEF(sctp_mbuf_threshold_count)
 USRSCTP_SYSCTL_GET_DEF(sctp_do_drain)
+USRSCTP_SYSCTL_GET_DEF(sctp_idle_compact_time)
+USRSCTP_SYSCTL_GET_DEF(sctp_perf_stats_enable)
 USRSCTP_SYSCTL_GET_DEF(sctp_hb_maxburst)
 USRSCTP_SYSCTL_GET_DEF(sctp_abort_if_one_2_one_hits_limit)
 USRSCTP_SYSCTL_GET_DEF(sctp_min_residual)
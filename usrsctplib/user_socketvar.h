@@ -209,6 +209,7 @@ struct socket {
 
 	void	(*so_upcall)(struct socket *, void *, int);
 	void	*so_upcallarg;
+	struct	sctp_pollset_entry *so_pollset;	/* readiness set, see user_pollset.c */
 	struct	ucred *so_cred;		/* (a) user credentials */
 	struct	label *so_label;	/* (b) MAC label for socket */
 	struct	label *so_peerlabel;	/* (b) cached MAC label for peer */
@@ -240,10 +241,10 @@ extern userland_mutex_t accept_mtx;
 extern userland_cond_t accept_cond;
 #define ACCEPT_LOCK_ASSERT()
 #define	ACCEPT_LOCK() do { \
-	EnterCriticalSection(&accept_mtx); \
+	SCTP_MTX_LOCK(&accept_mtx, SCTP_LOCK_CLASS_ACCEPT); \
 } while (0)
 #define	ACCEPT_UNLOCK()	do { \
-	LeaveCriticalSection(&accept_mtx); \
+	SCTP_MTX_UNLOCK(&accept_mtx, SCTP_LOCK_CLASS_ACCEPT); \
 } while (0)
 #define	ACCEPT_UNLOCK_ASSERT()
 #else
@@ -251,11 +252,11 @@ extern userland_mutex_t accept_mtx;
 
 extern userland_cond_t accept_cond;
 #ifdef INVARIANTS
-#define	ACCEPT_LOCK()	KASSERT(pthread_mutex_lock(&accept_mtx) == 0, ("%s: accept_mtx already locked", __func__))
-#define	ACCEPT_UNLOCK()	KASSERT(pthread_mutex_unlock(&accept_mtx) == 0, ("%s: accept_mtx not locked", __func__))
+#define	ACCEPT_LOCK()	KASSERT(SCTP_MTX_LOCK(&accept_mtx, SCTP_LOCK_CLASS_ACCEPT) == 0, ("%s: accept_mtx already locked", __func__))
+#define	ACCEPT_UNLOCK()	KASSERT(SCTP_MTX_UNLOCK(&accept_mtx, SCTP_LOCK_CLASS_ACCEPT) == 0, ("%s: accept_mtx not locked", __func__))
 #else
-#define	ACCEPT_LOCK()   (void)pthread_mutex_lock(&accept_mtx)
-#define	ACCEPT_UNLOCK() (void)pthread_mutex_unlock(&accept_mtx)
+#define	ACCEPT_LOCK()   (void)SCTP_MTX_LOCK(&accept_mtx, SCTP_LOCK_CLASS_ACCEPT)
+#define	ACCEPT_UNLOCK() (void)SCTP_MTX_UNLOCK(&accept_mtx, SCTP_LOCK_CLASS_ACCEPT)
 #endif
 #define	ACCEPT_LOCK_ASSERT() \
           KASSERT(pthread_mutex_trylock(&accept_mtx) == EBUSY, ("%s: accept_mtx not locked", __func__))
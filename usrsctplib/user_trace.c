@@ -0,0 +1,302 @@
+/*-
+ * Copyright (C) 2026 usrsctp contributors
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the project nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE PROJECT AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE PROJECT OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/* __Userspace__ */
+
+/*
+ * Binary event tracing. Every thread producing events owns a ring of
+ * fixed size records, so recording an event takes neither a lock nor an
+ * atomic read-modify-write: the owner only writes the head index and the
+ * reader only writes the tail index. When a ring is full new events are
+ * dropped and only the sequence number advances, the reader sees the loss
+ * as a gap. The rings are linked on a list, which is only locked when a
+ * thread records its first event and by the reader. A ring outlives its
+ * thread, so events recorded just before a thread exits are not lost, and
+ * is handed to the next thread needing one. The rings are freed by
+ * usrsctp_finish().
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#if defined(__Userspace_os_Windows)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+#include <usrsctp.h>
+#include <user_trace.h>
+
+#if defined(_MSC_VER)
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL __thread
+#endif
+
+struct sctp_trace_ring {
+	struct sctp_trace_ring *next;
+	uint16_t thread;
+	volatile int orphaned;
+	/* Only accessed by the owning thread. */
+	uint32_t seq;
+	uint32_t tail_cache;
+	volatile uint32_t head;
+	/* Only written by the reader, keep it off the owner's cache line. */
+	uint8_t pad[64];
+	volatile uint32_t tail;
+	struct sctp_trace_event events[SCTP_TRACE_RING_SIZE];
+};
+
+static TRACE_THREAD_LOCAL struct sctp_trace_ring *sctp_trace_self;
+/* Rings attached before the last sctp_trace_finish() are gone. */
+static TRACE_THREAD_LOCAL uint32_t sctp_trace_self_generation;
+static volatile uint32_t sctp_trace_generation;
+static struct sctp_trace_ring *sctp_trace_rings;
+static uint16_t sctp_trace_threads;
+
+#if defined(__Userspace_os_Windows)
+static SRWLOCK sctp_trace_lock = SRWLOCK_INIT;
+static DWORD sctp_trace_key = FLS_OUT_OF_INDEXES;
+static LARGE_INTEGER sctp_trace_freq;
+
+#define TRACE_LOCK() AcquireSRWLockExclusive(&sctp_trace_lock)
+#define TRACE_UNLOCK() ReleaseSRWLockExclusive(&sctp_trace_lock)
+
+static __inline uint32_t
+trace_load_acquire(volatile uint32_t *p)
+{
+	uint32_t v;
+
+	v = *p;
+	MemoryBarrier();
+	return (v);
+}
+
+static __inline void
+trace_store_release(volatile uint32_t *p, uint32_t v)
+{
+	MemoryBarrier();
+	*p = v;
+}
+#else
+static pthread_mutex_t sctp_trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t sctp_trace_key;
+static int sctp_trace_key_valid;
+
+#define TRACE_LOCK() pthread_mutex_lock(&sctp_trace_lock)
+#define TRACE_UNLOCK() pthread_mutex_unlock(&sctp_trace_lock)
+#define trace_load_acquire(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define trace_store_release(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#endif
+
+static uint64_t
+sctp_trace_now(void)
+{
+#if defined(__Userspace_os_Windows)
+	LARGE_INTEGER now;
+
+	QueryPerformanceCounter(&now);
+	return ((uint64_t)(now.QuadPart / sctp_trace_freq.QuadPart) * 1000000000 +
+	        (uint64_t)(now.QuadPart % sctp_trace_freq.QuadPart) * 1000000000 / sctp_trace_freq.QuadPart);
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+/* Called when a thread exits, the ring stays readable until reused. */
+#if defined(__Userspace_os_Windows)
+static void WINAPI
+#else
+static void
+#endif
+sctp_trace_detach(void *arg)
+{
+	struct sctp_trace_ring *ring;
+
+	ring = (struct sctp_trace_ring *)arg;
+	sctp_trace_self = NULL;
+	if (ring != NULL) {
+		ring->orphaned = 1;
+	}
+}
+
+static struct sctp_trace_ring *
+sctp_trace_attach(void)
+{
+	struct sctp_trace_ring *ring;
+
+	TRACE_LOCK();
+#if defined(__Userspace_os_Windows)
+	if (sctp_trace_key == FLS_OUT_OF_INDEXES) {
+		QueryPerformanceFrequency(&sctp_trace_freq);
+		sctp_trace_key = FlsAlloc(sctp_trace_detach);
+	}
+#else
+	if (!sctp_trace_key_valid) {
+		if (pthread_key_create(&sctp_trace_key, sctp_trace_detach) == 0) {
+			sctp_trace_key_valid = 1;
+		}
+	}
+#endif
+	for (ring = sctp_trace_rings; ring != NULL; ring = ring->next) {
+		if (ring->orphaned) {
+			ring->orphaned = 0;
+			break;
+		}
+	}
+	if (ring == NULL) {
+		ring = (struct sctp_trace_ring *)calloc(1, sizeof(struct sctp_trace_ring));
+		if (ring == NULL) {
+			TRACE_UNLOCK();
+			return (NULL);
+		}
+		ring->thread = sctp_trace_threads++;
+		ring->next = sctp_trace_rings;
+		sctp_trace_rings = ring;
+	}
+	/*
+	 * A reused ring keeps its thread number and sequence number, to the
+	 * reader the new owner looks like the old thread continuing.
+	 */
+	ring->tail_cache = trace_load_acquire(&ring->tail);
+#if defined(__Userspace_os_Windows)
+	if (sctp_trace_key != FLS_OUT_OF_INDEXES) {
+		FlsSetValue(sctp_trace_key, ring);
+	}
+#else
+	if (sctp_trace_key_valid) {
+		pthread_setspecific(sctp_trace_key, ring);
+	}
+#endif
+	sctp_trace_self_generation = sctp_trace_generation;
+	TRACE_UNLOCK();
+	sctp_trace_self = ring;
+	return (ring);
+}
+
+void
+sctp_trace_record(uint8_t event, uint8_t from, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+	struct sctp_trace_ring *ring;
+	struct sctp_trace_event *ev;
+	uint32_t head, seq;
+
+	ring = sctp_trace_self;
+	if ((ring == NULL) ||
+	    (sctp_trace_self_generation != sctp_trace_generation)) {
+		if ((ring = sctp_trace_attach()) == NULL) {
+			return;
+		}
+	}
+	seq = ring->seq++;
+	head = ring->head;
+	if (head - ring->tail_cache >= SCTP_TRACE_RING_SIZE) {
+		ring->tail_cache = trace_load_acquire(&ring->tail);
+		if (head - ring->tail_cache >= SCTP_TRACE_RING_SIZE) {
+			return;
+		}
+	}
+	ev = &ring->events[head & (SCTP_TRACE_RING_SIZE - 1)];
+	ev->time = sctp_trace_now();
+	ev->seq = seq;
+	ev->thread = ring->thread;
+	ev->event = event;
+	ev->from = from;
+	ev->params[0] = a;
+	ev->params[1] = b;
+	ev->params[2] = c;
+	ev->params[3] = d;
+	trace_store_release(&ring->head, head + 1);
+}
+
+/*
+ * Copies up to max buffered events into events and returns the number
+ * copied. The events of one thread are in order, events of different
+ * threads are not merged, sort by time if needed.
+ */
+int
+usrsctp_trace_read(struct sctp_trace_event *events, int max)
+{
+	struct sctp_trace_ring *ring;
+	uint32_t head, tail;
+	int n;
+
+	if ((events == NULL) || (max <= 0)) {
+		return (0);
+	}
+	n = 0;
+	TRACE_LOCK();
+	for (ring = sctp_trace_rings; (ring != NULL) && (n < max); ring = ring->next) {
+		head = trace_load_acquire(&ring->head);
+		tail = ring->tail;
+		while ((tail != head) && (n < max)) {
+			events[n++] = ring->events[tail & (SCTP_TRACE_RING_SIZE - 1)];
+			tail++;
+		}
+		trace_store_release(&ring->tail, tail);
+	}
+	TRACE_UNLOCK();
+	return (n);
+}
+
+/*
+ * Frees all rings. Called from usrsctp_finish() once the threads of the
+ * stack have exited; other threads which recorded events attach a new
+ * ring on their next event.
+ */
+void
+sctp_trace_finish(void)
+{
+	struct sctp_trace_ring *ring;
+
+	TRACE_LOCK();
+#if defined(__Userspace_os_Windows)
+	if (sctp_trace_key != FLS_OUT_OF_INDEXES) {
+		FlsFree(sctp_trace_key);
+		sctp_trace_key = FLS_OUT_OF_INDEXES;
+	}
+#else
+	if (sctp_trace_key_valid) {
+		pthread_key_delete(sctp_trace_key);
+		sctp_trace_key_valid = 0;
+	}
+#endif
+	while ((ring = sctp_trace_rings) != NULL) {
+		sctp_trace_rings = ring->next;
+		free(ring);
+	}
+	sctp_trace_threads = 0;
+	sctp_trace_generation++;
+	sctp_trace_self = NULL;
+	TRACE_UNLOCK();
+}
@@ -543,6 +543,9 @@ struct sctp_event_subscribe {
 
 #define SCTP_ENABLE_STREAM_RESET        0x00000900 /* struct sctp_assoc_value */
 
+/* Pluggable Congestion Control Socket option */
+#define SCTP_PLUGGABLE_CC               0x00001202
+
 /* Pluggable Stream Scheduling Socket option */
 #define SCTP_PLUGGABLE_SS               0x00001203
 #define SCTP_SS_VALUE                   0x00001204
@@ -560,6 +563,8 @@ struct sctp_event_subscribe {
 #define SCTP_TIMEOUTS                   0x00000106
 #define SCTP_PR_STREAM_STATUS           0x00000107
 #define SCTP_PR_ASSOC_STATUS            0x00000108
+#define SCTP_GET_ASSOC_PERF_STATS       0x00001106
+#define SCTP_GET_ASSOC_MEM_STATS        0x00001107
 
 /*
  * write-only options
@@ -830,6 +835,52 @@ struct sctp_prstatus {
 	uint64_t sprstat_abandoned_sent;
 };
 
+/*
+ * Log-linear histogram: values below 8 have a bucket each, every larger
+ * power of two range is split into 8 buckets. So a bucket covers at most
+ * 12.5% of its lower bound.
+ */
+#define SCTP_PERF_HIST_SUB_BITS 3
+#define SCTP_PERF_HIST_BUCKETS  ((32 - SCTP_PERF_HIST_SUB_BITS + 1) << SCTP_PERF_HIST_SUB_BITS)
+/* Smallest value counted in bucket i. */
+#define SCTP_PERF_HIST_BUCKET_LOW(i) \
+	(((i) < (1 << SCTP_PERF_HIST_SUB_BITS)) ? (uint32_t)(i) : \
+	 (uint32_t)(((1 << SCTP_PERF_HIST_SUB_BITS) | ((i) & ((1 << SCTP_PERF_HIST_SUB_BITS) - 1))) << \
+	            (((i) >> SCTP_PERF_HIST_SUB_BITS) - 1)))
+
+struct sctp_perf_histogram {
+	uint64_t sph_count;
+	uint64_t sph_sum;
+	uint32_t sph_min;
+	uint32_t sph_max;
+	uint32_t sph_buckets[SCTP_PERF_HIST_BUCKETS];
+};
+
+/* Times are in microseconds. */
+struct sctp_assoc_perf_stats {
+	sctp_assoc_t sps_assoc_id;
+	struct sctp_perf_histogram sps_rtt;         /* RTT samples */
+	struct sctp_perf_histogram sps_send_to_ack; /* send call to cum-ack of the message */
+	struct sctp_perf_histogram sps_recv_dwell;  /* read queue to application */
+	struct sctp_perf_histogram sps_sack_bytes;  /* bytes newly acked per SACK */
+};
+
+/*
+ * Memory held by an association in bytes. For SCTP_ALL_ASSOC the numbers
+ * are summed up over all associations of the endpoint and include the
+ * endpoint itself.
+ */
+struct sctp_assoc_mem_stats {
+	sctp_assoc_t sams_assoc_id;
+	uint32_t sams_assocs;		/* number of associations summed up */
+	uint64_t sams_total;
+	uint64_t sams_control;		/* endpoint, association and path control blocks */
+	uint64_t sams_streams;		/* stream tables */
+	uint64_t sams_mapping;		/* TSN mapping arrays */
+	uint64_t sams_queues;		/* chunk, message and read queue entries */
+	uint64_t sams_mbufs;		/* mbufs and clusters on these queues */
+};
+
 /* Standard TCP Congestion Control */
 #define SCTP_CC_RFC2581         0x00000000
 /* High Speed TCP Congestion Control (Floyd) */
@@ -838,6 +889,10 @@ struct sctp_prstatus {
 #define SCTP_CC_HTCP            0x00000002
 /* RTCC Congestion Control - RFC2581 plus */
 #define SCTP_CC_RTCC            0x00000003
+/* BBR like Congestion Control - model based, paced */
+#define SCTP_CC_BBR             0x00000004
+/* CUBIC Congestion Control with HyStart */
+#define SCTP_CC_CUBIC           0x00000005
 
 #define SCTP_CC_OPT_RTCC_SETMODE 0x00002000
 #define SCTP_CC_OPT_USE_DCCC_EC  0x00002001
@@ -865,6 +920,8 @@ struct sctp_prstatus {
 #define SCTP_SS_FAIR_BANDWITH       0x00000004
 /* First-come, first-serve */
 #define SCTP_SS_FIRST_COME          0x00000005
+/* Weighted fair queueing */
+#define SCTP_SS_WFQ                 0x00000006
 
 /******************** System calls *************/
 
@@ -875,6 +932,28 @@ usrsctp_init(uint16_t,
              int (*)(void *addr, void *buffer, size_t length, uint8_t tos, uint8_t set_df),
              void (*)(const char *format, ...));
 
+/*
+ * Like usrsctp_init(), but no timer thread is started. Time stands still
+ * until usrsctp_advance_clock() is called, which runs the timers becoming
+ * due in the calling thread. usrsctp_get_clock() returns the current time
+ * in microseconds and usrsctp_next_timer() the time the next timer might
+ * fire. This allows deterministic and faster than real-time simulations
+ * using AF_CONN.
+ */
+void
+usrsctp_init_virtual_clock(uint16_t,
+                           int (*)(void *addr, void *buffer, size_t length, uint8_t tos, uint8_t set_df),
+                           void (*)(const char *format, ...));
+
+uint64_t
+usrsctp_get_clock(void);
+
+uint64_t
+usrsctp_next_timer(void);
+
+void
+usrsctp_advance_clock(uint64_t usecs);
+
 struct socket *
 usrsctp_socket(int domain, int type, int protocol,
                int (*receive_cb)(struct socket *sock, union sctp_sockstore addr, void *data,
@@ -924,6 +1003,56 @@ usrsctp_sendv(struct socket *so,
               unsigned int infotype,
               int flags);
 
+/*
+ * Sends the message without copying it. The buffer must stay valid and
+ * unmodified until free_cb(data, arg) is called, which happens when the
+ * stack no longer references it: after the message has been acknowledged,
+ * abandoned (PR-SCTP) or discarded because the association is gone. The
+ * callback may run in any thread, also before this function returns, and
+ * must not call back into the stack. free_cb is called exactly once, also
+ * if the call fails, unless it is NULL. The whole message is queued at
+ * once, so SCTP_EXPLICIT_EOR is not supported.
+ */
+ssize_t
+usrsctp_sendv_zerocopy(struct socket *so,
+                       const void *data,
+                       size_t len,
+                       struct sockaddr *to,
+                       int addrcnt,
+                       void *info,
+                       socklen_t infolen,
+                       unsigned int infotype,
+                       int flags,
+                       void (*free_cb)(void *data, void *arg),
+                       void *arg);
+
+/*
+ * One message of usrsctp_sendmmsg(). sm_info, sm_infolen and sm_infotype
+ * are used like the info arguments of usrsctp_sendv(). sm_sent is set to
+ * the number of bytes queued.
+ */
+struct sctp_sndmmsg {
+	const void *sm_data;
+	size_t sm_len;
+	void *sm_info;
+	socklen_t sm_infolen;
+	unsigned int sm_infotype;
+	size_t sm_sent;
+};
+
+/*
+ * Queues the messages like count calls of usrsctp_sendv() and then starts
+ * one output pass, so small messages are bundled. Returns the number of
+ * messages queued, or -1 with errno set if the first one failed.
+ */
+int
+usrsctp_sendmmsg(struct socket *so,
+                 struct sctp_sndmmsg *msgs,
+                 unsigned int count,
+                 struct sockaddr *to,
+                 int addrcnt,
+                 int flags);
+
 ssize_t
 usrsctp_recvv(struct socket *so,
               void *dbuf,
@@ -935,6 +1064,70 @@ usrsctp_recvv(struct socket *so,
               unsigned int *infotype,
               int *msg_flags);
 
+/*
+ * One message of usrsctp_recvmmsg(). rm_data and rm_len describe the
+ * buffer, rm_from and rm_fromlen the optional buffer for the address of the
+ * peer. The other fields are set by usrsctp_recvmmsg().
+ */
+struct sctp_rcvmmsg {
+	void *rm_data;
+	size_t rm_len;
+	struct sockaddr *rm_from;
+	socklen_t rm_fromlen;
+	struct sctp_rcvinfo rm_rcvinfo;
+	size_t rm_received;
+	int rm_flags;
+};
+
+/*
+ * Reads up to count messages and sends the window updates once at the end.
+ * Returns the number of messages read, 0 if the association was shut down
+ * or -1 with errno set.
+ */
+int
+usrsctp_recvmmsg(struct socket *so,
+                 struct sctp_rcvmmsg *msgs,
+                 unsigned int count,
+                 int flags);
+
+/*
+ * Edge triggered readiness sets for sockets without a receive callback.
+ * A socket is reported when it becomes readable or writable, or when an
+ * error occurs, and then not again until the next such event.
+ */
+#define SCTP_EVENT_READ  0x0001
+#define SCTP_EVENT_WRITE 0x0002
+#define SCTP_EVENT_ERROR 0x0004
+
+/* usrsctp_pollset_create() flag: provide a file descriptor. */
+#define SCTP_POLLSET_FD  0x0001
+
+struct sctp_pollset;
+
+struct sctp_pollevent {
+	struct socket *pe_socket;
+	void *pe_data;
+	int pe_events;		/* SCTP_EVENT_* */
+};
+
+struct sctp_pollset *
+usrsctp_pollset_create(int flags);
+
+int
+usrsctp_pollset_destroy(struct sctp_pollset *set);
+
+int
+usrsctp_pollset_add(struct sctp_pollset *set, struct socket *so, int events, void *data);
+
+int
+usrsctp_pollset_remove(struct sctp_pollset *set, struct socket *so);
+
+int
+usrsctp_pollset_wait(struct sctp_pollset *set, struct sctp_pollevent *events, int maxevents, int timeout);
+
+int
+usrsctp_pollset_fd(struct sctp_pollset *set);
+
 int
 usrsctp_bind(struct socket *so,
              struct sockaddr *name,
@@ -1001,6 +1194,24 @@ usrsctp_deregister_address(void *);
 int
 usrsctp_set_ulpinfo(struct socket *, void *);
 
+/* One message of a batched receive callback. */
+struct sctp_recvbatch_msg {
+	union sctp_sockstore rb_addr;
+	void *rb_data;		/* to be freed by the callback */
+	size_t rb_datalen;
+	struct sctp_rcvinfo rb_rcvinfo;
+	int rb_flags;
+};
+
+/*
+ * Replaces the receive callback of a socket created with one by a callback
+ * which is called with all messages of the socket that became ready while
+ * processing one packet. Passing NULL restores the receive callback.
+ */
+int
+usrsctp_set_recv_batch_cb(struct socket *,
+                          int (*)(struct socket *, struct sctp_recvbatch_msg *, int, void *));
+
 #define SCTP_DUMP_OUTBOUND 1
 #define SCTP_DUMP_INBOUND  0
 
@@ -1010,6 +1221,20 @@ usrsctp_dumppacket(const void *, size_t, int);
 void
 usrsctp_freedumpbuffer(char *);
 
+/*
+ * Writes all packets sent and received to a pcapng file, from a
+ * background thread. Packets are truncated to snaplen bytes (0 for no
+ * limit) and, if sample is larger than 1, only every sample-th packet
+ * is captured. Packets of AF_CONN associations are framed as SCTP over
+ * UDP between 127.0.0.1 and 127.0.0.2. Returns -1 and sets errno on
+ * failure, EALREADY if a capture is running.
+ */
+int
+usrsctp_capture_start(const char *, uint32_t, uint32_t);
+
+void
+usrsctp_capture_stop(void);
+
 void
 usrsctp_enable_crc32c_offload(void);
 
@@ -1070,6 +1295,8 @@ USRSCTP_SYSCTL_DECL(sctp_nat_friendly)
 USRSCTP_SYSCTL_DECL(sctp_L2_abc_variable)
 USRSCTP_SYSCTL_DECL(sctp_mbuf_threshold_count)
 USRSCTP_SYSCTL_DECL(sctp_do_drain)
+USRSCTP_SYSCTL_DECL(sctp_idle_compact_time)
+USRSCTP_SYSCTL_DECL(sctp_perf_stats_enable)
 USRSCTP_SYSCTL_DECL(sctp_hb_maxburst)
 USRSCTP_SYSCTL_DECL(sctp_abort_if_one_2_one_hits_limit)
 USRSCTP_SYSCTL_DECL(sctp_min_residual)
@@ -1253,12 +1480,108 @@ struct sctpstat {
 	uint32_t  sctps_send_cwnd_avoid;     /* Send cwnd full  avoidance, already max burst inflight to net */
 	uint32_t  sctps_fwdtsn_map_over;     /* number of map array over-runs via fwd-tsn's */
 	uint32_t  sctps_queue_upd_ecne;      /* Number of times we queued or updated an ECN chunk on send queue */
-	uint32_t  sctps_reserved[31];        /* Future ABI compat - remove int's from here when adding new */
+	uint32_t  sctps_idle_compactions;    /* Number of times an idle association was compacted */
+	uint32_t  sctps_reserved[30];        /* Future ABI compat - remove int's from here when adding new */
 };
 
 void
 usrsctp_get_stat(struct sctpstat *);
 
+/*
+ * Binary event tracing. Select the events to record by passing the
+ * SCTP_*_LOGGING_ENABLE bits to usrsctp_sysctl_set_sctp_logging_level().
+ * Each thread records into its own buffer of SCTP_TRACE_RING_SIZE
+ * events, usrsctp_trace_read() drains them. Events not read before
+ * usrsctp_finish() are discarded. The meaning of params depends on the
+ * event, programs/trace_decode.c shows how to print them.
+ */
+#define SCTP_CWND_LOGGING_ENABLE   0x00000004
+#define SCTP_FLIGHT_LOGGING_ENABLE 0x00000020
+#define SCTP_FR_LOGGING_ENABLE     0x00000040
+#define SCTP_MAP_LOGGING_ENABLE    0x00000100
+#define SCTP_RTTVAR_LOGGING_ENABLE 0x00002000
+#define SCTP_SACK_LOGGING_ENABLE   0x00004000
+#define SCTP_LOG_MAXBURST_ENABLE   0x00080000
+#define SCTP_LOG_RWND_ENABLE       0x00100000
+#define SCTP_TIMER_LOGGING_ENABLE  0x20000000
+#define SCTP_RTX_LOGGING_ENABLE    0x40000000
+#define SCTP_PACKET_LOGGING_ENABLE 0x80000000
+
+#define SCTP_LOG_EVENT_CWND      1
+#define SCTP_LOG_EVENT_FR        4
+#define SCTP_LOG_EVENT_MAP       5
+#define SCTP_LOG_EVENT_MAXBURST  6
+#define SCTP_LOG_EVENT_RWND      7
+#define SCTP_LOG_EVENT_SACK      9
+#define SCTP_LOG_EVENT_RTT      11
+#define SCTP_LOG_MISC_EVENT     15
+#define SCTP_LOG_EVENT_TIMER    20
+#define SCTP_LOG_EVENT_RTX      21
+#define SCTP_LOG_EVENT_PACKET   22
+
+#define SCTP_TRACE_RING_SIZE 4096
+
+struct sctp_trace_event {
+	uint64_t time;		/* monotonic, in nanoseconds */
+	uint32_t seq;		/* per thread, a gap means events were dropped */
+	uint16_t thread;
+	uint8_t event;		/* SCTP_LOG_EVENT_* */
+	uint8_t from;		/* where the event was logged */
+	uint32_t params[4];
+};
+
+int
+usrsctp_trace_read(struct sctp_trace_event *, int);
+
+/*
+ * Lock statistics, only available when the library is built with
+ * SCTP_LOCK_STATS. Otherwise usrsctp_get_lock_stats() fails with
+ * EOPNOTSUPP.
+ */
+#define SCTP_LOCK_STATS_MAX 15
+
+struct sctp_lock_stats {
+	const char *sls_name;
+	uint64_t sls_acquisitions;
+	uint64_t sls_contended;		/* acquisitions which had to wait */
+	uint64_t sls_wait_time;		/* in nanoseconds */
+	uint64_t sls_max_hold_time;	/* in nanoseconds */
+};
+
+int
+usrsctp_get_lock_stats(struct sctp_lock_stats *, int);
+
+/*
+ * Memory accounting, one entry for the SCTP_MALLOC() allocations and one
+ * for each zone of the stack.
+ */
+#define SCTP_MEM_STATS_MAX 20
+
+struct sctp_mem_stats {
+	const char *sms_name;
+	uint64_t sms_in_use;		/* bytes currently allocated */
+	uint64_t sms_objects;		/* objects currently allocated */
+	uint64_t sms_allocs;
+	uint64_t sms_failures;		/* allocations which failed */
+};
+
+int
+usrsctp_get_mem_stats(struct sctp_mem_stats *, int);
+
+/*
+ * Limits in bytes for the memory allocated from the zones of the stack,
+ * 0 means no limit.
+ */
+#define SCTP_MEM_PRESSURE_NONE 0
+#define SCTP_MEM_PRESSURE_SOFT 1
+#define SCTP_MEM_PRESSURE_HARD 2
+
+int
+usrsctp_set_mem_limits(uint64_t soft_limit, uint64_t hard_limit);
+
+void
+usrsctp_set_mem_pressure_cb(void (*)(int level, uint64_t in_use, void *arg), void *arg);
+
 #ifdef _WIN32
 #ifdef _MSC_VER
 #pragma warning(default: 4200)